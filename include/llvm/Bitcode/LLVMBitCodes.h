@@ -196,23 +196,24 @@ enum ModulePathSymtabCodes {
 // The summary section uses different codes in the per-module
 // and combined index cases.
 enum GlobalValueSummarySymtabCodes {
-  // PERMODULE: [valueid, flags, instcount, numrefs, numrefs x valueid,
-  //             n x (valueid)]
+  // PERMODULE: [valueid, flags, instcount, fflags, numrefs, rorefcnt,
+  //             worefcnt, numrefs x valueid, n x (valueid)]
   FS_PERMODULE = 1,
-  // PERMODULE_PROFILE: [valueid, flags, instcount, numrefs,
-  //                     numrefs x valueid,
+  // PERMODULE_PROFILE: [valueid, flags, instcount, fflags, numrefs, rorefcnt,
+  //                     worefcnt, numrefs x valueid,
   //                     n x (valueid, hotness)]
   FS_PERMODULE_PROFILE = 2,
-  // PERMODULE_GLOBALVAR_INIT_REFS: [valueid, flags, n x valueid]
+  // PERMODULE_GLOBALVAR_INIT_REFS: [valueid, flags, varflags, n x valueid]
   FS_PERMODULE_GLOBALVAR_INIT_REFS = 3,
-  // COMBINED: [valueid, modid, flags, instcount, numrefs, numrefs x valueid,
-  //            n x (valueid)]
+  // COMBINED: [valueid, modid, flags, instcount, fflags, numrefs, rorefcnt,
+  //            worefcnt, numrefs x valueid, n x (valueid)]
   FS_COMBINED = 4,
-  // COMBINED_PROFILE: [valueid, modid, flags, instcount, numrefs,
-  //                    numrefs x valueid,
+  // COMBINED_PROFILE: [valueid, modid, flags, instcount, fflags, numrefs,
+  //                    rorefcnt, worefcnt, numrefs x valueid,
   //                    n x (valueid, hotness)]
   FS_COMBINED_PROFILE = 5,
-  // COMBINED_GLOBALVAR_INIT_REFS: [valueid, modid, flags, n x valueid]
+  // COMBINED_GLOBALVAR_INIT_REFS: [valueid, modid, flags, varflags,
+  //                                n x valueid]
   FS_COMBINED_GLOBALVAR_INIT_REFS = 6,
   // ALIAS: [valueid, flags, valueid]
   FS_ALIAS = 7,
@@ -126,15 +126,33 @@ public:
     OPC_CheckChild0Same, OPC_CheckChild1Same,
     OPC_CheckChild2Same, OPC_CheckChild3Same,
     OPC_CheckPatternPredicate,
+    // Space-optimized forms that implicitly encode the predicate number.
+    OPC_CheckPatternPredicate0, OPC_CheckPatternPredicate1,
+    OPC_CheckPatternPredicate2, OPC_CheckPatternPredicate3,
+    OPC_CheckPatternPredicate4, OPC_CheckPatternPredicate5,
+    OPC_CheckPatternPredicate6, OPC_CheckPatternPredicate7,
     OPC_CheckPredicate,
+    // Space-optimized forms that implicitly encode the predicate number.
+    OPC_CheckPredicate0, OPC_CheckPredicate1, OPC_CheckPredicate2,
+    OPC_CheckPredicate3, OPC_CheckPredicate4, OPC_CheckPredicate5,
+    OPC_CheckPredicate6, OPC_CheckPredicate7,
     OPC_CheckOpcode,
     OPC_SwitchOpcode,
     OPC_CheckType,
+    // Space-optimized forms that implicitly encode the VT.
+    OPC_CheckTypeI32, OPC_CheckTypeI64,
     OPC_CheckTypeRes,
     OPC_SwitchType,
     OPC_CheckChild0Type, OPC_CheckChild1Type, OPC_CheckChild2Type,
     OPC_CheckChild3Type, OPC_CheckChild4Type, OPC_CheckChild5Type,
     OPC_CheckChild6Type, OPC_CheckChild7Type,
+    // Space-optimized forms that implicitly encode the VT.
+    OPC_CheckChild0TypeI32, OPC_CheckChild1TypeI32, OPC_CheckChild2TypeI32,
+    OPC_CheckChild3TypeI32, OPC_CheckChild4TypeI32, OPC_CheckChild5TypeI32,
+    OPC_CheckChild6TypeI32, OPC_CheckChild7TypeI32,
+    OPC_CheckChild0TypeI64, OPC_CheckChild1TypeI64, OPC_CheckChild2TypeI64,
+    OPC_CheckChild3TypeI64, OPC_CheckChild4TypeI64, OPC_CheckChild5TypeI64,
+    OPC_CheckChild6TypeI64, OPC_CheckChild7TypeI64,
     OPC_CheckInteger,
     OPC_CheckChild0Integer, OPC_CheckChild1Integer, OPC_CheckChild2Integer,
     OPC_CheckChild3Integer, OPC_CheckChild4Integer,
@@ -145,7 +163,11 @@ public:
     OPC_CheckFoldableChainNode,
 
     OPC_EmitInteger,
+    // Space-optimized forms that implicitly encode the VT.
+    OPC_EmitInteger8, OPC_EmitInteger16, OPC_EmitInteger32, OPC_EmitInteger64,
     OPC_EmitRegister,
+    // Space-optimized forms that implicitly encode the VT.
+    OPC_EmitRegisterI32, OPC_EmitRegisterI64,
     OPC_EmitRegister2,
     OPC_EmitConvertToTarget,
     OPC_EmitMergeInputChains,
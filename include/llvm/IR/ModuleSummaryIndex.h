@@ -18,6 +18,7 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
@@ -89,34 +90,51 @@ using GlobalValueSummaryMapTy =
     std::map<GlobalValue::GUID, GlobalValueSummaryInfo>;
 
 /// Struct that holds a reference to a particular GUID in a global value
-/// summary.
+/// summary. When used as a reference edge of a function summary, it also
+/// records whether the function only reads or only writes the referenced
+/// variable.
 struct ValueInfo {
-  const GlobalValueSummaryMapTy::value_type *Ref = nullptr;
+  enum Flags { ReadOnly = 1, WriteOnly = 2 };
+  PointerIntPair<const GlobalValueSummaryMapTy::value_type *, 2, unsigned>
+      RefAndFlags;
 
   ValueInfo() = default;
-  ValueInfo(const GlobalValueSummaryMapTy::value_type *Ref) : Ref(Ref) {}
+  ValueInfo(const GlobalValueSummaryMapTy::value_type *R) {
+    RefAndFlags.setPointer(R);
+  }
 
-  operator bool() const { return Ref; }
+  operator bool() const { return getRef(); }
 
-  GlobalValue::GUID getGUID() const { return Ref->first; }
-  const GlobalValue *getValue() const { return Ref->second.GV; }
+  GlobalValue::GUID getGUID() const { return getRef()->first; }
+  const GlobalValue *getValue() const { return getRef()->second.GV; }
 
   ArrayRef<std::unique_ptr<GlobalValueSummary>> getSummaryList() const {
-    return Ref->second.SummaryList;
+    return getRef()->second.SummaryList;
+  }
+
+  bool isReadOnly() const { return RefAndFlags.getInt() & ReadOnly; }
+  bool isWriteOnly() const { return RefAndFlags.getInt() & WriteOnly; }
+  void setReadOnly() { RefAndFlags.setInt(RefAndFlags.getInt() | ReadOnly); }
+  void setWriteOnly() { RefAndFlags.setInt(RefAndFlags.getInt() | WriteOnly); }
+
+  const GlobalValueSummaryMapTy::value_type *getRef() const {
+    return RefAndFlags.getPointer();
   }
 };
 
 template <> struct DenseMapInfo<ValueInfo> {
   static inline ValueInfo getEmptyKey() {
-    return ValueInfo((GlobalValueSummaryMapTy::value_type *)-1);
+    return ValueInfo((GlobalValueSummaryMapTy::value_type *)-8);
   }
 
   static inline ValueInfo getTombstoneKey() {
-    return ValueInfo((GlobalValueSummaryMapTy::value_type *)-2);
+    return ValueInfo((GlobalValueSummaryMapTy::value_type *)-16);
   }
 
-  static bool isEqual(ValueInfo L, ValueInfo R) { return L.Ref == R.Ref; }
-  static unsigned getHashValue(ValueInfo I) { return (uintptr_t)I.Ref; }
+  static bool isEqual(ValueInfo L, ValueInfo R) {
+    return L.getRef() == R.getRef();
+  }
+  static unsigned getHashValue(ValueInfo I) { return (uintptr_t)I.getRef(); }
 };
 
 /// \brief Function and variable summary information to aid decisions and
@@ -490,15 +508,36 @@ template <> struct DenseMapInfo<FunctionSummary::ConstVCall> {
 
 /// \brief Global variable summary information to aid decisions and
 /// implementation of importing.
-///
-/// Currently this doesn't add anything to the base \p GlobalValueSummary,
-/// but is a placeholder as additional info may be added to the summary
-/// for variables.
 class GlobalVarSummary : public GlobalValueSummary {
+public:
+  /// Flags computed by the whole program attribute propagation. In the
+  /// per-module summary they tell whether the variable is a candidate for
+  /// the analysis, i.e. whether it could be internalized in every module
+  /// that imports it.
+  struct GVarFlags {
+    GVarFlags(bool MaybeReadOnly, bool MaybeWriteOnly)
+        : MaybeReadOnly(MaybeReadOnly), MaybeWriteOnly(MaybeWriteOnly) {}
+
+    /// The variable is never written to by any live function.
+    unsigned MaybeReadOnly : 1;
+    /// The variable is never read by any live function.
+    unsigned MaybeWriteOnly : 1;
+  };
+
+private:
+  GVarFlags VarFlags;
 
 public:
-  GlobalVarSummary(GVFlags Flags, std::vector<ValueInfo> Refs)
-      : GlobalValueSummary(GlobalVarKind, Flags, std::move(Refs)) {}
+  GlobalVarSummary(GVFlags Flags, GVarFlags VarFlags,
+                   std::vector<ValueInfo> Refs)
+      : GlobalValueSummary(GlobalVarKind, Flags, std::move(Refs)),
+        VarFlags(VarFlags) {}
+
+  GVarFlags varflags() const { return VarFlags; }
+  void setReadOnly(bool RO) { VarFlags.MaybeReadOnly = RO; }
+  void setWriteOnly(bool WO) { VarFlags.MaybeWriteOnly = WO; }
+  bool maybeReadOnly() const { return VarFlags.MaybeReadOnly; }
+  bool maybeWriteOnly() const { return VarFlags.MaybeWriteOnly; }
 
   /// Check if this is a global variable summary.
   static bool classof(const GlobalValueSummary *GVS) {
@@ -619,6 +658,11 @@ private:
   /// considered live.
   bool WithGlobalValueDeadStripping = false;
 
+  /// Indicates that the read-only and write-only attributes of global
+  /// variables have been propagated over the whole program, so that the
+  /// GVarFlags of the variable summaries can be trusted.
+  bool WithAttributePropagation = false;
+
   std::set<std::string> CfiFunctionDefs;
   std::set<std::string> CfiFunctionDecls;
 
@@ -649,6 +693,25 @@ public:
   }
   bool isGUIDLive(GlobalValue::GUID GUID) const;
 
+  bool withAttributePropagation() const { return WithAttributePropagation; }
+  void setWithAttributePropagation() { WithAttributePropagation = true; }
+
+  bool isReadOnly(const GlobalVarSummary *GVS) const {
+    return WithAttributePropagation && GVS->maybeReadOnly();
+  }
+  bool isWriteOnly(const GlobalVarSummary *GVS) const {
+    return WithAttributePropagation && GVS->maybeWriteOnly();
+  }
+
+  /// Analyze index and detect unmodified (read-only) and unread (write-only)
+  /// global variables. Must be called after dead symbols have been computed.
+  /// Only the prevailing copy of a variable, as told by \p isPrevailing, can
+  /// keep the attributes.
+  void propagateAttributes(
+      function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
+          isPrevailing,
+      const DenseSet<GlobalValue::GUID> &PreservedSymbols);
+
   /// Return a ValueInfo for GUID if it exists, otherwise return ValueInfo().
   ValueInfo getValueInfo(GlobalValue::GUID GUID) const {
     auto I = GlobalValueMap.find(GUID);
@@ -692,7 +755,7 @@ public:
     addOriginalName(VI.getGUID(), Summary->getOriginalName());
     // Here we have a notionally const VI, but the value it points to is owned
     // by the non-const *this.
-    const_cast<GlobalValueSummaryMapTy::value_type *>(VI.Ref)
+    const_cast<GlobalValueSummaryMapTy::value_type *>(VI.getRef())
         ->second.SummaryList.push_back(std::move(Summary));
   }
 
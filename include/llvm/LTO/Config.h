@@ -73,6 +73,18 @@ struct Config {
   /// Sample PGO profile path.
   std::string SampleProfile;
 
+  /// Order the hot functions of each module by the profiled call graph.
+  bool FunctionOrdering = false;
+
+  /// If this field is set, regular LTO also writes the function order to this
+  /// symbol ordering file. Implies FunctionOrdering.
+  std::string FunctionOrderingFile;
+
+  /// Write section names instead of symbol names to FunctionOrderingFile, for
+  /// linkers that order input sections. Functions are expected to be emitted
+  /// in their own sections.
+  bool FunctionOrderingFileSections = false;
+
   /// Optimization remarks file path.
   std::string RemarksFilename = "";
 
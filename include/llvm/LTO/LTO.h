@@ -16,6 +16,7 @@
 #ifndef LLVM_LTO_LTO_H
 #define LLVM_LTO_LTO_H
 
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
@@ -313,6 +314,11 @@ private:
     /// The unmangled name of the global.
     std::string IRName;
 
+    /// The GUID of the IR copies of the global. Unlike IRName, which is only
+    /// set once the prevailing copy has been seen, this is known even if the
+    /// prevailing definition is not in IR (e.g. it is in a native object).
+    GlobalValue::GUID GUID = 0;
+
     /// Keep track if the symbol is visible outside of a module with a summary
     /// (i.e. in either a regular object or a regular LTO module without a
     /// summary).
@@ -371,7 +377,8 @@ private:
                    const SymbolResolution *&ResI, const SymbolResolution *ResE);
 
   Error runRegularLTO(AddStreamFn AddStream);
-  Error runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache);
+  Error runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
+                   const DenseSet<GlobalValue::GUID> &GUIDPreservedSymbols);
 
   mutable bool CalledGetMaxTasks = false;
 };
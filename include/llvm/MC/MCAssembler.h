@@ -178,13 +178,28 @@ private:
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
                                const MCAsmLayout &Layout) const;
 
+  /// The fragments of a section which may still change size during
+  /// relaxation, in layout order.
+  struct RelaxationCandidates {
+    MCSection *Sec;
+    std::vector<MCFragment *> Fragments;
+  };
+
   /// \brief Perform one layout iteration and return true if any offsets
   /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  bool layoutOnce(MCAsmLayout &Layout,
+                  MutableArrayRef<RelaxationCandidates> Candidates);
+
+  /// \brief Perform one layout iteration of the given section and return the
+  /// number of fragments that were relaxed. Fragments which can no longer
+  /// change size are removed from \p C.
+  unsigned layoutSectionOnce(MCAsmLayout &Layout, RelaxationCandidates &C);
+
+  /// \brief Return true if \p F may change size during relaxation.
+  bool mayRelaxFragment(const MCFragment &F) const;
 
-  /// \brief Perform one layout iteration of the given section and return true
-  /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec);
+  /// \brief Relax \p F if needed and return true if it changed.
+  bool relaxFragment(MCAsmLayout &Layout, MCFragment &F);
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
@@ -157,7 +157,7 @@ struct MCCVFunctionInfo {
 /// Holds state from .cv_file and .cv_loc directives for later emission.
 class CodeViewContext {
 public:
-  CodeViewContext();
+  explicit CodeViewContext(MCContext &Ctx);
   ~CodeViewContext();
 
   bool isValidFileNumber(unsigned FileNumber) const;
@@ -247,6 +247,8 @@ public:
   std::pair<StringRef, unsigned> addToStringTable(StringRef S);
 
 private:
+  MCContext &Ctx;
+
   /// The current CodeView line information from the last .cv_loc directive.
   MCCVLoc CurrentCVLoc = MCCVLoc(0, 0, 0, 0, false, true);
   bool CVLocSeen = false;
@@ -615,6 +615,15 @@ namespace llvm {
 
     void deallocate(void *Ptr) {}
 
+    /// Create a fragment of type \p FragT in the context's arena. Fragments
+    /// must be released with MCFragment::destroy(), which only runs the
+    /// destructor; the memory itself is reclaimed by reset().
+    template <typename FragT, typename... ArgTs>
+    FragT *createFragment(ArgTs &&... Args) {
+      return new (Allocator.Allocate(sizeof(FragT), alignof(FragT)))
+          FragT(std::forward<ArgTs>(Args)...);
+    }
+
     bool hadError() { return HadError; }
     void reportError(SMLoc L, const Twine &Msg);
     // Unrecoverable error has occurred. Display the best diagnostic we can
@@ -95,8 +95,9 @@ public:
 
   /// Destroys the current fragment.
   ///
-  /// This must be used instead of delete as MCFragment is non-virtual.
-  /// This method will dispatch to the appropriate subclass.
+  /// This must be used instead of delete as MCFragment is non-virtual and
+  /// fragments are allocated by MCContext::createFragment. This method will
+  /// dispatch to the appropriate subclass destructor.
   void destroy();
 
   FragmentType getKind() const { return Kind; }
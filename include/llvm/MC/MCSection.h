@@ -165,7 +165,10 @@ public:
   reverse_iterator rend() { return Fragments.rend(); }
   const_reverse_iterator rend() const  { return Fragments.rend(); }
 
-  MCSection::iterator getSubsectionInsertionPoint(unsigned Subsection);
+  /// Return the insertion point for \p Subsection, creating the fragment that
+  /// starts it in \p Ctx if needed.
+  MCSection::iterator getSubsectionInsertionPoint(unsigned Subsection,
+                                                  MCContext &Ctx);
 
   void dump() const;
 
@@ -167,6 +167,12 @@ ModulePass *createIPConstantPropagationPass();
 ///
 ModulePass *createIPSCCPPass();
 
+//===----------------------------------------------------------------------===//
+/// createFunctionSpecializationPass - This pass clones functions for the
+/// constant arguments passed by some of their call sites.
+///
+ModulePass *createFunctionSpecializationPass();
+
 //===----------------------------------------------------------------------===//
 //
 /// createLoopExtractorPass - This pass extracts all natural loops from the
@@ -220,6 +226,19 @@ ModulePass *createBarrierNoopPass();
 /// indicating the set of functions they may target at run-time.
 ModulePass *createCalledValuePropagationPass();
 
+/// createHotColdSplittingPass - Outline regions that are unlikely to be
+/// executed into separate cold functions.
+ModulePass *createHotColdSplittingPass();
+
+/// createFunctionOrderingPass - Order functions by their profiled call graph
+/// so that hot callees follow their callers. The first form writes the order
+/// to the file named by -function-ordering-file, if any. The second writes it
+/// to \p OrderingFile unless that is empty, as section names if
+/// \p WriteSectionNames is set and as symbol names otherwise.
+ModulePass *createFunctionOrderingPass();
+ModulePass *createFunctionOrderingPass(StringRef OrderingFile,
+                                       bool WriteSectionNames = false);
+
 /// What to do with the summary when running passes that operate on it.
 enum class PassSummaryAction {
   None,   ///< Do nothing.
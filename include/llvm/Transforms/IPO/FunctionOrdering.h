@@ -0,0 +1,48 @@
+//===- FunctionOrdering.h - Profile-guided function ordering ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass orders the functions of a module so that hot callees are placed
+// right after their hot callers, using the profiled call graph.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_IPO_FUNCTIONORDERING_H
+#define LLVM_TRANSFORMS_IPO_FUNCTIONORDERING_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/PassManager.h"
+#include <string>
+
+namespace llvm {
+
+class Module;
+
+/// Pass to order the functions of a module by their profiled call graph.
+class FunctionOrderingPass : public PassInfoMixin<FunctionOrderingPass> {
+  std::string OrderingFile;
+  bool WriteSectionNames;
+
+public:
+  /// Write the order of the hot functions to the file named by the
+  /// -function-ordering-file option, if any.
+  FunctionOrderingPass();
+
+  /// If \p OrderingFile is not empty, the order of the hot functions is also
+  /// written to it for the linker: as section names if \p WriteSectionNames is
+  /// set, and as symbol names otherwise.
+  explicit FunctionOrderingPass(StringRef OrderingFile,
+                                bool WriteSectionNames = false)
+      : OrderingFile(OrderingFile), WriteSectionNames(WriteSectionNames) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_TRANSFORMS_IPO_FUNCTIONORDERING_H
@@ -0,0 +1,45 @@
+//===- ModuleInliner.h - Priority-ordered module inliner --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass inlines call sites in a module-wide priority order, as an
+// alternative to the bottom-up CGSCC inliner.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_IPO_MODULEINLINER_H
+#define LLVM_TRANSFORMS_IPO_MODULEINLINER_H
+
+#include "llvm/Analysis/InlineCost.h"
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+class Module;
+
+/// The module inliner pass.
+///
+/// Rather than making local decisions while walking the call graph one SCC at
+/// a time, this pass keeps all the call sites of the module in a single
+/// priority queue, ordered by the estimated benefit of inlining a call site
+/// per unit of code growth. The most profitable call sites are inlined first,
+/// until a module-wide growth budget is exhausted.
+class ModuleInlinerPass : public PassInfoMixin<ModuleInlinerPass> {
+public:
+  ModuleInlinerPass(InlineParams Params = getInlineParams())
+      : Params(std::move(Params)) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+
+private:
+  InlineParams Params;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_TRANSFORMS_IPO_MODULEINLINER_H
@@ -25,7 +25,9 @@
 
 namespace llvm {
 
+class DataLayout;
 class Module;
+class TargetLibraryInfo;
 
 /// Pass to perform interprocedural constant propagation.
 class IPSCCPPass : public PassInfoMixin<IPSCCPPass> {
@@ -33,6 +35,9 @@ public:
   PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
 };
 
+/// Run interprocedural SCCP on \p M. Returns true if the module changed.
+bool runIPSCCP(Module &M, const DataLayout &DL, const TargetLibraryInfo *TLI);
+
 } // end namespace llvm
 
 #endif // LLVM_TRANSFORMS_IPO_SCCP_H
@@ -196,6 +196,12 @@ Pass *createLoopUnrollPass(int OptLevel = 2, int Threshold = -1, int Count = -1,
 // Create an unrolling pass for full unrolling that uses exact trip count only.
 Pass *createSimpleLoopUnrollPass(int OptLevel = 2);
 
+//===----------------------------------------------------------------------===//
+//
+// LoopUnrollAndJam - This pass is a simple loop unroll and jam pass.
+//
+FunctionPass *createLoopUnrollAndJamPass();
+
 //===----------------------------------------------------------------------===//
 //
 // LoopReroll - This pass is a simple loop rerolling pass.
@@ -363,6 +369,13 @@ FunctionPass *createGVNHoistPass();
 //
 FunctionPass *createGVNSinkPass();
 
+//===----------------------------------------------------------------------===//
+//
+// HeapToStack - Replace small heap allocations that do not escape and are
+// freed on all paths with stack allocations.
+//
+FunctionPass *createHeapToStackPass();
+
 //===----------------------------------------------------------------------===//
 //
 // MergedLoadStoreMotion - This pass merges loads and stores in diamonds. Loads
@@ -548,6 +561,12 @@ FunctionPass *createNaryReassociatePass();
 //
 FunctionPass *createLoopDistributePass();
 
+//===----------------------------------------------------------------------===//
+//
+// LoopFuse - Fuse adjacent loops with the same trip count.
+//
+FunctionPass *createLoopFusePass();
+
 //===----------------------------------------------------------------------===//
 //
 // LoopLoadElimination - Perform loop-aware load elimination.
@@ -0,0 +1,63 @@
+//===- CodeLayout.h - Code layout algorithms --------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Declares layout algorithms that order the nodes of a weighted graph, such
+// as the basic blocks of a function or the functions of a call graph, to
+// improve instruction cache, TLB and branch predictor utilization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_CODELAYOUT_H
+#define LLVM_TRANSFORMS_UTILS_CODELAYOUT_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+
+/// An edge of the graph to lay out, executed \p Count times.
+struct LayoutEdge {
+  unsigned Src;
+  unsigned Dst;
+  uint64_t Count;
+};
+
+/// Find a layout of the nodes of a control flow graph that maximizes the
+/// extended TSP (Ext-TSP) objective. The objective rewards an edge that
+/// becomes a fall-through, and to a lesser extent a short forward or backward
+/// jump, in proportion to its execution count.
+///
+/// \p NodeSizes and \p NodeCounts give the size (in any unit, e.g.
+/// instructions) and the execution count of every node. Node 0 is the entry
+/// and is kept first. Returns the new order as a permutation of node indices.
+std::vector<unsigned> applyExtTspLayout(ArrayRef<uint64_t> NodeSizes,
+                                        ArrayRef<uint64_t> NodeCounts,
+                                        ArrayRef<LayoutEdge> Edges);
+
+/// Compute the Ext-TSP score of the layout \p Order.
+double calcExtTspScore(ArrayRef<unsigned> Order, ArrayRef<uint64_t> NodeSizes,
+                       ArrayRef<LayoutEdge> Edges);
+
+/// Order the functions of a call graph with the Call-Chain Clustering (C3)
+/// heuristic of hfsort: going from the hottest function down, every function
+/// is appended to the cluster of its most frequent caller, unless the merged
+/// cluster would be too large or much sparser. Clusters are then sorted by
+/// decreasing density, i.e. execution count per byte.
+///
+/// \p FuncSizes and \p FuncCounts give the size in bytes and the execution
+/// count of every function, and \p Calls the number of calls between them.
+/// Returns the new order as a permutation of function indices.
+std::vector<unsigned> applyC3Ordering(ArrayRef<uint64_t> FuncSizes,
+                                      ArrayRef<uint64_t> FuncCounts,
+                                      ArrayRef<LayoutEdge> Calls);
+
+} // end namespace llvm
+
+#endif // LLVM_TRANSFORMS_UTILS_CODELAYOUT_H
@@ -70,12 +70,13 @@ public:
   GlobalNumberState() = default;
 
   uint64_t getNumber(GlobalValue* Global) {
-    ValueNumberMap::iterator MapIter;
-    bool Inserted;
-    std::tie(MapIter, Inserted) = GlobalNumbers.insert({Global, NextNumber});
-    if (Inserted)
-      NextNumber++;
-    return MapIter->second;
+    // Unlike insert, find does not create a value handle, so looking up a
+    // global that already has a number does not modify the context.
+    ValueNumberMap::iterator MapIter = GlobalNumbers.find(Global);
+    if (MapIter != GlobalNumbers.end())
+      return MapIter->second;
+    GlobalNumbers.insert({Global, NextNumber});
+    return NextNumber++;
   }
 
   void erase(GlobalValue *Global) {
@@ -24,6 +24,7 @@ namespace llvm {
 
 class AssumptionCache;
 class BasicBlock;
+class DependenceInfo;
 class DominatorTree;
 class Loop;
 class LoopInfo;
@@ -76,6 +77,22 @@ void computePeelCount(Loop *L, unsigned LoopSize,
 bool peelLoop(Loop *L, unsigned PeelCount, LoopInfo *LI, ScalarEvolution *SE,
               DominatorTree *DT, AssumptionCache *AC, bool PreserveLCSSA);
 
+/// Return true if the outer loop \p L of a loop nest can be unrolled and the
+/// copies of its only inner loop jammed together without reordering
+/// dependent memory accesses.
+bool isSafeToUnrollAndJam(Loop *L, ScalarEvolution &SE, DominatorTree &DT,
+                          DependenceInfo &DI);
+
+/// Unroll the outer loop \p L \p Count times and jam the copies of its inner
+/// loop. The loop nest must be legal according to \c isSafeToUnrollAndJam.
+/// \p TripMultiple is a known divisor of the trip count of \p L; if \p Count
+/// does not divide it, the remaining iterations run in an epilogue copy of
+/// the loop nest, which requires the trip count to be computable by \p SE.
+LoopUnrollResult UnrollAndJamLoop(Loop *L, unsigned Count,
+                                  unsigned TripMultiple, LoopInfo *LI,
+                                  ScalarEvolution *SE, DominatorTree *DT,
+                                  OptimizationRemarkEmitter *ORE);
+
 MDNode *GetUnrollMetadata(MDNode *LoopID, StringRef Name);
 
 } // end namespace llvm
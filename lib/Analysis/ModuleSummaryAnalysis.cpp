@@ -109,6 +109,18 @@ static bool isNonRenamableLocal(const GlobalValue &GV) {
   return GV.hasSection() && GV.hasLocalLinkage();
 }
 
+static bool isNonVolatileLoad(const Instruction *I) {
+  if (const auto *LI = dyn_cast<LoadInst>(I))
+    return !LI->isVolatile();
+  return false;
+}
+
+static bool isNonVolatileStore(const Instruction *I) {
+  if (const auto *SI = dyn_cast<StoreInst>(I))
+    return !SI->isVolatile();
+  return false;
+}
+
 /// Determine whether this call has all constant integer arguments (excluding
 /// "this") and summarize it to VCalls or ConstVCalls as appropriate.
 static void addVCallToSet(DevirtCallSite Call, GlobalValue::GUID Guid,
@@ -199,7 +211,8 @@ static void
 computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
                        const Function &F, BlockFrequencyInfo *BFI,
                        ProfileSummaryInfo *PSI, bool HasLocalsInUsedOrAsm,
-                       DenseSet<GlobalValue::GUID> &CantBePromoted) {
+                       DenseSet<GlobalValue::GUID> &CantBePromoted,
+                       bool IsThinLTO) {
   // Summary not currently supported for anonymous functions, they should
   // have been named.
   assert(F.hasName());
@@ -216,6 +229,10 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
       TypeCheckedLoadConstVCalls;
   ICallPromotionAnalysis ICallAnalysis;
   SmallPtrSet<const User *, 8> Visited;
+  // Non-volatile loads and stores whose pointer operands may reference global
+  // variables that are only read or only written by this function.
+  SmallVector<const Instruction *, 8> NonVolatileLoads;
+  SmallVector<const Instruction *, 8> NonVolatileStores;
 
   // Add personality function, prefix data and prologue data to function's ref
   // list.
@@ -227,6 +244,27 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
       if (isa<DbgInfoIntrinsic>(I))
         continue;
       ++NumInsts;
+      if (IsThinLTO) {
+        // References from the pointer operand of a non-volatile load or store
+        // are collected separately once all other instructions have been
+        // visited. The stored value may escape, so its references are
+        // recorded as regular references right away.
+        if (isNonVolatileLoad(&I)) {
+          Visited.insert(&I);
+          NonVolatileLoads.push_back(&I);
+          continue;
+        }
+        if (isNonVolatileStore(&I)) {
+          Visited.insert(&I);
+          NonVolatileStores.push_back(&I);
+          const Value *Stored = I.getOperand(0);
+          if (const auto *GV = dyn_cast<GlobalValue>(Stored))
+            RefEdges.insert(Index.getOrInsertValueInfo(GV));
+          else if (const auto *U = dyn_cast<User>(Stored))
+            findRefEdges(Index, U, RefEdges, Visited);
+          continue;
+        }
+      }
       findRefEdges(Index, &I, RefEdges, Visited);
       auto CS = ImmutableCallSite(&I);
       if (!CS)
@@ -301,6 +339,48 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
     CallGraphEdges[Index.getOrInsertValueInfo(I)].updateHotness(
         CalleeInfo::HotnessType::Critical);
 
+  std::vector<ValueInfo> Refs;
+  if (IsThinLTO) {
+    SetVector<ValueInfo> LoadRefEdges, StoreRefEdges;
+    for (const auto *I : NonVolatileLoads) {
+      Visited.erase(I);
+      findRefEdges(Index, I, LoadRefEdges, Visited);
+    }
+    // Constant expressions visited for the loads may also be used as store
+    // addresses, so the stores get a cache of their own. Only the address is
+    // walked: the references of the stored value were recorded above.
+    SmallPtrSet<const User *, 8> StoreCache;
+    for (const auto *I : NonVolatileStores) {
+      const Value *Ptr = cast<StoreInst>(I)->getPointerOperand();
+      if (const auto *GV = dyn_cast<GlobalValue>(Ptr))
+        StoreRefEdges.insert(Index.getOrInsertValueInfo(GV));
+      else if (const auto *U = dyn_cast<User>(Ptr))
+        findRefEdges(Index, U, StoreRefEdges, StoreCache);
+    }
+    // A variable that is both loaded and stored is neither read-only nor
+    // write-only in this function.
+    for (auto &VI : StoreRefEdges)
+      if (LoadRefEdges.remove(VI))
+        RefEdges.insert(VI);
+
+    // Group the read-only and then the write-only references at the end of
+    // the list. References already present in RefEdges stay regular ones.
+    unsigned RefCnt = RefEdges.size();
+    for (auto &VI : LoadRefEdges)
+      RefEdges.insert(VI);
+    unsigned FirstWORef = RefEdges.size();
+    for (auto &VI : StoreRefEdges)
+      RefEdges.insert(VI);
+
+    Refs = RefEdges.takeVector();
+    for (; RefCnt < FirstWORef; ++RefCnt)
+      Refs[RefCnt].setReadOnly();
+    for (; RefCnt < Refs.size(); ++RefCnt)
+      Refs[RefCnt].setWriteOnly();
+  } else {
+    Refs = RefEdges.takeVector();
+  }
+
   bool NonRenamableLocal = isNonRenamableLocal(F);
   bool NotEligibleForImport =
       NonRenamableLocal || HasInlineAsmMaybeReferencingInternal ||
@@ -318,9 +398,9 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
       F.returnDoesNotAlias(),
   };
   auto FuncSummary = llvm::make_unique<FunctionSummary>(
-      Flags, NumInsts, FunFlags, RefEdges.takeVector(),
-      CallGraphEdges.takeVector(), TypeTests.takeVector(),
-      TypeTestAssumeVCalls.takeVector(), TypeCheckedLoadVCalls.takeVector(),
+      Flags, NumInsts, FunFlags, std::move(Refs), CallGraphEdges.takeVector(),
+      TypeTests.takeVector(), TypeTestAssumeVCalls.takeVector(),
+      TypeCheckedLoadVCalls.takeVector(),
       TypeTestAssumeConstVCalls.takeVector(),
       TypeCheckedLoadConstVCalls.takeVector());
   if (NonRenamableLocal)
@@ -330,15 +410,24 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
 
 static void
 computeVariableSummary(ModuleSummaryIndex &Index, const GlobalVariable &V,
-                       DenseSet<GlobalValue::GUID> &CantBePromoted) {
+                       DenseSet<GlobalValue::GUID> &CantBePromoted,
+                       bool IsThinLTO) {
   SetVector<ValueInfo> RefEdges;
   SmallPtrSet<const User *, 8> Visited;
   findRefEdges(Index, &V, RefEdges, Visited);
   bool NonRenamableLocal = isNonRenamableLocal(V);
   GlobalValueSummary::GVFlags Flags(V.getLinkage(), NonRenamableLocal,
                                     /* Live = */ false, V.isDSOLocal());
-  auto GVarSummary =
-      llvm::make_unique<GlobalVarSummary>(Flags, RefEdges.takeVector());
+  // Only a variable that every importing module may hold an internal copy of
+  // is a candidate for the read-only and write-only analysis.
+  bool CanBeInternalized =
+      IsThinLTO && !V.hasComdat() && !V.hasAppendingLinkage() &&
+      !V.isInterposable() && !V.hasAvailableExternallyLinkage() &&
+      !V.hasDLLExportStorageClass() && !V.isExternallyInitialized() &&
+      !V.isThreadLocal();
+  GlobalVarSummary::GVarFlags VarFlags(CanBeInternalized, CanBeInternalized);
+  auto GVarSummary = llvm::make_unique<GlobalVarSummary>(
+      Flags, VarFlags, RefEdges.takeVector());
   if (NonRenamableLocal)
     CantBePromoted.insert(V.getGUID());
   Index.addGlobalValueSummary(V.getName(), std::move(GVarSummary));
@@ -386,6 +475,12 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
   // Next collect those in the llvm.compiler.used set.
   collectUsedGlobalVariables(M, Used, /*CompilerUsed*/ true);
   DenseSet<GlobalValue::GUID> CantBePromoted;
+
+  bool IsThinLTO = true;
+  if (auto *MD =
+          mdconst::extract_or_null<ConstantInt>(M.getModuleFlag("ThinLTO")))
+    IsThinLTO = MD->getZExtValue();
+
   for (auto *V : Used) {
     if (V->hasLocalLinkage()) {
       LocalsUsed.insert(V);
@@ -439,8 +534,9 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
             Index.addGlobalValueSummary(Name, std::move(Summary));
           } else {
             std::unique_ptr<GlobalVarSummary> Summary =
-                llvm::make_unique<GlobalVarSummary>(GVFlags,
-                                                    ArrayRef<ValueInfo>{});
+                llvm::make_unique<GlobalVarSummary>(
+                    GVFlags, GlobalVarSummary::GVarFlags(false, false),
+                    ArrayRef<ValueInfo>{});
             Index.addGlobalValueSummary(Name, std::move(Summary));
           }
         });
@@ -465,7 +561,7 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
 
     computeFunctionSummary(Index, M, F, BFI, PSI,
                            !LocalsUsed.empty() || HasLocalInlineAsmSymbol,
-                           CantBePromoted);
+                           CantBePromoted, IsThinLTO);
   }
 
   // Compute summaries for all variables defined in module, and save in the
@@ -473,7 +569,7 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
   for (const GlobalVariable &G : M.globals()) {
     if (G.isDeclaration())
       continue;
-    computeVariableSummary(Index, G, CantBePromoted);
+    computeVariableSummary(Index, G, CantBePromoted, IsThinLTO);
   }
 
   // Compute summaries for all aliases defined in module, and save in the
@@ -496,11 +592,6 @@ ModuleSummaryIndex llvm::buildModuleSummaryIndex(
   setLiveRoot(Index, "llvm.global_dtors");
   setLiveRoot(Index, "llvm.global.annotations");
 
-  bool IsThinLTO = true;
-  if (auto *MD =
-          mdconst::extract_or_null<ConstantInt>(M.getModuleFlag("ThinLTO")))
-    IsThinLTO = MD->getZExtValue();
-
   for (auto &GlobalList : Index) {
     // Ignore entries for references that are undefined in the current module.
     if (GlobalList.second.SummaryList.empty())
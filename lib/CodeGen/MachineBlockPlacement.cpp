@@ -57,13 +57,16 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/CodeLayout.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -79,6 +82,7 @@ STATISTIC(CondBranchTakenFreq,
           "Potential frequency of taking conditional branches");
 STATISTIC(UncondBranchTakenFreq,
           "Potential frequency of taking unconditional branches");
+STATISTIC(NumExtTspLayouts, "Number of functions laid out with Ext-TSP");
 
 static cl::opt<unsigned> AlignAllBlock("align-all-blocks",
                                        cl::desc("Force the alignment of all "
@@ -182,6 +186,22 @@ static cl::opt<unsigned> TriangleChainCount(
     cl::init(2),
     cl::Hidden);
 
+static cl::opt<bool> EnableExtTspBlockPlacement(
+    "enable-ext-tsp-block-placement", cl::Hidden, cl::init(false),
+    cl::desc("Reorder blocks after chain-based placement to maximize the "
+             "Ext-TSP objective (fall-throughs and short jumps weighted by "
+             "block frequency)"));
+
+static cl::opt<bool> ApplyExtTspWithoutProfile(
+    "ext-tsp-apply-without-profile", cl::Hidden, cl::init(true),
+    cl::desc("Apply Ext-TSP block placement to functions without profile "
+             "data"));
+
+static cl::opt<bool> PrintExtTspStats(
+    "ext-tsp-block-placement-stats", cl::Hidden, cl::init(false),
+    cl::desc("Print the Ext-TSP score and the expected number of taken "
+             "branches of each function before and after Ext-TSP placement"));
+
 extern cl::opt<unsigned> StaticLikelyProb;
 extern cl::opt<unsigned> ProfileLikelyProb;
 
@@ -467,6 +487,11 @@ class MachineBlockPlacement : public MachineFunctionPass {
   void buildCFGChains();
   void optimizeBranches();
   void alignBlocks();
+  /// Reorder the blocks of the function to maximize the Ext-TSP objective.
+  void applyExtTsp();
+  /// Rebuild a single chain following the current block order, so that the
+  /// passes that walk the function chain see the Ext-TSP layout.
+  void createCFGChainExtTsp();
   /// Returns true if a block should be tail-duplicated to increase fallthrough
   /// opportunities.
   bool shouldTailDuplicate(MachineBasicBlock *BB);
@@ -2714,6 +2739,128 @@ bool MachineBlockPlacement::maybeTailDuplicateBlock(
   return Removed;
 }
 
+/// The expected number of taken branches per entry into the function when the
+/// blocks are laid out in \p Order.
+static double getTakenBranchesPerEntry(ArrayRef<unsigned> Order,
+                                       ArrayRef<uint64_t> BlockCounts,
+                                       ArrayRef<LayoutEdge> Edges) {
+  std::vector<unsigned> Position(Order.size());
+  for (unsigned I = 0, E = Order.size(); I != E; ++I)
+    Position[Order[I]] = I;
+  uint64_t Taken = 0;
+  for (const LayoutEdge &Edge : Edges)
+    if (Position[Edge.Dst] != Position[Edge.Src] + 1)
+      Taken += Edge.Count;
+  return BlockCounts[0] ? (double)Taken / BlockCounts[0] : 0.0;
+}
+
+void MachineBlockPlacement::applyExtTsp() {
+  // A block that falls through without an analyzable branch cannot be
+  // separated from its layout successor, and funclets have their own layout
+  // constraints. Leave such functions alone.
+  SmallVector<MachineOperand, 4> Cond;
+  for (MachineBasicBlock &MBB : *F) {
+    if (MBB.isEHFuncletEntry())
+      return;
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (TII->analyzeBranch(MBB, TBB, FBB, Cond) && MBB.canFallThrough())
+      return;
+  }
+
+  std::vector<MachineBasicBlock *> Blocks;
+  DenseMap<const MachineBasicBlock *, unsigned> BlockIndex;
+  for (MachineBasicBlock &MBB : *F) {
+    BlockIndex[&MBB] = Blocks.size();
+    Blocks.push_back(&MBB);
+  }
+
+  // Block sizes are estimated in bytes; targets that do not report
+  // instruction sizes are assumed to use four bytes per instruction.
+  std::vector<uint64_t> BlockSizes(Blocks.size());
+  std::vector<uint64_t> BlockCounts(Blocks.size());
+  std::vector<LayoutEdge> Edges;
+  for (MachineBasicBlock *MBB : Blocks) {
+    unsigned Index = BlockIndex[MBB];
+    uint64_t Size = 0;
+    for (const MachineInstr &MI : *MBB) {
+      if (MI.isMetaInstruction())
+        continue;
+      unsigned Bytes = TII->getInstSizeInBytes(MI);
+      Size += Bytes ? Bytes : 4;
+    }
+    BlockSizes[Index] = std::max<uint64_t>(Size, 1);
+    BlockFrequency Freq = MBFI->getBlockFreq(MBB);
+    BlockCounts[Index] = Freq.getFrequency();
+    for (MachineBasicBlock *Succ : MBB->successors()) {
+      BlockFrequency EdgeFreq = Freq * MBPI->getEdgeProbability(MBB, Succ);
+      Edges.push_back({Index, BlockIndex[Succ], EdgeFreq.getFrequency()});
+    }
+  }
+
+  std::vector<unsigned> CurrentOrder(Blocks.size());
+  std::iota(CurrentOrder.begin(), CurrentOrder.end(), 0);
+  std::vector<unsigned> NewOrder =
+      applyExtTspLayout(BlockSizes, BlockCounts, Edges);
+
+  if (PrintExtTspStats) {
+    double OldTaken =
+        getTakenBranchesPerEntry(CurrentOrder, BlockCounts, Edges);
+    double NewTaken = getTakenBranchesPerEntry(NewOrder, BlockCounts, Edges);
+    errs() << "ext-tsp: " << F->getName() << ": score "
+           << format("%.2f", calcExtTspScore(CurrentOrder, BlockSizes, Edges))
+           << " -> "
+           << format("%.2f", calcExtTspScore(NewOrder, BlockSizes, Edges))
+           << ", taken branches per entry " << format("%.3f", OldTaken)
+           << " -> " << format("%.3f", NewTaken);
+    if (OldTaken > 0)
+      errs() << format(" (%+.1f%%)", 100.0 * (NewTaken - OldTaken) / OldTaken);
+    errs() << "\n";
+  }
+
+  if (NewOrder == CurrentOrder)
+    return;
+  ++NumExtTspLayouts;
+  DEBUG(dbgs() << "Applying Ext-TSP layout to " << F->getName() << "\n");
+
+  // Remember the fall-throughs of the current layout; those that are broken
+  // by the new order need an explicit branch.
+  std::vector<MachineBasicBlock *> PrevFallThroughs(Blocks.size());
+  for (MachineBasicBlock *MBB : Blocks)
+    PrevFallThroughs[BlockIndex[MBB]] = MBB->getFallThrough();
+
+  std::vector<unsigned> NewIndex(Blocks.size());
+  for (unsigned I = 0, E = NewOrder.size(); I != E; ++I)
+    NewIndex[NewOrder[I]] = I;
+  F->sort([&](MachineBasicBlock &L, MachineBasicBlock &R) {
+    return NewIndex[BlockIndex[&L]] < NewIndex[BlockIndex[&R]];
+  });
+
+  for (MachineBasicBlock &MBB : *F) {
+    MachineFunction::iterator Next = std::next(MBB.getIterator());
+    MachineBasicBlock *FTMBB = PrevFallThroughs[BlockIndex[&MBB]];
+    if (FTMBB && (Next == F->end() || &*Next != FTMBB))
+      TII->insertUnconditionalBranch(MBB, FTMBB, MBB.findBranchDebugLoc());
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (!TII->analyzeBranch(MBB, TBB, FBB, Cond))
+      MBB.updateTerminator();
+  }
+}
+
+void MachineBlockPlacement::createCFGChainExtTsp() {
+  BlockToChain.clear();
+  ComputedEdges.clear();
+  ChainAllocator.DestroyAll();
+
+  MachineBasicBlock *HeadBB = &F->front();
+  BlockChain *FunctionChain =
+      new (ChainAllocator.Allocate()) BlockChain(BlockToChain, HeadBB);
+  for (MachineBasicBlock &MBB : *F)
+    if (&MBB != HeadBB)
+      FunctionChain->merge(&MBB, nullptr);
+}
+
 bool MachineBlockPlacement::runOnMachineFunction(MachineFunction &MF) {
   if (skipFunction(MF.getFunction()))
     return false;
@@ -2795,6 +2942,13 @@ bool MachineBlockPlacement::runOnMachineFunction(MachineFunction &MF) {
     }
   }
 
+  // Refine the chain-based layout with Ext-TSP when requested.
+  if (EnableExtTspBlockPlacement && MF.size() > 2 &&
+      (ApplyExtTspWithoutProfile || MF.getFunction().hasProfileData())) {
+    applyExtTsp();
+    createCFGChainExtTsp();
+  }
+
   optimizeBranches();
   alignBlocks();
 
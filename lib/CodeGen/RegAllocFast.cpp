@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IndexedMap.h"
 #include "llvm/ADT/SmallSet.h"
@@ -55,6 +56,7 @@ using namespace llvm;
 STATISTIC(NumStores, "Number of stores added");
 STATISTIC(NumLoads , "Number of loads added");
 STATISTIC(NumCopies, "Number of copies coalesced");
+STATISTIC(NumStoresAvoided, "Number of block-local stores avoided");
 
 static RegisterRegAlloc
   fastRegAlloc("fast", "fast register allocator", createFastRegisterAllocator);
@@ -80,6 +82,10 @@ namespace {
     /// Maps virtual regs to the frame index where these values are spilled.
     IndexedMap<int, VirtReg2IndexFunctor> StackSlotForVirtReg;
 
+    /// Has a bit set for every virtual register for which it was determined
+    /// that it may be live across blocks.
+    BitVector MayLiveAcrossBlocks;
+
     /// Everything we know about a live virtual register.
     struct LiveReg {
       MachineInstr *LastUse = nullptr; ///< Last instr to use reg.
@@ -185,6 +191,7 @@ namespace {
                                SmallVectorImpl<unsigned> &VirtDead);
     int getStackSpaceFor(unsigned VirtReg, const TargetRegisterClass &RC);
     bool isLastUseOfLocalReg(const MachineOperand &MO) const;
+    bool mayLiveOut(unsigned VirtReg);
 
     void addKillFlag(const LiveReg &LRI);
     void killVirtReg(LiveRegMap::iterator LRI);
@@ -213,7 +220,7 @@ namespace {
                                        unsigned VirtReg, unsigned Hint);
     LiveRegMap::iterator reloadVirtReg(MachineInstr &MI, unsigned OpNum,
                                        unsigned VirtReg, unsigned Hint);
-    void spillAll(MachineBasicBlock::iterator MI);
+    void spillAll(MachineBasicBlock::iterator MI, bool OnlyLiveOut);
     bool setPhysReg(MachineInstr &MI, unsigned OpNum, MCPhysReg PhysReg);
 
     void dumpState();
@@ -261,6 +268,44 @@ bool RegAllocFast::isLastUseOfLocalReg(const MachineOperand &MO) const {
   return ++I == MRI->reg_nodbg_end();
 }
 
+/// Returns false if \p VirtReg is known to not live out of the current block.
+bool RegAllocFast::mayLiveOut(unsigned VirtReg) {
+  unsigned Idx = TargetRegisterInfo::virtReg2Index(VirtReg);
+  // Nothing can be live-out if there are no successors.
+  if (MBB->succ_empty())
+    return false;
+  if (MayLiveAcrossBlocks.test(Idx))
+    return true;
+
+  // A register that has been reloaded was used before being defined in this
+  // block, so its value flows around a loop.
+  if (StackSlotForVirtReg[VirtReg] != -1) {
+    MayLiveAcrossBlocks.set(Idx);
+    return true;
+  }
+
+  // If this block loops back to itself, it would be necessary to check whether
+  // the use comes after the def.
+  if (MBB->isSuccessor(MBB)) {
+    MayLiveAcrossBlocks.set(Idx);
+    return true;
+  }
+
+  // See if the first Limit defs and uses of the register are all in the
+  // current block. Give up on registers with many references to keep this
+  // cheap.
+  static const unsigned Limit = 8;
+  unsigned C = 0;
+  for (const MachineInstr &UseInst : MRI->reg_nodbg_instructions(VirtReg)) {
+    if (UseInst.getParent() != MBB || ++C >= Limit) {
+      MayLiveAcrossBlocks.set(Idx);
+      return true;
+    }
+  }
+
+  return false;
+}
+
 /// Set kill flags on last use of a virtual register.
 void RegAllocFast::addKillFlag(const LiveReg &LR) {
   if (!LR.LastUse) return;
@@ -351,15 +396,25 @@ void RegAllocFast::spillVirtReg(MachineBasicBlock::iterator MI,
   killVirtReg(LRI);
 }
 
-/// Spill all dirty virtregs without killing them.
-void RegAllocFast::spillAll(MachineBasicBlock::iterator MI) {
+/// Spill all dirty virtregs without killing them. If \p OnlyLiveOut is set,
+/// registers known not to be live out of the current block are released
+/// without being stored.
+void RegAllocFast::spillAll(MachineBasicBlock::iterator MI, bool OnlyLiveOut) {
   if (LiveVirtRegs.empty()) return;
   isBulkSpilling = true;
   // The LiveRegMap is keyed by an unsigned (the virtreg number), so the order
   // of spilling here is deterministic, if arbitrary.
   for (LiveRegMap::iterator I = LiveVirtRegs.begin(), E = LiveVirtRegs.end();
-       I != E; ++I)
+       I != E; ++I) {
+    if (OnlyLiveOut && I->Dirty && !mayLiveOut(I->VirtReg)) {
+      DEBUG(dbgs() << "Not spilling block-local " << printReg(I->VirtReg, TRI)
+                   << '\n');
+      ++NumStoresAvoided;
+      killVirtReg(I);
+      continue;
+    }
     spillVirtReg(MI, I);
+  }
   LiveVirtRegs.clear();
   isBulkSpilling = false;
 }
@@ -1026,7 +1081,7 @@ void RegAllocFast::allocateBasicBlock(MachineBasicBlock &MBB) {
       // definitions may be used later on and we do not want to reuse
       // those for virtual registers in between.
       DEBUG(dbgs() << "  Spilling remaining registers before call.\n");
-      spillAll(MI);
+      spillAll(MI, /*OnlyLiveOut=*/false);
     }
 
     // Third scan.
@@ -1069,7 +1124,7 @@ void RegAllocFast::allocateBasicBlock(MachineBasicBlock &MBB) {
 
   // Spill all physical registers holding virtual registers now.
   DEBUG(dbgs() << "Spilling live registers at end of block.\n");
-  spillAll(MBB.getFirstTerminator());
+  spillAll(MBB.getFirstTerminator(), /*OnlyLiveOut=*/true);
 
   // Erase all the coalesced copies. We are delaying it until now because
   // LiveVirtRegs might refer to the instrs.
@@ -1099,6 +1154,8 @@ bool RegAllocFast::runOnMachineFunction(MachineFunction &MF) {
   unsigned NumVirtRegs = MRI->getNumVirtRegs();
   StackSlotForVirtReg.resize(NumVirtRegs);
   LiveVirtRegs.setUniverse(NumVirtRegs);
+  MayLiveAcrossBlocks.clear();
+  MayLiveAcrossBlocks.resize(NumVirtRegs);
 
   // Loop over all of the basic blocks, eliminating virtual register references
   for (MachineBasicBlock &MBB : MF)
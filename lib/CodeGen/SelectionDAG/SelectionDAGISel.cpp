@@ -2651,18 +2651,27 @@ CheckChildSame(const unsigned char *MatcherTable, unsigned &MatcherIndex,
                      RecordedNodes);
 }
 
-/// CheckPatternPredicate - Implements OP_CheckPatternPredicate.
+/// CheckPatternPredicate - Implements OP_CheckPatternPredicate and its
+/// OP_CheckPatternPredicateN forms, which encode the predicate in the opcode.
 LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
-CheckPatternPredicate(const unsigned char *MatcherTable, unsigned &MatcherIndex,
-                      const SelectionDAGISel &SDISel) {
-  return SDISel.CheckPatternPredicate(MatcherTable[MatcherIndex++]);
+CheckPatternPredicate(unsigned Opcode, const unsigned char *MatcherTable,
+                      unsigned &MatcherIndex, const SelectionDAGISel &SDISel) {
+  unsigned PredNo = Opcode == SelectionDAGISel::OPC_CheckPatternPredicate
+                        ? MatcherTable[MatcherIndex++]
+                        : Opcode - SelectionDAGISel::OPC_CheckPatternPredicate0;
+  return SDISel.CheckPatternPredicate(PredNo);
 }
 
-/// CheckNodePredicate - Implements OP_CheckNodePredicate.
+/// CheckNodePredicate - Implements OP_CheckNodePredicate and its
+/// OP_CheckPredicateN forms, which encode the predicate in the opcode.
 LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
-CheckNodePredicate(const unsigned char *MatcherTable, unsigned &MatcherIndex,
-                   const SelectionDAGISel &SDISel, SDNode *N) {
-  return SDISel.CheckNodePredicate(N, MatcherTable[MatcherIndex++]);
+CheckNodePredicate(unsigned Opcode, const unsigned char *MatcherTable,
+                   unsigned &MatcherIndex, const SelectionDAGISel &SDISel,
+                   SDNode *N) {
+  unsigned PredNo = Opcode == SelectionDAGISel::OPC_CheckPredicate
+                        ? MatcherTable[MatcherIndex++]
+                        : Opcode - SelectionDAGISel::OPC_CheckPredicate0;
+  return SDISel.CheckNodePredicate(N, PredNo);
 }
 
 LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
@@ -2674,23 +2683,35 @@ CheckOpcode(const unsigned char *MatcherTable, unsigned &MatcherIndex,
 }
 
 LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
-CheckType(const unsigned char *MatcherTable, unsigned &MatcherIndex, SDValue N,
-          const TargetLowering *TLI, const DataLayout &DL) {
-  MVT::SimpleValueType VT = (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+CheckType(MVT::SimpleValueType VT, SDValue N, const TargetLowering *TLI,
+          const DataLayout &DL) {
   if (N.getValueType() == VT) return true;
 
   // Handle the case when VT is iPTR.
   return VT == MVT::iPTR && N.getValueType() == TLI->getPointerTy(DL);
 }
 
+LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
+CheckType(const unsigned char *MatcherTable, unsigned &MatcherIndex, SDValue N,
+          const TargetLowering *TLI, const DataLayout &DL) {
+  MVT::SimpleValueType VT = (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+  return ::CheckType(VT, N, TLI, DL);
+}
+
+LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
+CheckChildType(MVT::SimpleValueType VT, SDValue N, const TargetLowering *TLI,
+               const DataLayout &DL, unsigned ChildNo) {
+  if (ChildNo >= N.getNumOperands())
+    return false;  // Match fails if out of range child #.
+  return ::CheckType(VT, N.getOperand(ChildNo), TLI, DL);
+}
+
 LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
 CheckChildType(const unsigned char *MatcherTable, unsigned &MatcherIndex,
                SDValue N, const TargetLowering *TLI, const DataLayout &DL,
                unsigned ChildNo) {
-  if (ChildNo >= N.getNumOperands())
-    return false;  // Match fails if out of range child #.
-  return ::CheckType(MatcherTable, MatcherIndex, N.getOperand(ChildNo), TLI,
-                     DL);
+  MVT::SimpleValueType VT = (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+  return ::CheckChildType(VT, N, TLI, DL, ChildNo);
 }
 
 LLVM_ATTRIBUTE_ALWAYS_INLINE static inline bool
@@ -2767,7 +2788,8 @@ static unsigned IsPredicateKnownToFail(const unsigned char *Table,
                                        bool &Result,
                                        const SelectionDAGISel &SDISel,
                   SmallVectorImpl<std::pair<SDValue, SDNode*>> &RecordedNodes) {
-  switch (Table[Index++]) {
+  unsigned Opcode = Table[Index++];
+  switch (Opcode) {
   default:
     Result = false;
     return Index-1;  // Could not evaluate this predicate.
@@ -2782,10 +2804,26 @@ static unsigned IsPredicateKnownToFail(const unsigned char *Table,
                         Table[Index-1] - SelectionDAGISel::OPC_CheckChild0Same);
     return Index;
   case SelectionDAGISel::OPC_CheckPatternPredicate:
-    Result = !::CheckPatternPredicate(Table, Index, SDISel);
+  case SelectionDAGISel::OPC_CheckPatternPredicate0:
+  case SelectionDAGISel::OPC_CheckPatternPredicate1:
+  case SelectionDAGISel::OPC_CheckPatternPredicate2:
+  case SelectionDAGISel::OPC_CheckPatternPredicate3:
+  case SelectionDAGISel::OPC_CheckPatternPredicate4:
+  case SelectionDAGISel::OPC_CheckPatternPredicate5:
+  case SelectionDAGISel::OPC_CheckPatternPredicate6:
+  case SelectionDAGISel::OPC_CheckPatternPredicate7:
+    Result = !::CheckPatternPredicate(Opcode, Table, Index, SDISel);
     return Index;
   case SelectionDAGISel::OPC_CheckPredicate:
-    Result = !::CheckNodePredicate(Table, Index, SDISel, N.getNode());
+  case SelectionDAGISel::OPC_CheckPredicate0:
+  case SelectionDAGISel::OPC_CheckPredicate1:
+  case SelectionDAGISel::OPC_CheckPredicate2:
+  case SelectionDAGISel::OPC_CheckPredicate3:
+  case SelectionDAGISel::OPC_CheckPredicate4:
+  case SelectionDAGISel::OPC_CheckPredicate5:
+  case SelectionDAGISel::OPC_CheckPredicate6:
+  case SelectionDAGISel::OPC_CheckPredicate7:
+    Result = !::CheckNodePredicate(Opcode, Table, Index, SDISel, N.getNode());
     return Index;
   case SelectionDAGISel::OPC_CheckOpcode:
     Result = !::CheckOpcode(Table, Index, N.getNode());
@@ -2794,6 +2832,13 @@ static unsigned IsPredicateKnownToFail(const unsigned char *Table,
     Result = !::CheckType(Table, Index, N, SDISel.TLI,
                           SDISel.CurDAG->getDataLayout());
     return Index;
+  case SelectionDAGISel::OPC_CheckTypeI32:
+  case SelectionDAGISel::OPC_CheckTypeI64: {
+    MVT::SimpleValueType VT =
+        Opcode == SelectionDAGISel::OPC_CheckTypeI32 ? MVT::i32 : MVT::i64;
+    Result = !::CheckType(VT, N, SDISel.TLI, SDISel.CurDAG->getDataLayout());
+    return Index;
+  }
   case SelectionDAGISel::OPC_CheckTypeRes: {
     unsigned Res = Table[Index++];
     Result = !::CheckType(Table, Index, N.getValue(Res), SDISel.TLI,
@@ -2810,7 +2855,31 @@ static unsigned IsPredicateKnownToFail(const unsigned char *Table,
   case SelectionDAGISel::OPC_CheckChild7Type:
     Result = !::CheckChildType(
                  Table, Index, N, SDISel.TLI, SDISel.CurDAG->getDataLayout(),
-                 Table[Index - 1] - SelectionDAGISel::OPC_CheckChild0Type);
+                 Opcode - SelectionDAGISel::OPC_CheckChild0Type);
+    return Index;
+  case SelectionDAGISel::OPC_CheckChild0TypeI32:
+  case SelectionDAGISel::OPC_CheckChild1TypeI32:
+  case SelectionDAGISel::OPC_CheckChild2TypeI32:
+  case SelectionDAGISel::OPC_CheckChild3TypeI32:
+  case SelectionDAGISel::OPC_CheckChild4TypeI32:
+  case SelectionDAGISel::OPC_CheckChild5TypeI32:
+  case SelectionDAGISel::OPC_CheckChild6TypeI32:
+  case SelectionDAGISel::OPC_CheckChild7TypeI32:
+    Result = !::CheckChildType(
+                 MVT::i32, N, SDISel.TLI, SDISel.CurDAG->getDataLayout(),
+                 Opcode - SelectionDAGISel::OPC_CheckChild0TypeI32);
+    return Index;
+  case SelectionDAGISel::OPC_CheckChild0TypeI64:
+  case SelectionDAGISel::OPC_CheckChild1TypeI64:
+  case SelectionDAGISel::OPC_CheckChild2TypeI64:
+  case SelectionDAGISel::OPC_CheckChild3TypeI64:
+  case SelectionDAGISel::OPC_CheckChild4TypeI64:
+  case SelectionDAGISel::OPC_CheckChild5TypeI64:
+  case SelectionDAGISel::OPC_CheckChild6TypeI64:
+  case SelectionDAGISel::OPC_CheckChild7TypeI64:
+    Result = !::CheckChildType(
+                 MVT::i64, N, SDISel.TLI, SDISel.CurDAG->getDataLayout(),
+                 Opcode - SelectionDAGISel::OPC_CheckChild0TypeI64);
     return Index;
   case SelectionDAGISel::OPC_CheckCondCode:
     Result = !::CheckCondCode(Table, Index, N);
@@ -3176,10 +3245,19 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
       continue;
 
     case OPC_CheckPatternPredicate:
-      if (!::CheckPatternPredicate(MatcherTable, MatcherIndex, *this)) break;
+    case OPC_CheckPatternPredicate0: case OPC_CheckPatternPredicate1:
+    case OPC_CheckPatternPredicate2: case OPC_CheckPatternPredicate3:
+    case OPC_CheckPatternPredicate4: case OPC_CheckPatternPredicate5:
+    case OPC_CheckPatternPredicate6: case OPC_CheckPatternPredicate7:
+      if (!::CheckPatternPredicate(Opcode, MatcherTable, MatcherIndex, *this))
+        break;
       continue;
     case OPC_CheckPredicate:
-      if (!::CheckNodePredicate(MatcherTable, MatcherIndex, *this,
+    case OPC_CheckPredicate0: case OPC_CheckPredicate1:
+    case OPC_CheckPredicate2: case OPC_CheckPredicate3:
+    case OPC_CheckPredicate4: case OPC_CheckPredicate5:
+    case OPC_CheckPredicate6: case OPC_CheckPredicate7:
+      if (!::CheckNodePredicate(Opcode, MatcherTable, MatcherIndex, *this,
                                 N.getNode()))
         break;
       continue;
@@ -3210,6 +3288,14 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
                        CurDAG->getDataLayout()))
         break;
       continue;
+    case OPC_CheckTypeI32:
+    case OPC_CheckTypeI64: {
+      MVT::SimpleValueType VT =
+          Opcode == OPC_CheckTypeI32 ? MVT::i32 : MVT::i64;
+      if (!::CheckType(VT, N, TLI, CurDAG->getDataLayout()))
+        break;
+      continue;
+    }
 
     case OPC_CheckTypeRes: {
       unsigned Res = MatcherTable[MatcherIndex++];
@@ -3290,6 +3376,22 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
                             Opcode - OPC_CheckChild0Type))
         break;
       continue;
+    case OPC_CheckChild0TypeI32: case OPC_CheckChild1TypeI32:
+    case OPC_CheckChild2TypeI32: case OPC_CheckChild3TypeI32:
+    case OPC_CheckChild4TypeI32: case OPC_CheckChild5TypeI32:
+    case OPC_CheckChild6TypeI32: case OPC_CheckChild7TypeI32:
+      if (!::CheckChildType(MVT::i32, N, TLI, CurDAG->getDataLayout(),
+                            Opcode - OPC_CheckChild0TypeI32))
+        break;
+      continue;
+    case OPC_CheckChild0TypeI64: case OPC_CheckChild1TypeI64:
+    case OPC_CheckChild2TypeI64: case OPC_CheckChild3TypeI64:
+    case OPC_CheckChild4TypeI64: case OPC_CheckChild5TypeI64:
+    case OPC_CheckChild6TypeI64: case OPC_CheckChild7TypeI64:
+      if (!::CheckChildType(MVT::i64, N, TLI, CurDAG->getDataLayout(),
+                            Opcode - OPC_CheckChild0TypeI64))
+        break;
+      continue;
     case OPC_CheckCondCode:
       if (!::CheckCondCode(MatcherTable, MatcherIndex, N)) break;
       continue;
@@ -3337,9 +3439,21 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
 
       continue;
     }
-    case OPC_EmitInteger: {
-      MVT::SimpleValueType VT =
-        (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+    case OPC_EmitInteger:
+    case OPC_EmitInteger8:
+    case OPC_EmitInteger16:
+    case OPC_EmitInteger32:
+    case OPC_EmitInteger64: {
+      MVT::SimpleValueType VT;
+      switch (Opcode) {
+      case OPC_EmitInteger8:  VT = MVT::i8;  break;
+      case OPC_EmitInteger16: VT = MVT::i16; break;
+      case OPC_EmitInteger32: VT = MVT::i32; break;
+      case OPC_EmitInteger64: VT = MVT::i64; break;
+      default:
+        VT = (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+        break;
+      }
       int64_t Val = MatcherTable[MatcherIndex++];
       if (Val & 128)
         Val = GetVBR(Val, MatcherTable, MatcherIndex);
@@ -3348,9 +3462,17 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
                                                         VT), nullptr));
       continue;
     }
-    case OPC_EmitRegister: {
-      MVT::SimpleValueType VT =
-        (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+    case OPC_EmitRegister:
+    case OPC_EmitRegisterI32:
+    case OPC_EmitRegisterI64: {
+      MVT::SimpleValueType VT;
+      switch (Opcode) {
+      case OPC_EmitRegisterI32: VT = MVT::i32; break;
+      case OPC_EmitRegisterI64: VT = MVT::i64; break;
+      default:
+        VT = (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
+        break;
+      }
       unsigned RegNo = MatcherTable[MatcherIndex++];
       RecordedNodes.push_back(std::pair<SDValue, SDNode*>(
                               CurDAG->getRegister(RegNo, VT), nullptr));
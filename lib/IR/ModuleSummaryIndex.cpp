@@ -69,3 +69,48 @@ bool ModuleSummaryIndex::isGUIDLive(GlobalValue::GUID GUID) const {
       return true;
   return false;
 }
+
+static void propagateAttributesToRefs(GlobalValueSummary *S) {
+  // A variable referenced other than through a read-only (resp. write-only)
+  // reference is not read-only (resp. write-only). References from variable
+  // initializers are never flagged, as they may take the address of the
+  // referenced variable.
+  for (auto &VI : S->refs())
+    for (auto &Ref : VI.getSummaryList())
+      if (auto *GVS = dyn_cast<GlobalVarSummary>(Ref->getBaseObject())) {
+        if (!VI.isReadOnly())
+          GVS->setReadOnly(false);
+        if (!VI.isWriteOnly())
+          GVS->setWriteOnly(false);
+      }
+}
+
+void ModuleSummaryIndex::propagateAttributes(
+    function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
+        isPrevailing,
+    const DenseSet<GlobalValue::GUID> &GUIDPreservedSymbols) {
+  for (auto &P : *this)
+    for (auto &S : P.second.SummaryList) {
+      // References from dead summaries don't matter.
+      if (!isGlobalValueLive(S.get()))
+        continue;
+      if (auto *GVS = dyn_cast<GlobalVarSummary>(S->getBaseObject()))
+        // Every module referencing the variable must be able to import a copy
+        // of it. The variable may also be accessed outside of the summary if
+        // it is preserved, interposable or reached through an alias. A copy
+        // that doesn't prevail may be replaced by a definition the summary
+        // doesn't describe, e.g. one from a native object.
+        if (GVS->notEligibleToImport() || !GVS->refs().empty() ||
+            GlobalValue::isInterposableLinkage(GVS->linkage()) ||
+            isa<AliasSummary>(S.get()) || GUIDPreservedSymbols.count(P.first) ||
+            (!GlobalValue::isLocalLinkage(S->linkage()) &&
+             !isPrevailing(P.first, S.get()))) {
+          GVS->setReadOnly(false);
+          GVS->setWriteOnly(false);
+        }
+      // An aliasee is not marked live by itself when only reached through its
+      // aliases, so the references are taken from the base object.
+      propagateAttributesToRefs(S->getBaseObject());
+    }
+  setWithAttributePropagation();
+}
@@ -201,6 +201,11 @@ static void computeCacheKey(
     GlobalValue::LinkageTypes Linkage = GS.second->linkage();
     Hasher.update(
         ArrayRef<uint8_t>((const uint8_t *)&Linkage, sizeof(Linkage)));
+    // Read-only and write-only variables are internalized after import.
+    if (auto *GVS = dyn_cast<GlobalVarSummary>(GS.second)) {
+      AddUnsigned(Index.isReadOnly(GVS));
+      AddUnsigned(Index.isWriteOnly(GVS));
+    }
     AddUsedCfiGlobal(GS.first);
     AddUsedThings(GS.second);
   }
@@ -417,6 +422,9 @@ void LTO::addModuleToGlobalRes(ArrayRef<InputFile::Symbol> Syms,
 
     auto &GlobalRes = GlobalResolutions[Sym.getName()];
     GlobalRes.UnnamedAddr &= Sym.isUnnamedAddr();
+    if (!Sym.getIRName().empty())
+      GlobalRes.GUID = GlobalValue::getGUID(
+          GlobalValue::dropLLVMManglingEscape(Sym.getIRName()));
     if (Res.Prevailing) {
       assert(GlobalRes.IRName.empty() &&
              "Multiple prevailing defs are not allowed");
@@ -745,19 +753,18 @@ Error LTO::run(AddStreamFn AddStream, NativeObjectCache Cache) {
   // Compute "dead" symbols, we don't want to import/export these!
   DenseSet<GlobalValue::GUID> GUIDPreservedSymbols;
   for (auto &Res : GlobalResolutions) {
-    if (Res.second.VisibleOutsideSummary &&
-        // IRName will be defined if we have seen the prevailing copy of
-        // this value. If not, no need to preserve any ThinLTO copies.
-        !Res.second.IRName.empty())
-      GUIDPreservedSymbols.insert(GlobalValue::getGUID(
-          GlobalValue::dropLLVMManglingEscape(Res.second.IRName)));
+    // Preserve the ThinLTO copies even if the prevailing definition is not in
+    // IR: they may still be referenced, and the variables written, through
+    // that definition.
+    if (Res.second.VisibleOutsideSummary && Res.second.GUID)
+      GUIDPreservedSymbols.insert(Res.second.GUID);
   }
 
   computeDeadSymbols(ThinLTO.CombinedIndex, GUIDPreservedSymbols);
 
   if (auto E = runRegularLTO(AddStream))
     return E;
-  return runThinLTO(AddStream, Cache);
+  return runThinLTO(AddStream, Cache, GUIDPreservedSymbols);
 }
 
 Error LTO::runRegularLTO(AddStreamFn AddStream) {
@@ -1072,7 +1079,8 @@ ThinBackend lto::createWriteIndexesThinBackend(std::string OldPrefix,
   };
 }
 
-Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
+Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
+                      const DenseSet<GlobalValue::GUID> &GUIDPreservedSymbols) {
   if (ThinLTO.ModuleMap.empty())
     return Error::success();
 
@@ -1102,9 +1110,22 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
       ThinLTO.ModuleMap.size());
   StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>> ResolvedODR;
 
-  if (Conf.OptLevel > 0)
+  auto isPrevailing = [&](GlobalValue::GUID GUID,
+                          const GlobalValueSummary *S) {
+    return ThinLTO.PrevailingModuleForGUID[GUID] == S->modulePath();
+  };
+
+  if (Conf.OptLevel > 0) {
+    // Find the variables that are only read or only written by the ThinLTO
+    // modules. Symbols visible outside of the summary may be accessed where
+    // the analysis can't see it, and the copies that don't prevail may be
+    // replaced by a definition the summary doesn't describe.
+    ThinLTO.CombinedIndex.propagateAttributes(isPrevailing,
+                                              GUIDPreservedSymbols);
+
     ComputeCrossModuleImport(ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
                              ImportLists, ExportLists);
+  }
 
   // Figure out which symbols need to be internalized. This also needs to happen
   // at -O0 because summary-based DCE is implemented using internalization, and
@@ -1115,13 +1136,11 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
     // First check if the symbol was flagged as having external references.
     if (Res.second.Partition != GlobalResolution::External)
       continue;
-    // IRName will be defined if we have seen the prevailing copy of
-    // this value. If not, no need to mark as exported from a ThinLTO
-    // partition (and we can't get the GUID).
-    if (Res.second.IRName.empty())
+    // Copies that don't prevail are exported too, so that they aren't
+    // internalized apart from the prevailing definition.
+    auto GUID = Res.second.GUID;
+    if (!GUID)
       continue;
-    auto GUID = GlobalValue::getGUID(
-        GlobalValue::dropLLVMManglingEscape(Res.second.IRName));
     // Mark exported unless index-based analysis determined it to be dead.
     if (ThinLTO.CombinedIndex.isGUIDLive(GUID))
       ExportedGUIDs.insert(GUID);
@@ -1141,10 +1160,6 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
   };
   thinLTOInternalizeAndPromoteInIndex(ThinLTO.CombinedIndex, isExported);
 
-  auto isPrevailing = [&](GlobalValue::GUID GUID,
-                          const GlobalValueSummary *S) {
-    return ThinLTO.PrevailingModuleForGUID[GUID] == S->modulePath();
-  };
   auto recordNewLinkage = [&](StringRef ModuleIdentifier,
                               GlobalValue::GUID GUID,
                               GlobalValue::LinkageTypes NewLinkage) {
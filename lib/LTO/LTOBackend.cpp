@@ -34,6 +34,7 @@
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/FunctionOrdering.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar/LoopPassManager.h"
 #include "llvm/Transforms/Utils/FunctionImportUtils.h"
@@ -131,6 +132,13 @@ createTargetMachine(Config &Conf, const Target *TheTarget, Module &M) {
       Conf.CodeModel, Conf.CGOptLevel));
 }
 
+// Only regular LTO sees the whole program and can write an ordering file.
+// ThinLTO backends are given no file, so that they never fall back to
+// -function-ordering-file and overwrite each other's output.
+static StringRef getFunctionOrderingFile(const Config &Conf, bool IsThinLTO) {
+  return IsThinLTO ? StringRef() : StringRef(Conf.FunctionOrderingFile);
+}
+
 static void runNewPMPasses(Config &Conf, Module &Mod, TargetMachine *TM,
                            unsigned OptLevel, bool IsThinLTO) {
   Optional<PGOOptions> PGOOpt;
@@ -185,6 +193,9 @@ static void runNewPMPasses(Config &Conf, Module &Mod, TargetMachine *TM,
     MPM = PB.buildThinLTODefaultPipeline(OL, Conf.DebugPassManager);
   else
     MPM = PB.buildLTODefaultPipeline(OL, Conf.DebugPassManager);
+  if (Conf.FunctionOrdering || !Conf.FunctionOrderingFile.empty())
+    MPM.addPass(FunctionOrderingPass(getFunctionOrderingFile(Conf, IsThinLTO),
+                                     Conf.FunctionOrderingFileSections));
   MPM.run(Mod, MAM);
 
   // FIXME (davide): verify the output.
@@ -256,6 +267,10 @@ static void runOldPMPasses(Config &Conf, Module &Mod, TargetMachine *TM,
     PMB.populateThinLTOPassManager(passes);
   else
     PMB.populateLTOPassManager(passes);
+  if (Conf.FunctionOrdering || !Conf.FunctionOrderingFile.empty())
+    passes.add(
+        createFunctionOrderingPass(getFunctionOrderingFile(Conf, IsThinLTO),
+                                   Conf.FunctionOrderingFileSections));
   passes.run(Mod);
 }
 
@@ -126,6 +126,25 @@ static void computePrevailingCopies(
   }
 }
 
+// Compute the read-only and write-only variables. Only the copy the linker
+// would pick can keep these attributes.
+static void propagateAttributes(
+    ModuleSummaryIndex &Index,
+    const DenseSet<GlobalValue::GUID> &GUIDPreservedSymbols) {
+  DenseMap<GlobalValue::GUID, const GlobalValueSummary *> PrevailingCopy;
+  computePrevailingCopies(Index, PrevailingCopy);
+
+  auto isPrevailing = [&](GlobalValue::GUID GUID, const GlobalValueSummary *S) {
+    const auto &Prevailing = PrevailingCopy.find(GUID);
+    // Not in map means that there was only one copy, which must be prevailing.
+    if (Prevailing == PrevailingCopy.end())
+      return true;
+    return Prevailing->second == S;
+  };
+
+  Index.propagateAttributes(isPrevailing, GUIDPreservedSymbols);
+}
+
 static StringMap<MemoryBufferRef>
 generateModuleMap(const std::vector<ThinLTOBuffer> &Modules) {
   StringMap<MemoryBufferRef> ModuleMap;
@@ -377,6 +396,19 @@ public:
             ArrayRef<uint8_t>((const uint8_t *)&Entry, sizeof(GlobalValue::GUID)));
     }
 
+    // Include the read-only and write-only variables, which are internalized
+    // after import.
+    for (auto &Entry : DefinedFunctions) {
+      auto *GVS = dyn_cast<GlobalVarSummary>(Entry.second);
+      if (!GVS)
+        continue;
+      uint8_t Flags[2] = {Index.isReadOnly(GVS), Index.isWriteOnly(GVS)};
+      Hasher.update(
+          ArrayRef<uint8_t>((const uint8_t *)&Entry.first,
+                            sizeof(GlobalValue::GUID)));
+      Hasher.update(ArrayRef<uint8_t>(Flags, 2));
+    }
+
     // This choice of file name allows the cache to be pruned (see pruneCache()
     // in include/llvm/Support/CachePruning.h).
     sys::path::append(EntryPath, CachePath,
@@ -627,6 +659,9 @@ void ThinLTOCodeGenerator::promote(Module &TheModule,
   // Compute "dead" symbols, we don't want to import/export these!
   computeDeadSymbols(Index, GUIDPreservedSymbols);
 
+  // Compute read-only and write-only variables.
+  propagateAttributes(Index, GUIDPreservedSymbols);
+
   // Generate import/export list
   StringMap<FunctionImporter::ImportMapTy> ImportLists(ModuleCount);
   StringMap<FunctionImporter::ExportSetTy> ExportLists(ModuleCount);
@@ -672,6 +707,9 @@ void ThinLTOCodeGenerator::crossModuleImport(Module &TheModule,
   // Compute "dead" symbols, we don't want to import/export these!
   computeDeadSymbols(Index, GUIDPreservedSymbols);
 
+  // Compute read-only and write-only variables.
+  propagateAttributes(Index, GUIDPreservedSymbols);
+
   // Generate import/export list
   StringMap<FunctionImporter::ImportMapTy> ImportLists(ModuleCount);
   StringMap<FunctionImporter::ExportSetTy> ExportLists(ModuleCount);
@@ -749,6 +787,9 @@ void ThinLTOCodeGenerator::internalize(Module &TheModule,
   // Compute "dead" symbols, we don't want to import/export these!
   computeDeadSymbols(Index, GUIDPreservedSymbols);
 
+  // Compute read-only and write-only variables.
+  propagateAttributes(Index, GUIDPreservedSymbols);
+
   // Generate import/export list
   StringMap<FunctionImporter::ImportMapTy> ImportLists(ModuleCount);
   StringMap<FunctionImporter::ExportSetTy> ExportLists(ModuleCount);
@@ -901,6 +942,9 @@ void ThinLTOCodeGenerator::run() {
   // Compute "dead" symbols, we don't want to import/export these!
   computeDeadSymbols(*Index, GUIDPreservedSymbols);
 
+  // Compute read-only and write-only variables.
+  propagateAttributes(*Index, GUIDPreservedSymbols);
+
   // Collect the import/export lists for all modules from the call-graph in the
   // combined index.
   StringMap<FunctionImporter::ImportMapTy> ImportLists(ModuleCount);
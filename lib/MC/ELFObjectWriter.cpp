@@ -38,12 +38,14 @@
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/SwapByteOrder.h"
@@ -63,6 +65,16 @@ using namespace llvm;
 #undef  DEBUG_TYPE
 #define DEBUG_TYPE "reloc-info"
 
+static cl::opt<bool> ParallelEmission(
+    "elf-parallel-emission", cl::Hidden, cl::init(false),
+    cl::desc("Sort the ELF symbol table and encode relocation sections and "
+             "the string table in parallel"));
+
+static cl::opt<unsigned> ParallelEmissionThreshold(
+    "elf-parallel-emission-threshold", cl::Hidden, cl::init(4096),
+    cl::desc("Minimum number of symbols or relocations for which "
+             "-elf-parallel-emission takes effect"));
+
 namespace {
 
 using SectionIndexMapTy = DenseMap<const MCSectionELF *, uint32_t>;
@@ -102,6 +114,9 @@ class ELFObjectWriter : public MCObjectWriter {
     const MCSymbolELF *Symbol;
     uint32_t SectionIndex;
     StringRef Name;
+    /// Position of the symbol in MCAssembler::symbols(), used to order symbols
+    /// with the same name.
+    unsigned Order;
 
     // Support lexicographic sorting.
     bool operator<(const ELFSymbolData &RHS) const {
@@ -113,7 +128,9 @@ class ELFObjectWriter : public MCObjectWriter {
         return true;
       if (LHSType == ELF::STT_SECTION && RHSType == ELF::STT_SECTION)
         return SectionIndex < RHS.SectionIndex;
-      return Name < RHS.Name;
+      if (int Cmp = Name.compare(RHS.Name))
+        return Cmp < 0;
+      return Order < RHS.Order;
     }
   };
 
@@ -184,13 +201,15 @@ public:
       write32(W);
   }
 
-  template <typename T> void write(T Val) {
+  template <typename T> void write(raw_ostream &OS, T Val) const {
     if (IsLittleEndian)
-      support::endian::Writer<support::little>(getStream()).write(Val);
+      support::endian::Writer<support::little>(OS).write(Val);
     else
-      support::endian::Writer<support::big>(getStream()).write(Val);
+      support::endian::Writer<support::big>(OS).write(Val);
   }
 
+  template <typename T> void write(T Val) { write(getStream(), Val); }
+
   void writeHeader(const MCAssembler &Asm);
 
   void writeSymbol(SymbolTableWriter &Writer, uint32_t StringIndex,
@@ -225,8 +244,6 @@ public:
   MCSectionELF *createRelocationSection(MCContext &Ctx,
                                         const MCSectionELF &Sec);
 
-  const MCSectionELF *createStringTable(MCContext &Ctx);
-
   void executePostLayoutBinding(MCAssembler &Asm,
                                 const MCAsmLayout &Layout) override;
 
@@ -242,7 +259,9 @@ public:
                         uint32_t Link, uint32_t Info, uint64_t Alignment,
                         uint64_t EntrySize);
 
-  void writeRelocations(const MCAssembler &Asm, const MCSectionELF &Sec);
+  /// Put the relocations of \p Sec in output order and return their number.
+  size_t sortRelocations(const MCAssembler &Asm, const MCSectionELF &Sec);
+  void writeRelocations(const MCSectionELF &Sec, raw_ostream &OS) const;
 
   using MCObjectWriter::isSymbolRefDifferenceFullyResolvedImpl;
   bool isSymbolRefDifferenceFullyResolvedImpl(const MCAssembler &Asm,
@@ -793,6 +812,7 @@ void ELFObjectWriter::computeSymbolTable(
 
   // Add the data for the symbols.
   bool HasLargeSectionIndex = false;
+  unsigned SymbolOrder = 0;
   for (const MCSymbol &S : Asm.symbols()) {
     const auto &Symbol = cast<MCSymbolELF>(S);
     bool Used = Symbol.isUsedInReloc();
@@ -810,6 +830,7 @@ void ELFObjectWriter::computeSymbolTable(
 
     ELFSymbolData MSD;
     MSD.Symbol = cast<MCSymbolELF>(&Symbol);
+    MSD.Order = SymbolOrder++;
 
     bool Local = Symbol.getBinding() == ELF::STB_LOCAL;
     assert(Local || !Symbol.isTemporary());
@@ -910,9 +931,18 @@ void ELFObjectWriter::computeSymbolTable(
                        ELF::STT_FILE | ELF::STB_LOCAL, 0, 0, ELF::STV_DEFAULT,
                        ELF::SHN_ABS, true);
 
-  // Symbols are required to be in lexicographic order.
-  array_pod_sort(LocalSymbolData.begin(), LocalSymbolData.end());
-  array_pod_sort(ExternalSymbolData.begin(), ExternalSymbolData.end());
+  // Symbols are required to be in lexicographic order. The order is total,
+  // so sorting in parallel gives the same result as sorting sequentially.
+  if (ParallelEmission && LocalSymbolData.size() + ExternalSymbolData.size() >=
+                              ParallelEmissionThreshold) {
+    parallel::sort(parallel::par, LocalSymbolData.begin(),
+                   LocalSymbolData.end());
+    parallel::sort(parallel::par, ExternalSymbolData.begin(),
+                   ExternalSymbolData.end());
+  } else {
+    array_pod_sort(LocalSymbolData.begin(), LocalSymbolData.end());
+    array_pod_sort(ExternalSymbolData.begin(), ExternalSymbolData.end());
+  }
 
   // Set the symbol indices. Local symbols must come before all other
   // symbols with non-local bindings.
@@ -1090,8 +1120,8 @@ void ELFObjectWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type,
   WriteWord(EntrySize); // sh_entsize
 }
 
-void ELFObjectWriter::writeRelocations(const MCAssembler &Asm,
-                                       const MCSectionELF &Sec) {
+size_t ELFObjectWriter::sortRelocations(const MCAssembler &Asm,
+                                        const MCSectionELF &Sec) {
   std::vector<ELFRelocationEntry> &Relocs = Relocations[&Sec];
 
   // We record relocations by pushing to the end of a vector. Reverse the vector
@@ -1102,63 +1132,66 @@ void ELFObjectWriter::writeRelocations(const MCAssembler &Asm,
 
   // Sort the relocation entries. MIPS needs this.
   TargetObjectWriter->sortRelocs(Asm, Relocs);
+  return Relocs.size();
+}
+
+void ELFObjectWriter::writeRelocations(const MCSectionELF &Sec,
+                                       raw_ostream &OS) const {
+  // This may run concurrently for different sections, so it must not modify
+  // the relocation lists; sortRelocations has already put them in order.
+  const std::vector<ELFRelocationEntry> &Relocs =
+      Relocations.find(&Sec)->second;
 
   for (unsigned i = 0, e = Relocs.size(); i != e; ++i) {
     const ELFRelocationEntry &Entry = Relocs[e - i - 1];
     unsigned Index = Entry.Symbol ? Entry.Symbol->getIndex() : 0;
 
     if (is64Bit()) {
-      write(Entry.Offset);
+      write(OS, Entry.Offset);
       if (TargetObjectWriter->getEMachine() == ELF::EM_MIPS) {
-        write(uint32_t(Index));
+        write(OS, uint32_t(Index));
 
-        write(TargetObjectWriter->getRSsym(Entry.Type));
-        write(TargetObjectWriter->getRType3(Entry.Type));
-        write(TargetObjectWriter->getRType2(Entry.Type));
-        write(TargetObjectWriter->getRType(Entry.Type));
+        write(OS, TargetObjectWriter->getRSsym(Entry.Type));
+        write(OS, TargetObjectWriter->getRType3(Entry.Type));
+        write(OS, TargetObjectWriter->getRType2(Entry.Type));
+        write(OS, TargetObjectWriter->getRType(Entry.Type));
       } else {
         struct ELF::Elf64_Rela ERE64;
         ERE64.setSymbolAndType(Index, Entry.Type);
-        write(ERE64.r_info);
+        write(OS, ERE64.r_info);
       }
       if (hasRelocationAddend())
-        write(Entry.Addend);
+        write(OS, Entry.Addend);
     } else {
-      write(uint32_t(Entry.Offset));
+      write(OS, uint32_t(Entry.Offset));
 
       struct ELF::Elf32_Rela ERE32;
       ERE32.setSymbolAndType(Index, Entry.Type);
-      write(ERE32.r_info);
+      write(OS, ERE32.r_info);
 
       if (hasRelocationAddend())
-        write(uint32_t(Entry.Addend));
+        write(OS, uint32_t(Entry.Addend));
 
       if (TargetObjectWriter->getEMachine() == ELF::EM_MIPS) {
         if (uint32_t RType = TargetObjectWriter->getRType2(Entry.Type)) {
-          write(uint32_t(Entry.Offset));
+          write(OS, uint32_t(Entry.Offset));
 
           ERE32.setSymbolAndType(0, RType);
-          write(ERE32.r_info);
-          write(uint32_t(0));
+          write(OS, ERE32.r_info);
+          write(OS, uint32_t(0));
         }
         if (uint32_t RType = TargetObjectWriter->getRType3(Entry.Type)) {
-          write(uint32_t(Entry.Offset));
+          write(OS, uint32_t(Entry.Offset));
 
           ERE32.setSymbolAndType(0, RType);
-          write(ERE32.r_info);
-          write(uint32_t(0));
+          write(OS, ERE32.r_info);
+          write(OS, uint32_t(0));
         }
       }
     }
   }
 }
 
-const MCSectionELF *ELFObjectWriter::createStringTable(MCContext &Ctx) {
-  const MCSectionELF *StrtabSection = SectionTable[StringTableIndex - 1];
-  StrTabBuilder.write(getStream());
-  return StrtabSection;
-}
-
 void ELFObjectWriter::writeSection(const SectionIndexMapTy &SectionIndexMap,
                                    uint32_t GroupSymbolIndex, uint64_t Offset,
                                    uint64_t Size, const MCSectionELF &Section) {
@@ -1320,14 +1353,47 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
   // Compute symbol table information.
   computeSymbolTable(Asm, Layout, SectionIndexMap, RevGroupMap, SectionOffsets);
 
-  for (MCSectionELF *RelSection : Relocations) {
+  size_t NumRelocations = 0;
+  for (MCSectionELF *RelSection : Relocations)
+    NumRelocations += sortRelocations(
+        Asm, cast<MCSectionELF>(*RelSection->getAssociatedSection()));
+
+  // Once the symbol indices are known and the relocation lists are sorted, the
+  // relocation sections and the string table are independent of each other.
+  // For large objects, encode them concurrently into buffers, then write them
+  // out in order. Otherwise stream them directly.
+  bool EncodeInParallel =
+      ParallelEmission && NumRelocations >= ParallelEmissionThreshold;
+  std::vector<SmallString<0>> Contents;
+  if (EncodeInParallel) {
+    // The last buffer holds the string table.
+    Contents.resize(Relocations.size() + 1);
+    parallel::for_each_n(parallel::par, size_t(0), Contents.size(),
+                         [&](size_t I) {
+                           raw_svector_ostream OS(Contents[I]);
+                           if (I == Relocations.size())
+                             StrTabBuilder.write(OS);
+                           else
+                             writeRelocations(
+                                 cast<MCSectionELF>(
+                                     *Relocations[I]->getAssociatedSection()),
+                                 OS);
+                         });
+  }
+
+  for (size_t I = 0, E = Relocations.size(); I != E; ++I) {
+    MCSectionELF *RelSection = Relocations[I];
     align(RelSection->getAlignment());
 
     // Remember the offset into the file for this section.
     uint64_t SecStart = getStream().tell();
 
-    writeRelocations(Asm,
-                     cast<MCSectionELF>(*RelSection->getAssociatedSection()));
+    if (EncodeInParallel)
+      getStream() << Contents[I];
+    else
+      writeRelocations(
+          cast<MCSectionELF>(*RelSection->getAssociatedSection()),
+          getStream());
 
     uint64_t SecEnd = getStream().tell();
     SectionOffsets[RelSection] = std::make_pair(SecStart, SecEnd);
@@ -1335,7 +1401,11 @@ void ELFObjectWriter::writeObject(MCAssembler &Asm,
 
   {
     uint64_t SecStart = getStream().tell();
-    const MCSectionELF *Sec = createStringTable(Ctx);
+    const MCSectionELF *Sec = SectionTable[StringTableIndex - 1];
+    if (EncodeInParallel)
+      getStream() << Contents.back();
+    else
+      StrTabBuilder.write(getStream());
     uint64_t SecEnd = getStream().tell();
     SectionOffsets[Sec] = std::make_pair(SecStart, SecEnd);
   }
@@ -68,6 +68,9 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxedFragments, "Number of relaxed fragments");
+STATISTIC(MaxFragmentsRelaxedPerStep,
+          "Maximum number of fragments relaxed in a layout step");
 STATISTIC(PaddingFragmentsRelaxations,
           "Number of Padding Fragments relaxations");
 STATISTIC(PaddingFragmentsBytes,
@@ -698,7 +701,7 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
     // Create dummy fragments to eliminate any empty sections, this simplifies
     // layout.
     if (Sec.getFragmentList().empty())
-      new MCDataFragment(&Sec);
+      getContext().createFragment<MCDataFragment>(&Sec);
 
     Sec.setOrdinal(SectionIndex++);
   }
@@ -713,8 +716,20 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
       Frag.setLayoutOrder(FragmentIndex++);
   }
 
+  // Collect the fragments which may change size during relaxation. Sections
+  // without any of them keep their layout and are not revisited.
+  SmallVector<RelaxationCandidates, 16> Candidates;
+  for (MCSection &Sec : *this) {
+    RelaxationCandidates C = {&Sec, {}};
+    for (MCFragment &Frag : Sec)
+      if (mayRelaxFragment(Frag))
+        C.Fragments.push_back(&Frag);
+    if (!C.Fragments.empty())
+      Candidates.push_back(std::move(C));
+  }
+
   // Layout until everything fits.
-  while (layoutOnce(Layout))
+  while (layoutOnce(Layout, Candidates))
     if (getContext().hadError())
       return;
 
@@ -922,69 +937,92 @@ bool MCAssembler::relaxCVDefRange(MCAsmLayout &Layout,
   return OldSize != F.getContents().size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
+bool MCAssembler::mayRelaxFragment(const MCFragment &F) const {
+  switch (F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    assert(!getRelaxAll() &&
+           "Did not expect a MCRelaxableFragment in RelaxAll mode");
+    return getBackend().mayNeedRelaxation(
+        cast<MCRelaxableFragment>(F).getInst());
+  case MCFragment::FT_Dwarf:
+  case MCFragment::FT_DwarfFrame:
+  case MCFragment::FT_LEB:
+  case MCFragment::FT_Padding:
+  case MCFragment::FT_CVInlineLines:
+  case MCFragment::FT_CVDefRange:
+    return true;
+  }
+}
+
+bool MCAssembler::relaxFragment(MCAsmLayout &Layout, MCFragment &F) {
+  switch(F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    return relaxInstruction(Layout, cast<MCRelaxableFragment>(F));
+  case MCFragment::FT_Dwarf:
+    return relaxDwarfLineAddr(Layout, cast<MCDwarfLineAddrFragment>(F));
+  case MCFragment::FT_DwarfFrame:
+    return relaxDwarfCallFrameFragment(Layout,
+                                       cast<MCDwarfCallFrameFragment>(F));
+  case MCFragment::FT_LEB:
+    return relaxLEB(Layout, cast<MCLEBFragment>(F));
+  case MCFragment::FT_Padding:
+    return relaxPaddingFragment(Layout, cast<MCPaddingFragment>(F));
+  case MCFragment::FT_CVInlineLines:
+    return relaxCVInlineLineTable(Layout, cast<MCCVInlineLineTableFragment>(F));
+  case MCFragment::FT_CVDefRange:
+    return relaxCVDefRange(Layout, cast<MCCVDefRangeFragment>(F));
+  }
+}
+
+unsigned MCAssembler::layoutSectionOnce(MCAsmLayout &Layout,
+                                        RelaxationCandidates &C) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = nullptr;
-
-  // Attempt to relax all the fragments in the section.
-  for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
-    bool RelaxedFrag = false;
-    switch(I->getKind()) {
-    default:
-      break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
-    case MCFragment::FT_Dwarf:
-      RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
-      break;
-    case MCFragment::FT_DwarfFrame:
-      RelaxedFrag =
-        relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
-      break;
-    case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
-      break;
-    case MCFragment::FT_Padding:
-      RelaxedFrag = relaxPaddingFragment(Layout, *cast<MCPaddingFragment>(I));
-      break;
-    case MCFragment::FT_CVInlineLines:
-      RelaxedFrag =
-          relaxCVInlineLineTable(Layout, *cast<MCCVInlineLineTableFragment>(I));
-      break;
-    case MCFragment::FT_CVDefRange:
-      RelaxedFrag = relaxCVDefRange(Layout, *cast<MCCVDefRangeFragment>(I));
-      break;
-    }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = &*I;
-  }
-  if (FirstRelaxedFragment) {
-    Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
-    return true;
+  unsigned NumRelaxed = 0;
+
+  // Attempt to relax all the candidate fragments in the section. Fragments
+  // that can never change size are not visited at all.
+  for (MCFragment *F : C.Fragments) {
+    if (!relaxFragment(Layout, *F))
+      continue;
+    ++NumRelaxed;
+    if (!FirstRelaxedFragment)
+      FirstRelaxedFragment = F;
   }
-  return false;
+  if (!FirstRelaxedFragment)
+    return 0;
+
+  Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
+
+  // An instruction relaxed to a form which never needs relaxation is final.
+  C.Fragments.erase(remove_if(C.Fragments,
+                              [&](const MCFragment *F) {
+                                return !mayRelaxFragment(*F);
+                              }),
+                    C.Fragments.end());
+  return NumRelaxed;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             MutableArrayRef<RelaxationCandidates> Candidates) {
   ++stats::RelaxationSteps;
 
-  bool WasRelaxed = false;
-  for (iterator it = begin(), ie = end(); it != ie; ++it) {
-    MCSection &Sec = *it;
-    while (layoutSectionOnce(Layout, Sec))
-      WasRelaxed = true;
-  }
+  unsigned NumRelaxed = 0;
+  for (RelaxationCandidates &C : Candidates)
+    while (unsigned N = layoutSectionOnce(Layout, C))
+      NumRelaxed += N;
 
-  return WasRelaxed;
+  DEBUG(dbgs() << "Layout step relaxed " << NumRelaxed << " fragments\n");
+  stats::RelaxedFragments += NumRelaxed;
+  stats::MaxFragmentsRelaxedPerStep.updateMax(NumRelaxed);
+  return NumRelaxed != 0;
 }
 
 void MCAssembler::finishLayout(MCAsmLayout &Layout) {
@@ -70,6 +70,10 @@ MCContext::MCContext(const MCAsmInfo *mai, const MCRegisterInfo *mri,
 MCContext::~MCContext() {
   if (AutoReset)
     reset();
+  else
+    // Fragments owned by the CodeView context live in Allocator, which is
+    // destroyed first.
+    CVContext.reset();
 
   // NOTE: The symbols are all allocated out of a bump pointer allocator,
   // we don't need to free them here.
@@ -84,8 +88,12 @@ void MCContext::reset() {
   COFFAllocator.DestroyAll();
   ELFAllocator.DestroyAll();
   MachOAllocator.DestroyAll();
+  WasmAllocator.DestroyAll();
 
   MCSubtargetAllocator.DestroyAll();
+  // The CodeView context may hold a fragment that was never inserted into a
+  // section, so destroy it before releasing the memory of all fragments.
+  CVContext.reset();
   UsedNames.clear();
   Symbols.clear();
   Allocator.Reset();
@@ -99,8 +107,6 @@ void MCContext::reset() {
   DwarfCompileUnitID = 0;
   CurrentDwarfLoc = MCDwarfLoc(0, 0, 0, DWARF2_FLAG_IS_STMT, 0, 0);
 
-  CVContext.reset();
-
   MachOUniquingMap.clear();
   ELFUniquingMap.clear();
   COFFUniquingMap.clear();
@@ -339,7 +345,7 @@ MCSectionELF *MCContext::createELFSectionImpl(StringRef Section, unsigned Type,
   auto *Ret = new (ELFAllocator.Allocate()) MCSectionELF(
       Section, Type, Flags, K, EntrySize, Group, UniqueID, R, Associated);
 
-  auto *F = new MCDataFragment();
+  auto *F = createFragment<MCDataFragment>();
   Ret->getFragmentList().insert(Ret->begin(), F);
   F->setParent(Ret);
   R->setFragment(F);
@@ -559,7 +565,7 @@ void MCContext::finalizeDwarfSections(MCStreamer &MCOS) {
 
 CodeViewContext &MCContext::getCVContext() {
   if (!CVContext.get())
-    CVContext.reset(new CodeViewContext);
+    CVContext.reset(new CodeViewContext(*this));
   return *CVContext.get();
 }
 
@@ -504,7 +504,7 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst,
       // When not in a bundle-locked group and the -mc-relax-all flag is used,
       // we create a new temporary fragment which will be later merged into
       // the current fragment.
-      DF = new MCDataFragment();
+      DF = getContext().createFragment<MCDataFragment>();
     else if (isBundleLocked() && !Sec.isBundleGroupBeforeFirstInst())
       // If we are bundle-locked, we re-use the current fragment.
       // The bundle-locking directive ensures this is a new data fragment.
@@ -513,12 +513,13 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst,
       // Optimize memory usage by emitting the instruction to a
       // MCCompactEncodedInstFragment when not in a bundle-locked group and
       // there are no fixups registered.
-      MCCompactEncodedInstFragment *CEIF = new MCCompactEncodedInstFragment();
+      MCCompactEncodedInstFragment *CEIF =
+          getContext().createFragment<MCCompactEncodedInstFragment>();
       insert(CEIF);
       CEIF->getContents().append(Code.begin(), Code.end());
       return;
     } else {
-      DF = new MCDataFragment();
+      DF = getContext().createFragment<MCDataFragment>();
       insert(DF);
     }
     if (Sec.getBundleLockState() == MCSection::BundleLockedAlignToEnd) {
@@ -547,7 +548,7 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst,
   if (Assembler.isBundlingEnabled() && Assembler.getRelaxAll()) {
     if (!isBundleLocked()) {
       mergeFragment(getOrCreateDataFragment(), DF);
-      delete DF;
+      DF->destroy();
     }
   }
 }
@@ -575,7 +576,7 @@ void MCELFStreamer::EmitBundleLock(bool AlignToEnd) {
 
   if (getAssembler().getRelaxAll() && !isBundleLocked()) {
     // TODO: drop the lock state and set directly in the fragment
-    MCDataFragment *DF = new MCDataFragment();
+    MCDataFragment *DF = getContext().createFragment<MCDataFragment>();
     BundleGroups.push_back(DF);
   }
 
@@ -608,7 +609,7 @@ void MCELFStreamer::EmitBundleUnlock() {
     if (!isBundleLocked()) {
       mergeFragment(getOrCreateDataFragment(), DF);
       BundleGroups.pop_back();
-      delete DF;
+      DF->destroy();
     }
 
     if (Sec.getBundleLockState() != MCSection::BundleLockedAlignToEnd)
@@ -39,7 +39,7 @@ void MCObjectStreamer::flushPendingLabels(MCFragment *F, uint64_t FOffset) {
   if (PendingLabels.empty())
     return;
   if (!F) {
-    F = new MCDataFragment();
+    F = getContext().createFragment<MCDataFragment>();
     MCSection *CurSection = getCurrentSectionOnly();
     CurSection->getFragmentList().insert(CurInsertionPoint, F);
     F->setParent(CurSection);
@@ -100,7 +100,7 @@ MCDataFragment *MCObjectStreamer::getOrCreateDataFragment() {
   // already has instructions (see MCELFStreamer::EmitInstToData for details)
   if (!F || (Assembler->isBundlingEnabled() && !Assembler->getRelaxAll() &&
              F->hasInstructions())) {
-    F = new MCDataFragment();
+    F = getContext().createFragment<MCDataFragment>();
     insert(F);
   }
   return F;
@@ -110,7 +110,7 @@ MCPaddingFragment *MCObjectStreamer::getOrCreatePaddingFragment() {
   MCPaddingFragment *F =
       dyn_cast_or_null<MCPaddingFragment>(getCurrentFragment());
   if (!F) {
-    F = new MCPaddingFragment();
+    F = getContext().createFragment<MCPaddingFragment>();
     insert(F);
   }
   return F;
@@ -203,7 +203,7 @@ void MCObjectStreamer::EmitULEB128Value(const MCExpr *Value) {
     EmitULEB128IntValue(IntValue);
     return;
   }
-  insert(new MCLEBFragment(*Value, false));
+  insert(getContext().createFragment<MCLEBFragment>(*Value, false));
 }
 
 void MCObjectStreamer::EmitSLEB128Value(const MCExpr *Value) {
@@ -212,7 +212,7 @@ void MCObjectStreamer::EmitSLEB128Value(const MCExpr *Value) {
     EmitSLEB128IntValue(IntValue);
     return;
   }
-  insert(new MCLEBFragment(*Value, true));
+  insert(getContext().createFragment<MCLEBFragment>(*Value, true));
 }
 
 void MCObjectStreamer::EmitWeakReference(MCSymbol *Alias,
@@ -240,7 +240,8 @@ bool MCObjectStreamer::changeSectionImpl(MCSection *Section,
   if (IntSubsection < 0 || IntSubsection > 8192)
     report_fatal_error("Subsection number out of range");
   CurInsertionPoint =
-      Section->getSubsectionInsertionPoint(unsigned(IntSubsection));
+      Section->getSubsectionInsertionPoint(unsigned(IntSubsection),
+                                          getContext());
   return Created;
 }
 
@@ -305,7 +306,8 @@ void MCObjectStreamer::EmitInstToFragment(const MCInst &Inst,
 
   // Always create a new, separate fragment here, because its size can change
   // during relaxation.
-  MCRelaxableFragment *IF = new MCRelaxableFragment(Inst, STI);
+  MCRelaxableFragment *IF =
+      getContext().createFragment<MCRelaxableFragment>(Inst, STI);
   insert(IF);
 
   SmallString<128> Code;
@@ -386,7 +388,8 @@ void MCObjectStreamer::EmitDwarfAdvanceLineAddr(int64_t LineDelta,
                           Res);
     return;
   }
-  insert(new MCDwarfLineAddrFragment(LineDelta, *AddrDelta));
+  insert(getContext().createFragment<MCDwarfLineAddrFragment>(LineDelta,
+                                                             *AddrDelta));
 }
 
 void MCObjectStreamer::EmitDwarfAdvanceFrameAddr(const MCSymbol *LastLabel,
@@ -397,7 +400,7 @@ void MCObjectStreamer::EmitDwarfAdvanceFrameAddr(const MCSymbol *LastLabel,
     MCDwarfFrameEmitter::EmitAdvanceLoc(*this, Res);
     return;
   }
-  insert(new MCDwarfCallFrameFragment(*AddrDelta));
+  insert(getContext().createFragment<MCDwarfCallFrameFragment>(*AddrDelta));
 }
 
 void MCObjectStreamer::EmitCVLocDirective(unsigned FunctionId, unsigned FileNo,
@@ -462,7 +465,8 @@ void MCObjectStreamer::EmitValueToAlignment(unsigned ByteAlignment,
                                             unsigned MaxBytesToEmit) {
   if (MaxBytesToEmit == 0)
     MaxBytesToEmit = ByteAlignment;
-  insert(new MCAlignFragment(ByteAlignment, Value, ValueSize, MaxBytesToEmit));
+  insert(getContext().createFragment<MCAlignFragment>(
+      ByteAlignment, Value, ValueSize, MaxBytesToEmit));
 
   // Update the maximum alignment on the current section if necessary.
   MCSection *CurSec = getCurrentSectionOnly();
@@ -479,7 +483,7 @@ void MCObjectStreamer::EmitCodeAlignment(unsigned ByteAlignment,
 void MCObjectStreamer::emitValueToOffset(const MCExpr *Offset,
                                          unsigned char Value,
                                          SMLoc Loc) {
-  insert(new MCOrgFragment(*Offset, Value, Loc));
+  insert(getContext().createFragment<MCOrgFragment>(*Offset, Value, Loc));
 }
 
 void MCObjectStreamer::EmitCodePaddingBasicBlockStart(
@@ -583,7 +587,7 @@ void MCObjectStreamer::emitFill(const MCExpr &NumBytes, uint64_t FillValue,
   flushPendingLabels(DF, DF->getContents().size());
 
   assert(getCurrentSectionOnly() && "need a section");
-  insert(new MCFillFragment(FillValue, NumBytes, Loc));
+  insert(getContext().createFragment<MCFillFragment>(FillValue, NumBytes, Loc));
 }
 
 void MCObjectStreamer::emitFill(const MCExpr &NumValues, int64_t Size,
@@ -54,7 +54,7 @@ void MCSection::setBundleLockState(BundleLockStateType NewState) {
 }
 
 MCSection::iterator
-MCSection::getSubsectionInsertionPoint(unsigned Subsection) {
+MCSection::getSubsectionInsertionPoint(unsigned Subsection, MCContext &Ctx) {
   if (Subsection == 0 && SubsectionFragmentMap.empty())
     return end();
 
@@ -76,7 +76,7 @@ MCSection::getSubsectionInsertionPoint(unsigned Subsection) {
   if (!ExactMatch && Subsection != 0) {
     // The GNU as documentation claims that subsections have an alignment of 4,
     // although this appears not to be the case.
-    MCFragment *F = new MCDataFragment();
+    MCFragment *F = Ctx.createFragment<MCDataFragment>();
     SubsectionFragmentMap.insert(MI, std::make_pair(Subsection, F));
     getFragmentList().insert(IP, F);
     F->setParent(this);
@@ -12,8 +12,10 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/BinaryFormat/COFF.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <cstddef>
@@ -24,6 +26,10 @@
 
 using namespace llvm;
 
+static cl::opt<bool> ParallelTailMerging(
+    "strtab-parallel-tail-merging", cl::Hidden, cl::init(false),
+    cl::desc("Sort large string tables for tail merging in parallel"));
+
 StringTableBuilder::~StringTableBuilder() = default;
 
 void StringTableBuilder::initSize() {
@@ -80,19 +86,14 @@ static int charTailAt(StringPair *P, size_t Pos) {
   return (unsigned char)S[S.size() - Pos - 1];
 }
 
-// Three-way radix quicksort. This is much faster than std::sort with strcmp
-// because it does not compare characters that we already know the same.
-static void multikeySort(MutableArrayRef<StringPair *> Vec, int Pos) {
-tailcall:
-  if (Vec.size() <= 1)
-    return;
-
-  // Partition items so that items in [0, I) are greater than the pivot,
-  // [I, J) are the same as the pivot, and [J, Vec.size()) are less than
-  // the pivot.
+// Partition items so that items in [0, I) are greater than the pivot,
+// [I, J) are the same as the pivot, and [J, Vec.size()) are less than
+// the pivot. Returns the pivot character.
+static int partition(MutableArrayRef<StringPair *> Vec, int Pos, size_t &I,
+                     size_t &J) {
   int Pivot = charTailAt(Vec[0], Pos);
-  size_t I = 0;
-  size_t J = Vec.size();
+  I = 0;
+  J = Vec.size();
   for (size_t K = 1; K < J;) {
     int C = charTailAt(Vec[K], Pos);
     if (C > Pivot)
@@ -102,6 +103,18 @@ tailcall:
     else
       K++;
   }
+  return Pivot;
+}
+
+// Three-way radix quicksort. This is much faster than std::sort with strcmp
+// because it does not compare characters that we already know the same.
+static void multikeySort(MutableArrayRef<StringPair *> Vec, int Pos) {
+tailcall:
+  if (Vec.size() <= 1)
+    return;
+
+  size_t I, J;
+  int Pivot = partition(Vec, Pos, I, J);
 
   multikeySort(Vec.slice(0, I), Pos);
   multikeySort(Vec.slice(J), Pos);
@@ -115,6 +128,53 @@ tailcall:
   }
 }
 
+// Slices with fewer strings than this are not split any further for the
+// parallel sort.
+static const size_t MinParallelSortSize = 1024;
+
+namespace {
+struct SortSlice {
+  MutableArrayRef<StringPair *> Vec;
+  int Pos;
+};
+} // end anonymous namespace
+
+// Run the top levels of multikeySort, collecting the slices that are left to
+// sort. The slices are disjoint and are each sorted independently of the
+// others.
+static void splitForParallelSort(MutableArrayRef<StringPair *> Vec, int Pos,
+                                 unsigned Depth,
+                                 std::vector<SortSlice> &Slices) {
+  if (Vec.size() <= 1)
+    return;
+  if (Vec.size() < MinParallelSortSize || Depth == 0) {
+    Slices.push_back({Vec, Pos});
+    return;
+  }
+
+  size_t I, J;
+  int Pivot = partition(Vec, Pos, I, J);
+
+  splitForParallelSort(Vec.slice(0, I), Pos, Depth - 1, Slices);
+  splitForParallelSort(Vec.slice(J), Pos, Depth - 1, Slices);
+  if (Pivot != -1)
+    splitForParallelSort(Vec.slice(I, J - I), Pos + 1, Depth - 1, Slices);
+}
+
+static void sortForTailMerging(MutableArrayRef<StringPair *> Vec) {
+  if (!ParallelTailMerging || Vec.size() < MinParallelSortSize) {
+    multikeySort(Vec, 0);
+    return;
+  }
+
+  // The partitioning does not depend on scheduling, so the result is
+  // identical to the sequential sort.
+  std::vector<SortSlice> Slices;
+  splitForParallelSort(Vec, 0, Log2_64(Vec.size()) + 1, Slices);
+  parallel::for_each(parallel::par, Slices.begin(), Slices.end(),
+                     [](const SortSlice &S) { multikeySort(S.Vec, S.Pos); });
+}
+
 void StringTableBuilder::finalize() {
   finalizeStringTable(/*Optimize=*/true);
 }
@@ -132,7 +192,7 @@ void StringTableBuilder::finalizeStringTable(bool Optimize) {
     for (StringPair &P : StringIndexMap)
       Strings.push_back(&P);
 
-    multikeySort(Strings, 0);
+    sortForTailMerging(Strings);
     initSize();
 
     StringRef Previous;
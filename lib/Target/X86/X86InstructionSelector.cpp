@@ -81,8 +81,9 @@ private:
                          MachineFunction &MF) const;
   bool selectConstant(MachineInstr &I, MachineRegisterInfo &MRI,
                       MachineFunction &MF) const;
-  bool selectTrunc(MachineInstr &I, MachineRegisterInfo &MRI,
-                   MachineFunction &MF) const;
+  bool selectTruncOrPtrCast(MachineInstr &I, MachineRegisterInfo &MRI,
+                            MachineFunction &MF) const;
+  bool selectBitcast(MachineInstr &I, MachineRegisterInfo &MRI) const;
   bool selectZext(MachineInstr &I, MachineRegisterInfo &MRI,
                   MachineFunction &MF) const;
   bool selectAnyext(MachineInstr &I, MachineRegisterInfo &MRI,
@@ -91,6 +92,14 @@ private:
                  MachineFunction &MF) const;
   bool selectUadde(MachineInstr &I, MachineRegisterInfo &MRI,
                    MachineFunction &MF) const;
+  bool selectShift(MachineInstr &I, MachineRegisterInfo &MRI,
+                   MachineFunction &MF) const;
+  bool selectSignExtendShifts(MachineInstr &I, MachineRegisterInfo &MRI,
+                              MachineFunction &MF) const;
+  bool selectDivRem(MachineInstr &I, MachineRegisterInfo &MRI,
+                    MachineFunction &MF) const;
+  bool selectSelect(MachineInstr &I, MachineRegisterInfo &MRI,
+                    MachineFunction &MF) const;
   bool selectCopy(MachineInstr &I, MachineRegisterInfo &MRI) const;
   bool selectUnmergeValues(MachineInstr &I, MachineRegisterInfo &MRI,
                            MachineFunction &MF,
@@ -342,8 +351,12 @@ bool X86InstructionSelector::select(MachineInstr &I,
     return selectConstant(I, MRI, MF);
   case TargetOpcode::G_FCONSTANT:
     return materializeFP(I, MRI, MF);
+  case TargetOpcode::G_BITCAST:
+    return selectBitcast(I, MRI);
   case TargetOpcode::G_TRUNC:
-    return selectTrunc(I, MRI, MF);
+  case TargetOpcode::G_PTRTOINT:
+  case TargetOpcode::G_INTTOPTR:
+    return selectTruncOrPtrCast(I, MRI, MF);
   case TargetOpcode::G_ZEXT:
     return selectZext(I, MRI, MF);
   case TargetOpcode::G_ANYEXT:
@@ -352,6 +365,17 @@ bool X86InstructionSelector::select(MachineInstr &I,
     return selectCmp(I, MRI, MF);
   case TargetOpcode::G_UADDE:
     return selectUadde(I, MRI, MF);
+  case TargetOpcode::G_SHL:
+  case TargetOpcode::G_LSHR:
+  case TargetOpcode::G_ASHR:
+    return selectShift(I, MRI, MF);
+  case TargetOpcode::G_SDIV:
+  case TargetOpcode::G_SREM:
+  case TargetOpcode::G_UDIV:
+  case TargetOpcode::G_UREM:
+    return selectDivRem(I, MRI, MF);
+  case TargetOpcode::G_SELECT:
+    return selectSelect(I, MRI, MF);
   case TargetOpcode::G_UNMERGE_VALUES:
     return selectUnmergeValues(I, MRI, MF, CoverageInfo);
   case TargetOpcode::G_MERGE_VALUES:
@@ -640,10 +664,13 @@ bool X86InstructionSelector::selectConstant(MachineInstr &I,
   return constrainSelectedInstRegOperands(I, TII, TRI, RBI);
 }
 
-bool X86InstructionSelector::selectTrunc(MachineInstr &I,
-                                         MachineRegisterInfo &MRI,
-                                         MachineFunction &MF) const {
-  assert((I.getOpcode() == TargetOpcode::G_TRUNC) && "unexpected instruction");
+bool X86InstructionSelector::selectTruncOrPtrCast(MachineInstr &I,
+                                                  MachineRegisterInfo &MRI,
+                                                  MachineFunction &MF) const {
+  assert((I.getOpcode() == TargetOpcode::G_TRUNC ||
+          I.getOpcode() == TargetOpcode::G_PTRTOINT ||
+          I.getOpcode() == TargetOpcode::G_INTTOPTR) &&
+         "unexpected instruction");
 
   const unsigned DstReg = I.getOperand(0).getReg();
   const unsigned SrcReg = I.getOperand(1).getReg();
@@ -655,7 +682,8 @@ bool X86InstructionSelector::selectTrunc(MachineInstr &I,
   const RegisterBank &SrcRB = *RBI.getRegBank(SrcReg, MRI, TRI);
 
   if (DstRB.getID() != SrcRB.getID()) {
-    DEBUG(dbgs() << "G_TRUNC input/output on different banks\n");
+    DEBUG(dbgs() << TII.getName(I.getOpcode())
+                 << " input/output on different banks\n");
     return false;
   }
 
@@ -688,7 +716,8 @@ bool X86InstructionSelector::selectTrunc(MachineInstr &I,
 
   if (!RBI.constrainGenericRegister(SrcReg, *SrcRC, MRI) ||
       !RBI.constrainGenericRegister(DstReg, *DstRC, MRI)) {
-    DEBUG(dbgs() << "Failed to constrain G_TRUNC\n");
+    DEBUG(dbgs() << "Failed to constrain " << TII.getName(I.getOpcode())
+                 << "\n");
     return false;
   }
 
@@ -698,6 +727,40 @@ bool X86InstructionSelector::selectTrunc(MachineInstr &I,
   return true;
 }
 
+// A bitcast between two vectors of the same size in the same register bank is
+// a copy.
+bool X86InstructionSelector::selectBitcast(MachineInstr &I,
+                                           MachineRegisterInfo &MRI) const {
+  assert((I.getOpcode() == TargetOpcode::G_BITCAST) &&
+         "unexpected instruction");
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned SrcReg = I.getOperand(1).getReg();
+
+  const LLT DstTy = MRI.getType(DstReg);
+  const LLT SrcTy = MRI.getType(SrcReg);
+
+  const RegisterBank &DstRB = *RBI.getRegBank(DstReg, MRI, TRI);
+  const RegisterBank &SrcRB = *RBI.getRegBank(SrcReg, MRI, TRI);
+
+  if (DstRB.getID() != SrcRB.getID() ||
+      DstRB.getID() != X86::VECRRegBankID || !DstTy.isVector() ||
+      !SrcTy.isVector() || DstTy.getSizeInBits() != SrcTy.getSizeInBits()) {
+    DEBUG(dbgs() << "Unsupported G_BITCAST\n");
+    return false;
+  }
+
+  const TargetRegisterClass *RC = getRegClass(DstTy, DstRB);
+  if (!RBI.constrainGenericRegister(SrcReg, *RC, MRI) ||
+      !RBI.constrainGenericRegister(DstReg, *RC, MRI)) {
+    DEBUG(dbgs() << "Failed to constrain G_BITCAST\n");
+    return false;
+  }
+
+  I.setDesc(TII.get(X86::COPY));
+  return true;
+}
+
 bool X86InstructionSelector::selectZext(MachineInstr &I,
                                         MachineRegisterInfo &MRI,
                                         MachineFunction &MF) const {
@@ -905,6 +968,405 @@ bool X86InstructionSelector::selectUadde(MachineInstr &I,
   return true;
 }
 
+bool X86InstructionSelector::selectShift(MachineInstr &I,
+                                         MachineRegisterInfo &MRI,
+                                         MachineFunction &MF) const {
+  assert((I.getOpcode() == TargetOpcode::G_SHL ||
+          I.getOpcode() == TargetOpcode::G_LSHR ||
+          I.getOpcode() == TargetOpcode::G_ASHR) &&
+         "unexpected instruction");
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned Op0Reg = I.getOperand(1).getReg();
+  const unsigned Op1Reg = I.getOperand(2).getReg();
+
+  const LLT DstTy = MRI.getType(DstReg);
+  const RegisterBank &DstRB = *RBI.getRegBank(DstReg, MRI, TRI);
+
+  if (DstRB.getID() != X86::GPRRegBankID)
+    return false;
+
+  if (I.getOpcode() == TargetOpcode::G_ASHR &&
+      selectSignExtendShifts(I, MRI, MF))
+    return true;
+
+  static const struct ShiftEntry {
+    unsigned SizeInBits;
+    unsigned CReg;
+    unsigned OpSHL;
+    unsigned OpLSHR;
+    unsigned OpASHR;
+    unsigned OpSHLri;
+    unsigned OpLSHRri;
+    unsigned OpASHRri;
+  } OpTable[] = {
+      {8, X86::CL, X86::SHL8rCL, X86::SHR8rCL, X86::SAR8rCL, X86::SHL8ri,
+       X86::SHR8ri, X86::SAR8ri}, // i8
+      {16, X86::CX, X86::SHL16rCL, X86::SHR16rCL, X86::SAR16rCL, X86::SHL16ri,
+       X86::SHR16ri, X86::SAR16ri}, // i16
+      {32, X86::ECX, X86::SHL32rCL, X86::SHR32rCL, X86::SAR32rCL, X86::SHL32ri,
+       X86::SHR32ri, X86::SAR32ri}, // i32
+      {64, X86::RCX, X86::SHL64rCL, X86::SHR64rCL, X86::SAR64rCL, X86::SHL64ri,
+       X86::SHR64ri, X86::SAR64ri}, // i64
+  };
+
+  const ShiftEntry *Entry = nullptr;
+  for (const ShiftEntry &E : OpTable)
+    if (E.SizeInBits == DstTy.getSizeInBits())
+      Entry = &E;
+  if (!Entry)
+    return false;
+
+  // Shift by a constant amount with the immediate forms.
+  auto Amt = getConstantVRegVal(Op1Reg, MRI);
+  if (Amt && *Amt >= 0 && *Amt < DstTy.getSizeInBits()) {
+    unsigned Opcode;
+    switch (I.getOpcode()) {
+    case TargetOpcode::G_SHL:
+      Opcode = Entry->OpSHLri;
+      break;
+    case TargetOpcode::G_LSHR:
+      Opcode = Entry->OpLSHRri;
+      break;
+    default:
+      Opcode = Entry->OpASHRri;
+      break;
+    }
+
+    MachineInstr &ShiftInst =
+        *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Opcode), DstReg)
+             .addReg(Op0Reg)
+             .addImm(*Amt);
+    if (!constrainSelectedInstRegOperands(ShiftInst, TII, TRI, RBI))
+      return false;
+
+    I.eraseFromParent();
+    return true;
+  }
+
+  unsigned Opcode;
+  switch (I.getOpcode()) {
+  case TargetOpcode::G_SHL:
+    Opcode = Entry->OpSHL;
+    break;
+  case TargetOpcode::G_LSHR:
+    Opcode = Entry->OpLSHR;
+    break;
+  default:
+    Opcode = Entry->OpASHR;
+    break;
+  }
+
+  // The shift amount has the same type as the shifted value, but the
+  // instruction only reads CL.
+  BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(TargetOpcode::COPY),
+          Entry->CReg)
+      .addReg(Op1Reg);
+
+  // If we defined a super-register of CL, emit a subreg KILL to precisely
+  // describe what we're doing here.
+  if (Entry->CReg != X86::CL)
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(TargetOpcode::KILL),
+            X86::CL)
+        .addReg(Entry->CReg, RegState::Kill);
+
+  MachineInstr &ShiftInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Opcode), DstReg)
+           .addReg(Op0Reg);
+
+  const TargetRegisterClass *RC = getRegClass(DstTy, DstRB);
+  if (!constrainSelectedInstRegOperands(ShiftInst, TII, TRI, RBI) ||
+      !RBI.constrainGenericRegister(Op1Reg, *RC, MRI))
+    return false;
+
+  I.eraseFromParent();
+  return true;
+}
+
+// The legalizer turns G_SEXT (G_TRUNC x) into G_ASHR (G_SHL x, C), C once
+// shifts are legal. Select that pair as a MOVSX from a sub-register of x.
+bool X86InstructionSelector::selectSignExtendShifts(
+    MachineInstr &I, MachineRegisterInfo &MRI, MachineFunction &MF) const {
+  assert((I.getOpcode() == TargetOpcode::G_ASHR) && "unexpected instruction");
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned ShlReg = I.getOperand(1).getReg();
+
+  auto Amt = getConstantVRegVal(I.getOperand(2).getReg(), MRI);
+  MachineInstr *ShlMI = MRI.getVRegDef(ShlReg);
+  if (!Amt || ShlMI->getOpcode() != TargetOpcode::G_SHL ||
+      !MRI.hasOneUse(ShlReg) ||
+      getConstantVRegVal(ShlMI->getOperand(2).getReg(), MRI) != Amt)
+    return false;
+
+  const LLT DstTy = MRI.getType(DstReg);
+  const unsigned DstSize = DstTy.getSizeInBits();
+  const int64_t FromSize = DstSize - *Amt;
+
+  unsigned Opcode;
+  if (DstSize == 64 && FromSize == 8)
+    Opcode = X86::MOVSX64rr8;
+  else if (DstSize == 64 && FromSize == 16)
+    Opcode = X86::MOVSX64rr16;
+  else if (DstSize == 64 && FromSize == 32)
+    Opcode = X86::MOVSX64rr32;
+  else if (DstSize == 32 && FromSize == 8)
+    Opcode = X86::MOVSX32rr8;
+  else if (DstSize == 32 && FromSize == 16)
+    Opcode = X86::MOVSX32rr16;
+  else if (DstSize == 16 && FromSize == 8)
+    Opcode = X86::MOVSX16rr8;
+  else
+    return false;
+
+  // Look through the G_ANYEXT that widened the value before the shifts.
+  unsigned SrcReg = ShlMI->getOperand(1).getReg();
+  MachineInstr *SrcMI = MRI.getVRegDef(SrcReg);
+  if (SrcMI->getOpcode() == TargetOpcode::G_ANYEXT &&
+      MRI.getType(SrcMI->getOperand(1).getReg()).getSizeInBits() >= FromSize)
+    SrcReg = SrcMI->getOperand(1).getReg();
+
+  const RegisterBank &SrcRB = *RBI.getRegBank(SrcReg, MRI, TRI);
+  if (SrcRB.getID() != X86::GPRRegBankID)
+    return false;
+
+  const LLT FromTy = LLT::scalar(FromSize);
+  const TargetRegisterClass *FromRC = getRegClass(FromTy, SrcRB);
+  unsigned FromReg = SrcReg;
+  if (MRI.getType(SrcReg).getSizeInBits() != FromSize) {
+    const unsigned SubIdx = getSubRegIndex(FromRC);
+    const TargetRegisterClass *SrcRC = TRI.getSubClassWithSubReg(
+        getRegClass(MRI.getType(SrcReg), SrcRB), SubIdx);
+    if (!SrcRC || !RBI.constrainGenericRegister(SrcReg, *SrcRC, MRI))
+      return false;
+
+    FromReg = MRI.createVirtualRegister(FromRC);
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(TargetOpcode::COPY),
+            FromReg)
+        .addReg(SrcReg, 0, SubIdx);
+  }
+
+  MachineInstr &ExtInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Opcode), DstReg)
+           .addReg(FromReg);
+  if (!constrainSelectedInstRegOperands(ExtInst, TII, TRI, RBI))
+    return false;
+
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectDivRem(MachineInstr &I,
+                                          MachineRegisterInfo &MRI,
+                                          MachineFunction &MF) const {
+  assert((I.getOpcode() == TargetOpcode::G_SDIV ||
+          I.getOpcode() == TargetOpcode::G_SREM ||
+          I.getOpcode() == TargetOpcode::G_UDIV ||
+          I.getOpcode() == TargetOpcode::G_UREM) &&
+         "unexpected instruction");
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned Op1Reg = I.getOperand(1).getReg();
+  const unsigned Op2Reg = I.getOperand(2).getReg();
+
+  const LLT RegTy = MRI.getType(DstReg);
+  const RegisterBank &RegRB = *RBI.getRegBank(DstReg, MRI, TRI);
+
+  if (RegRB.getID() != X86::GPRRegBankID)
+    return false;
+
+  // This mirrors the DIV/IDIV lowering in X86FastISel. The dividend lives in
+  // the register pair HighInReg:LowInReg, the quotient ends up in LowInReg
+  // and the remainder in HighInReg. The exception is i8, where the dividend
+  // is the single register AX: it is extended straight into AX, and the
+  // quotient and remainder end up in AL and AH.
+  const static unsigned NumOps = 4; // SDiv, SRem, UDiv, URem
+  const static unsigned Copy = TargetOpcode::COPY;
+  const static struct DivRemEntry {
+    unsigned SizeInBits;
+    unsigned LowInReg;
+    unsigned HighInReg;
+    struct DivRemResult {
+      unsigned OpDivRem;        // The DIV/IDIV opcode to use.
+      unsigned OpSignExtend;    // Opcode sign-extending LowInReg into
+                                // HighInReg, or 0 to zero HighInReg.
+      unsigned OpCopy;          // Opcode copying the dividend into LowInReg.
+      unsigned DivRemResultReg; // Register containing the result.
+      bool IsOpSigned;
+    } ResultTable[NumOps];
+  } OpTable[] = {
+      {8, X86::AX, 0, {
+           {X86::IDIV8r, 0, X86::MOVSX16rr8, X86::AL, true},  // SDiv
+           {X86::IDIV8r, 0, X86::MOVSX16rr8, X86::AH, true},  // SRem
+           {X86::DIV8r, 0, X86::MOVZX16rr8, X86::AL, false},  // UDiv
+           {X86::DIV8r, 0, X86::MOVZX16rr8, X86::AH, false},  // URem
+       }},                                                    // i8
+      {16, X86::AX, X86::DX, {
+           {X86::IDIV16r, X86::CWD, Copy, X86::AX, true},     // SDiv
+           {X86::IDIV16r, X86::CWD, Copy, X86::DX, true},     // SRem
+           {X86::DIV16r, 0, Copy, X86::AX, false},            // UDiv
+           {X86::DIV16r, 0, Copy, X86::DX, false},            // URem
+       }},                                                    // i16
+      {32, X86::EAX, X86::EDX, {
+           {X86::IDIV32r, X86::CDQ, Copy, X86::EAX, true},    // SDiv
+           {X86::IDIV32r, X86::CDQ, Copy, X86::EDX, true},    // SRem
+           {X86::DIV32r, 0, Copy, X86::EAX, false},           // UDiv
+           {X86::DIV32r, 0, Copy, X86::EDX, false},           // URem
+       }},                                                    // i32
+      {64, X86::RAX, X86::RDX, {
+           {X86::IDIV64r, X86::CQO, Copy, X86::RAX, true},    // SDiv
+           {X86::IDIV64r, X86::CQO, Copy, X86::RDX, true},    // SRem
+           {X86::DIV64r, 0, Copy, X86::RAX, false},           // UDiv
+           {X86::DIV64r, 0, Copy, X86::RDX, false},           // URem
+       }},                                                    // i64
+  };
+
+  const DivRemEntry *TypeEntry = nullptr;
+  for (const DivRemEntry &E : OpTable)
+    if (E.SizeInBits == RegTy.getSizeInBits())
+      TypeEntry = &E;
+  if (!TypeEntry)
+    return false;
+
+  unsigned OpIndex;
+  switch (I.getOpcode()) {
+  default:
+    llvm_unreachable("Unexpected div/rem opcode");
+  case TargetOpcode::G_SDIV:
+    OpIndex = 0;
+    break;
+  case TargetOpcode::G_SREM:
+    OpIndex = 1;
+    break;
+  case TargetOpcode::G_UDIV:
+    OpIndex = 2;
+    break;
+  case TargetOpcode::G_UREM:
+    OpIndex = 3;
+    break;
+  }
+
+  const DivRemEntry::DivRemResult &OpEntry = TypeEntry->ResultTable[OpIndex];
+
+  const TargetRegisterClass *RC = getRegClass(RegTy, RegRB);
+  if (!RBI.constrainGenericRegister(Op1Reg, *RC, MRI) ||
+      !RBI.constrainGenericRegister(Op2Reg, *RC, MRI) ||
+      !RBI.constrainGenericRegister(DstReg, *RC, MRI)) {
+    DEBUG(dbgs() << "Failed to constrain " << TII.getName(I.getOpcode())
+                 << " operand\n");
+    return false;
+  }
+
+  // Move the dividend into the low-order input register.
+  BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(OpEntry.OpCopy),
+          TypeEntry->LowInReg)
+      .addReg(Op1Reg);
+
+  // Sign-extend or zero the high-order input register.
+  if (OpEntry.OpSignExtend) {
+    BuildMI(*I.getParent(), I, I.getDebugLoc(),
+            TII.get(OpEntry.OpSignExtend));
+  } else if (TypeEntry->HighInReg) {
+    unsigned Zero32 = MRI.createVirtualRegister(&X86::GR32RegClass);
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(X86::MOV32r0),
+            Zero32);
+
+    // Copy the zero into the appropriate sub/super/identical register.
+    if (RegTy.getSizeInBits() == 16) {
+      BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Copy),
+              TypeEntry->HighInReg)
+          .addReg(Zero32, 0, X86::sub_16bit);
+    } else if (RegTy.getSizeInBits() == 32) {
+      BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Copy),
+              TypeEntry->HighInReg)
+          .addReg(Zero32);
+    } else {
+      BuildMI(*I.getParent(), I, I.getDebugLoc(),
+              TII.get(TargetOpcode::SUBREG_TO_REG), TypeEntry->HighInReg)
+          .addImm(0)
+          .addReg(Zero32)
+          .addImm(X86::sub_32bit);
+    }
+  }
+
+  // Generate the DIV/IDIV instruction.
+  BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(OpEntry.OpDivRem))
+      .addReg(Op2Reg);
+
+  // For the i8 remainder, don't reference AH directly: in 64-bit mode that
+  // could end up in a REX-prefixed instruction. Shift AX right by 8 instead.
+  if (OpEntry.DivRemResultReg == X86::AH && STI.is64Bit()) {
+    unsigned SourceSuperReg = MRI.createVirtualRegister(&X86::GR16RegClass);
+    unsigned ResultSuperReg = MRI.createVirtualRegister(&X86::GR16RegClass);
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Copy), SourceSuperReg)
+        .addReg(X86::AX);
+
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(X86::SHR16ri),
+            ResultSuperReg)
+        .addReg(SourceSuperReg)
+        .addImm(8);
+
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Copy), DstReg)
+        .addReg(ResultSuperReg, 0, X86::sub_8bit);
+  } else {
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Copy), DstReg)
+        .addReg(OpEntry.DivRemResultReg);
+  }
+
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectSelect(MachineInstr &I,
+                                          MachineRegisterInfo &MRI,
+                                          MachineFunction &MF) const {
+  assert((I.getOpcode() == TargetOpcode::G_SELECT) && "unexpected instruction");
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned CondReg = I.getOperand(1).getReg();
+  const unsigned TrueReg = I.getOperand(2).getReg();
+  const unsigned FalseReg = I.getOperand(3).getReg();
+
+  const LLT Ty = MRI.getType(DstReg);
+  const RegisterBank &DstRB = *RBI.getRegBank(DstReg, MRI, TRI);
+
+  if (DstRB.getID() != X86::GPRRegBankID || !STI.hasCMov())
+    return false;
+
+  unsigned OpCmov;
+  switch (Ty.getSizeInBits()) {
+  default:
+    return false;
+  case 16:
+    OpCmov = X86::CMOVNE16rr;
+    break;
+  case 32:
+    OpCmov = X86::CMOVNE32rr;
+    break;
+  case 64:
+    OpCmov = X86::CMOVNE64rr;
+    break;
+  }
+
+  MachineInstr &TestInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(X86::TEST8ri))
+           .addReg(CondReg)
+           .addImm(1);
+
+  // CMOVNE keeps its tied first source unless the condition holds.
+  MachineInstr &CmovInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(OpCmov), DstReg)
+           .addReg(FalseReg)
+           .addReg(TrueReg);
+
+  if (!constrainSelectedInstRegOperands(TestInst, TII, TRI, RBI) ||
+      !constrainSelectedInstRegOperands(CmovInst, TII, TRI, RBI))
+    return false;
+
+  I.eraseFromParent();
+  return true;
+}
+
 bool X86InstructionSelector::selectExtract(MachineInstr &I,
                                            MachineRegisterInfo &MRI,
                                            MachineFunction &MF) const {
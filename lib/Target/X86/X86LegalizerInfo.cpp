@@ -72,6 +72,10 @@ X86LegalizerInfo::X86LegalizerInfo(const X86Subtarget &STI,
   setLegalizeScalarToDifferentSizeStrategy(G_PHI, 0, widen_1);
   for (unsigned BinOp : {G_SUB, G_MUL, G_AND, G_OR, G_XOR})
     setLegalizeScalarToDifferentSizeStrategy(BinOp, 0, widen_1);
+  for (unsigned Op : {G_SHL, G_LSHR, G_ASHR, G_SDIV, G_SREM, G_UDIV, G_UREM})
+    setLegalizeScalarToDifferentSizeStrategy(Op, 0, widen_1);
+  setLegalizeScalarToDifferentSizeStrategy(
+      G_SELECT, 0, widenToLargerTypesUnsupportedOtherwise);
   for (unsigned MemOp : {G_LOAD, G_STORE})
     setLegalizeScalarToDifferentSizeStrategy(MemOp, 0,
        narrowToSmallerAndWidenToSmallest);
@@ -107,6 +111,18 @@ void X86LegalizerInfo::setLegalizerInfo32bit() {
     setAction({Op, 1, s1}, Legal);
   }
 
+  // Shifts and divisions
+  for (unsigned Op : {G_SHL, G_LSHR, G_ASHR, G_SDIV, G_SREM, G_UDIV, G_UREM})
+    for (auto Ty : {s8, s16, s32})
+      setAction({Op, Ty}, Legal);
+
+  // Select is lowered to CMOV, which has no 8-bit form.
+  if (Subtarget.hasCMov()) {
+    for (auto Ty : {s16, s32, p0})
+      setAction({G_SELECT, Ty}, Legal);
+    setAction({G_SELECT, 1, s1}, Legal);
+  }
+
   for (unsigned MemOp : {G_LOAD, G_STORE}) {
     for (auto Ty : {s8, s16, s32, p0})
       setAction({MemOp, Ty}, Legal);
@@ -122,6 +138,12 @@ void X86LegalizerInfo::setLegalizerInfo32bit() {
   setAction({G_GEP, p0}, Legal);
   setAction({G_GEP, 1, s32}, Legal);
 
+  setAction({G_INTTOPTR, p0}, Legal);
+  setAction({G_INTTOPTR, 1, LLT::scalar(p0.getSizeInBits())}, Legal);
+  for (auto Ty : {s8, s16, s32})
+    setAction({G_PTRTOINT, Ty}, Legal);
+  setAction({G_PTRTOINT, 1, p0}, Legal);
+
   // Control-flow
   setAction({G_BRCOND, s1}, Legal);
 
@@ -168,11 +190,19 @@ void X86LegalizerInfo::setLegalizerInfo64bit() {
   for (unsigned BinOp : {G_ADD, G_SUB, G_MUL, G_AND, G_OR, G_XOR})
     setAction({BinOp, s64}, Legal);
 
+  // Shifts and divisions
+  for (unsigned Op : {G_SHL, G_LSHR, G_ASHR, G_SDIV, G_SREM, G_UDIV, G_UREM})
+    setAction({Op, s64}, Legal);
+
+  if (Subtarget.hasCMov())
+    setAction({G_SELECT, s64}, Legal);
+
   for (unsigned MemOp : {G_LOAD, G_STORE})
     setAction({MemOp, s64}, Legal);
 
   // Pointer-handling
   setAction({G_GEP, 1, s64}, Legal);
+  setAction({G_PTRTOINT, s64}, Legal);
 
   // Constants
   setAction({TargetOpcode::G_CONSTANT, s64}, Legal);
@@ -247,6 +277,16 @@ void X86LegalizerInfo::setLegalizerInfoSSE2() {
 
   setAction({G_MUL, v8s16}, Legal);
 
+  for (unsigned MemOp : {G_LOAD, G_STORE})
+    for (auto Ty : {v16s8, v8s16})
+      setAction({MemOp, Ty}, Legal);
+
+  // Bitcasts between 128-bit vectors are register copies.
+  for (auto Ty : {v16s8, v8s16, v4s32, v2s64}) {
+    setAction({G_BITCAST, Ty}, Legal);
+    setAction({G_BITCAST, 1, Ty}, Legal);
+  }
+
   setAction({G_FPEXT, s64}, Legal);
   setAction({G_FPEXT, 1, s32}, Legal);
 
@@ -293,9 +333,14 @@ void X86LegalizerInfo::setLegalizerInfoAVX() {
   const LLT v8s64 = LLT::vector(8, 64);
 
   for (unsigned MemOp : {G_LOAD, G_STORE})
-    for (auto Ty : {v8s32, v4s64})
+    for (auto Ty : {v32s8, v16s16, v8s32, v4s64})
       setAction({MemOp, Ty}, Legal);
 
+  for (auto Ty : {v32s8, v16s16, v8s32, v4s64}) {
+    setAction({G_BITCAST, Ty}, Legal);
+    setAction({G_BITCAST, 1, Ty}, Legal);
+  }
+
   for (auto Ty : {v32s8, v16s16, v8s32, v4s64}) {
     setAction({G_INSERT, Ty}, Legal);
     setAction({G_EXTRACT, 1, Ty}, Legal);
@@ -375,9 +420,14 @@ void X86LegalizerInfo::setLegalizerInfoAVX512() {
   setAction({G_MUL, v16s32}, Legal);
 
   for (unsigned MemOp : {G_LOAD, G_STORE})
-    for (auto Ty : {v16s32, v8s64})
+    for (auto Ty : {v64s8, v32s16, v16s32, v8s64})
       setAction({MemOp, Ty}, Legal);
 
+  for (auto Ty : {v64s8, v32s16, v16s32, v8s64}) {
+    setAction({G_BITCAST, Ty}, Legal);
+    setAction({G_BITCAST, 1, Ty}, Legal);
+  }
+
   for (auto Ty : {v64s8, v32s16, v16s32, v8s64}) {
     setAction({G_INSERT, Ty}, Legal);
     setAction({G_EXTRACT, 1, Ty}, Legal);
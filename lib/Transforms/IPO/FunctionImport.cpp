@@ -235,6 +235,34 @@ updateValueInfoForIndirectCalls(const ModuleSummaryIndex &Index, ValueInfo VI) {
   return Index.getValueInfo(GUID);
 }
 
+/// Import the read-only and write-only global variables referenced by
+/// \p Summary, so that every module accessing them holds a copy that can be
+/// internalized after import.
+static void computeImportForReferencedGlobals(
+    const FunctionSummary &Summary, const ModuleSummaryIndex &Index,
+    const GVSummaryMapTy &DefinedGVSummaries,
+    FunctionImporter::ImportMapTy &ImportList,
+    StringMap<FunctionImporter::ExportSetTy> *ExportLists) {
+  for (auto &VI : Summary.refs()) {
+    if (!VI.isReadOnly() && !VI.isWriteOnly())
+      continue;
+    if (DefinedGVSummaries.count(VI.getGUID()))
+      continue;
+    for (auto &RefSummary : VI.getSummaryList()) {
+      auto *GVS = dyn_cast<GlobalVarSummary>(RefSummary.get());
+      if (!GVS || (!Index.isReadOnly(GVS) && !Index.isWriteOnly(GVS)))
+        continue;
+      DEBUG(dbgs() << " ref -> " << VI.getGUID() << " "
+                   << (Index.isReadOnly(GVS) ? "read-only" : "write-only")
+                   << "\n");
+      ImportList[GVS->modulePath()].insert(std::make_pair(VI.getGUID(), 0));
+      if (ExportLists)
+        (*ExportLists)[GVS->modulePath()].insert(VI.getGUID());
+      break;
+    }
+  }
+}
+
 /// Compute the list of functions to import for a given caller. Mark these
 /// imported functions and the symbols they reference in their source module as
 /// exported from their source module.
@@ -244,6 +272,8 @@ static void computeImportForFunction(
     SmallVectorImpl<EdgeInfo> &Worklist,
     FunctionImporter::ImportMapTy &ImportList,
     StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr) {
+  computeImportForReferencedGlobals(Summary, Index, DefinedGVSummaries,
+                                    ImportList, ExportLists);
   for (auto &Edge : Summary.calls()) {
     ValueInfo VI = Edge.first;
     DEBUG(dbgs() << " edge -> " << VI.getGUID() << " Threshold:" << Threshold
@@ -455,6 +485,13 @@ void llvm::ComputeCrossModuleImportForModule(
   // GUID -> Summary
   GVSummaryMapTy FunctionSummaryMap;
   Index.collectDefinedFunctionsForModule(ModulePath, FunctionSummaryMap);
+  // Also record the variables it defines, so that they aren't imported as
+  // read-only or write-only variables.
+  for (auto &GlobalList : Index)
+    for (auto &Summary : GlobalList.second.SummaryList)
+      if (isa<GlobalVarSummary>(Summary.get()) &&
+          Summary->modulePath() == ModulePath)
+        FunctionSummaryMap[GlobalList.first] = Summary.get();
 
   // Compute the import list for this module.
   DEBUG(dbgs() << "Computing import for Module '" << ModulePath << "'\n");
@@ -714,6 +751,24 @@ void llvm::thinLTOInternalizeModule(Module &TheModule,
   internalizeModule(TheModule, MustPreserveGV);
 }
 
+/// Internalize the read-only and write-only variables marked when renaming the
+/// modules for ThinLTO. This can't be done before the import is complete, as
+/// the IRMover must be able to link the imported definitions to their external
+/// declarations. The marker itself is dropped so that it doesn't reach the
+/// optimized module.
+static void internalizeGVsAfterImport(Module &M) {
+  for (auto &GV : M.globals()) {
+    if (!GV.hasAttribute("thinlto-internalize"))
+      continue;
+    GV.setAttributes(GV.getAttributes().removeAttribute(
+        M.getContext(), "thinlto-internalize"));
+    if (GV.isDeclaration())
+      continue;
+    GV.setLinkage(GlobalValue::InternalLinkage);
+    GV.setVisibility(GlobalValue::DefaultVisibility);
+  }
+}
+
 /// Make alias a clone of its aliasee.
 static Function *replaceAliasWithAliasee(Module *SrcModule, GlobalAlias *GA) {
   Function *Fn = cast<Function>(GA->getBaseObject());
@@ -851,6 +906,8 @@ Expected<bool> FunctionImporter::importFunctions(
     NumImportedModules++;
   }
 
+  internalizeGVsAfterImport(DestModule);
+
   NumImportedFunctions += ImportedCount;
 
   DEBUG(dbgs() << "Imported " << ImportedCount << " functions for Module "
@@ -0,0 +1,225 @@
+//===- FunctionOrdering.cpp - Profile-guided function ordering ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass builds a call graph weighted by profile counts: function counts
+// are entry counts and call counts are the profile counts of the calling
+// blocks. It orders the executed functions with the Call-Chain Clustering
+// (C3) heuristic so that hot callees follow their hot callers, which reduces
+// the number of i-TLB entries and cache lines the hot text needs.
+//
+// The order is applied by moving the functions to the front of the module, in
+// the computed order, and giving them the .hot section prefix. Functions are
+// emitted in module order, so the order carries over to the object file. When
+// the whole program is visible, as in regular LTO, the order can also be
+// written to an ordering file for the linker, either as symbol names (lld's
+// --symbol-ordering-file) or as section names (gold's --section-ordering-file).
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/FunctionOrdering.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Mangler.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Utils/CodeLayout.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "function-ordering"
+
+STATISTIC(NumOrderedFunctions, "Number of hot functions ordered");
+
+static cl::opt<std::string> OrderingFileOpt(
+    "function-ordering-file", cl::Hidden,
+    cl::desc("Write the order of the hot functions to this symbol ordering "
+             "file"));
+
+static cl::opt<bool> OrderingFileSectionsOpt(
+    "function-ordering-file-sections", cl::Hidden, cl::init(false),
+    cl::desc("Write section names instead of symbol names to the function "
+             "ordering file"));
+
+/// Estimated size of \p F in bytes.
+static uint64_t estimateSize(const Function &F) {
+  uint64_t Size = 0;
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB)
+      if (!isa<DbgInfoIntrinsic>(I))
+        Size += 4;
+  return std::max<uint64_t>(Size, 1);
+}
+
+static bool orderFunctions(
+    Module &M, ProfileSummaryInfo *PSI,
+    function_ref<BlockFrequencyInfo &(Function &)> GetBFI,
+    StringRef OrderingFile, bool WriteSectionNames) {
+  if (!PSI->hasProfileSummary())
+    return false;
+
+  // Executed functions that are not cold are candidates.
+  std::vector<Function *> Funcs;
+  DenseMap<const Function *, unsigned> FuncIndex;
+  std::vector<uint64_t> FuncSizes, FuncCounts;
+  for (Function &F : M) {
+    if (F.isDeclaration() || PSI->isFunctionEntryCold(&F))
+      continue;
+    Optional<uint64_t> Count = F.getEntryCount();
+    if (!Count || !*Count)
+      continue;
+    FuncIndex[&F] = Funcs.size();
+    Funcs.push_back(&F);
+    FuncSizes.push_back(estimateSize(F));
+    FuncCounts.push_back(*Count);
+  }
+  if (Funcs.empty())
+    return false;
+
+  std::vector<LayoutEdge> Calls;
+  for (Function *Caller : Funcs) {
+    BlockFrequencyInfo &BFI = GetBFI(*Caller);
+    for (BasicBlock &BB : *Caller) {
+      Optional<uint64_t> Count = BFI.getBlockProfileCount(&BB);
+      if (!Count || !*Count)
+        continue;
+      for (Instruction &I : BB) {
+        CallSite CS(&I);
+        if (!CS || isa<IntrinsicInst>(I))
+          continue;
+        auto It = FuncIndex.find(CS.getCalledFunction());
+        if (It != FuncIndex.end())
+          Calls.push_back({FuncIndex[Caller], It->second, *Count});
+      }
+    }
+  }
+
+  std::vector<unsigned> Order = applyC3Ordering(FuncSizes, FuncCounts, Calls);
+
+  // Move the ordered functions to the front of the module. Going backwards
+  // keeps them in order.
+  Module::FunctionListType &FL = M.getFunctionList();
+  for (unsigned Index : llvm::reverse(Order)) {
+    Function *F = Funcs[Index];
+    FL.splice(FL.begin(), FL, F->getIterator());
+    F->setSectionPrefix(".hot");
+  }
+  NumOrderedFunctions += Order.size();
+  DEBUG({
+    dbgs() << "Function order:\n";
+    for (unsigned Index : Order)
+      dbgs() << "  " << Funcs[Index]->getName() << "\n";
+  });
+
+  if (OrderingFile.empty())
+    return true;
+  std::error_code EC;
+  raw_fd_ostream OS(OrderingFile, EC, sys::fs::F_Text);
+  if (EC) {
+    M.getContext().emitError("could not open function ordering file '" +
+                             OrderingFile + "': " + EC.message());
+    return true;
+  }
+  // Private functions have no symbol to order by. Section names assume one
+  // section per function, named after the .hot prefix set above, unless the
+  // function has an explicit section.
+  Mangler Mang;
+  for (unsigned Index : Order) {
+    Function *F = Funcs[Index];
+    if (F->hasPrivateLinkage())
+      continue;
+    SmallString<64> Name;
+    Mang.getNameWithPrefix(Name, F, /*CannotUsePrivateLabel=*/false);
+    if (!WriteSectionNames)
+      OS << Name << "\n";
+    else if (F->hasSection())
+      OS << F->getSection() << "\n";
+    else
+      OS << ".text.hot." << Name << "\n";
+  }
+  return true;
+}
+
+FunctionOrderingPass::FunctionOrderingPass()
+    : OrderingFile(OrderingFileOpt), WriteSectionNames(OrderingFileSectionsOpt) {
+}
+
+PreservedAnalyses FunctionOrderingPass::run(Module &M,
+                                            ModuleAnalysisManager &AM) {
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  auto GetBFI = [&FAM](Function &F) -> BlockFrequencyInfo & {
+    return FAM.getResult<BlockFrequencyAnalysis>(F);
+  };
+  ProfileSummaryInfo *PSI = &AM.getResult<ProfileSummaryAnalysis>(M);
+  if (!orderFunctions(M, PSI, GetBFI, OrderingFile, WriteSectionNames))
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
+
+namespace {
+
+class FunctionOrderingLegacyPass : public ModulePass {
+  std::string OrderingFile;
+  bool WriteSectionNames;
+
+public:
+  static char ID;
+
+  FunctionOrderingLegacyPass()
+      : FunctionOrderingLegacyPass(OrderingFileOpt, OrderingFileSectionsOpt) {}
+
+  FunctionOrderingLegacyPass(StringRef OrderingFile, bool WriteSectionNames)
+      : ModulePass(ID), OrderingFile(OrderingFile),
+        WriteSectionNames(WriteSectionNames) {
+    initializeFunctionOrderingLegacyPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<BlockFrequencyInfoWrapperPass>();
+    AU.addRequired<ProfileSummaryInfoWrapperPass>();
+  }
+
+  bool runOnModule(Module &M) override {
+    if (skipModule(M))
+      return false;
+    auto GetBFI = [this](Function &F) -> BlockFrequencyInfo & {
+      return this->getAnalysis<BlockFrequencyInfoWrapperPass>(F).getBFI();
+    };
+    ProfileSummaryInfo *PSI =
+        getAnalysis<ProfileSummaryInfoWrapperPass>().getPSI();
+    return orderFunctions(M, PSI, GetBFI, OrderingFile, WriteSectionNames);
+  }
+};
+
+} // end anonymous namespace
+
+char FunctionOrderingLegacyPass::ID = 0;
+INITIALIZE_PASS_BEGIN(FunctionOrderingLegacyPass, "function-ordering",
+                      "Profile Guided Function Ordering", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ProfileSummaryInfoWrapperPass)
+INITIALIZE_PASS_END(FunctionOrderingLegacyPass, "function-ordering",
+                    "Profile Guided Function Ordering", false, false)
+
+ModulePass *llvm::createFunctionOrderingPass() {
+  return new FunctionOrderingLegacyPass();
+}
+
+ModulePass *llvm::createFunctionOrderingPass(StringRef OrderingFile,
+                                             bool WriteSectionNames) {
+  return new FunctionOrderingLegacyPass(OrderingFile, WriteSectionNames);
+}
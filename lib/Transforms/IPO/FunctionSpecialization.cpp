@@ -0,0 +1,411 @@
+//===- FunctionSpecialization.cpp - Function Specialization ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass specializes functions for constant arguments. Interprocedural SCCP
+// only propagates an argument into a function when all call sites agree on
+// it. Sort and dispatch routines are often called with a handful of different
+// callbacks, flags or sizes, which then stay opaque inside the function.
+//
+// The direct call sites of a function are grouped by the constant integers and
+// functions they pass. For each group the benefit of a copy of the function
+// with those arguments replaced by constants is estimated:
+//   - calls through a constant function pointer become direct calls, worth
+//     what InlineCost expects to save by inlining the callee there,
+//   - instructions using a constant integer fold, and so does the code on
+//     the paths not taken by branches and switches on it,
+//   - uses in loops are weighted by an assumed trip count per loop level.
+// The benefit is compared against the size of the copy. The most profitable
+// specializations are created until a module-wide code growth budget is used
+// up, and their call sites are redirected. Interprocedural SCCP is then run
+// again to propagate the constants through the copies and fold them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/FunctionSpecialization.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/CodeMetrics.h"
+#include "llvm/Analysis/InlineCost.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/SCCP.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <functional>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "function-specialization"
+
+STATISTIC(NumSpecialized, "Number of function specializations created");
+
+static cl::opt<unsigned> MaxClonesPerFunction(
+    "func-specialization-max-clones", cl::init(3), cl::Hidden,
+    cl::desc("The maximum number of specializations of a single function"));
+
+static cl::opt<unsigned> MaxCodeGrowth(
+    "func-specialization-max-growth", cl::init(20), cl::Hidden,
+    cl::desc("The maximum size of all specializations, in percent of the "
+             "size of the module"));
+
+static cl::opt<unsigned> AvgLoopIterationCount(
+    "func-specialization-avg-iters-cost", cl::init(10), cl::Hidden,
+    cl::desc("The trip count assumed for loops when estimating the benefit "
+             "of a specialization"));
+
+namespace {
+
+/// A copy of a function with some arguments replaced by constants, and the
+/// call sites that would call it.
+struct SpecializationCandidate {
+  Function *F;
+  SmallVector<std::pair<Argument *, Constant *>, 4> Args;
+  SmallVector<CallSite, 8> CallSites;
+  unsigned Size = 0;
+  int64_t Cost = 0;
+  int64_t Bonus = 0;
+};
+
+class FunctionSpecializer {
+public:
+  FunctionSpecializer(
+      const TargetLibraryInfo *TLI,
+      function_ref<LoopInfo &(Function &)> GetLI,
+      function_ref<TargetTransformInfo &(Function &)> GetTTI,
+      std::function<AssumptionCache &(Function &)> GetAC)
+      : TLI(TLI), GetLI(GetLI), GetTTI(GetTTI), GetAC(std::move(GetAC)) {}
+
+  bool run(Module &M);
+
+private:
+  /// Group the direct call sites of \p F by the constants they pass and add
+  /// the profitable groups to \p Candidates.
+  void collectCandidates(Function &F,
+                         SmallVectorImpl<SpecializationCandidate> &Candidates);
+
+  /// Estimate the benefit of replacing the argument \p A with \p C.
+  int64_t getArgumentBonus(Argument *A, Constant *C, LoopInfo &LI);
+
+  /// Estimate the size of the code that becomes dead when the condition of
+  /// \p TI folds.
+  int64_t getDeadCodeBonus(TerminatorInst *TI);
+
+  /// Create the specialization \p C and redirect its call sites to it.
+  void specialize(SpecializationCandidate &C, unsigned Index);
+
+  const TargetLibraryInfo *TLI;
+  function_ref<LoopInfo &(Function &)> GetLI;
+  function_ref<TargetTransformInfo &(Function &)> GetTTI;
+  std::function<AssumptionCache &(Function &)> GetAC;
+};
+
+} // end anonymous namespace
+
+int64_t FunctionSpecializer::getDeadCodeBonus(TerminatorInst *TI) {
+  // All successors only reached from TI become dead but the one taken.
+  int64_t Total = 0, Largest = 0;
+  for (BasicBlock *Succ : TI->successors()) {
+    if (Succ->getSinglePredecessor() != TI->getParent())
+      continue;
+    int64_t Size = Succ->size();
+    Total += Size;
+    Largest = std::max(Largest, Size);
+  }
+  return (Total - Largest) * InlineConstants::InstrCost;
+}
+
+int64_t FunctionSpecializer::getArgumentBonus(Argument *A, Constant *C,
+                                              LoopInfo &LI) {
+  int64_t Bonus = 0;
+  for (User *U : A->users()) {
+    auto *I = dyn_cast<Instruction>(U);
+    if (!I)
+      continue;
+
+    int64_t UserBonus = InlineConstants::InstrCost;
+    CallSite CS(I);
+    if (CS && CS.getCalledValue() == A) {
+      // The indirect call becomes a direct call that may be inlined.
+      UserBonus += InlineConstants::CallPenalty;
+      auto *Callee = dyn_cast<Function>(C);
+      if (Callee && !Callee->isDeclaration() &&
+          Callee->getFunctionType() == CS.getFunctionType()) {
+        InlineCost IC =
+            getInlineCost(CS, Callee, getInlineParams(), GetTTI(*Callee), GetAC,
+                          None, nullptr, nullptr);
+        if (IC.isAlways())
+          UserBonus += getInlineParams().DefaultThreshold;
+        else if (IC)
+          UserBonus += IC.getCostDelta();
+      }
+    } else if (auto *TI = dyn_cast<TerminatorInst>(I)) {
+      UserBonus += getDeadCodeBonus(TI);
+    } else if (isa<CmpInst>(I)) {
+      for (User *CmpUser : I->users())
+        if (auto *BI = dyn_cast<BranchInst>(CmpUser))
+          UserBonus += getDeadCodeBonus(BI);
+    }
+
+    // Uses in loops run many times.
+    for (unsigned Depth = LI.getLoopDepth(I->getParent()); Depth; --Depth)
+      UserBonus *= AvgLoopIterationCount;
+    Bonus += UserBonus;
+  }
+  return Bonus;
+}
+
+void FunctionSpecializer::collectCandidates(
+    Function &F, SmallVectorImpl<SpecializationCandidate> &Candidates) {
+  // A definition that may be replaced at link time cannot be copied.
+  if (F.isDeclaration() || F.isInterposable() || F.arg_empty() ||
+      F.isVarArg() || F.optForSize() ||
+      F.hasFnAttribute(Attribute::OptimizeNone) ||
+      F.hasFnAttribute(Attribute::NoDuplicate))
+    return;
+
+  LoopInfo &LI = GetLI(F);
+  DenseMap<std::pair<Argument *, Constant *>, int64_t> ArgBonus;
+  SmallVector<SpecializationCandidate, 4> Groups;
+  for (Use &U : F.uses()) {
+    CallSite CS(U.getUser());
+    if (!CS || !CS.isCallee(&U))
+      continue;
+
+    SpecializationCandidate Key;
+    for (Argument &A : F.args()) {
+      auto *C = dyn_cast<Constant>(CS.getArgument(A.getArgNo()));
+      if (!C || !(isa<ConstantInt>(C) || isa<Function>(C)))
+        continue;
+      auto Inserted = ArgBonus.insert({{&A, C}, 0});
+      if (Inserted.second)
+        Inserted.first->second = getArgumentBonus(&A, C, LI);
+      if (Inserted.first->second <= 0)
+        continue;
+      Key.Args.push_back({&A, C});
+      Key.Bonus += Inserted.first->second;
+    }
+    if (Key.Args.empty())
+      continue;
+
+    auto Group = find_if(Groups, [&](const SpecializationCandidate &G) {
+      return G.Args == Key.Args;
+    });
+    if (Group == Groups.end()) {
+      Key.F = &F;
+      Groups.push_back(std::move(Key));
+      Group = std::prev(Groups.end());
+    }
+    Group->CallSites.push_back(CS);
+  }
+  if (Groups.empty())
+    return;
+
+  CodeMetrics Metrics;
+  SmallPtrSet<const Value *, 32> EphValues;
+  CodeMetrics::collectEphemeralValues(&F, &GetAC(F), EphValues);
+  for (BasicBlock &BB : F)
+    Metrics.analyzeBasicBlock(&BB, GetTTI(F), EphValues);
+  if (Metrics.notDuplicatable)
+    return;
+
+  for (SpecializationCandidate &G : Groups) {
+    G.Size = Metrics.NumInsts;
+    G.Cost = int64_t(Metrics.NumInsts) * InlineConstants::InstrCost;
+    if (G.Bonus > G.Cost) {
+      Candidates.push_back(std::move(G));
+      continue;
+    }
+
+    Instruction *Call = G.CallSites.front().getInstruction();
+    OptimizationRemarkEmitter ORE(Call->getFunction());
+    ORE.emit([&]() {
+      return OptimizationRemarkMissed(DEBUG_TYPE, "NotProfitable", Call)
+             << "not specializing " << ore::NV("Callee", &F)
+             << ": estimated benefit " << ore::NV("Bonus", G.Bonus)
+             << " does not exceed the cost " << ore::NV("Cost", G.Cost)
+             << " of the copy";
+    });
+  }
+}
+
+void FunctionSpecializer::specialize(SpecializationCandidate &C,
+                                     unsigned Index) {
+  Function *F = C.F;
+  ValueToValueMapTy VMap;
+  Function *Clone = CloneFunction(F, VMap);
+  Clone->setName(F->getName() + ".specialized." + Twine(Index));
+  Clone->setLinkage(GlobalValue::InternalLinkage);
+  Clone->setDLLStorageClass(GlobalValue::DefaultStorageClass);
+  Clone->setComdat(nullptr);
+
+  // Interprocedural SCCP propagates the constants further once the copy has
+  // no other callers.
+  for (auto &Arg : C.Args)
+    cast<Argument>(VMap[Arg.first])->replaceAllUsesWith(Arg.second);
+  for (CallSite CS : C.CallSites)
+    CS.setCalledFunction(Clone);
+
+  DEBUG(dbgs() << "FnSpecialization: created " << Clone->getName() << " for "
+               << C.CallSites.size() << " call sites\n");
+  OptimizationRemarkEmitter ORE(F);
+  ORE.emit([&]() {
+    return OptimizationRemark(DEBUG_TYPE, "Specialized", F)
+           << "specialized " << ore::NV("Callee", F) << " as "
+           << ore::NV("Specialization", Clone) << " for "
+           << ore::NV("NumCallSites", unsigned(C.CallSites.size()))
+           << " call sites: estimated benefit " << ore::NV("Bonus", C.Bonus)
+           << ", cost " << ore::NV("Cost", C.Cost);
+  });
+  ++NumSpecialized;
+}
+
+bool FunctionSpecializer::run(Module &M) {
+  uint64_t ModuleSize = 0;
+  SmallVector<Function *, 32> Worklist;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    for (BasicBlock &BB : F)
+      ModuleSize += BB.size();
+    Worklist.push_back(&F);
+  }
+
+  SmallVector<SpecializationCandidate, 8> Candidates;
+  for (Function *F : Worklist)
+    collectCandidates(*F, Candidates);
+  if (Candidates.empty())
+    return false;
+
+  // Spend the budget on the most profitable specializations first.
+  std::stable_sort(Candidates.begin(), Candidates.end(),
+                   [](const SpecializationCandidate &L,
+                      const SpecializationCandidate &R) {
+                     return L.Bonus - L.Cost > R.Bonus - R.Cost;
+                   });
+
+  uint64_t Budget = ModuleSize * MaxCodeGrowth / 100;
+  DenseMap<Function *, unsigned> NumClones;
+  bool Changed = false;
+  for (SpecializationCandidate &C : Candidates) {
+    unsigned &Clones = NumClones[C.F];
+    if (C.Size > Budget || Clones >= MaxClonesPerFunction) {
+      Instruction *Call = C.CallSites.front().getInstruction();
+      OptimizationRemarkEmitter ORE(Call->getFunction());
+      ORE.emit([&]() {
+        return OptimizationRemarkMissed(DEBUG_TYPE, "Budget", Call)
+               << "not specializing " << ore::NV("Callee", C.F)
+               << ": the code growth budget is exhausted";
+      });
+      continue;
+    }
+    Budget -= C.Size;
+    specialize(C, ++Clones);
+    Changed = true;
+  }
+
+  // Fold the constants into the specializations.
+  if (Changed)
+    runIPSCCP(M, M.getDataLayout(), TLI);
+  return Changed;
+}
+
+PreservedAnalyses FunctionSpecializationPass::run(Module &M,
+                                                  ModuleAnalysisManager &AM) {
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  auto GetLI = [&](Function &F) -> LoopInfo & {
+    return FAM.getResult<LoopAnalysis>(F);
+  };
+  auto GetTTI = [&](Function &F) -> TargetTransformInfo & {
+    return FAM.getResult<TargetIRAnalysis>(F);
+  };
+  std::function<AssumptionCache &(Function &)> GetAC =
+      [&](Function &F) -> AssumptionCache & {
+    return FAM.getResult<AssumptionAnalysis>(F);
+  };
+  auto &TLI = AM.getResult<TargetLibraryAnalysis>(M);
+
+  if (!FunctionSpecializer(&TLI, GetLI, GetTTI, GetAC).run(M))
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
+
+namespace {
+
+class FunctionSpecializationLegacyPass : public ModulePass {
+public:
+  static char ID;
+
+  FunctionSpecializationLegacyPass() : ModulePass(ID) {
+    initializeFunctionSpecializationLegacyPassPass(
+        *PassRegistry::getPassRegistry());
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AssumptionCacheTracker>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addRequired<TargetLibraryInfoWrapperPass>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+  }
+
+  bool runOnModule(Module &M) override {
+    if (skipModule(M))
+      return false;
+
+    auto GetLI = [this](Function &F) -> LoopInfo & {
+      return getAnalysis<LoopInfoWrapperPass>(F).getLoopInfo();
+    };
+    auto GetTTI = [this](Function &F) -> TargetTransformInfo & {
+      return getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F);
+    };
+    std::function<AssumptionCache &(Function &)> GetAC =
+        [this](Function &F) -> AssumptionCache & {
+      return getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F);
+    };
+    const TargetLibraryInfo *TLI =
+        &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
+
+    return FunctionSpecializer(TLI, GetLI, GetTTI, GetAC).run(M);
+  }
+};
+
+} // end anonymous namespace
+
+char FunctionSpecializationLegacyPass::ID = 0;
+
+INITIALIZE_PASS_BEGIN(FunctionSpecializationLegacyPass,
+                      "function-specialization",
+                      "Function Specialization", false, false)
+INITIALIZE_PASS_DEPENDENCY(AssumptionCacheTracker)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(TargetTransformInfoWrapperPass)
+INITIALIZE_PASS_END(FunctionSpecializationLegacyPass,
+                    "function-specialization",
+                    "Function Specialization", false, false)
+
+ModulePass *llvm::createFunctionSpecializationPass() {
+  return new FunctionSpecializationLegacyPass();
+}
@@ -0,0 +1,297 @@
+//===- HotColdSplitting.cpp - Outline cold regions ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass outlines single-entry regions of a function that are unlikely to
+// be executed into separate functions. The outlined functions are marked cold
+// and placed in the .text.unlikely section, which shrinks the hot part of the
+// caller and keeps cold code off the hot pages and cache lines.
+//
+// A block is considered cold if
+//   - it ends in unreachable, or it calls a function marked cold, or
+//   - profile data says it is cold, or
+//   - all of its successors are cold.
+// Each cold block whose immediate dominator is not cold starts a region that
+// contains the blocks it dominates, minus the blocks that can be entered from
+// outside the region.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/HotColdSplitting.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "hotcoldsplit"
+
+STATISTIC(NumColdRegionsOutlined, "Number of cold regions outlined");
+
+static cl::opt<unsigned> MinOutlineSize(
+    "hotcoldsplit-threshold", cl::init(3), cl::Hidden,
+    cl::desc("Minimum number of instructions in a cold region for it to be "
+             "outlined"));
+
+/// Returns true if \p BB contains a call that is known to be rarely executed.
+static bool hasColdCall(const BasicBlock &BB) {
+  for (const Instruction &I : BB) {
+    ImmutableCallSite CS(&I);
+    if (!CS || isa<IntrinsicInst>(I))
+      continue;
+    if (CS.hasFnAttr(Attribute::Cold))
+      return true;
+    if (const Function *Callee = CS.getCalledFunction())
+      if (Callee->hasFnAttribute(Attribute::Cold))
+        return true;
+  }
+  return false;
+}
+
+/// Returns true if \p BB may be moved to another function. Returns, resumes
+/// and exception handling pads have to stay in the function they belong to.
+static bool mayExtractBlock(const BasicBlock &BB) {
+  const TerminatorInst *Term = BB.getTerminator();
+  if (isa<ReturnInst>(Term) || isa<ResumeInst>(Term))
+    return false;
+  return !BB.hasAddressTaken() && !BB.isEHPad();
+}
+
+static unsigned getRegionSize(ArrayRef<BasicBlock *> Region) {
+  unsigned Size = 0;
+  for (BasicBlock *BB : Region)
+    for (Instruction &I : *BB)
+      if (!isa<DbgInfoIntrinsic>(I))
+        ++Size;
+  return Size;
+}
+
+namespace {
+
+class HotColdSplitting {
+  ProfileSummaryInfo *PSI;
+
+  bool outlineColdRegions(Function &F);
+  Function *outlineRegion(Function &F, ArrayRef<BasicBlock *> Region,
+                          OptimizationRemarkEmitter &ORE);
+
+public:
+  HotColdSplitting(ProfileSummaryInfo *PSI) : PSI(PSI) {}
+
+  bool run(Module &M);
+};
+
+} // end anonymous namespace
+
+Function *HotColdSplitting::outlineRegion(Function &F,
+                                          ArrayRef<BasicBlock *> Region,
+                                          OptimizationRemarkEmitter &ORE) {
+  BasicBlock *Header = Region.front();
+  DebugLoc Loc;
+  for (Instruction &I : *Header)
+    if ((Loc = I.getDebugLoc()))
+      break;
+
+  DominatorTree DT(F);
+  CodeExtractor CE(Region, &DT);
+  Function *Outlined = CE.isEligible() ? CE.extractCodeRegion() : nullptr;
+  if (!Outlined) {
+    ORE.emit([&]() {
+      return OptimizationRemarkMissed(DEBUG_TYPE, "ExtractFailed", Loc, Header)
+             << "Failed to extract region at block "
+             << ore::NV("Block", Header);
+    });
+    return nullptr;
+  }
+
+  Outlined->addFnAttr(Attribute::Cold);
+  Outlined->addFnAttr(Attribute::NoInline);
+  Outlined->addFnAttr(Attribute::MinSize);
+  Outlined->setSectionPrefix(".unlikely");
+
+  CallInst *Call = nullptr;
+  for (User *U : Outlined->users())
+    if (auto *CI = dyn_cast<CallInst>(U)) {
+      CI->addAttribute(AttributeList::FunctionIndex, Attribute::Cold);
+      Call = CI;
+    }
+
+  ++NumColdRegionsOutlined;
+  DEBUG(dbgs() << "Outlined cold region of " << F.getName() << " into "
+               << Outlined->getName() << "\n");
+  ORE.emit([&]() {
+    return OptimizationRemark(DEBUG_TYPE, "HotColdSplit", Loc,
+                              Call->getParent())
+           << "Outlined cold region into " << ore::NV("Callee", Outlined);
+  });
+  return Outlined;
+}
+
+bool HotColdSplitting::outlineColdRegions(Function &F) {
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+  BranchProbabilityInfo BPI(F, LI);
+  BlockFrequencyInfo BFI(F, BPI, LI);
+  bool UseProfile = PSI && PSI->hasProfileSummary() && F.getEntryCount();
+
+  // Seed the cold set, then propagate backwards: a block all of whose
+  // successors are cold is cold too. The entry block is never outlined.
+  BasicBlock *Entry = &F.getEntryBlock();
+  SmallPtrSet<BasicBlock *, 16> Cold;
+  for (BasicBlock &BB : F) {
+    if (&BB == Entry || !mayExtractBlock(BB))
+      continue;
+    if (isa<UnreachableInst>(BB.getTerminator()) || hasColdCall(BB) ||
+        (UseProfile && PSI->isColdBB(&BB, &BFI)))
+      Cold.insert(&BB);
+  }
+  if (Cold.empty())
+    return false;
+
+  for (bool Changed = true; Changed;) {
+    Changed = false;
+    for (BasicBlock *BB : post_order(&F)) {
+      if (BB == Entry || Cold.count(BB) || !mayExtractBlock(*BB) ||
+          succ_empty(BB))
+        continue;
+      if (all_of(successors(BB),
+                 [&](BasicBlock *Succ) { return Cold.count(Succ); })) {
+        Cold.insert(BB);
+        Changed = true;
+      }
+    }
+  }
+
+  // Form one single-entry region per cold block whose immediate dominator
+  // is hot. Blocks dominated by a cold block are only reached through it, so
+  // they are included even if nothing marked them cold.
+  SmallPtrSet<BasicBlock *, 16> Claimed;
+  std::vector<SmallVector<BasicBlock *, 8>> Regions;
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  for (BasicBlock *Header : RPOT) {
+    if (!Cold.count(Header) || Claimed.count(Header))
+      continue;
+    BasicBlock *IDom = DT.getNode(Header)->getIDom()->getBlock();
+    if (Cold.count(IDom))
+      continue;
+
+    SetVector<BasicBlock *> Region;
+    SmallVector<DomTreeNode *, 8> Worklist(1, DT.getNode(Header));
+    while (!Worklist.empty()) {
+      DomTreeNode *N = Worklist.pop_back_val();
+      BasicBlock *BB = N->getBlock();
+      if (!mayExtractBlock(*BB) || Claimed.count(BB))
+        continue;
+      Region.insert(BB);
+      Worklist.append(N->begin(), N->end());
+    }
+
+    // Drop blocks that can be entered from outside the region until only
+    // the header can.
+    for (bool Changed = true; Changed;) {
+      Changed = false;
+      for (unsigned I = 1; I < Region.size(); ++I) {
+        BasicBlock *BB = Region[I];
+        if (all_of(predecessors(BB),
+                   [&](BasicBlock *Pred) { return Region.count(Pred); }))
+          continue;
+        Region.remove(BB);
+        Changed = true;
+        --I;
+      }
+    }
+
+    if (getRegionSize(Region.getArrayRef()) < MinOutlineSize)
+      continue;
+    Claimed.insert(Region.begin(), Region.end());
+    Regions.emplace_back(Region.begin(), Region.end());
+  }
+
+  OptimizationRemarkEmitter ORE(&F);
+  bool Changed = false;
+  for (ArrayRef<BasicBlock *> Region : Regions)
+    Changed |= outlineRegion(F, Region, ORE) != nullptr;
+  return Changed;
+}
+
+bool HotColdSplitting::run(Module &M) {
+  bool Changed = false;
+  // Outlined functions are appended to the module and are cold, so they are
+  // skipped without being visited twice.
+  SmallVector<Function *, 32> Worklist;
+  for (Function &F : M)
+    if (!F.isDeclaration() && F.size() > 1 &&
+        !F.hasFnAttribute(Attribute::OptimizeNone) &&
+        !F.hasFnAttribute(Attribute::Naked) &&
+        !F.hasFnAttribute(Attribute::Cold))
+      Worklist.push_back(&F);
+  for (Function *F : Worklist)
+    Changed |= outlineColdRegions(*F);
+  return Changed;
+}
+
+PreservedAnalyses HotColdSplittingPass::run(Module &M,
+                                            ModuleAnalysisManager &AM) {
+  ProfileSummaryInfo *PSI = &AM.getResult<ProfileSummaryAnalysis>(M);
+  if (HotColdSplitting(PSI).run(M))
+    return PreservedAnalyses::none();
+  return PreservedAnalyses::all();
+}
+
+namespace {
+
+class HotColdSplittingLegacyPass : public ModulePass {
+public:
+  static char ID;
+
+  HotColdSplittingLegacyPass() : ModulePass(ID) {
+    initializeHotColdSplittingLegacyPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<ProfileSummaryInfoWrapperPass>();
+  }
+
+  bool runOnModule(Module &M) override {
+    if (skipModule(M))
+      return false;
+    ProfileSummaryInfo *PSI =
+        getAnalysis<ProfileSummaryInfoWrapperPass>().getPSI();
+    return HotColdSplitting(PSI).run(M);
+  }
+};
+
+} // end anonymous namespace
+
+char HotColdSplittingLegacyPass::ID = 0;
+INITIALIZE_PASS_BEGIN(HotColdSplittingLegacyPass, "hotcoldsplit",
+                      "Hot Cold Splitting", false, false)
+INITIALIZE_PASS_DEPENDENCY(ProfileSummaryInfoWrapperPass)
+INITIALIZE_PASS_END(HotColdSplittingLegacyPass, "hotcoldsplit",
+                    "Hot Cold Splitting", false, false)
+
+ModulePass *llvm::createHotColdSplittingPass() {
+  return new HotColdSplittingLegacyPass();
+}
@@ -36,6 +36,12 @@
 // Collisions in the hash affect the speed of the pass but not the correctness
 // or determinism of the resulting transformation.
 //
+// Functions are therefore kept in one binary tree per hash value. The trees
+// are independent, so the new functions of each round are looked up in their
+// trees in parallel. The IR is only read while doing so; the merges that were
+// found are applied afterwards, one at a time and in the order of the work
+// list, which keeps the result independent of the number of threads.
+//
 // When a match is found the functions are folded. If both functions are
 // overridable, we move the functionality into a new internal function and
 // leave two overridable thunks to it.
@@ -90,6 +96,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
@@ -99,10 +106,12 @@
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstrTypes.h"
@@ -120,12 +129,14 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Utils/FunctionComparator.h"
 #include <algorithm>
 #include <cassert>
 #include <iterator>
+#include <map>
 #include <set>
 #include <utility>
 #include <vector>
@@ -165,16 +176,22 @@ static cl::opt<bool>
                       cl::desc("Preserve debug info in thunk when mergefunc "
                                "transformations are made."));
 
+static cl::opt<bool>
+    MergeFunctionsParallel("mergefunc-parallel", cl::Hidden, cl::init(false),
+                           cl::desc("Compare functions with different hashes "
+                                    "on different threads."));
+
 namespace {
 
 class FunctionNode {
-  mutable AssertingVH<Function> F;
+  // Nodes are created on several threads, so this cannot be a value handle.
+  // FNodesInTree tracks the function instead.
+  mutable Function *F;
   FunctionComparator::FunctionHash Hash;
 
 public:
-  // Note the hash is recalculated potentially multiple times, but it is cheap.
-  FunctionNode(Function *F)
-    : F(F), Hash(FunctionComparator::functionHash(*F))  {}
+  FunctionNode(Function *F, FunctionComparator::FunctionHash Hash)
+    : F(F), Hash(Hash) {}
 
   Function *getFunc() const { return F; }
   FunctionComparator::FunctionHash getHash() const { return Hash; }
@@ -196,8 +213,7 @@ class MergeFunctions : public ModulePass {
 public:
   static char ID;
 
-  MergeFunctions()
-    : ModulePass(ID), FnTree(FunctionNodeCmp(&GlobalNumbers)) {
+  MergeFunctions() : ModulePass(ID) {
     initializeMergeFunctionsPass(*PassRegistry::getPassRegistry());
   }
 
@@ -234,15 +250,19 @@ private:
   bool doSanityCheck(std::vector<WeakTrackingVH> &Worklist);
 #endif
 
-  /// Insert a ComparableFunction into the FnTree, or merge it away if it's
-  /// equal to one that's already present.
-  bool insert(Function *NewFunction);
+  /// Insert the functions of the work list into the FnTrees, and merge away
+  /// those that are equal to one that is already present.
+  bool insertAll(Module &M, std::vector<WeakTrackingVH> &Worklist);
 
-  /// Remove a Function from the FnTree and queue it up for a second sweep of
+  /// Merge NewFunction, which is equal to the function in OldF, into one
+  /// function.
+  void mergeWithNode(const FunctionNode &OldF, Function *NewFunction);
+
+  /// Remove a Function from the FnTrees and queue it up for a second sweep of
   /// analysis.
   void remove(Function *F);
 
-  /// Find the functions that use this Value and remove them from FnTree and
+  /// Find the functions that use this Value and remove them from FnTrees and
   /// queue the functions.
   void removeUsers(Value *V);
 
@@ -275,16 +295,27 @@ private:
   /// Replace function F with function G in the function tree.
   void replaceFunctionInTree(const FunctionNode &FN, Function *G);
 
-  /// The set of all distinct functions. Use the insert() and remove() methods
-  /// to modify it. The map allows efficient lookup and deferring of Functions.
-  FnTreeType FnTree;
+  /// The set of all distinct functions, with one tree per hash value. Use the
+  /// insertAll() and remove() methods to modify it. The map allows efficient
+  /// lookup and deferring of Functions.
+  std::map<FunctionComparator::FunctionHash, FnTreeType> FnTrees;
 
   // Map functions to the iterators of the FunctionNode which contains them
-  // in the FnTree. This must be updated carefully whenever the FnTree is
-  // modified, i.e. in insert(), remove(), and replaceFunctionInTree(), to avoid
-  // dangling iterators into FnTree. The invariant that preserves this is that
-  // there is exactly one mapping F -> FN for each FunctionNode FN in FnTree.
+  // in the FnTrees. This must be updated carefully whenever the FnTrees are
+  // modified, i.e. in insertAll(), remove(), and replaceFunctionInTree(), to
+  // avoid dangling iterators into FnTrees. The invariant that preserves this
+  // is that there is exactly one mapping F -> FN for each FunctionNode FN in
+  // FnTrees.
   ValueMap<Function*, FnTreeType::iterator> FNodesInTree;
+
+  /// Functions found to be equal to a node in FnTrees by insertAll() that have
+  /// not been merged yet. remove() takes them out and defers them if they are
+  /// changed by an earlier merge.
+  SmallPtrSet<Function *, 16> PendingMerges;
+
+  /// The nodes that remove() erased from FnTrees while insertAll() is merging.
+  /// Functions that were found to be equal to them are deferred.
+  SmallPtrSet<const FunctionNode *, 16> ErasedNodes;
 };
 
 } // end anonymous namespace
@@ -413,18 +444,12 @@ bool MergeFunctions::runOnModule(Module &M) {
     DEBUG(dbgs() << "size of worklist: " << Worklist.size() << '\n');
 
     // Insert functions and merge them.
-    for (WeakTrackingVH &I : Worklist) {
-      if (!I)
-        continue;
-      Function *F = cast<Function>(I);
-      if (!F->isDeclaration() && !F->hasAvailableExternallyLinkage()) {
-        Changed |= insert(F);
-      }
-    }
-    DEBUG(dbgs() << "size of FnTree: " << FnTree.size() << '\n');
+    Changed |= insertAll(M, Worklist);
+    DEBUG(dbgs() << "size of FnTrees: " << FNodesInTree.size() << '\n');
   } while (!Deferred.empty());
 
-  FnTree.clear();
+  FnTrees.clear();
+  FNodesInTree.clear();
   GlobalNumbers.clear();
 
   return Changed;
@@ -797,21 +822,142 @@ void MergeFunctions::replaceFunctionInTree(const FunctionNode &FN,
   FN.replaceBy(G);
 }
 
-// Insert a ComparableFunction into the FnTree, or merge it away if equal to one
-// that was already inserted.
-bool MergeFunctions::insert(Function *NewFunction) {
-  std::pair<FnTreeType::iterator, bool> Result =
-      FnTree.insert(FunctionNode(NewFunction));
+// Make the lazily computed state that FunctionComparator reads available
+// before functions are compared on several threads.
+static void prepareForParallelCompare(Module &M, GlobalNumberState &Numbers,
+                                      ArrayRef<Function *> Functions) {
+  // Number every global, so that comparisons only look the numbers up.
+  for (GlobalValue &GV : M.global_values())
+    Numbers.getNumber(&GV);
+
+  // Comparing GEPs computes their constant offsets. Both the field offsets
+  // of struct indices and the allocation sizes that array and vector indices
+  // are scaled by may compute a struct layout, which the DataLayout caches
+  // without locking.
+  const DataLayout &DL = M.getDataLayout();
+  for (Function *F : Functions)
+    for (BasicBlock &BB : *F)
+      for (Instruction &I : BB)
+        if (auto *GEP = dyn_cast<GetElementPtrInst>(&I))
+          for (gep_type_iterator GTI = gep_type_begin(GEP),
+                                 GTE = gep_type_end(GEP);
+               GTI != GTE; ++GTI) {
+            if (StructType *STy = GTI.getStructTypeOrNull())
+              DL.getStructLayout(STy);
+            else if (GTI.getIndexedType()->isSized())
+              DL.getTypeAllocSize(GTI.getIndexedType());
+          }
+}
 
-  if (Result.second) {
-    assert(FNodesInTree.count(NewFunction) == 0);
-    FNodesInTree.insert({NewFunction, Result.first});
-    DEBUG(dbgs() << "Inserting as unique: " << NewFunction->getName() << '\n');
-    return false;
+// Insert the functions of the work list into the FnTrees, or merge them away if
+// equal to one that was already inserted.
+bool MergeFunctions::insertAll(Module &M,
+                               std::vector<WeakTrackingVH> &Worklist) {
+  std::vector<Function *> Functions;
+  for (WeakTrackingVH &I : Worklist) {
+    if (!I)
+      continue;
+    Function *F = cast<Function>(I);
+    if (!F->isDeclaration() && !F->hasAvailableExternallyLinkage())
+      Functions.push_back(F);
   }
 
-  const FunctionNode &OldF = *Result.first;
+  std::vector<FunctionComparator::FunctionHash> Hashes(Functions.size());
+  auto HashFunction = [&](size_t Idx) {
+    Hashes[Idx] = FunctionComparator::functionHash(*Functions[Idx]);
+  };
 
+  // A function can only be equal to functions in the tree for its hash, so
+  // the lookups in different trees are independent of each other.
+  struct InsertResult {
+    FnTreeType::iterator Node;
+    const FunctionNode *NodeAddr;
+    bool Inserted;
+  };
+  struct BucketWork {
+    FunctionComparator::FunctionHash Hash;
+    FnTreeType *Tree;
+    std::vector<unsigned> FunctionIdxs;
+  };
+  std::vector<BucketWork> Buckets;
+  std::vector<InsertResult> Results(Functions.size());
+  auto InsertBucket = [&](size_t BucketIdx) {
+    BucketWork &B = Buckets[BucketIdx];
+    for (unsigned Idx : B.FunctionIdxs) {
+      auto Result = B.Tree->insert(FunctionNode(Functions[Idx], B.Hash));
+      Results[Idx] = {Result.first, &*Result.first, Result.second};
+    }
+  };
+
+  if (MergeFunctionsParallel) {
+    parallel::for_each_n(parallel::par, size_t(0), Functions.size(),
+                         HashFunction);
+    prepareForParallelCompare(M, GlobalNumbers, Functions);
+  } else {
+    for (size_t Idx = 0, E = Functions.size(); Idx != E; ++Idx)
+      HashFunction(Idx);
+  }
+
+  // Group the functions by hash, keeping the order of the work list within
+  // each group.
+  std::map<FunctionComparator::FunctionHash, unsigned> BucketIdxForHash;
+  for (unsigned Idx = 0, E = Functions.size(); Idx != E; ++Idx) {
+    auto P = BucketIdxForHash.insert({Hashes[Idx], Buckets.size()});
+    if (P.second) {
+      auto T = FnTrees.find(Hashes[Idx]);
+      if (T == FnTrees.end())
+        T = FnTrees
+                .insert(std::make_pair(
+                    Hashes[Idx], FnTreeType(FunctionNodeCmp(&GlobalNumbers))))
+                .first;
+      Buckets.push_back({Hashes[Idx], &T->second, {}});
+    }
+    Buckets[P.first->second].FunctionIdxs.push_back(Idx);
+  }
+
+  if (MergeFunctionsParallel)
+    parallel::for_each_n(parallel::par, size_t(0), Buckets.size(),
+                         InsertBucket);
+  else
+    for (size_t BucketIdx = 0, E = Buckets.size(); BucketIdx != E; ++BucketIdx)
+      InsertBucket(BucketIdx);
+
+  // Register the new nodes before merging anything, so that remove() can find
+  // them.
+  ErasedNodes.clear();
+  for (unsigned Idx = 0, E = Functions.size(); Idx != E; ++Idx) {
+    Function *F = Functions[Idx];
+    if (Results[Idx].Inserted) {
+      assert(FNodesInTree.count(F) == 0);
+      FNodesInTree.insert({F, Results[Idx].Node});
+      DEBUG(dbgs() << "Inserting as unique: " << F->getName() << '\n');
+    } else {
+      PendingMerges.insert(F);
+    }
+  }
+
+  // Apply the merges in the order of the work list. A merge may change other
+  // functions; those are deferred to the next round together with the
+  // functions that were found to be equal to them.
+  bool Changed = false;
+  for (unsigned Idx = 0, E = Functions.size(); Idx != E; ++Idx) {
+    Function *F = Functions[Idx];
+    if (Results[Idx].Inserted || !PendingMerges.erase(F))
+      continue;
+    if (ErasedNodes.count(Results[Idx].NodeAddr)) {
+      DEBUG(dbgs() << "Deferred " << F->getName() << ".\n");
+      Deferred.emplace_back(F);
+      continue;
+    }
+    mergeWithNode(*Results[Idx].Node, F);
+    Changed = true;
+  }
+  assert(PendingMerges.empty() && "Unhandled merge");
+  return Changed;
+}
+
+void MergeFunctions::mergeWithNode(const FunctionNode &OldF,
+                                   Function *NewFunction) {
   // Impose a total order (by name) on the replacement of functions. This is
   // important when operating on more than one module independently to prevent
   // cycles of thunks calling each other when the modules are linked together.
@@ -822,7 +968,7 @@ bool MergeFunctions::insert(Function *NewFunction) {
        OldF.getFunc()->getName() > NewFunction->getName())) {
     // Swap the two functions.
     Function *F = OldF.getFunc();
-    replaceFunctionInTree(*Result.first, NewFunction);
+    replaceFunctionInTree(OldF, NewFunction);
     NewFunction = F;
     assert(OldF.getFunc() != F && "Must have swapped the functions.");
   }
@@ -832,20 +978,23 @@ bool MergeFunctions::insert(Function *NewFunction) {
 
   Function *DeleteF = NewFunction;
   mergeTwoFunctions(OldF.getFunc(), DeleteF);
-  return true;
 }
 
-// Remove a function from FnTree. If it was already in FnTree, add
-// it to Deferred so that we'll look at it in the next round.
+// Remove a function from FnTrees. If it was already in FnTrees, or waiting to
+// be merged, add it to Deferred so that we'll look at it in the next round.
 void MergeFunctions::remove(Function *F) {
   auto I = FNodesInTree.find(F);
   if (I != FNodesInTree.end()) {
     DEBUG(dbgs() << "Deferred " << F->getName()<< ".\n");
-    FnTree.erase(I->second);
+    ErasedNodes.insert(&*I->second);
+    FnTrees.find(I->second->getHash())->second.erase(I->second);
     // I->second has been invalidated, remove it from the FNodesInTree map to
     // preserve the invariant.
     FNodesInTree.erase(I);
     Deferred.emplace_back(F);
+  } else if (PendingMerges.erase(F)) {
+    DEBUG(dbgs() << "Deferred " << F->getName()<< ".\n");
+    Deferred.emplace_back(F);
   }
 }
 
@@ -0,0 +1,378 @@
+//===- ModuleInliner.cpp - Priority-ordered module inliner ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a module level inliner. The CGSCC inliner visits the
+// call graph bottom-up and decides on each call site as it comes across it,
+// so a cheap but very hot call deep in the call graph may be reached after
+// the callers have already grown too large on colder calls.
+//
+// Instead, this pass puts every call site of the module in one priority queue.
+// The priority of a call site is the benefit InlineCost expects from inlining
+// it, scaled by the execution frequency of the call relative to the entry of
+// its caller (or by its profile count when a profile is available), per
+// instruction of the callee. Call sites are inlined most profitable first, as
+// long as the size of the module stays within a growth budget. Always-inline
+// call sites don't count against the budget.
+//
+// Inlining into a function changes the cost and frequency of the call sites it
+// contains, so queued call sites are re-evaluated lazily: when a call site is
+// popped after its caller or callee changed, its priority is recomputed and it
+// is queued again.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/ModuleInliner.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "module-inline"
+
+STATISTIC(NumInlined, "Number of call sites inlined");
+STATISTIC(NumDeleted, "Number of functions deleted because all callers found");
+STATISTIC(NumOverBudget,
+          "Number of call sites not inlined because of the growth budget");
+
+static cl::opt<unsigned> ModuleInlineGrowth(
+    "module-inline-growth-percent", cl::init(50), cl::Hidden,
+    cl::desc("The maximum growth of the module size, in percent, allowed to "
+             "the module inliner"));
+
+namespace {
+
+/// A call site waiting in the priority queue.
+struct QueuedCall {
+  WeakTrackingVH Call;
+  Function *Caller;
+  Function *Callee;
+  /// Index in the inline history of the call site this one was inlined from,
+  /// or -1 if it was in the original module.
+  int InlineHistoryID;
+  double Priority;
+  /// The versions of the caller and the callee the priority was computed for.
+  unsigned CallerVersion;
+  unsigned CalleeVersion;
+  /// Order of insertion, used to break ties deterministically.
+  unsigned Seq;
+};
+
+/// Order the heap so that the highest priority comes first and, among equal
+/// priorities, the call site queued first.
+struct QueuedCallCompare {
+  bool operator()(const QueuedCall &L, const QueuedCall &R) const {
+    if (L.Priority != R.Priority)
+      return L.Priority < R.Priority;
+    return L.Seq > R.Seq;
+  }
+};
+
+class ModuleInliner {
+public:
+  ModuleInliner(Module &M, ModuleAnalysisManager &AM,
+                const InlineParams &Params)
+      : M(M), Params(Params),
+        FAM(AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager()),
+        PSI(AM.getResult<ProfileSummaryAnalysis>(M)) {
+    GetAssumptionCache = [&](Function &F) -> AssumptionCache & {
+      return FAM.getResult<AssumptionAnalysis>(F);
+    };
+  }
+
+  bool run();
+
+private:
+  unsigned getSize(Function &F);
+  void markChanged(Function &F);
+  InlineCost computePriority(QueuedCall &QC);
+  void enqueue(CallSite CS, int InlineHistoryID);
+  bool inlineHistoryIncludes(Function *F, int InlineHistoryID) const;
+  void deleteIfDead(Function &F);
+
+  Module &M;
+  const InlineParams &Params;
+  FunctionAnalysisManager &FAM;
+  ProfileSummaryInfo &PSI;
+  std::function<AssumptionCache &(Function &)> GetAssumptionCache;
+
+  /// Binary heap of the call sites, see QueuedCallCompare.
+  std::vector<QueuedCall> Queue;
+  unsigned NextSeq = 0;
+
+  /// Bumped each time a function is modified, to detect stale priorities.
+  DenseMap<Function *, unsigned> Versions;
+  /// Cached instruction counts of the functions.
+  DenseMap<Function *, unsigned> Sizes;
+
+  /// The callee and parent history entry of each call site made visible by
+  /// inlining, to avoid inlining through recursion forever.
+  SmallVector<std::pair<Function *, int>, 16> InlineHistory;
+
+  uint64_t ModuleSize = 0;
+};
+
+} // end anonymous namespace
+
+unsigned ModuleInliner::getSize(Function &F) {
+  auto It = Sizes.find(&F);
+  if (It != Sizes.end())
+    return It->second;
+  unsigned Size = 0;
+  for (Instruction &I : instructions(F))
+    if (!isa<DbgInfoIntrinsic>(I))
+      ++Size;
+  Sizes[&F] = Size;
+  return Size;
+}
+
+void ModuleInliner::markChanged(Function &F) {
+  ++Versions[&F];
+  Sizes.erase(&F);
+  FAM.invalidate(F, PreservedAnalyses::none());
+}
+
+bool ModuleInliner::inlineHistoryIncludes(Function *F,
+                                          int InlineHistoryID) const {
+  while (InlineHistoryID != -1) {
+    assert(unsigned(InlineHistoryID) < InlineHistory.size() &&
+           "Invalid inline history ID");
+    if (InlineHistory[InlineHistoryID].first == F)
+      return true;
+    InlineHistoryID = InlineHistory[InlineHistoryID].second;
+  }
+  return false;
+}
+
+/// Compute the inline cost of \p QC and, unless the call site should not be
+/// inlined at all, its priority.
+InlineCost ModuleInliner::computePriority(QueuedCall &QC) {
+  CallSite CS(cast<Instruction>(QC.Call));
+  Function &Caller = *QC.Caller;
+  Function &Callee = *QC.Callee;
+  QC.CallerVersion = Versions.lookup(&Caller);
+  QC.CalleeVersion = Versions.lookup(&Callee);
+
+  auto GetBFI = [&](Function &F) -> BlockFrequencyInfo & {
+    return FAM.getResult<BlockFrequencyAnalysis>(F);
+  };
+  auto &CalleeTTI = FAM.getResult<TargetIRAnalysis>(Callee);
+  auto &ORE = FAM.getResult<OptimizationRemarkEmitterAnalysis>(Caller);
+  InlineCost IC = getInlineCost(CS, Params, CalleeTTI, GetAssumptionCache,
+                                {GetBFI}, &PSI, &ORE);
+  if (IC.isAlways()) {
+    QC.Priority = std::numeric_limits<double>::max();
+    return IC;
+  }
+  if (!IC)
+    return IC;
+
+  // Weight the benefit by how often the call is executed: its profile count if
+  // there is one, otherwise its frequency relative to the caller's entry.
+  BlockFrequencyInfo &CallerBFI = GetBFI(Caller);
+  double Frequency;
+  if (auto Count = PSI.getProfileCount(CS.getInstruction(), &CallerBFI))
+    Frequency = *Count;
+  else
+    Frequency = double(CallerBFI.getBlockFreq(CS.getParent()).getFrequency()) /
+                CallerBFI.getEntryFreq();
+
+  // The cost delta is positive for a call site worth inlining, the larger the
+  // cheaper the call site is compared to the threshold.
+  double Benefit = IC.getCostDelta() * Frequency;
+  QC.Priority = Benefit / std::max(getSize(Callee), 1u);
+  return IC;
+}
+
+void ModuleInliner::enqueue(CallSite CS, int InlineHistoryID) {
+  Function *Callee = CS.getCalledFunction();
+  if (!Callee || Callee->isDeclaration())
+    return;
+  Function *Caller = CS.getCaller();
+  if (Caller->hasFnAttribute(Attribute::OptimizeNone))
+    return;
+  QueuedCall QC{CS.getInstruction(), Caller, Callee, InlineHistoryID, 0.0,
+                0, 0, NextSeq++};
+  if (!computePriority(QC))
+    return;
+  Queue.push_back(QC);
+  std::push_heap(Queue.begin(), Queue.end(), QueuedCallCompare());
+}
+
+void ModuleInliner::deleteIfDead(Function &F) {
+  // Only local functions are known to have no other callers than the ones in
+  // this module.
+  if (!F.hasLocalLinkage())
+    return;
+  F.removeDeadConstantUsers();
+  if (!F.use_empty())
+    return;
+  DEBUG(dbgs() << "    Deleting dead function: " << F.getName() << "\n");
+  ModuleSize -= getSize(F);
+  Versions.erase(&F);
+  Sizes.erase(&F);
+  FAM.clear(F, F.getName());
+  // Deleting the body nulls out the call sites it contained in the queue.
+  M.getFunctionList().erase(&F);
+  ++NumDeleted;
+}
+
+bool ModuleInliner::run() {
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      ModuleSize += getSize(F);
+  const uint64_t Budget = ModuleSize + ModuleSize * ModuleInlineGrowth / 100;
+
+  // Queue the call sites in module order, which also decides between equally
+  // profitable call sites.
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    SmallVector<CallSite, 16> Calls;
+    for (Instruction &I : instructions(F))
+      if (auto CS = CallSite(&I))
+        Calls.push_back(CS);
+    for (CallSite CS : Calls)
+      enqueue(CS, -1);
+  }
+
+  bool Changed = false;
+  while (!Queue.empty()) {
+    std::pop_heap(Queue.begin(), Queue.end(), QueuedCallCompare());
+    QueuedCall QC = Queue.back();
+    Queue.pop_back();
+
+    // The call site was deleted, e.g. by the simplifications done while
+    // inlining into its caller, or along with a dead caller.
+    if (!QC.Call)
+      continue;
+    CallSite CS(cast<Instruction>(QC.Call));
+    if (CS.getCalledFunction() != QC.Callee)
+      continue;
+    Function &Caller = *QC.Caller;
+    Function &Callee = *QC.Callee;
+
+    // Re-evaluate a call site whose caller or callee changed since it was
+    // queued, and put it back in the queue if it is no longer the most
+    // profitable one.
+    bool Stale = QC.CallerVersion != Versions.lookup(&Caller) ||
+                 QC.CalleeVersion != Versions.lookup(&Callee);
+    InlineCost IC = computePriority(QC);
+    if (!IC)
+      continue;
+    if (Stale && !Queue.empty() &&
+        QueuedCallCompare()(QC, Queue.front())) {
+      Queue.push_back(QC);
+      std::push_heap(Queue.begin(), Queue.end(), QueuedCallCompare());
+      continue;
+    }
+
+    if (QC.InlineHistoryID != -1 &&
+        inlineHistoryIncludes(&Callee, QC.InlineHistoryID))
+      continue;
+
+    auto &ORE = FAM.getResult<OptimizationRemarkEmitterAnalysis>(Caller);
+    DebugLoc DLoc = CS->getDebugLoc();
+    BasicBlock *Block = CS.getParent();
+
+    using namespace ore;
+
+    unsigned CalleeSize = getSize(Callee);
+    if (!IC.isAlways() && ModuleSize + CalleeSize > Budget) {
+      DEBUG(dbgs() << "    Growth budget exhausted for " << Callee.getName()
+                   << " in " << Caller.getName() << "\n");
+      ++NumOverBudget;
+      ORE.emit([&]() {
+        return OptimizationRemarkMissed(DEBUG_TYPE, "TooMuchGrowth", DLoc,
+                                        Block)
+               << NV("Callee", &Callee) << " not inlined into "
+               << NV("Caller", &Caller)
+               << " because the module growth budget is exhausted";
+      });
+      continue;
+    }
+
+    InlineFunctionInfo IFI(
+        /*cg=*/nullptr, &GetAssumptionCache, &PSI,
+        &FAM.getResult<BlockFrequencyAnalysis>(Caller),
+        &FAM.getResult<BlockFrequencyAnalysis>(Callee));
+    if (!InlineFunction(CS, IFI)) {
+      ORE.emit([&]() {
+        return OptimizationRemarkMissed(DEBUG_TYPE, "NotInlined", DLoc, Block)
+               << NV("Callee", &Callee) << " will not be inlined into "
+               << NV("Caller", &Caller);
+      });
+      continue;
+    }
+    Changed = true;
+    ++NumInlined;
+
+    ORE.emit([&]() {
+      bool AlwaysInline = IC.isAlways();
+      StringRef RemarkName = AlwaysInline ? "AlwaysInline" : "Inlined";
+      OptimizationRemark R(DEBUG_TYPE, RemarkName, DLoc, Block);
+      R << NV("Callee", &Callee) << " inlined into " << NV("Caller", &Caller);
+      if (AlwaysInline)
+        R << " with cost=always";
+      else
+        R << " with cost=" << NV("Cost", IC.getCost())
+          << " (threshold=" << NV("Threshold", IC.getThreshold()) << ")";
+      return R;
+    });
+    DEBUG(dbgs() << "    Inlined " << Callee.getName() << " into "
+                 << Caller.getName() << " with priority " << QC.Priority
+                 << "\n");
+
+    // The call site is replaced by a copy of the callee.
+    ModuleSize += CalleeSize;
+    ModuleSize -= 1;
+    AttributeFuncs::mergeAttributesForInlining(Caller, Callee);
+    markChanged(Caller);
+
+    // Queue the call sites made visible in the caller.
+    if (!IFI.InlinedCallSites.empty()) {
+      int NewHistoryID = InlineHistory.size();
+      InlineHistory.push_back({&Callee, QC.InlineHistoryID});
+      for (CallSite NewCS : IFI.InlinedCallSites)
+        enqueue(NewCS, NewHistoryID);
+    }
+
+    deleteIfDead(Callee);
+  }
+
+  return Changed;
+}
+
+PreservedAnalyses ModuleInlinerPass::run(Module &M,
+                                         ModuleAnalysisManager &AM) {
+  if (!ModuleInliner(M, AM, Params).run())
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
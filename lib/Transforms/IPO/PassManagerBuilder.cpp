@@ -45,6 +45,10 @@ static cl::opt<bool>
     RunPartialInlining("enable-partial-inlining", cl::init(false), cl::Hidden,
                        cl::ZeroOrMore, cl::desc("Run Partial inlinining pass"));
 
+static cl::opt<bool>
+    EnableHotColdSplit("hot-cold-split", cl::init(false), cl::Hidden,
+                       cl::desc("Outline cold regions into separate functions"));
+
 static cl::opt<bool>
     RunLoopVectorization("vectorize-loops", cl::Hidden,
                          cl::desc("Run the Loop vectorization passes"));
@@ -92,6 +96,22 @@ static cl::opt<bool> EnableLoopInterchange(
     "enable-loopinterchange", cl::init(false), cl::Hidden,
     cl::desc("Enable the new, experimental LoopInterchange Pass"));
 
+static cl::opt<bool> EnableUnrollAndJam(
+    "enable-unroll-and-jam", cl::init(false), cl::Hidden,
+    cl::desc("Enable the experimental unroll and jam pass"));
+
+static cl::opt<bool> EnableFunctionSpecialization(
+    "enable-function-specialization", cl::init(false), cl::Hidden,
+    cl::desc("Enable specializing functions for constant arguments"));
+
+static cl::opt<bool> EnableHeapToStack(
+    "enable-heap-to-stack", cl::init(false), cl::Hidden,
+    cl::desc("Enable moving small heap allocations to the stack"));
+
+static cl::opt<bool> EnableLoopFusion(
+    "enable-loop-fusion", cl::init(false), cl::Hidden,
+    cl::desc("Enable the experimental loop fusion pass"));
+
 static cl::opt<bool>
     EnablePrepareForThinLTO("prepare-for-thinlto", cl::init(false), cl::Hidden,
                             cl::desc("Enable preparation for ThinLTO."));
@@ -302,6 +322,10 @@ void PassManagerBuilder::addPGOInstrPasses(legacy::PassManagerBase &MPM) {
 void PassManagerBuilder::addFunctionSimplificationPasses(
     legacy::PassManagerBase &MPM) {
   // Start of function pass.
+  // Move small allocations of inlined containers to the stack, where SROA
+  // can break them up.
+  if (EnableHeapToStack)
+    MPM.add(createHeapToStackPass());
   // Break up aggregate allocas, using SSAUpdater.
   MPM.add(createSROAPass());
   MPM.add(createEarlyCSEPass(EnableEarlyCSEMemSSA)); // Catch trivial redundancies
@@ -344,6 +368,10 @@ void PassManagerBuilder::addFunctionSimplificationPasses(
   addExtensionsToPM(EP_LateLoopOptimizations, MPM);
   MPM.add(createLoopDeletionPass());          // Delete dead loops
 
+  if (EnableLoopFusion) {
+    MPM.add(createLoopFusePass()); // Fuse adjacent loops
+    MPM.add(createCFGSimplificationPass());
+  }
   if (EnableLoopInterchange) {
     MPM.add(createLoopInterchangePass()); // Interchange loops
     MPM.add(createCFGSimplificationPass());
@@ -470,6 +498,8 @@ void PassManagerBuilder::populateModulePassManager(
     MPM.add(createCallSiteSplittingPass());
 
   MPM.add(createIPSCCPPass());          // IP SCCP
+  if (EnableFunctionSpecialization)
+    MPM.add(createFunctionSpecializationPass());
   MPM.add(createCalledValuePropagationPass());
   MPM.add(createGlobalOptimizerPass()); // Optimize out global vars
   // Promote any localized global vars.
@@ -518,6 +548,12 @@ void PassManagerBuilder::populateModulePassManager(
   if (RunPartialInlining)
     MPM.add(createPartialInliningPass());
 
+  // Split cold regions out of functions once inlining decisions are final.
+  // When preparing for (Thin)LTO this is left to the link-time pipelines, which
+  // run it after link-time inlining.
+  if (EnableHotColdSplit && !PrepareForLTO && !PrepareForThinLTO)
+    MPM.add(createHotColdSplittingPass());
+
   if (OptLevel > 1 && !PrepareForLTO && !PrepareForThinLTO)
     // Remove avail extern fns and globals definitions if we aren't
     // compiling an object file for later LTO. For LTO we want to preserve
@@ -647,6 +683,10 @@ void PassManagerBuilder::populateModulePassManager(
   addExtensionsToPM(EP_Peephole, MPM);
   addInstructionCombiningPass(MPM);
 
+  if (EnableUnrollAndJam && !DisableUnrollLoops) {
+    // Unroll and jam nests of two loops before unrolling the inner loops.
+    MPM.add(createLoopUnrollAndJamPass());
+  }
   if (!DisableUnrollLoops) {
     MPM.add(createLoopUnrollPass(OptLevel));    // Unroll small loops
 
@@ -782,6 +822,10 @@ void PassManagerBuilder::addLTOOptimizationPasses(legacy::PassManagerBase &PM) {
     PM.add(createGlobalOptimizerPass());
   PM.add(createGlobalDCEPass()); // Remove dead functions.
 
+  // Split cold regions out of functions now that link-time inlining is done.
+  if (EnableHotColdSplit)
+    PM.add(createHotColdSplittingPass());
+
   // If we didn't decide to inline a function, check to see if we can
   // transform it to pass arguments by value instead of by reference.
   PM.add(createArgumentPromotionPass());
@@ -24,6 +24,13 @@
 //   for virtual constant propagation hold and a single vtable's function
 //   returns 0, or a single vtable's function returns 1, replace each virtual
 //   call with a comparison of the vptr against that vtable's address.
+// - Speculative devirtualization (-wholeprogramdevirt-speculative): if the
+//   list of callees may be incomplete, for example because classes are also
+//   derived from in other shared objects, none of the above is sound. Instead,
+//   compare the loaded function pointer against the most likely callee, as
+//   given by the indirect call value profile or by the type metadata if it
+//   names a single implementation, and call that callee directly if it
+//   matches. The original indirect call is kept as the fallback.
 //
 // This pass is intended to be used during the regular and thin LTO pipelines.
 // During regular LTO, the pass determines the best optimization for each
@@ -73,12 +80,15 @@
 #include "llvm/Pass.h"
 #include "llvm/PassRegistry.h"
 #include "llvm/PassSupport.h"
+#include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/FunctionAttrs.h"
+#include "llvm/Transforms/Instrumentation.h"
+#include "llvm/Transforms/Utils/CallPromotionUtils.h"
 #include "llvm/Transforms/Utils/Evaluator.h"
 #include <algorithm>
 #include <cstddef>
@@ -111,6 +121,21 @@ static cl::opt<std::string> ClWriteSummary(
     cl::desc("Write summary to given YAML file after running pass"),
     cl::Hidden);
 
+static cl::opt<bool> ClSpeculative(
+    "wholeprogramdevirt-speculative",
+    cl::desc("Do not assume that the type metadata lists every target of a "
+             "virtual call; instead call the most likely target directly "
+             "under a check of the loaded function pointer"),
+    cl::Hidden);
+
+static cl::opt<unsigned> ClSpeculativeMinPercent(
+    "wholeprogramdevirt-speculative-min-percent", cl::init(50), cl::Hidden,
+    cl::desc("The percentage of the profiled calls from a call site that a "
+             "target must account for to be called speculatively"));
+
+// The maximum number of value profile records read from a virtual call site.
+static const uint32_t MaxNumProfiledTargets = 8;
+
 // Find the minimum offset that we may store a value of size Size bits at. If
 // IsAfter is set, look for an offset before the object, otherwise look for an
 // offset after the object.
@@ -451,6 +476,9 @@ struct DevirtModule {
                            VTableSlotInfo &SlotInfo,
                            WholeProgramDevirtResolution *Res);
 
+  bool trySpeculativeDevirt(MutableArrayRef<VirtualCallTarget> TargetsForSlot,
+                            VTableSlotInfo &SlotInfo);
+
   bool tryEvaluateFunctionsWithArgs(
       MutableArrayRef<VirtualCallTarget> TargetsForSlot,
       ArrayRef<uint64_t> Args);
@@ -789,6 +817,93 @@ bool DevirtModule::trySingleImplDevirt(
   return true;
 }
 
+bool DevirtModule::trySpeculativeDevirt(
+    MutableArrayRef<VirtualCallTarget> TargetsForSlot,
+    VTableSlotInfo &SlotInfo) {
+  // Value profiles identify their targets by the hash of the PGO name.
+  std::vector<uint64_t> TargetGUIDs;
+  for (VirtualCallTarget &Target : TargetsForSlot)
+    TargetGUIDs.push_back(
+        GlobalValue::getGUID(getPGOFuncName(*Target.Fn, /*InLTO=*/true)));
+
+  bool IsSingleImpl = true;
+  for (auto &&Target : TargetsForSlot)
+    if (TargetsForSlot[0].Fn != Target.Fn)
+      IsSingleImpl = false;
+
+  bool Changed = false;
+  auto Apply = [&](CallSiteInfo &CSInfo) {
+    for (auto &&VCallSite : CSInfo.CallSites) {
+      Instruction *Call = VCallSite.CS.getInstruction();
+      InstrProfValueData ValueData[MaxNumProfiledTargets];
+      uint32_t NumValueData = 0;
+      uint64_t TotalCount = 0;
+      bool HasProfile =
+          getValueProfDataFromInst(*Call, IPVK_IndirectCallTarget,
+                                   MaxNumProfiledTargets, ValueData,
+                                   NumValueData, TotalCount);
+
+      // Pick the hottest profiled target that the type metadata agrees with,
+      // or the single implementation if there is no profile.
+      unsigned TargetIdx = TargetsForSlot.size();
+      uint32_t RecordIdx = 0;
+      if (HasProfile) {
+        for (; RecordIdx != NumValueData; ++RecordIdx) {
+          auto I = find(TargetGUIDs, ValueData[RecordIdx].Value);
+          if (I != TargetGUIDs.end()) {
+            TargetIdx = I - TargetGUIDs.begin();
+            break;
+          }
+        }
+        if (TargetIdx == TargetsForSlot.size() ||
+            ValueData[RecordIdx].Count * 100 <
+                TotalCount * ClSpeculativeMinPercent)
+          continue;
+      } else if (IsSingleImpl) {
+        TargetIdx = 0;
+      } else {
+        continue;
+      }
+
+      Function *TheFn = TargetsForSlot[TargetIdx].Fn;
+      if (!isLegalToPromote(VCallSite.CS, TheFn))
+        continue;
+
+      if (RemarksEnabled) {
+        VCallSite.emitRemark("speculative", TheFn->getName(), OREGetter);
+        TargetsForSlot[TargetIdx].WasDevirt = true;
+      }
+      Changed = true;
+
+      // The indirect call stays in place for any target that the type metadata
+      // does not know about, so the type check is still needed and the unsafe
+      // use count is left alone.
+      if (!HasProfile) {
+        promoteCallWithIfThenElse(VCallSite.CS, TheFn);
+        continue;
+      }
+
+      uint64_t Count = ValueData[RecordIdx].Count;
+      pgo::promoteIndirectCall(Call, TheFn, Count, TotalCount,
+                               /*AttachProfToDirectCall=*/false,
+                               /*ORE=*/nullptr);
+
+      // Remove the promoted target from the profile of the fallback call.
+      SmallVector<InstrProfValueData, MaxNumProfiledTargets> Remaining(
+          ValueData, ValueData + NumValueData);
+      Remaining.erase(Remaining.begin() + RecordIdx);
+      Call->setMetadata(LLVMContext::MD_prof, nullptr);
+      if (!Remaining.empty())
+        annotateValueSite(M, *Call, Remaining, TotalCount - Count,
+                          IPVK_IndirectCallTarget, Remaining.size());
+    }
+  };
+  Apply(SlotInfo.CSInfo);
+  for (auto &P : SlotInfo.ConstCSInfo)
+    Apply(P.second);
+  return Changed;
+}
+
 bool DevirtModule::tryEvaluateFunctionsWithArgs(
     MutableArrayRef<VirtualCallTarget> TargetsForSlot,
     ArrayRef<uint64_t> Args) {
@@ -1468,8 +1583,12 @@ bool DevirtModule::run() {
                        cast<MDString>(S.first.TypeID)->getString())
                    .WPDRes[S.first.ByteOffset];
 
-      if (!trySingleImplDevirt(TargetsForSlot, S.second, Res) &&
-          tryVirtualConstProp(TargetsForSlot, S.second, Res, S.first))
+      // Speculation keeps the indirect calls, which cannot be expressed as a
+      // type identifier resolution, so it is only done in regular LTO.
+      if (ClSpeculative && !ExportSummary)
+        trySpeculativeDevirt(TargetsForSlot, S.second);
+      else if (!trySingleImplDevirt(TargetsForSlot, S.second, Res) &&
+               tryVirtualConstProp(TargetsForSlot, S.second, Res, S.first))
         DidVirtualConstProp = true;
 
       // Collect functions devirtualized at least for one call site for stats.
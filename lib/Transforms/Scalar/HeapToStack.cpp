@@ -0,0 +1,367 @@
+//===- HeapToStack.cpp - Promote heap allocations to the stack ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass turns calls to malloc and operator new into stack allocations.
+// After inlining, containers that only live during a single call often still
+// allocate their storage on the heap. Such an allocation is replaced with a
+// static alloca in the entry block when
+//   - its size is a constant no larger than -heap-to-stack-max-size bytes,
+//     and the stack slots created in the function stay within
+//     -heap-to-stack-max-frame-size bytes in total,
+//   - the pointer does not escape the function, as shown by CaptureTracking,
+//     and is only passed to calls that cannot free it,
+//   - every path from the allocation to a return, or back to the allocation,
+//     frees it, so that no two allocations made by it are live at once.
+// The frees are removed and lifetime markers delimit the new stack slot.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Scalar/HeapToStack.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/GlobalsModRef.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Scalar.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "heap-to-stack"
+
+STATISTIC(NumPromoted, "Number of heap allocations moved to the stack");
+
+static cl::opt<unsigned> MaxPromotedSize(
+    "heap-to-stack-max-size", cl::init(128), cl::Hidden,
+    cl::desc("The maximum size in bytes of a heap allocation that is moved "
+             "to the stack"));
+
+static cl::opt<unsigned> MaxPromotedFrameSize(
+    "heap-to-stack-max-frame-size", cl::init(1024), cl::Hidden,
+    cl::desc("The maximum number of bytes of stack that heap allocations "
+             "moved to the stack may take up in one function"));
+
+/// The alignment of the memory returned by malloc on the common targets. The
+/// stack slot must be at least as aligned, since the users may rely on it.
+static const unsigned MallocAlignment = 16;
+
+namespace {
+
+/// Follows the uses of an allocation to find out whether it escapes and to
+/// collect the calls that free it.
+struct AllocationUseTracker : public CaptureTracker {
+  AllocationUseTracker(const Instruction *Alloc, const TargetLibraryInfo &TLI)
+      : Alloc(Alloc), TLI(TLI) {}
+
+  void tooManyUses() override { Captured = true; }
+
+  bool shouldExplore(const Use *U) override {
+    auto *I = cast<Instruction>(U->getUser());
+    if (CallInst *Free = isFreeCall(I, &TLI)) {
+      // Freeing a pointer that may point to another object would free the
+      // stack slot.
+      if (Free->getArgOperand(0)->stripPointerCasts() == Alloc)
+        Frees.push_back(Free);
+      else
+        Captured = true;
+      return false;
+    }
+
+    // A call that writes memory may free the allocation even if it does not
+    // capture the pointer. Intrinsics never do.
+    ImmutableCallSite CS(I);
+    if (CS && !isa<IntrinsicInst>(I) && !CS.onlyReadsMemory()) {
+      Captured = true;
+      return false;
+    }
+    return true;
+  }
+
+  bool captured(const Use *U) override {
+    Captured = true;
+    return true;
+  }
+
+  const Instruction *Alloc;
+  const TargetLibraryInfo &TLI;
+  SmallVector<CallInst *, 4> Frees;
+  bool Captured = false;
+};
+
+/// Moves the small heap allocations of a function to the stack.
+class HeapToStack {
+public:
+  HeapToStack(Function &F, const TargetLibraryInfo &TLI,
+              OptimizationRemarkEmitter &ORE)
+      : F(F), TLI(TLI), ORE(ORE), DL(F.getParent()->getDataLayout()) {}
+
+  bool run();
+
+private:
+  /// Return true if \p Alloc, which returns a pointer to \p Size bytes of
+  /// heap memory, can be replaced with a stack slot. Collects the calls
+  /// that free it in \p Frees.
+  bool canPromote(Instruction *Alloc, uint64_t Size,
+                  SmallVectorImpl<CallInst *> &Frees);
+
+  /// Replace \p Alloc with a stack slot of \p Size bytes and remove \p Frees.
+  void promote(Instruction *Alloc, uint64_t Size,
+               ArrayRef<CallInst *> Frees);
+
+  Function &F;
+  const TargetLibraryInfo &TLI;
+  OptimizationRemarkEmitter &ORE;
+  const DataLayout &DL;
+};
+
+} // end anonymous namespace
+
+/// Return true if every path that starts right after \p Alloc reaches one of
+/// \p Frees before it leaves the function or executes \p Alloc again.
+static bool isFreedOnAllPaths(Instruction *Alloc,
+                              ArrayRef<CallInst *> Frees) {
+  SmallPtrSet<const Instruction *, 4> FreeSet(Frees.begin(), Frees.end());
+  SmallPtrSet<BasicBlock *, 16> Visited;
+  SmallVector<std::pair<BasicBlock *, BasicBlock::iterator>, 16> Worklist;
+
+  // If an invoke unwinds, nothing was allocated.
+  if (auto *II = dyn_cast<InvokeInst>(Alloc))
+    Worklist.push_back({II->getNormalDest(), II->getNormalDest()->begin()});
+  else
+    Worklist.push_back(
+        {Alloc->getParent(), std::next(BasicBlock::iterator(Alloc))});
+
+  while (!Worklist.empty()) {
+    BasicBlock *BB;
+    BasicBlock::iterator It;
+    std::tie(BB, It) = Worklist.pop_back_val();
+
+    bool Freed = false;
+    for (BasicBlock::iterator E = BB->end(); It != E && !Freed; ++It) {
+      if (&*It == Alloc)
+        return false;
+      Freed = FreeSet.count(&*It);
+    }
+    if (Freed)
+      continue;
+
+    TerminatorInst *TI = BB->getTerminator();
+    if (isa<ReturnInst>(TI) || isa<ResumeInst>(TI))
+      return false;
+    for (BasicBlock *Succ : TI->successors())
+      if (Visited.insert(Succ).second)
+        Worklist.push_back({Succ, Succ->begin()});
+  }
+  return true;
+}
+
+bool HeapToStack::canPromote(Instruction *Alloc, uint64_t Size,
+                             SmallVectorImpl<CallInst *> &Frees) {
+  if (Size > MaxPromotedSize) {
+    ORE.emit([&]() {
+      return OptimizationRemarkMissed(DEBUG_TYPE, "TooLarge", Alloc)
+             << "allocation of " << ore::NV("Size", Size)
+             << " bytes not moved to the stack: larger than "
+             << ore::NV("MaxSize", MaxPromotedSize.getValue()) << " bytes";
+    });
+    return false;
+  }
+
+  AllocationUseTracker Tracker(Alloc, TLI);
+  PointerMayBeCaptured(Alloc, &Tracker);
+  if (Tracker.Captured) {
+    ORE.emit([&]() {
+      return OptimizationRemarkMissed(DEBUG_TYPE, "Escapes", Alloc)
+             << "allocation not moved to the stack: the pointer may escape "
+                "or be freed by a call";
+    });
+    return false;
+  }
+
+  if (!isFreedOnAllPaths(Alloc, Tracker.Frees)) {
+    ORE.emit([&]() {
+      return OptimizationRemarkMissed(DEBUG_TYPE, "NotFreed", Alloc)
+             << "allocation not moved to the stack: it is not freed on all "
+                "paths";
+    });
+    return false;
+  }
+
+  Frees.append(Tracker.Frees.begin(), Tracker.Frees.end());
+  return true;
+}
+
+void HeapToStack::promote(Instruction *Alloc, uint64_t Size,
+                          ArrayRef<CallInst *> Frees) {
+  DEBUG(dbgs() << "HeapToStack: promoting " << *Alloc << "\n");
+
+  // The stack slot is a static alloca, so it is allocated once per call of
+  // the function. The lifetime markers tell the code generator that it is
+  // only live between the allocation and the frees.
+  Type *SlotTy = ArrayType::get(Type::getInt8Ty(F.getContext()), Size);
+  auto *Slot =
+      new AllocaInst(SlotTy, DL.getAllocaAddrSpace(), nullptr, MallocAlignment,
+                     Alloc->getName() + ".h2s",
+                     &*F.getEntryBlock().getFirstInsertionPt());
+
+  IRBuilder<> Builder(Alloc);
+  ConstantInt *SizeC = Builder.getInt64(Size);
+  Builder.CreateLifetimeStart(Slot, SizeC);
+  Alloc->replaceAllUsesWith(
+      Builder.CreatePointerCast(Slot, Alloc->getType()));
+
+  for (CallInst *Free : Frees) {
+    Builder.SetInsertPoint(Free);
+    Builder.CreateLifetimeEnd(Slot, SizeC);
+    Free->eraseFromParent();
+  }
+
+  // Operator new is no longer called, so it cannot throw either.
+  if (auto *II = dyn_cast<InvokeInst>(Alloc)) {
+    BranchInst::Create(II->getNormalDest(), II);
+    II->getUnwindDest()->removePredecessor(II->getParent());
+  }
+  Alloc->eraseFromParent();
+}
+
+bool HeapToStack::run() {
+  if (DL.getAllocaAddrSpace() != 0)
+    return false;
+
+  SmallVector<std::pair<Instruction *, uint64_t>, 8> Candidates;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB) {
+      if (!isMallocLikeFn(&I, &TLI) ||
+          I.getType()->getPointerAddressSpace() != 0)
+        continue;
+
+      // valloc returns page aligned memory, which the stack slot cannot
+      // provide.
+      LibFunc Func;
+      if (!TLI.getLibFunc(ImmutableCallSite(&I), Func) ||
+          Func == LibFunc_valloc)
+        continue;
+
+      // All of malloc and the variants of operator new take the size first.
+      auto *Size = dyn_cast<ConstantInt>(CallSite(&I).getArgument(0));
+      if (!Size || Size->isZero()) {
+        ORE.emit([&]() {
+          return OptimizationRemarkMissed(DEBUG_TYPE, "UnknownSize", &I)
+                 << "allocation not moved to the stack: its size is not a "
+                    "known constant";
+        });
+        continue;
+      }
+      Candidates.push_back({&I, Size->getZExtValue()});
+    }
+
+  bool Changed = false;
+  uint64_t FrameSize = 0;
+  for (auto &Candidate : Candidates) {
+    Instruction *Alloc = Candidate.first;
+    uint64_t Size = Candidate.second;
+    SmallVector<CallInst *, 4> Frees;
+    if (!canPromote(Alloc, Size, Frees))
+      continue;
+
+    // The stack slots are static allocas, so they all live in the frame at
+    // once, however short the lifetimes of the allocations are.
+    uint64_t SlotSize = alignTo(Size, MallocAlignment);
+    if (FrameSize + SlotSize > MaxPromotedFrameSize) {
+      ORE.emit([&]() {
+        return OptimizationRemarkMissed(DEBUG_TYPE, "FrameTooLarge", Alloc)
+               << "allocation of " << ore::NV("Size", Size)
+               << " bytes not moved to the stack: the function would use more "
+                  "than "
+               << ore::NV("MaxFrameSize", MaxPromotedFrameSize.getValue())
+               << " bytes of stack for moved allocations";
+      });
+      continue;
+    }
+    FrameSize += SlotSize;
+
+    ORE.emit([&]() {
+      return OptimizationRemark(DEBUG_TYPE, "HeapToStack", Alloc)
+             << "moved allocation of " << ore::NV("Size", Size)
+             << " bytes to the stack";
+    });
+    promote(Alloc, Size, Frees);
+    ++NumPromoted;
+    Changed = true;
+  }
+  return Changed;
+}
+
+PreservedAnalyses HeapToStackPass::run(Function &F,
+                                       FunctionAnalysisManager &AM) {
+  auto &TLI = AM.getResult<TargetLibraryAnalysis>(F);
+  auto &ORE = AM.getResult<OptimizationRemarkEmitterAnalysis>(F);
+
+  if (!HeapToStack(F, TLI, ORE).run())
+    return PreservedAnalyses::all();
+  PreservedAnalyses PA;
+  PA.preserve<GlobalsAA>();
+  return PA;
+}
+
+namespace {
+
+class HeapToStackLegacyPass : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  HeapToStackLegacyPass() : FunctionPass(ID) {
+    initializeHeapToStackLegacyPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (skipFunction(F))
+      return false;
+
+    auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
+    auto &ORE = getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE();
+    return HeapToStack(F, TLI, ORE).run();
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<TargetLibraryInfoWrapperPass>();
+    AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
+    AU.addPreserved<GlobalsAAWrapperPass>();
+  }
+};
+
+} // end anonymous namespace
+
+char HeapToStackLegacyPass::ID = 0;
+
+INITIALIZE_PASS_BEGIN(HeapToStackLegacyPass, DEBUG_TYPE,
+                      "Move heap allocations to the stack", false, false)
+INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(OptimizationRemarkEmitterWrapperPass)
+INITIALIZE_PASS_END(HeapToStackLegacyPass, DEBUG_TYPE,
+                    "Move heap allocations to the stack", false, false)
+
+FunctionPass *llvm::createHeapToStackPass() {
+  return new HeapToStackLegacyPass();
+}
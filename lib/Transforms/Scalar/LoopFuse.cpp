@@ -0,0 +1,438 @@
+//===- LoopFuse.cpp - Loop Fusion Pass ------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the Loop Fusion Pass, the inverse of Loop Distribution.
+// Adjacent loops over the same iteration space, as they are left behind by
+// inlining small array helpers, each stream their arrays through the cache.
+// Fusing them into one loop reuses the data while it is still in the cache.
+//
+// Two sibling innermost loops L0 and L1 are fused when
+//   - they are control-flow equivalent: L0 runs iff L1 runs,
+//   - ScalarEvolution proves that their backedge-taken counts are equal,
+//   - L1 directly follows L0 and the code between them can be hoisted above
+//     L0, and no value computed in L0 is used after it,
+//   - no dependence from iteration i of L0 to iteration j < i of L1 exists.
+// The dependences are checked with DependenceAnalysis. When it cannot rule out
+// a dependence, the accesses are compared as affine recurrences: accesses with
+// the same stride are safe if the access of L1 does not run ahead of the
+// access of L0.
+//
+// The body of L1 is appended to the body of L0 and both share the header of
+// L0. The remarks of this pass explain why two loops were not fused.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Scalar/LoopFuse.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/GlobalsModRef.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "loop-fusion"
+
+STATISTIC(NumFusedLoops, "Number of loops fused");
+
+namespace {
+
+/// Fuses the adjacent sibling loops of a function.
+class LoopFuser {
+public:
+  LoopFuser(Function &F, LoopInfo &LI, DominatorTree &DT,
+            PostDominatorTree &PDT, ScalarEvolution &SE, DependenceInfo &DI,
+            OptimizationRemarkEmitter &ORE)
+      : F(F), LI(LI), DT(DT), PDT(PDT), SE(SE), DI(DI), ORE(ORE) {}
+
+  bool run();
+
+private:
+  /// Try to fuse the sibling loops \p Siblings, which are ordered by their
+  /// position in the function.
+  bool fuseSiblings(SmallVectorImpl<Loop *> &Siblings);
+
+  /// Return true if \p L1 can be appended to the body of \p L0.
+  bool canFuse(Loop *L0, Loop *L1);
+
+  /// Return true if the loop has the shape the transformation expects.
+  /// Collect its memory accesses into \p MemAccesses.
+  bool isCandidate(Loop *L, SmallVectorImpl<Instruction *> &MemAccesses,
+                   Loop *RemarkLoop);
+
+  /// Return true if fusing the access \p Src of the first loop with the access
+  /// \p Dst of the second loop cannot reorder conflicting accesses.
+  bool isSafeToFuse(Instruction *Src, Loop *L0, Instruction *Dst, Loop *L1);
+
+  /// Append the body of \p L1 to the body of \p L0 and remove \p L1.
+  void fuse(Loop *L0, Loop *L1);
+
+  /// Emit a missed remark for \p L1, which was not fused with \p L0.
+  bool reject(Loop *L1, StringRef Name, StringRef Reason);
+
+  Function &F;
+  LoopInfo &LI;
+  DominatorTree &DT;
+  PostDominatorTree &PDT;
+  ScalarEvolution &SE;
+  DependenceInfo &DI;
+  OptimizationRemarkEmitter &ORE;
+
+  /// Position of the blocks in reverse post-order.
+  DenseMap<const BasicBlock *, unsigned> RPOIndex;
+};
+
+} // end anonymous namespace
+
+bool LoopFuser::reject(Loop *L1, StringRef Name, StringRef Reason) {
+  DEBUG(dbgs() << "LoopFuse: Not fusing " << L1->getHeader()->getName()
+               << ": " << Reason << "\n");
+  ORE.emit([&]() {
+    return OptimizationRemarkMissed(DEBUG_TYPE, Name, L1->getStartLoc(),
+                                    L1->getHeader())
+           << "loop not fused with the preceding loop: " << Reason;
+  });
+  return false;
+}
+
+static Value *getPointerOperand(Instruction *I) {
+  if (auto *Load = dyn_cast<LoadInst>(I))
+    return Load->getPointerOperand();
+  return cast<StoreInst>(I)->getPointerOperand();
+}
+
+bool LoopFuser::isCandidate(Loop *L,
+                            SmallVectorImpl<Instruction *> &MemAccesses,
+                            Loop *RemarkLoop) {
+  if (!L->empty())
+    return reject(RemarkLoop, "NotInnermost", "loop is not innermost");
+
+  BasicBlock *Latch = L->getLoopLatch();
+  if (!L->isLoopSimplifyForm() || !L->getUniqueExitBlock() ||
+      L->getExitingBlock() != Latch)
+    return reject(RemarkLoop, "NotSimplified",
+                  "loop is not in simplified form or has several exits");
+
+  for (BasicBlock *BB : L->blocks())
+    for (Instruction &I : *BB) {
+      if (auto *Load = dyn_cast<LoadInst>(&I)) {
+        if (!Load->isSimple())
+          return reject(RemarkLoop, "UnsafeInstruction",
+                        "loop contains volatile or atomic accesses");
+        MemAccesses.push_back(&I);
+      } else if (auto *Store = dyn_cast<StoreInst>(&I)) {
+        if (!Store->isSimple())
+          return reject(RemarkLoop, "UnsafeInstruction",
+                        "loop contains volatile or atomic accesses");
+        MemAccesses.push_back(&I);
+      } else if (I.mayReadOrWriteMemory() || I.mayHaveSideEffects()) {
+        return reject(RemarkLoop, "UnsafeInstruction",
+                      "loop contains calls or other instructions with side "
+                      "effects");
+      }
+    }
+
+  if (isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(L)))
+    return reject(RemarkLoop, "UnknownTripCount",
+                  "trip count cannot be computed");
+  return true;
+}
+
+bool LoopFuser::isSafeToFuse(Instruction *Src, Loop *L0, Instruction *Dst,
+                             Loop *L1) {
+  // After fusion, iteration i of L1 runs before iteration i + 1 of L0. Only
+  // conflicts from a later iteration of L0 to an earlier iteration of L1 are
+  // reordered.
+  if (!DI.depends(Src, Dst, true))
+    return true;
+
+  auto *SrcAR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(getPointerOperand(Src)));
+  auto *DstAR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(getPointerOperand(Dst)));
+  if (!SrcAR || !DstAR || SrcAR->getLoop() != L0 || DstAR->getLoop() != L1 ||
+      !SrcAR->isAffine() || !DstAR->isAffine())
+    return false;
+
+  // Both accesses must advance by the same number of bytes per iteration.
+  auto *Step = dyn_cast<SCEVConstant>(SrcAR->getStepRecurrence(SE));
+  if (!Step || Step != DstAR->getStepRecurrence(SE) || Step->isZero())
+    return false;
+  const SCEV *SrcStart = SrcAR->getStart();
+  const SCEV *DstStart = DstAR->getStart();
+  if (SE.getEffectiveSCEVType(SrcStart->getType()) !=
+      SE.getEffectiveSCEVType(DstStart->getType()))
+    return false;
+
+  // If neither access is wider than the stride, the access of iteration j of
+  // L1 only overlaps the accesses of iterations i <= j of L0 as long as its
+  // start does not run ahead of the start of L0 in the direction of the
+  // stride.
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  APInt Stride = Step->getAPInt().abs();
+  auto AccessSize = [&](Instruction *I) {
+    return DL.getTypeStoreSize(
+        getPointerOperand(I)->getType()->getPointerElementType());
+  };
+  if (Stride.ult(AccessSize(Src)) || Stride.ult(AccessSize(Dst)))
+    return false;
+
+  const SCEV *Distance = SE.getMinusSCEV(SrcStart, DstStart);
+  if (Step->getAPInt().isNonNegative())
+    return SE.isKnownNonNegative(Distance);
+  return SE.isKnownNonPositive(Distance);
+}
+
+bool LoopFuser::canFuse(Loop *L0, Loop *L1) {
+  SmallVector<Instruction *, 16> MemAccesses0, MemAccesses1;
+  if (!isCandidate(L0, MemAccesses0, L1) || !isCandidate(L1, MemAccesses1, L1))
+    return false;
+
+  BasicBlock *Preheader0 = L0->getLoopPreheader();
+  BasicBlock *Preheader1 = L1->getLoopPreheader();
+  if (!DT.dominates(Preheader0, Preheader1) ||
+      !PDT.dominates(Preheader1, Preheader0))
+    return reject(L1, "NotControlFlowEquivalent",
+                  "loops are not control-flow equivalent");
+
+  if (SE.getBackedgeTakenCount(L0) != SE.getBackedgeTakenCount(L1))
+    return reject(L1, "DifferentTripCount",
+                  "trip counts of the loops are not known to be equal");
+
+  // The exit of L0 must lead straight into the preheader of L1.
+  if (L0->getUniqueExitBlock() != Preheader1 ||
+      Preheader1->getSinglePredecessor() != L0->getLoopLatch())
+    return reject(L1, "NotAdjacent", "loops are not adjacent");
+
+  // The values of L0 are only final once all of its iterations ran.
+  for (BasicBlock *BB : L0->blocks())
+    for (Instruction &I : *BB)
+      for (User *U : I.users())
+        if (!L0->contains(cast<Instruction>(U)))
+          return reject(L1, "LiveOut",
+                        "values computed in the first loop are used after it");
+
+  // The code between the loops is moved before L0. It does not use values of
+  // L0, which were checked above.
+  for (Instruction &I : *Preheader1) {
+    if (&I == Preheader1->getTerminator())
+      break;
+    if (isa<PHINode>(I) || I.mayReadOrWriteMemory() ||
+        !isSafeToSpeculativelyExecute(&I))
+      return reject(L1, "CodeBetweenLoops",
+                    "code between the loops cannot be moved before the first "
+                    "loop");
+  }
+
+  for (Instruction *Src : MemAccesses0)
+    for (Instruction *Dst : MemAccesses1) {
+      if (!isa<StoreInst>(Src) && !isa<StoreInst>(Dst))
+        continue;
+      if (!isSafeToFuse(Src, L0, Dst, L1)) {
+        DEBUG(dbgs() << "LoopFuse: Dependence from " << *Src << " to " << *Dst
+                     << "\n");
+        return reject(L1, "Dependence", "dependence prevents fusion");
+      }
+    }
+  return true;
+}
+
+void LoopFuser::fuse(Loop *L0, Loop *L1) {
+  BasicBlock *Preheader0 = L0->getLoopPreheader();
+  BasicBlock *Header0 = L0->getHeader();
+  BasicBlock *Latch0 = L0->getLoopLatch();
+  BasicBlock *Preheader1 = L1->getLoopPreheader();
+  BasicBlock *Header1 = L1->getHeader();
+  BasicBlock *Latch1 = L1->getLoopLatch();
+  DEBUG(dbgs() << "LoopFuse: Fusing " << Header0->getName() << " and "
+               << Header1->getName() << "\n");
+
+  ORE.emit([&]() {
+    return OptimizationRemark(DEBUG_TYPE, "Fused", L0->getStartLoc(), Header0)
+           << "fused with the following loop";
+  });
+
+  SE.forgetLoop(L0);
+  SE.forgetLoop(L1);
+
+  // Hoist the code between the loops above L0.
+  Instruction *InsertPt = Preheader0->getTerminator();
+  while (&Preheader1->front() != Preheader1->getTerminator())
+    Preheader1->front().moveBefore(InsertPt);
+
+  // The latch of L0 falls through into the body of L1, and the latch of L1
+  // branches back to the header of L0.
+  auto *Br0 = cast<BranchInst>(Latch0->getTerminator());
+  Value *Cond0 = Br0->isConditional() ? Br0->getCondition() : nullptr;
+  BranchInst::Create(Header1, Br0);
+  Br0->eraseFromParent();
+  if (Cond0)
+    RecursivelyDeleteTriviallyDeadInstructions(Cond0);
+  Latch1->getTerminator()->replaceUsesOfWith(Header1, Header0);
+
+  for (PHINode &PN : Header0->phis())
+    PN.setIncomingBlock(PN.getBasicBlockIndex(Latch0), Latch1);
+  Instruction *FirstNonPHI = Header0->getFirstNonPHI();
+  while (auto *PN = dyn_cast<PHINode>(&Header1->front())) {
+    PN->setIncomingBlock(PN->getBasicBlockIndex(Preheader1), Preheader0);
+    PN->moveBefore(FirstNonPHI);
+  }
+
+  // The preheader of L1 is unreachable now.
+  LI.removeBlock(Preheader1);
+  Preheader1->eraseFromParent();
+
+  // L0 takes over the blocks of L1.
+  for (BasicBlock *BB : L1->blocks()) {
+    L0->addBlockEntry(BB);
+    LI.changeLoopFor(BB, L0);
+  }
+  if (Loop *Parent = L1->getParentLoop())
+    Parent->removeChildLoop(L1);
+  else
+    LI.removeLoop(find(LI, L1));
+  LI.destroy(L1);
+
+  DT.recalculate(F);
+  PDT.recalculate(F);
+  ++NumFusedLoops;
+}
+
+bool LoopFuser::fuseSiblings(SmallVectorImpl<Loop *> &Siblings) {
+  if (Siblings.size() < 2)
+    return false;
+  std::sort(Siblings.begin(), Siblings.end(), [&](Loop *A, Loop *B) {
+    return RPOIndex[A->getHeader()] < RPOIndex[B->getHeader()];
+  });
+
+  // A fused loop stays the first loop of the next pair.
+  bool Changed = false;
+  Loop *L0 = Siblings.front();
+  for (Loop *L1 : make_range(std::next(Siblings.begin()), Siblings.end())) {
+    if (canFuse(L0, L1)) {
+      fuse(L0, L1);
+      Changed = true;
+      continue;
+    }
+    L0 = L1;
+  }
+  return Changed;
+}
+
+bool LoopFuser::run() {
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  for (BasicBlock *BB : RPOT)
+    RPOIndex[BB] = RPOIndex.size();
+
+  // Collect the sibling sets of the loop nests before fusion changes them.
+  SmallVector<SmallVector<Loop *, 4>, 8> SiblingSets;
+  SiblingSets.emplace_back(LI.begin(), LI.end());
+  SmallVector<Loop *, 8> Worklist(LI.begin(), LI.end());
+  while (!Worklist.empty()) {
+    Loop *L = Worklist.pop_back_val();
+    if (L->empty())
+      continue;
+    SiblingSets.emplace_back(L->begin(), L->end());
+    Worklist.append(L->begin(), L->end());
+  }
+
+  bool Changed = false;
+  for (auto &Siblings : SiblingSets)
+    Changed |= fuseSiblings(Siblings);
+  return Changed;
+}
+
+namespace {
+
+class LoopFuseLegacy : public FunctionPass {
+public:
+  static char ID;
+
+  LoopFuseLegacy() : FunctionPass(ID) {
+    initializeLoopFuseLegacyPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (skipFunction(F))
+      return false;
+
+    auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    auto &PDT = getAnalysis<PostDominatorTreeWrapperPass>().getPostDomTree();
+    auto &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+    auto &DI = getAnalysis<DependenceAnalysisWrapperPass>().getDI();
+    auto &ORE = getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE();
+
+    return LoopFuser(F, LI, DT, PDT, SE, DI, ORE).run();
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addPreserved<LoopInfoWrapperPass>();
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addRequired<PostDominatorTreeWrapperPass>();
+    AU.addPreserved<PostDominatorTreeWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+    AU.addRequired<DependenceAnalysisWrapperPass>();
+    AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
+    AU.addPreserved<GlobalsAAWrapperPass>();
+  }
+};
+
+} // end anonymous namespace
+
+PreservedAnalyses LoopFusePass::run(Function &F, FunctionAnalysisManager &AM) {
+  auto &LI = AM.getResult<LoopAnalysis>(F);
+  auto &DT = AM.getResult<DominatorTreeAnalysis>(F);
+  auto &PDT = AM.getResult<PostDominatorTreeAnalysis>(F);
+  auto &SE = AM.getResult<ScalarEvolutionAnalysis>(F);
+  auto &DI = AM.getResult<DependenceAnalysis>(F);
+  auto &ORE = AM.getResult<OptimizationRemarkEmitterAnalysis>(F);
+
+  if (!LoopFuser(F, LI, DT, PDT, SE, DI, ORE).run())
+    return PreservedAnalyses::all();
+  PreservedAnalyses PA;
+  PA.preserve<LoopAnalysis>();
+  PA.preserve<DominatorTreeAnalysis>();
+  PA.preserve<PostDominatorTreeAnalysis>();
+  PA.preserve<GlobalsAA>();
+  return PA;
+}
+
+char LoopFuseLegacy::ID = 0;
+
+static const char lfuse_name[] = "Loop Fusion";
+
+INITIALIZE_PASS_BEGIN(LoopFuseLegacy, DEBUG_TYPE, lfuse_name, false, false)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(PostDominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(DependenceAnalysisWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(OptimizationRemarkEmitterWrapperPass)
+INITIALIZE_PASS_END(LoopFuseLegacy, DEBUG_TYPE, lfuse_name, false, false)
+
+FunctionPass *llvm::createLoopFusePass() { return new LoopFuseLegacy(); }
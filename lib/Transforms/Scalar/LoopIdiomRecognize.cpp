@@ -22,7 +22,7 @@
 // TODO List:
 //
 // Future loop memory idioms to recognize:
-//   memcmp, memmove, strlen, etc.
+//   memmove, strcmp, etc.
 // Future floating point idioms to recognize in -ffast-math mode:
 //   fpowi
 // Future integer operation idioms to recognize:
@@ -48,6 +48,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/Loads.h"
 #include "llvm/Analysis/LoopAccessAnalysis.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/LoopPass.h"
@@ -87,12 +88,14 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Scalar/LoopPassManager.h"
 #include "llvm/Transforms/Utils/BuildLibCalls.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Transforms/Utils/LoopUtils.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -102,6 +105,9 @@ using namespace llvm;
 
 STATISTIC(NumMemSet, "Number of memset's formed from loop stores");
 STATISTIC(NumMemCpy, "Number of memcpy's formed from loop load+stores");
+STATISTIC(NumStrLen, "Number of strlen's formed from byte search loops");
+STATISTIC(NumMemChr, "Number of memchr's formed from byte search loops");
+STATISTIC(NumMemCmp, "Number of memcmp's formed from byte compare loops");
 
 static cl::opt<bool> UseLIRCodeSizeHeurs(
     "use-lir-code-size-heurs",
@@ -121,6 +127,7 @@ class LoopIdiomRecognize {
   const TargetTransformInfo *TTI;
   const DataLayout *DL;
   bool ApplyCodeSizeHeuristics;
+  bool LoopDeleted = false;
 
 public:
   explicit LoopIdiomRecognize(AliasAnalysis *AA, DominatorTree *DT,
@@ -132,6 +139,9 @@ public:
 
   bool runOnLoop(Loop *L);
 
+  /// Return true if the loop was replaced by a library call and deleted.
+  bool isLoopDeleted() const { return LoopDeleted; }
+
 private:
   using StoreList = SmallVector<StoreInst *, 8>;
   using StoreListMap = MapVector<Value *, StoreList>;
@@ -191,6 +201,18 @@ private:
                                 PHINode *CntPhi, Value *Var, const DebugLoc DL,
                                 bool ZeroCheck, bool IsCntPhiUsedOutsideLoop);
 
+  /// @}
+  /// \name Byte Search and Compare Idiom Handling
+  /// @{
+
+  bool recognizeStrLen();
+  bool recognizeMemChrOrMemCmp();
+  bool isSideEffectFreeLoop() const;
+  bool canComputeExitValue(Value *V, bool InvariantOnly) const;
+  Value *expandExitValue(Value *V, const SCEV *Iterations,
+                         SCEVExpander &Expander, Instruction *InsertPt);
+  void deleteLoopReplacedByCall();
+
   /// @}
 };
 
@@ -219,7 +241,10 @@ public:
     const DataLayout *DL = &L->getHeader()->getModule()->getDataLayout();
 
     LoopIdiomRecognize LIR(AA, DT, LI, SE, TLI, TTI, DL);
-    return LIR.runOnLoop(L);
+    bool Changed = LIR.runOnLoop(L);
+    if (LIR.isLoopDeleted())
+      LPM.markLoopAsDeleted(*L);
+    return Changed;
   }
 
   /// This transformation requires natural loop information & requires that
@@ -237,13 +262,18 @@ char LoopIdiomRecognizeLegacyPass::ID = 0;
 
 PreservedAnalyses LoopIdiomRecognizePass::run(Loop &L, LoopAnalysisManager &AM,
                                               LoopStandardAnalysisResults &AR,
-                                              LPMUpdater &) {
+                                              LPMUpdater &Updater) {
   const auto *DL = &L.getHeader()->getModule()->getDataLayout();
 
+  // The loop may be deleted, so remember its name for the updater.
+  std::string LoopName = L.getName();
   LoopIdiomRecognize LIR(&AR.AA, &AR.DT, &AR.LI, &AR.SE, &AR.TLI, &AR.TTI, DL);
   if (!LIR.runOnLoop(&L))
     return PreservedAnalyses::all();
 
+  if (LIR.isLoopDeleted())
+    Updater.markLoopAsDeleted(L, LoopName);
+
   return getLoopPassPreservedAnalyses();
 }
 
@@ -277,7 +307,8 @@ bool LoopIdiomRecognize::runOnLoop(Loop *L) {
 
   // Disable loop idiom recognition if the function's name is a common idiom.
   StringRef Name = L->getHeader()->getParent()->getName();
-  if (Name == "memset" || Name == "memcpy")
+  if (Name == "memset" || Name == "memcpy" || Name == "strlen" ||
+      Name == "memchr" || Name == "memcmp" || Name == "bcmp")
     return false;
 
   // Determine if code size heuristics need to be applied.
@@ -1095,7 +1126,8 @@ bool LoopIdiomRecognize::avoidLIRForMultiBlockLoop(bool IsMemset,
 }
 
 bool LoopIdiomRecognize::runOnNoncountableLoop() {
-  return recognizePopcount() || recognizeAndInsertCTLZ();
+  return recognizePopcount() || recognizeAndInsertCTLZ() ||
+         recognizeStrLen() || recognizeMemChrOrMemCmp();
 }
 
 /// Check if the given conditional branch is based on the comparison between
@@ -1726,3 +1758,323 @@ void LoopIdiomRecognize::transformLoopToPopcount(BasicBlock *PreCondBB,
   //   loop. The loop would otherwise not be deleted even if it becomes empty.
   SE->forgetLoop(CurLoop);
 }
+
+/// Check if the conditional branch \p BI leaves loop \p L exactly when the
+/// operands of an i8 equality comparison are equal, or, if \p ExitOnMismatch
+/// is set, when they differ. Returns the comparison if so.
+static ICmpInst *matchByteCompareExit(BranchInst *BI, Loop *L,
+                                      bool ExitOnMismatch) {
+  if (!BI || !BI->isConditional())
+    return nullptr;
+
+  auto *Cmp = dyn_cast<ICmpInst>(BI->getCondition());
+  if (!Cmp || !Cmp->isEquality() ||
+      !Cmp->getOperand(0)->getType()->isIntegerTy(8))
+    return nullptr;
+
+  bool ExitOnTrue = !L->contains(BI->getSuccessor(0));
+  if (ExitOnTrue == !L->contains(BI->getSuccessor(1)))
+    return nullptr;
+
+  bool ExitOnEqual = (Cmp->getPredicate() == ICmpInst::ICMP_EQ) == ExitOnTrue;
+  if (ExitOnEqual == ExitOnMismatch)
+    return nullptr;
+  return Cmp;
+}
+
+/// If \p V is a simple byte load from an address that advances by one byte in
+/// every iteration of \p L, return the address of the first byte loaded.
+static const SCEV *getByteStreamStart(Value *V, Loop *L,
+                                      ScalarEvolution *SE) {
+  auto *Load = dyn_cast<LoadInst>(V);
+  if (!Load || !Load->isSimple() || !L->contains(Load) ||
+      Load->getPointerAddressSpace() != 0)
+    return nullptr;
+
+  auto *Ev = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Load->getPointerOperand()));
+  if (!Ev || Ev->getLoop() != L || !Ev->isAffine() ||
+      !Ev->getStepRecurrence(*SE)->isOne())
+    return nullptr;
+  return Ev->getStart();
+}
+
+/// Return true if nothing in the current loop but its control flow would be
+/// observable once the loop is gone.
+bool LoopIdiomRecognize::isSideEffectFreeLoop() const {
+  for (BasicBlock *BB : CurLoop->blocks())
+    for (Instruction &I : *BB)
+      if (I.mayHaveSideEffects())
+        return false;
+  return true;
+}
+
+/// Return true if the value \p V leaving the loop can be recomputed outside
+/// of it from the number of iterations executed. If \p InvariantOnly is set,
+/// the value must not depend on the iteration at all.
+bool LoopIdiomRecognize::canComputeExitValue(Value *V,
+                                             bool InvariantOnly) const {
+  auto *I = dyn_cast<Instruction>(V);
+  if (!I || !CurLoop->contains(I))
+    return true;
+  if (!SE->isSCEVable(V->getType()))
+    return false;
+
+  const SCEV *S = SE->getSCEV(V);
+  if (auto *Ev = dyn_cast<SCEVAddRecExpr>(S))
+    if (Ev->getLoop() == CurLoop)
+      return !InvariantOnly && Ev->isAffine();
+  return SE->isLoopInvariant(S, CurLoop);
+}
+
+/// Expand the value \p V has when leaving the loop after \p Iterations taken
+/// backedges. canComputeExitValue must have returned true for \p V.
+Value *LoopIdiomRecognize::expandExitValue(Value *V, const SCEV *Iterations,
+                                           SCEVExpander &Expander,
+                                           Instruction *InsertPt) {
+  auto *I = dyn_cast<Instruction>(V);
+  if (!I || !CurLoop->contains(I))
+    return V;
+
+  const SCEV *S = SE->getSCEV(V);
+  if (auto *Ev = dyn_cast<SCEVAddRecExpr>(S))
+    if (Ev->getLoop() == CurLoop)
+      S = Ev->evaluateAtIteration(Iterations, *SE);
+  return Expander.expandCodeFor(S, V->getType(), InsertPt);
+}
+
+/// Remove the current loop after all values leaving it were replaced with
+/// values computed in the preheader.
+void LoopIdiomRecognize::deleteLoopReplacedByCall() {
+  deleteDeadLoop(CurLoop, DT, SE, LI);
+  LoopDeleted = true;
+}
+
+/// Recognize a loop that scans a string for its terminating null byte:
+///
+///   loop:
+///     %p = phi i8* [ %s, %preheader ], [ %p.next, %loop ]
+///     %c = load i8, i8* %p
+///     %p.next = getelementptr i8, i8* %p, i64 1
+///     %done = icmp eq i8 %c, 0
+///     br i1 %done, label %exit, label %loop
+///
+/// and replace it with a call to strlen(%s). Every value leaving the loop is
+/// an affine recurrence evaluated at the returned length.
+bool LoopIdiomRecognize::recognizeStrLen() {
+  if (!TLI->has(LibFunc_strlen))
+    return false;
+
+  // Give up if the loop has multiple blocks or multiple backedges.
+  if (CurLoop->getNumBackEdges() != 1 || CurLoop->getNumBlocks() != 1)
+    return false;
+
+  BasicBlock *LoopBody = CurLoop->getHeader();
+  BasicBlock *ExitBB = CurLoop->getUniqueExitBlock();
+  if (!ExitBB || !CurLoop->hasDedicatedExits())
+    return false;
+
+  ICmpInst *Cmp =
+      matchByteCompareExit(dyn_cast<BranchInst>(LoopBody->getTerminator()),
+                           CurLoop, /*ExitOnMismatch=*/false);
+  if (!Cmp)
+    return false;
+
+  Value *Load = Cmp->getOperand(0);
+  Value *Char = Cmp->getOperand(1);
+  if (isa<Constant>(Load))
+    std::swap(Load, Char);
+  auto *Zero = dyn_cast<ConstantInt>(Char);
+  if (!Zero || !Zero->isZero())
+    return false;
+
+  const SCEV *Start = getByteStreamStart(Load, CurLoop, SE);
+  if (!Start || !isSideEffectFreeLoop())
+    return false;
+
+  for (PHINode &PN : ExitBB->phis())
+    if (!canComputeExitValue(PN.getIncomingValue(0), false))
+      return false;
+
+  BasicBlock *Preheader = CurLoop->getLoopPreheader();
+  Instruction *InsertPt = Preheader->getTerminator();
+  IRBuilder<> Builder(InsertPt);
+  SCEVExpander Expander(*SE, *DL, "loop-idiom");
+
+  Value *Str = Expander.expandCodeFor(Start, Builder.getInt8PtrTy(), InsertPt);
+  Value *Len = emitStrLen(Str, Builder, *DL, TLI);
+  if (!Len)
+    return false;
+
+  // The loop exits in the iteration that loads the null byte, so it takes as
+  // many backedges as there are bytes before it.
+  const SCEV *Iterations = SE->getSCEV(Len);
+  for (PHINode &PN : ExitBB->phis())
+    PN.setIncomingValue(0, expandExitValue(PN.getIncomingValue(0), Iterations,
+                                           Expander, InsertPt));
+
+  DEBUG(dbgs() << "  Formed strlen: " << *Len << "\n"
+               << "    from loop: " << *CurLoop << "\n");
+  deleteLoopReplacedByCall();
+  ++NumStrLen;
+  return true;
+}
+
+/// Recognize a rotated loop of two blocks that walks over a buffer of known
+/// length and leaves early when it finds a given byte, or when the byte
+/// differs from the byte at the same offset in a second buffer:
+///
+///   loop:
+///     %i = phi i64 [ 0, %preheader ], [ %i.next, %latch ]
+///     %c = load i8, i8* %a.i
+///     %found = icmp eq i8 %c, %ch           ; icmp ne i8 %c, %b.i for memcmp
+///     br i1 %found, label %exit, label %latch
+///   latch:
+///     %i.next = add i64 %i, 1
+///     %done = icmp eq i64 %i.next, %n
+///     br i1 %done, label %exit, label %loop
+///
+/// The first form becomes a call to memchr, the second a call to memcmp whose
+/// result is only compared against zero, which ExpandMemCmp turns back into
+/// a few wide loads when the length is a small constant.
+bool LoopIdiomRecognize::recognizeMemChrOrMemCmp() {
+  if (CurLoop->getNumBackEdges() != 1 || CurLoop->getNumBlocks() != 2)
+    return false;
+
+  BasicBlock *Header = CurLoop->getHeader();
+  BasicBlock *Latch = CurLoop->getLoopLatch();
+  BasicBlock *ExitBB = CurLoop->getUniqueExitBlock();
+  if (!Latch || Latch == Header || !ExitBB || !CurLoop->hasDedicatedExits())
+    return false;
+
+  // The latch must leave the loop after a computable number of iterations.
+  auto *LatchBr = dyn_cast<BranchInst>(Latch->getTerminator());
+  if (!LatchBr || !LatchBr->isConditional() ||
+      CurLoop->contains(LatchBr->getSuccessor(0)) ==
+          CurLoop->contains(LatchBr->getSuccessor(1)))
+    return false;
+  const SCEV *ExitCount = SE->getExitCount(CurLoop, Latch);
+  if (isa<SCEVCouldNotCompute>(ExitCount) ||
+      !SE->isLoopInvariant(ExitCount, CurLoop))
+    return false;
+
+  auto *HeaderBr = dyn_cast<BranchInst>(Header->getTerminator());
+  bool IsMemCmp = false;
+  ICmpInst *Cmp = matchByteCompareExit(HeaderBr, CurLoop, false);
+  if (!Cmp) {
+    Cmp = matchByteCompareExit(HeaderBr, CurLoop, true);
+    IsMemCmp = true;
+  }
+  if (!Cmp)
+    return false;
+  if (!TLI->has(IsMemCmp ? LibFunc_memcmp : LibFunc_memchr))
+    return false;
+
+  Value *LHS = Cmp->getOperand(0);
+  Value *RHS = Cmp->getOperand(1);
+  const SCEV *Start = getByteStreamStart(LHS, CurLoop, SE);
+  const SCEV *Start2 = getByteStreamStart(RHS, CurLoop, SE);
+  Value *Char = nullptr;
+  if (IsMemCmp) {
+    if (!Start || !Start2)
+      return false;
+  } else {
+    if (!Start) {
+      std::swap(LHS, RHS);
+      std::swap(Start, Start2);
+    }
+    if (!Start || Start2 || !CurLoop->isLoopInvariant(RHS))
+      return false;
+    Char = RHS;
+  }
+
+  if (!isSideEffectFreeLoop())
+    return false;
+
+  // The latch is the last block of an iteration, so one more byte than the
+  // number of backedges taken is compared when the loop runs to the end.
+  Type *IntPtrTy = DL->getIntPtrType(Header->getContext());
+  const SCEV *LenSCEV =
+      SE->getAddExpr(SE->getTruncateOrZeroExtend(ExitCount, IntPtrTy),
+                     SE->getOne(IntPtrTy));
+
+  BasicBlock *Preheader = CurLoop->getLoopPreheader();
+  Instruction *InsertPt = Preheader->getTerminator();
+
+  // memcmp may read all bytes of both buffers no matter where they differ,
+  // while the loop stops at the first difference. Only form it if the full
+  // length is known to be dereferenceable.
+  if (IsMemCmp) {
+    auto *Len = dyn_cast<SCEVConstant>(LenSCEV);
+    if (!Len)
+      return false;
+    for (const SCEV *S : {Start, Start2}) {
+      auto *Base = dyn_cast<SCEVUnknown>(S);
+      if (!Base || !isDereferenceableAndAlignedPointer(
+                       Base->getValue(), 1, Len->getAPInt(), *DL, InsertPt,
+                       DT))
+        return false;
+    }
+  }
+
+  // Values leaving through the header depend on where the search stopped.
+  // memcmp does not tell where the buffers differ, so they must be invariant.
+  for (PHINode &PN : ExitBB->phis())
+    for (unsigned i = 0, e = PN.getNumIncomingValues(); i != e; ++i)
+      if (!canComputeExitValue(PN.getIncomingValue(i),
+                               IsMemCmp && PN.getIncomingBlock(i) == Header))
+        return false;
+
+  IRBuilder<> Builder(InsertPt);
+  SCEVExpander Expander(*SE, *DL, "loop-idiom");
+  Value *Ptr = Expander.expandCodeFor(Start, Builder.getInt8PtrTy(), InsertPt);
+  Value *Len = Expander.expandCodeFor(LenSCEV, IntPtrTy, InsertPt);
+
+  Value *Call;
+  Value *RanToEnd;
+  const SCEV *FoundIterations = nullptr;
+  if (IsMemCmp) {
+    Value *Ptr2 =
+        Expander.expandCodeFor(Start2, Builder.getInt8PtrTy(), InsertPt);
+    Call = emitMemCmp(Ptr, Ptr2, Len, Builder, *DL, TLI);
+    if (!Call)
+      return false;
+    RanToEnd = Builder.CreateICmpEQ(Call, Builder.getInt32(0), "memcmp.eq");
+  } else {
+    Call = emitMemChr(Ptr, Builder.CreateZExt(Char, Builder.getInt32Ty()), Len,
+                      Builder, *DL, TLI);
+    if (!Call)
+      return false;
+    RanToEnd = Builder.CreateIsNull(Call, "memchr.notfound");
+    Value *End = Builder.CreatePtrToInt(Call, IntPtrTy);
+    Value *Start = Builder.CreatePtrToInt(Ptr, IntPtrTy);
+    Value *Pos = Builder.CreateSub(End, Start, "memchr.pos");
+    FoundIterations = SE->getSCEV(Pos);
+  }
+
+  // Pick the value of each exit phi depending on whether the loop would have
+  // left through the latch or through the header.
+  for (PHINode &PN : ExitBB->phis()) {
+    Value *FromHeader = nullptr, *FromLatch = nullptr;
+    for (unsigned i = 0, e = PN.getNumIncomingValues(); i != e; ++i) {
+      Value *V = PN.getIncomingValue(i);
+      if (PN.getIncomingBlock(i) == Header)
+        FromHeader = expandExitValue(V, FoundIterations, Expander, InsertPt);
+      else
+        FromLatch = expandExitValue(V, ExitCount, Expander, InsertPt);
+    }
+    Builder.SetInsertPoint(InsertPt);
+    Value *Exit = Builder.CreateSelect(RanToEnd, FromLatch, FromHeader,
+                                       PN.getName() + ".sel");
+    for (unsigned i = 0, e = PN.getNumIncomingValues(); i != e; ++i)
+      PN.setIncomingValue(i, Exit);
+  }
+
+  DEBUG(dbgs() << "  Formed " << (IsMemCmp ? "memcmp: " : "memchr: ") << *Call
+               << "\n    from loop: " << *CurLoop << "\n");
+  deleteLoopReplacedByCall();
+  if (IsMemCmp)
+    ++NumMemCmp;
+  else
+    ++NumMemChr;
+  return true;
+}
@@ -0,0 +1,293 @@
+//===- LoopUnrollAndJamPass.cpp - Loop unroll and jam pass ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass implements a simple unroll and jam heuristic: the outer loop of a
+// nest of two loops is unrolled and the copies of the inner loop are jammed
+// together when the inner loop loads values that do not depend on the outer
+// loop, so that the copies can share them. The size of the jammed inner loop
+// is estimated with the target cost model. The llvm.loop.unroll_and_jam
+// metadata enables, disables or sets the count of the transformation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Scalar/LoopUnrollAndJamPass.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/CodeMetrics.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/UnrollLoop.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "loop-unroll-and-jam"
+
+static cl::opt<unsigned> UnrollAndJamCount(
+    "unroll-and-jam-count", cl::Hidden,
+    cl::desc("Use this unroll and jam count for all loops, including loops "
+             "with an unroll_and_jam count pragma, for testing purposes"));
+
+static cl::opt<unsigned> UnrollAndJamThreshold(
+    "unroll-and-jam-threshold", cl::init(60), cl::Hidden,
+    cl::desc("Size limit of the jammed inner loop"));
+
+static cl::opt<unsigned> PragmaUnrollAndJamThreshold(
+    "pragma-unroll-and-jam-threshold", cl::init(1024), cl::Hidden,
+    cl::desc("Size limit of the jammed inner loop if the outer loop has an "
+             "unroll_and_jam pragma"));
+
+/// The largest unroll and jam count chosen by the heuristic.
+static const unsigned MaxUnrollAndJamCount = 8;
+
+// Returns the loop hint metadata node with the given name (for example,
+// "llvm.loop.unroll_and_jam.count"). If no such metadata node exists, then
+// nullptr is returned.
+static MDNode *GetUnrollAndJamMetadataForLoop(const Loop *L, StringRef Name) {
+  if (MDNode *LoopID = L->getLoopID())
+    return GetUnrollMetadata(LoopID, Name);
+  return nullptr;
+}
+
+// If loop has an unroll_and_jam_count pragma return the (necessarily
+// positive) value from the pragma. Otherwise return 0.
+static unsigned UnrollAndJamCountPragmaValue(const Loop *L) {
+  MDNode *MD =
+      GetUnrollAndJamMetadataForLoop(L, "llvm.loop.unroll_and_jam.count");
+  if (!MD)
+    return 0;
+  assert(MD->getNumOperands() == 2 &&
+         "Unroll and jam count hint metadata should have two operands.");
+  unsigned Count =
+      mdconst::extract<ConstantInt>(MD->getOperand(1))->getZExtValue();
+  assert(Count >= 1 && "Unroll and jam count must be positive.");
+  return Count;
+}
+
+/// Return true if the inner loop \p SubLoop loads a value that is the same
+/// in every iteration of \p L. The jammed copies of the inner loop share it.
+static bool hasSharedInnerLoads(Loop *L, Loop *SubLoop, ScalarEvolution &SE) {
+  for (BasicBlock *BB : SubLoop->blocks())
+    for (Instruction &I : *BB) {
+      auto *Load = dyn_cast<LoadInst>(&I);
+      if (!Load)
+        continue;
+      const SCEV *Ptr = SE.getSCEV(Load->getPointerOperand());
+      if (auto *AR = dyn_cast<SCEVAddRecExpr>(Ptr))
+        if (AR->getLoop() == SubLoop &&
+            all_of(AR->operands(),
+                   [&](const SCEV *Op) { return SE.isLoopInvariant(Op, L); }))
+          return true;
+      if (SE.isLoopInvariant(Ptr, L))
+        return true;
+    }
+  return false;
+}
+
+/// Return the number of times to unroll the outer loop \p L, or 0 if it
+/// should not be unroll and jammed.
+static unsigned
+computeUnrollAndJamCount(Loop *L, const TargetTransformInfo &TTI,
+                         ScalarEvolution &SE, AssumptionCache &AC,
+                         OptimizationRemarkEmitter &ORE) {
+  Loop *SubLoop = L->getSubLoops()[0];
+  unsigned TripMultiple = SE.getSmallConstantTripMultiple(L);
+
+  SmallPtrSet<const Value *, 32> EphValues;
+  CodeMetrics::collectEphemeralValues(L, &AC, EphValues);
+  CodeMetrics Metrics;
+  for (BasicBlock *BB : SubLoop->blocks())
+    Metrics.analyzeBasicBlock(BB, TTI, EphValues);
+  if (Metrics.notDuplicatable || Metrics.convergent) {
+    DEBUG(dbgs() << "  Inner loop cannot be duplicated\n");
+    return 0;
+  }
+
+  // An explicit count is used as is; iterations left over when it does not
+  // divide the trip count run in an epilogue loop nest.
+  unsigned Count = UnrollAndJamCount.getNumOccurrences() > 0
+                       ? UnrollAndJamCount
+                       : UnrollAndJamCountPragmaValue(L);
+  if (Count)
+    return Count > 1 ? Count : 0;
+
+  bool PragmaEnable =
+      GetUnrollAndJamMetadataForLoop(L, "llvm.loop.unroll_and_jam.enable");
+  if (!PragmaEnable && !hasSharedInnerLoads(L, SubLoop, SE)) {
+    DEBUG(dbgs() << "  No loads for the jammed inner loops to share\n");
+    return 0;
+  }
+
+  // Each copy keeps its own inner recurrences live across the jammed inner
+  // loop, so do not use more copies than there are registers for them.
+  unsigned InnerSize = std::max(Metrics.NumInsts, 1u);
+  unsigned Threshold =
+      PragmaEnable ? PragmaUnrollAndJamThreshold : UnrollAndJamThreshold;
+  unsigned NumRecurrences =
+      std::distance(SubLoop->getHeader()->phis().begin(),
+                    SubLoop->getHeader()->phis().end());
+  unsigned NumRegisters = TTI.getNumberOfRegisters(false);
+  // Prefer a count that divides the trip count, which needs no epilogue, and
+  // otherwise use the largest count that fits.
+  unsigned TripCount = SE.getSmallConstantTripCount(L);
+  unsigned LargestCount = 0;
+  for (Count = MaxUnrollAndJamCount; Count > 1; --Count) {
+    if (TripCount && Count > TripCount)
+      continue;
+    if (InnerSize * Count > Threshold)
+      continue;
+    if (NumRegisters && NumRecurrences * Count > NumRegisters)
+      continue;
+    if (TripMultiple % Count == 0)
+      return Count;
+    if (!LargestCount)
+      LargestCount = Count;
+  }
+  if (!LargestCount)
+    DEBUG(dbgs() << "  No unroll and jam count within the size threshold\n");
+  return LargestCount;
+}
+
+static bool tryToUnrollAndJamLoop(Loop *L, LoopInfo &LI, DominatorTree &DT,
+                                  ScalarEvolution &SE,
+                                  const TargetTransformInfo &TTI,
+                                  AssumptionCache &AC, DependenceInfo &DI,
+                                  OptimizationRemarkEmitter &ORE) {
+  if (GetUnrollAndJamMetadataForLoop(L, "llvm.loop.unroll_and_jam.disable"))
+    return false;
+  DEBUG(dbgs() << "Loop Unroll and Jam: F["
+               << L->getHeader()->getParent()->getName() << "] Loop %"
+               << L->getHeader()->getName() << "\n");
+
+  unsigned Count = computeUnrollAndJamCount(L, TTI, SE, AC, ORE);
+  if (!Count)
+    return false;
+  if (!isSafeToUnrollAndJam(L, SE, DT, DI)) {
+    ORE.emit([&]() {
+      return OptimizationRemarkMissed(DEBUG_TYPE, "Unsafe", L->getStartLoc(),
+                                      L->getHeader())
+             << "unable to unroll and jam loop as its shape or dependences do "
+                "not allow it";
+    });
+    return false;
+  }
+  return UnrollAndJamLoop(L, Count, SE.getSmallConstantTripMultiple(L), &LI,
+                          &SE, &DT, &ORE) != LoopUnrollResult::Unmodified;
+}
+
+static bool runImpl(LoopInfo &LI, DominatorTree &DT, ScalarEvolution &SE,
+                    const TargetTransformInfo &TTI, AssumptionCache &AC,
+                    DependenceInfo &DI, OptimizationRemarkEmitter &ORE) {
+  // Only nests of two loops are candidates, so transforming one candidate
+  // does not affect the others.
+  SmallVector<Loop *, 8> Candidates;
+  for (Loop *L : LI.getLoopsInPreorder())
+    if (L->getSubLoops().size() == 1 && L->getSubLoops()[0]->empty())
+      Candidates.push_back(L);
+
+  bool Changed = false;
+  for (Loop *L : Candidates)
+    Changed |= tryToUnrollAndJamLoop(L, LI, DT, SE, TTI, AC, DI, ORE);
+  return Changed;
+}
+
+namespace {
+
+class LoopUnrollAndJam : public FunctionPass {
+public:
+  static char ID; // Pass ID, replacement for typeid
+
+  LoopUnrollAndJam() : FunctionPass(ID) {
+    initializeLoopUnrollAndJamPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (skipFunction(F))
+      return false;
+
+    auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    auto &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+    const TargetTransformInfo &TTI =
+        getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F);
+    auto &AC = getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F);
+    auto &DI = getAnalysis<DependenceAnalysisWrapperPass>().getDI();
+    auto &ORE = getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE();
+
+    return runImpl(LI, DT, SE, TTI, AC, DI, ORE);
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequiredID(LoopSimplifyID);
+    AU.addRequiredID(LCSSAID);
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addPreserved<LoopInfoWrapperPass>();
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+    AU.addRequired<AssumptionCacheTracker>();
+    AU.addRequired<DependenceAnalysisWrapperPass>();
+    AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
+  }
+};
+
+} // end anonymous namespace
+
+char LoopUnrollAndJam::ID = 0;
+
+INITIALIZE_PASS_BEGIN(LoopUnrollAndJam, "loop-unroll-and-jam",
+                      "Unroll and Jam loops", false, false)
+INITIALIZE_PASS_DEPENDENCY(LoopSimplify)
+INITIALIZE_PASS_DEPENDENCY(LCSSAWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(TargetTransformInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(AssumptionCacheTracker)
+INITIALIZE_PASS_DEPENDENCY(DependenceAnalysisWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(OptimizationRemarkEmitterWrapperPass)
+INITIALIZE_PASS_END(LoopUnrollAndJam, "loop-unroll-and-jam",
+                    "Unroll and Jam loops", false, false)
+
+FunctionPass *llvm::createLoopUnrollAndJamPass() {
+  return new LoopUnrollAndJam();
+}
+
+PreservedAnalyses LoopUnrollAndJamPass::run(Function &F,
+                                            FunctionAnalysisManager &AM) {
+  auto &LI = AM.getResult<LoopAnalysis>(F);
+  auto &DT = AM.getResult<DominatorTreeAnalysis>(F);
+  auto &SE = AM.getResult<ScalarEvolutionAnalysis>(F);
+  auto &TTI = AM.getResult<TargetIRAnalysis>(F);
+  auto &AC = AM.getResult<AssumptionAnalysis>(F);
+  auto &DI = AM.getResult<DependenceAnalysis>(F);
+  auto &ORE = AM.getResult<OptimizationRemarkEmitterAnalysis>(F);
+
+  if (!runImpl(LI, DT, SE, TTI, AC, DI, ORE))
+    return PreservedAnalyses::all();
+  PreservedAnalyses PA;
+  PA.preserve<LoopAnalysis>();
+  PA.preserve<DominatorTreeAnalysis>();
+  return PA;
+}
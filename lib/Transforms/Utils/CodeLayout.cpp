@@ -0,0 +1,505 @@
+//===- CodeLayout.cpp - Code layout algorithms ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Ext-TSP is a layout objective that generalizes the number of fall-through
+// edges: a jump contributes its execution count if it becomes a fall-through,
+// and a fraction of it that decreases linearly with the distance if it is a
+// short forward or backward jump. Maximizing it is NP-hard, so the nodes are
+// laid out greedily:
+//   - every node starts in its own chain;
+//   - the pair of chains whose merge increases the score the most is merged,
+//     where a merge may split one of the chains in two and put the other one
+//     in between or around its halves;
+//   - when no merge increases the score, the chains are concatenated by
+//     decreasing execution density.
+//
+// See "Improved Basic Block Reordering" by A. Newell and S. Pupyrev, IEEE
+// Transactions on Computers, 2020.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/CodeLayout.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <utility>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "code-layout"
+
+static cl::opt<double> ForwardWeight(
+    "ext-tsp-forward-weight", cl::Hidden, cl::init(0.1),
+    cl::desc("The weight of forward jumps in the Ext-TSP score"));
+
+static cl::opt<double> BackwardWeight(
+    "ext-tsp-backward-weight", cl::Hidden, cl::init(0.1),
+    cl::desc("The weight of backward jumps in the Ext-TSP score"));
+
+static cl::opt<unsigned> ForwardDistance(
+    "ext-tsp-forward-distance", cl::Hidden, cl::init(1024),
+    cl::desc("The maximum distance of a forward jump that contributes to "
+             "the Ext-TSP score"));
+
+static cl::opt<unsigned> BackwardDistance(
+    "ext-tsp-backward-distance", cl::Hidden, cl::init(640),
+    cl::desc("The maximum distance of a backward jump that contributes to "
+             "the Ext-TSP score"));
+
+static cl::opt<unsigned> ChainSplitThreshold(
+    "ext-tsp-chain-split-threshold", cl::Hidden, cl::init(128),
+    cl::desc("The maximum number of nodes in a chain that may be split "
+             "when merging"));
+
+// A cluster should not span more than a huge page.
+static cl::opt<unsigned> MaxClusterSize(
+    "c3-max-cluster-size", cl::Hidden, cl::init(2 << 20),
+    cl::desc("The maximum size in bytes of a cluster of functions"));
+
+static cl::opt<unsigned> MaxDensityDegradation(
+    "c3-max-density-degradation", cl::Hidden, cl::init(8),
+    cl::desc("Do not merge clusters if the density of the caller's cluster "
+             "would drop by more than this factor"));
+
+/// The contribution of a jump from a node at \p SrcAddr of size \p SrcSize to
+/// a node at \p DstAddr, executed \p Count times.
+static double jumpScore(uint64_t SrcAddr, uint64_t SrcSize, uint64_t DstAddr,
+                        uint64_t Count) {
+  uint64_t SrcEnd = SrcAddr + SrcSize;
+  if (SrcEnd == DstAddr)
+    return Count;
+  if (SrcEnd < DstAddr) {
+    uint64_t Dist = DstAddr - SrcEnd;
+    if (Dist > ForwardDistance)
+      return 0;
+    return ForwardWeight * Count * (1.0 - (double)Dist / ForwardDistance);
+  }
+  uint64_t Dist = SrcEnd - DstAddr;
+  if (Dist > BackwardDistance)
+    return 0;
+  return BackwardWeight * Count * (1.0 - (double)Dist / BackwardDistance);
+}
+
+namespace {
+
+/// How two chains A and B are combined. A may be split at an offset into A1
+/// and A2.
+enum class MergeType { A_B, A1_B_A2, B_A2_A1, A2_A1_B };
+
+/// The edges between a chain and one of its neighbors.
+using AdjacentEdges = std::pair<unsigned, std::vector<unsigned>>;
+
+/// A sequence of nodes that is kept contiguous in the final layout.
+struct Chain {
+  unsigned Id;
+  std::vector<unsigned> Nodes;
+  uint64_t Size = 0;
+  uint64_t Count = 0;
+  /// Score of the edges within the chain.
+  double Score = 0;
+  /// Edges with both ends in the chain.
+  std::vector<unsigned> InnerEdges;
+  /// Edges to each adjacent chain, in the order the adjacency was found.
+  std::vector<AdjacentEdges> Adjacent;
+
+  bool isEntry() const { return !Nodes.empty() && Nodes.front() == 0; }
+  double density() const { return (double)Count / Size; }
+
+  std::vector<unsigned> *getEdgesTo(unsigned Other) {
+    for (auto &Adj : Adjacent)
+      if (Adj.first == Other)
+        return &Adj.second;
+    return nullptr;
+  }
+
+  void removeAdjacent(unsigned Other) {
+    Adjacent.erase(remove_if(Adjacent,
+                             [&](const AdjacentEdges &Adj) {
+                               return Adj.first == Other;
+                             }),
+                   Adjacent.end());
+  }
+};
+
+/// The best way found to merge two chains.
+struct MergeGain {
+  double Gain = -1;
+  double Score = 0;
+  /// Whether the second chain of the pair plays the role of A.
+  bool Swapped = false;
+  unsigned Offset = 0;
+  MergeType Type = MergeType::A_B;
+};
+
+class ExtTSPLayout {
+  ArrayRef<uint64_t> Sizes;
+  ArrayRef<LayoutEdge> Edges;
+  std::vector<Chain> Chains;
+  /// Outgoing edges of every node.
+  std::vector<std::vector<unsigned>> OutEdges;
+  /// Scratch space holding node addresses while a layout is scored.
+  std::vector<uint64_t> Addr;
+  DenseMap<std::pair<unsigned, unsigned>, MergeGain> GainCache;
+
+  /// Returns true if an executed edge goes from \p Src to \p Dst.
+  bool hasFallThrough(unsigned Src, unsigned Dst) const {
+    return any_of(OutEdges[Src],
+                  [&](unsigned E) { return Edges[E].Dst == Dst; });
+  }
+
+  /// Write the nodes of A and B combined as described by \p Type and
+  /// \p Offset into \p Nodes.
+  static void buildMerged(const Chain &A, const Chain &B, MergeType Type,
+                          unsigned Offset, std::vector<unsigned> &Nodes);
+  double score(ArrayRef<unsigned> Nodes, const Chain &A, const Chain &B,
+               ArrayRef<unsigned> Between);
+  MergeGain computeGain(Chain &X, Chain &Y);
+  const MergeGain &getGain(Chain &X, Chain &Y);
+  void merge(Chain &X, Chain &Y, const MergeGain &G);
+
+public:
+  ExtTSPLayout(ArrayRef<uint64_t> Sizes, ArrayRef<uint64_t> Counts,
+               ArrayRef<LayoutEdge> Edges);
+
+  std::vector<unsigned> run();
+};
+
+} // end anonymous namespace
+
+ExtTSPLayout::ExtTSPLayout(ArrayRef<uint64_t> Sizes,
+                           ArrayRef<uint64_t> Counts,
+                           ArrayRef<LayoutEdge> Edges)
+    : Sizes(Sizes), Edges(Edges), OutEdges(Sizes.size()),
+      Addr(Sizes.size()) {
+  Chains.resize(Sizes.size());
+  for (unsigned I = 0, E = Sizes.size(); I != E; ++I) {
+    Chain &C = Chains[I];
+    C.Id = I;
+    C.Nodes.push_back(I);
+    C.Size = Sizes[I];
+    C.Count = Counts[I];
+  }
+
+  for (unsigned I = 0, E = Edges.size(); I != E; ++I) {
+    const LayoutEdge &Edge = Edges[I];
+    if (!Edge.Count)
+      continue;
+    OutEdges[Edge.Src].push_back(I);
+    if (Edge.Src == Edge.Dst) {
+      Chain &C = Chains[Edge.Src];
+      C.InnerEdges.push_back(I);
+      C.Score += jumpScore(0, C.Size, 0, Edge.Count);
+      continue;
+    }
+    for (auto Ends : {std::make_pair(Edge.Src, Edge.Dst),
+                      std::make_pair(Edge.Dst, Edge.Src)}) {
+      Chain &C = Chains[Ends.first];
+      if (std::vector<unsigned> *Adj = C.getEdgesTo(Ends.second))
+        Adj->push_back(I);
+      else
+        C.Adjacent.emplace_back(Ends.second, std::vector<unsigned>(1, I));
+    }
+  }
+}
+
+void ExtTSPLayout::buildMerged(const Chain &A, const Chain &B, MergeType Type,
+                               unsigned Offset, std::vector<unsigned> &Nodes) {
+  auto A1 = makeArrayRef(A.Nodes).take_front(Offset);
+  auto A2 = makeArrayRef(A.Nodes).drop_front(Offset);
+  Nodes.clear();
+  auto append = [&](ArrayRef<unsigned> Part) {
+    Nodes.insert(Nodes.end(), Part.begin(), Part.end());
+  };
+  switch (Type) {
+  case MergeType::A_B:
+    append(A.Nodes);
+    append(B.Nodes);
+    break;
+  case MergeType::A1_B_A2:
+    append(A1);
+    append(B.Nodes);
+    append(A2);
+    break;
+  case MergeType::B_A2_A1:
+    append(B.Nodes);
+    append(A2);
+    append(A1);
+    break;
+  case MergeType::A2_A1_B:
+    append(A2);
+    append(A1);
+    append(B.Nodes);
+    break;
+  }
+}
+
+double ExtTSPLayout::score(ArrayRef<unsigned> Nodes, const Chain &A,
+                           const Chain &B, ArrayRef<unsigned> Between) {
+  uint64_t Offset = 0;
+  for (unsigned N : Nodes) {
+    Addr[N] = Offset;
+    Offset += Sizes[N];
+  }
+  double Score = 0;
+  for (ArrayRef<unsigned> EdgeList : {makeArrayRef(A.InnerEdges),
+                                      makeArrayRef(B.InnerEdges), Between})
+    for (unsigned E : EdgeList) {
+      const LayoutEdge &Edge = Edges[E];
+      Score += jumpScore(Addr[Edge.Src], Sizes[Edge.Src], Addr[Edge.Dst],
+                         Edge.Count);
+    }
+  return Score;
+}
+
+MergeGain ExtTSPLayout::computeGain(Chain &X, Chain &Y) {
+  ArrayRef<unsigned> Between = *X.getEdgesTo(Y.Id);
+  bool HasEntry = X.isEntry() || Y.isEntry();
+  double Base = X.Score + Y.Score;
+  MergeGain Best;
+  std::vector<unsigned> Nodes;
+
+  auto tryMerge = [&](bool Swapped, MergeType Type, unsigned Offset) {
+    const Chain &A = Swapped ? Y : X;
+    const Chain &B = Swapped ? X : Y;
+    buildMerged(A, B, Type, Offset, Nodes);
+    // The entry node has to stay first.
+    if (HasEntry && Nodes.front() != 0)
+      return;
+    double Score = score(Nodes, A, B, Between);
+    if (Score - Base > Best.Gain) {
+      Best.Gain = Score - Base;
+      Best.Score = Score;
+      Best.Swapped = Swapped;
+      Best.Offset = Offset;
+      Best.Type = Type;
+    }
+  };
+
+  for (bool Swapped : {false, true}) {
+    const Chain &A = Swapped ? Y : X;
+    tryMerge(Swapped, MergeType::A_B, 0);
+    if (A.Nodes.size() > ChainSplitThreshold)
+      continue;
+    for (unsigned Offset = 1, E = A.Nodes.size(); Offset < E; ++Offset) {
+      // Do not break an existing fall-through.
+      if (hasFallThrough(A.Nodes[Offset - 1], A.Nodes[Offset]))
+        continue;
+      tryMerge(Swapped, MergeType::A1_B_A2, Offset);
+      tryMerge(Swapped, MergeType::B_A2_A1, Offset);
+      tryMerge(Swapped, MergeType::A2_A1_B, Offset);
+    }
+  }
+  return Best;
+}
+
+const MergeGain &ExtTSPLayout::getGain(Chain &X, Chain &Y) {
+  auto Key = std::make_pair(std::min(X.Id, Y.Id), std::max(X.Id, Y.Id));
+  auto It = GainCache.find(Key);
+  if (It != GainCache.end())
+    return It->second;
+  return GainCache[Key] = computeGain(X, Y);
+}
+
+void ExtTSPLayout::merge(Chain &X, Chain &Y, const MergeGain &G) {
+  std::vector<unsigned> Nodes;
+  buildMerged(G.Swapped ? Y : X, G.Swapped ? X : Y, G.Type, G.Offset, Nodes);
+
+  // Cached gains of both chains are stale now.
+  for (Chain *C : {&X, &Y})
+    for (auto &Adj : C->Adjacent)
+      GainCache.erase(std::make_pair(std::min(C->Id, Adj.first),
+                                     std::max(C->Id, Adj.first)));
+
+  X.Nodes = std::move(Nodes);
+  X.Size += Y.Size;
+  X.Count += Y.Count;
+  X.Score = G.Score;
+  std::vector<unsigned> &Between = *X.getEdgesTo(Y.Id);
+  X.InnerEdges.insert(X.InnerEdges.end(), Between.begin(), Between.end());
+  X.InnerEdges.insert(X.InnerEdges.end(), Y.InnerEdges.begin(),
+                      Y.InnerEdges.end());
+  X.removeAdjacent(Y.Id);
+
+  // Redirect the edges of Y's other neighbors to X.
+  for (auto &Adj : Y.Adjacent) {
+    if (Adj.first == X.Id)
+      continue;
+    Chain &Z = Chains[Adj.first];
+    for (auto Ends : {std::make_pair(&X, &Z), std::make_pair(&Z, &X)}) {
+      unsigned Other = Ends.second->Id;
+      if (std::vector<unsigned> *Existing = Ends.first->getEdgesTo(Other))
+        Existing->insert(Existing->end(), Adj.second.begin(),
+                         Adj.second.end());
+      else
+        Ends.first->Adjacent.emplace_back(Other, Adj.second);
+    }
+    Z.removeAdjacent(Y.Id);
+  }
+
+  Y.Nodes.clear();
+  Y.InnerEdges.clear();
+  Y.Adjacent.clear();
+}
+
+std::vector<unsigned> ExtTSPLayout::run() {
+  while (true) {
+    Chain *BestX = nullptr, *BestY = nullptr;
+    MergeGain Best;
+    Best.Gain = 1e-9;
+    for (Chain &X : Chains) {
+      // Gains can be computed for pairs in any order; visit each pair once.
+      for (unsigned I = 0; I < X.Adjacent.size(); ++I) {
+        Chain &Y = Chains[X.Adjacent[I].first];
+        if (Y.Id < X.Id)
+          continue;
+        const MergeGain &G = getGain(X, Y);
+        if (G.Gain > Best.Gain) {
+          Best = G;
+          BestX = &X;
+          BestY = &Y;
+        }
+      }
+    }
+    if (!BestX)
+      break;
+    merge(*BestX, *BestY, Best);
+  }
+
+  std::vector<const Chain *> Order;
+  for (const Chain &C : Chains)
+    if (!C.Nodes.empty())
+      Order.push_back(&C);
+  std::stable_sort(Order.begin(), Order.end(),
+                   [](const Chain *L, const Chain *R) {
+                     if (L->isEntry() != R->isEntry())
+                       return L->isEntry();
+                     return L->density() > R->density();
+                   });
+
+  std::vector<unsigned> Result;
+  Result.reserve(Sizes.size());
+  for (const Chain *C : Order)
+    Result.insert(Result.end(), C->Nodes.begin(), C->Nodes.end());
+  return Result;
+}
+
+std::vector<unsigned> llvm::applyExtTspLayout(ArrayRef<uint64_t> NodeSizes,
+                                              ArrayRef<uint64_t> NodeCounts,
+                                              ArrayRef<LayoutEdge> Edges) {
+  assert(NodeSizes.size() == NodeCounts.size() && "Mismatched node info");
+  assert(all_of(NodeSizes, [](uint64_t Size) { return Size > 0; }) &&
+         "Nodes must have a positive size");
+  if (NodeSizes.empty())
+    return {};
+  return ExtTSPLayout(NodeSizes, NodeCounts, Edges).run();
+}
+
+double llvm::calcExtTspScore(ArrayRef<unsigned> Order,
+                             ArrayRef<uint64_t> NodeSizes,
+                             ArrayRef<LayoutEdge> Edges) {
+  std::vector<uint64_t> Addr(NodeSizes.size());
+  uint64_t Offset = 0;
+  for (unsigned N : Order) {
+    Addr[N] = Offset;
+    Offset += NodeSizes[N];
+  }
+  double Score = 0;
+  for (const LayoutEdge &Edge : Edges)
+    Score += jumpScore(Addr[Edge.Src], NodeSizes[Edge.Src], Addr[Edge.Dst],
+                       Edge.Count);
+  return Score;
+}
+
+std::vector<unsigned> llvm::applyC3Ordering(ArrayRef<uint64_t> FuncSizes,
+                                            ArrayRef<uint64_t> FuncCounts,
+                                            ArrayRef<LayoutEdge> Calls) {
+  assert(FuncSizes.size() == FuncCounts.size() && "Mismatched function info");
+  unsigned NumFuncs = FuncSizes.size();
+
+  struct Cluster {
+    std::vector<unsigned> Funcs;
+    uint64_t Size;
+    uint64_t Count;
+    double density() const {
+      return (double)Count / std::max<uint64_t>(Size, 1);
+    }
+  };
+  std::vector<Cluster> Clusters(NumFuncs);
+  std::vector<unsigned> FuncCluster(NumFuncs);
+  for (unsigned I = 0; I != NumFuncs; ++I) {
+    Clusters[I].Funcs.push_back(I);
+    Clusters[I].Size = FuncSizes[I];
+    Clusters[I].Count = FuncCounts[I];
+    FuncCluster[I] = I;
+  }
+
+  // The most frequent caller of every function.
+  std::vector<int> BestCaller(NumFuncs, -1);
+  std::vector<uint64_t> BestCallCount(NumFuncs, 0);
+  DenseMap<std::pair<unsigned, unsigned>, uint64_t> CallCounts;
+  for (const LayoutEdge &Call : Calls)
+    if (Call.Src != Call.Dst && Call.Count)
+      CallCounts[std::make_pair(Call.Src, Call.Dst)] += Call.Count;
+  for (const auto &Entry : CallCounts) {
+    unsigned Src = Entry.first.first, Dst = Entry.first.second;
+    // Break ties by index so that the result does not depend on the order of
+    // iteration.
+    if (Entry.second > BestCallCount[Dst] ||
+        (Entry.second == BestCallCount[Dst] && (int)Src < BestCaller[Dst])) {
+      BestCallCount[Dst] = Entry.second;
+      BestCaller[Dst] = Src;
+    }
+  }
+
+  std::vector<unsigned> ByCount(NumFuncs);
+  std::iota(ByCount.begin(), ByCount.end(), 0);
+  std::stable_sort(ByCount.begin(), ByCount.end(),
+                   [&](unsigned L, unsigned R) {
+                     return FuncCounts[L] > FuncCounts[R];
+                   });
+
+  for (unsigned Func : ByCount) {
+    if (!FuncCounts[Func] || BestCaller[Func] < 0)
+      continue;
+    Cluster &Callee = Clusters[FuncCluster[Func]];
+    Cluster &Caller = Clusters[FuncCluster[BestCaller[Func]]];
+    if (&Callee == &Caller || Callee.Size + Caller.Size > MaxClusterSize)
+      continue;
+    double MergedDensity = (double)(Callee.Count + Caller.Count) /
+                           std::max<uint64_t>(Callee.Size + Caller.Size, 1);
+    if (Caller.density() > MergedDensity * MaxDensityDegradation)
+      continue;
+
+    for (unsigned F : Callee.Funcs)
+      FuncCluster[F] = FuncCluster[BestCaller[Func]];
+    Caller.Funcs.insert(Caller.Funcs.end(), Callee.Funcs.begin(),
+                        Callee.Funcs.end());
+    Caller.Size += Callee.Size;
+    Caller.Count += Callee.Count;
+    Callee.Funcs.clear();
+  }
+
+  std::vector<const Cluster *> Order;
+  for (const Cluster &C : Clusters)
+    if (!C.Funcs.empty())
+      Order.push_back(&C);
+  std::stable_sort(Order.begin(), Order.end(),
+                   [](const Cluster *L, const Cluster *R) {
+                     return L->density() > R->density();
+                   });
+
+  std::vector<unsigned> Result;
+  Result.reserve(NumFuncs);
+  for (const Cluster *C : Order)
+    Result.insert(Result.end(), C->Funcs.begin(), C->Funcs.end());
+  return Result;
+}
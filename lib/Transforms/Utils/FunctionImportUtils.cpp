@@ -215,6 +215,20 @@ void FunctionImportGlobalProcessing::processGlobalForThinLTO(GlobalValue &GV) {
                        });
       if (IsLocal)
         GV.setDSOLocal(true);
+
+      // Mark the definitions of read-only and write-only variables. They
+      // can't be internalized yet, as the IRMover must still link imported
+      // definitions to their external declarations. See
+      // internalizeGVsAfterImport in FunctionImport.cpp. The flags are taken
+      // from the summary of this copy, as they are cleared for copies that
+      // don't prevail.
+      auto *GVar = dyn_cast<GlobalVariable>(&GV);
+      auto *GVS = dyn_cast_or_null<GlobalVarSummary>(
+          ImportIndex.findSummaryInModule(
+              VI.getGUID(), GV.getParent()->getModuleIdentifier()));
+      if (GVar && !GVar->isDeclaration() && GVS &&
+          (ImportIndex.isReadOnly(GVS) || ImportIndex.isWriteOnly(GVS)))
+        GVar->addAttribute("thinlto-internalize");
     }
   }
 
@@ -0,0 +1,491 @@
+//===-- LoopUnrollAndJam.cpp - Loop unroll and jam utilities --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements loop unroll and jam. The outer loop of a nest of two
+// loops is unrolled and the copies of the inner loop are fused into one inner
+// loop. Each iteration of the outer loop is split into the blocks before the
+// inner loop (Fore), the inner loop (Sub) and the blocks after it (Aft):
+//
+//   for i                          for i += 2
+//     Fore(i)                        Fore(i); Fore(i + 1)
+//     for j            becomes       for j
+//       Sub(i, j)                      Sub(i, j); Sub(i + 1, j)
+//     Aft(i)                         Aft(i); Aft(i + 1)
+//
+// Values the inner loop loads independently of i are then shared by the
+// copies, which gives register reuse across the iterations of the outer loop.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/UnrollLoop.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "loop-unroll-and-jam"
+
+STATISTIC(NumUnrolledAndJammed, "Number of loops unroll and jammed");
+
+namespace {
+
+/// The blocks of an outer loop with a single inner loop, in function order.
+struct LoopNestBlocks {
+  SmallVector<BasicBlock *, 4> Fore, Sub, Aft;
+  SmallPtrSet<BasicBlock *, 4> AftSet;
+};
+
+} // end anonymous namespace
+
+/// Split the blocks of \p L into the blocks before, in and after its only
+/// subloop. Return false if the loop does not have this shape.
+static bool partitionLoopNest(Loop *L, DominatorTree &DT,
+                              LoopNestBlocks &Blocks) {
+  if (L->getSubLoops().size() != 1)
+    return false;
+  Loop *SubLoop = L->getSubLoops()[0];
+  if (!SubLoop->empty())
+    return false;
+  BasicBlock *SubHeader = SubLoop->getHeader();
+  BasicBlock *SubExit = SubLoop->getUniqueExitBlock();
+  if (!SubExit)
+    return false;
+
+  SmallPtrSet<BasicBlock *, 4> ForeSet;
+  for (BasicBlock &BB : *L->getHeader()->getParent()) {
+    if (!L->contains(&BB))
+      continue;
+    if (SubLoop->contains(&BB)) {
+      Blocks.Sub.push_back(&BB);
+    } else if (DT.dominates(&BB, SubHeader)) {
+      Blocks.Fore.push_back(&BB);
+      ForeSet.insert(&BB);
+    } else if (DT.dominates(SubExit, &BB)) {
+      Blocks.Aft.push_back(&BB);
+      Blocks.AftSet.insert(&BB);
+    } else {
+      return false;
+    }
+  }
+
+  // The Fore blocks only lead to the subloop and the Aft blocks only lead
+  // back to the header or out of the loop from the latch.
+  BasicBlock *Latch = L->getLoopLatch();
+  for (BasicBlock *BB : Blocks.Fore)
+    for (BasicBlock *Succ : successors(BB))
+      if (!ForeSet.count(Succ) && Succ != SubHeader)
+        return false;
+  for (BasicBlock *BB : Blocks.Aft)
+    for (BasicBlock *Succ : successors(BB))
+      if (!Blocks.AftSet.count(Succ) && BB != Latch)
+        return false;
+  return Blocks.AftSet.count(Latch);
+}
+
+/// Collect the loads and stores of \p Blocks into \p MemInsts. Return false if
+/// the blocks contain any other instruction that touches memory or has side
+/// effects.
+static bool
+collectMemoryInstructions(ArrayRef<BasicBlock *> Blocks,
+                          SmallVectorImpl<Instruction *> &MemInsts) {
+  for (BasicBlock *BB : Blocks)
+    for (Instruction &I : *BB) {
+      if (auto *Load = dyn_cast<LoadInst>(&I)) {
+        if (!Load->isSimple())
+          return false;
+        MemInsts.push_back(&I);
+      } else if (auto *Store = dyn_cast<StoreInst>(&I)) {
+        if (!Store->isSimple())
+          return false;
+        MemInsts.push_back(&I);
+      } else if (I.mayReadOrWriteMemory() || I.mayHaveSideEffects()) {
+        return false;
+      }
+    }
+  return true;
+}
+
+/// Return true if no access in \p Earlier depends on an access in \p Later in
+/// a way that unroll and jam reverses. The code of a later iteration of the
+/// outer loop moves in front of code of an earlier iteration, so a dependence
+/// with a '>' direction on the outer loop is unsafe. Within the jammed inner
+/// loop, only iterations of the inner loop with a '<' and '>' direction pair
+/// swap their order.
+static bool checkDependences(ArrayRef<Instruction *> Earlier,
+                             ArrayRef<Instruction *> Later, unsigned LoopDepth,
+                             bool InnerLoop, DependenceInfo &DI) {
+  for (Instruction *Src : Earlier)
+    for (Instruction *Dst : Later) {
+      if (isa<LoadInst>(Src) && isa<LoadInst>(Dst))
+        continue;
+      auto D = DI.depends(Src, Dst, true);
+      if (!D)
+        continue;
+      if (D->isConfused() || D->getLevels() < LoopDepth + InnerLoop) {
+        DEBUG(dbgs() << "  Unknown dependence from " << *Src << " to " << *Dst
+                     << "\n");
+        return false;
+      }
+      unsigned Outer = D->getDirection(LoopDepth);
+      if (!InnerLoop) {
+        if (Outer & Dependence::DVEntry::GT) {
+          DEBUG(dbgs() << "  Backward dependence from " << *Src << " to "
+                       << *Dst << "\n");
+          return false;
+        }
+        continue;
+      }
+      unsigned Inner = D->getDirection(LoopDepth + 1);
+      if (((Outer & Dependence::DVEntry::LT) &&
+           (Inner & Dependence::DVEntry::GT)) ||
+          ((Outer & Dependence::DVEntry::GT) &&
+           (Inner & Dependence::DVEntry::LT))) {
+        DEBUG(dbgs() << "  Dependence from " << *Src << " to " << *Dst
+                     << " prevents jamming\n");
+        return false;
+      }
+    }
+  return true;
+}
+
+/// Collect the Aft instructions that compute the values the header phis of
+/// \p L receive from the latch. They are moved to the Fore blocks so that the
+/// next copy of the Fore blocks can use them. Return false if they cannot be
+/// moved.
+static bool collectHeaderPhiOperands(Loop *L, const LoopNestBlocks &Blocks,
+                                     SmallPtrSetImpl<Instruction *> &ToMove) {
+  Loop *SubLoop = L->getSubLoops()[0];
+  SmallVector<Value *, 8> Worklist;
+  for (PHINode &PN : L->getHeader()->phis())
+    Worklist.push_back(PN.getIncomingValueForBlock(L->getLoopLatch()));
+  while (!Worklist.empty()) {
+    auto *I = dyn_cast<Instruction>(Worklist.pop_back_val());
+    if (!I || ToMove.count(I))
+      continue;
+    if (SubLoop->contains(I))
+      return false;
+    if (!Blocks.AftSet.count(I->getParent()))
+      continue;
+    if (isa<PHINode>(I) || I->mayReadOrWriteMemory() ||
+        I->mayHaveSideEffects())
+      return false;
+    ToMove.insert(I);
+    Worklist.append(I->op_begin(), I->op_end());
+  }
+  return true;
+}
+
+static bool hasSimpleShape(Loop *L) {
+  BasicBlock *Latch = L->getLoopLatch();
+  if (!L->getLoopPreheader() || !Latch || L->getExitingBlock() != Latch ||
+      !L->getUniqueExitBlock())
+    return false;
+  auto *BI = dyn_cast<BranchInst>(Latch->getTerminator());
+  return BI && BI->isConditional();
+}
+
+bool llvm::isSafeToUnrollAndJam(Loop *L, ScalarEvolution &SE,
+                                DominatorTree &DT, DependenceInfo &DI) {
+  LoopNestBlocks Blocks;
+  if (!hasSimpleShape(L) || !partitionLoopNest(L, DT, Blocks)) {
+    DEBUG(dbgs() << "  Not a loop nest of the expected shape\n");
+    return false;
+  }
+  Loop *SubLoop = L->getSubLoops()[0];
+  if (!hasSimpleShape(SubLoop) ||
+      !SubLoop->getUniqueExitBlock()->getSinglePredecessor()) {
+    DEBUG(dbgs() << "  Inner loop is not in simplified form\n");
+    return false;
+  }
+
+  // All copies of the inner loop must run the same number of iterations.
+  const SCEV *SubLoopBECount = SE.getBackedgeTakenCount(SubLoop);
+  if (isa<SCEVCouldNotCompute>(SubLoopBECount) ||
+      !SE.isLoopInvariant(SubLoopBECount, L)) {
+    DEBUG(dbgs() << "  Inner loop trip count varies with the outer loop\n");
+    return false;
+  }
+
+  SmallPtrSet<Instruction *, 8> ToMove;
+  if (!collectHeaderPhiOperands(L, Blocks, ToMove)) {
+    DEBUG(dbgs() << "  Outer loop recurrence depends on the inner loop\n");
+    return false;
+  }
+
+  SmallVector<Instruction *, 8> ForeMemInsts, SubMemInsts, AftMemInsts;
+  if (!collectMemoryInstructions(Blocks.Fore, ForeMemInsts) ||
+      !collectMemoryInstructions(Blocks.Sub, SubMemInsts) ||
+      !collectMemoryInstructions(Blocks.Aft, AftMemInsts)) {
+    DEBUG(dbgs() << "  Loop nest contains calls or unsimple accesses\n");
+    return false;
+  }
+
+  unsigned LoopDepth = L->getLoopDepth();
+  return checkDependences(ForeMemInsts, SubMemInsts, LoopDepth, false, DI) &&
+         checkDependences(ForeMemInsts, AftMemInsts, LoopDepth, false, DI) &&
+         checkDependences(SubMemInsts, AftMemInsts, LoopDepth, false, DI) &&
+         checkDependences(SubMemInsts, SubMemInsts, LoopDepth, true, DI);
+}
+
+/// Add llvm.loop.unroll_and_jam.disable to the loop metadata of \p L, dropping
+/// the other unroll and jam hints.
+static void setLoopAlreadyUnrollAndJammed(Loop *L) {
+  MDNode *LoopID = L->getLoopID();
+  SmallVector<Metadata *, 4> MDs;
+  // Reserve first location for self reference to the LoopID metadata node.
+  MDs.push_back(nullptr);
+  if (LoopID) {
+    for (unsigned i = 1, ie = LoopID->getNumOperands(); i < ie; ++i) {
+      bool IsUnrollAndJamMetadata = false;
+      if (auto *MD = dyn_cast<MDNode>(LoopID->getOperand(i))) {
+        const MDString *S = dyn_cast<MDString>(MD->getOperand(0));
+        IsUnrollAndJamMetadata =
+            S && S->getString().startswith("llvm.loop.unroll_and_jam.");
+      }
+      if (!IsUnrollAndJamMetadata)
+        MDs.push_back(LoopID->getOperand(i));
+    }
+  }
+
+  LLVMContext &Context = L->getHeader()->getContext();
+  MDs.push_back(MDNode::get(
+      Context, MDString::get(Context, "llvm.loop.unroll_and_jam.disable")));
+  MDNode *NewLoopID = MDNode::get(Context, MDs);
+  // Set operand 0 to refer to the loop id itself.
+  NewLoopID->replaceOperandWith(0, NewLoopID);
+  L->setLoopID(NewLoopID);
+}
+
+/// Replace the terminator of \p BB with an unconditional branch to \p Dest.
+static void replaceWithBranch(BasicBlock *BB, BasicBlock *Dest,
+                              SmallVectorImpl<WeakTrackingVH> &DeadInsts) {
+  auto *BI = cast<BranchInst>(BB->getTerminator());
+  if (BI->isConditional())
+    DeadInsts.push_back(BI->getCondition());
+  BranchInst::Create(Dest, BI);
+  BI->eraseFromParent();
+}
+
+LoopUnrollResult llvm::UnrollAndJamLoop(Loop *L, unsigned Count,
+                                        unsigned TripMultiple, LoopInfo *LI,
+                                        ScalarEvolution *SE, DominatorTree *DT,
+                                        OptimizationRemarkEmitter *ORE) {
+  assert(Count > 1 && "Expected an unroll and jam factor!");
+
+  // If the trip count is not known to be a multiple of Count, run the last
+  // iterations in an epilogue copy of the loop nest. This leaves a loop whose
+  // trip count is a multiple of Count. The epilogue copies the loop metadata,
+  // so mark the loop first to keep the epilogue from being transformed again.
+  if (TripMultiple % Count != 0) {
+    MDNode *OrigLoopID = L->getLoopID();
+    setLoopAlreadyUnrollAndJammed(L);
+    if (!SE ||
+        !UnrollRuntimeLoopRemainder(L, Count, /*AllowExpensiveTripCount=*/false,
+                                    /*UseEpilogRemainder=*/true,
+                                    /*UnrollRemainder=*/false, LI, SE, DT,
+                                    /*AC=*/nullptr, /*PreserveLCSSA=*/true)) {
+      if (OrigLoopID)
+        L->setLoopID(OrigLoopID);
+      else
+        L->getLoopLatch()->getTerminator()->setMetadata(LLVMContext::MD_loop,
+                                                        nullptr);
+      DEBUG(dbgs() << "Could not create a remainder loop for %"
+                   << L->getHeader()->getName() << "\n");
+      if (ORE)
+        ORE->emit([&]() {
+          return OptimizationRemarkMissed(DEBUG_TYPE, "NoRemainder",
+                                          L->getStartLoc(), L->getHeader())
+                 << "unable to unroll and jam loop as no remainder loop can be "
+                    "created for its trip count";
+        });
+      return LoopUnrollResult::Unmodified;
+    }
+  }
+
+  LoopNestBlocks Blocks;
+  bool IsNest = partitionLoopNest(L, *DT, Blocks);
+  assert(IsNest && "Expected a legal loop nest!");
+  (void)IsNest;
+
+  Loop *SubLoop = L->getSubLoops()[0];
+  BasicBlock *Header = L->getHeader();
+  BasicBlock *Latch = L->getLoopLatch();
+  BasicBlock *Exit = L->getUniqueExitBlock();
+  BasicBlock *SubPreheader = SubLoop->getLoopPreheader();
+  BasicBlock *SubHeader = SubLoop->getHeader();
+  BasicBlock *SubLatch = SubLoop->getLoopLatch();
+  BasicBlock *SubExit = SubLoop->getUniqueExitBlock();
+  Function *F = Header->getParent();
+
+  DEBUG(dbgs() << "UNROLL AND JAM loop %" << Header->getName() << " by "
+               << Count << "\n");
+  if (ORE)
+    ORE->emit([&]() {
+      return OptimizationRemark(DEBUG_TYPE, "UnrolledAndJammed",
+                                L->getStartLoc(), Header)
+             << "unroll and jammed loop by a factor of "
+             << ore::NV("UnrollCount", Count);
+    });
+
+  if (SE)
+    SE->forgetLoop(L);
+
+  // Move the computation of the values the outer recurrences take around the
+  // backedge to the end of the Fore blocks, in dominance order.
+  SmallPtrSet<Instruction *, 8> ToMove;
+  collectHeaderPhiOperands(L, Blocks, ToMove);
+  for (auto *Node : depth_first(DT->getNode(SubExit))) {
+    BasicBlock *BB = Node->getBlock();
+    if (!Blocks.AftSet.count(BB))
+      continue;
+    for (auto I = BB->begin(); I != BB->end();) {
+      Instruction *Inst = &*I++;
+      if (ToMove.count(Inst))
+        Inst->moveBefore(SubPreheader->getTerminator());
+    }
+  }
+
+  // The latch values of the outer header phis, taken before the copies are
+  // made.
+  SmallVector<std::pair<PHINode *, Value *>, 4> HeaderPhis;
+  for (PHINode &PN : Header->phis())
+    HeaderPhis.push_back({&PN, PN.getIncomingValueForBlock(Latch)});
+
+  // Clone the loop body Count - 1 times. The copies of each group of blocks
+  // are placed after the previous copy of the group.
+  SmallVector<std::unique_ptr<ValueToValueMapTy>, 4> VMaps;
+  VMaps.emplace_back(nullptr);
+  BasicBlock *ForeInsertPt = Blocks.Fore.back();
+  BasicBlock *SubInsertPt = Blocks.Sub.back();
+  BasicBlock *AftInsertPt = Blocks.Aft.back();
+  for (unsigned It = 1; It != Count; ++It) {
+    VMaps.emplace_back(new ValueToValueMapTy());
+    ValueToValueMapTy &VMap = *VMaps.back();
+    SmallVector<BasicBlock *, 8> NewBlocks;
+    auto CloneBlocks = [&](ArrayRef<BasicBlock *> Group, Loop *ParentLoop,
+                           BasicBlock *&InsertPt) {
+      for (BasicBlock *BB : Group) {
+        BasicBlock *New = CloneBasicBlock(BB, VMap, "." + Twine(It), F);
+        New->moveAfter(InsertPt);
+        InsertPt = New;
+        VMap[BB] = New;
+        ParentLoop->addBasicBlockToLoop(New, *LI);
+        NewBlocks.push_back(New);
+      }
+    };
+    CloneBlocks(Blocks.Fore, L, ForeInsertPt);
+    CloneBlocks(Blocks.Sub, SubLoop, SubInsertPt);
+    CloneBlocks(Blocks.Aft, L, AftInsertPt);
+    remapInstructionsInBlocks(NewBlocks, VMap);
+  }
+
+  auto GetValue = [&](unsigned It, Value *V) -> Value * {
+    if (It == 0)
+      return V;
+    auto I = VMaps[It]->find(V);
+    return I == VMaps[It]->end() ? V : static_cast<Value *>(I->second);
+  };
+  auto GetBlock = [&](unsigned It, BasicBlock *BB) {
+    return cast<BasicBlock>(GetValue(It, BB));
+  };
+  unsigned Last = Count - 1;
+
+  // The outer header phis of a copy are the values the previous copy passes
+  // around the backedge.
+  for (unsigned It = 1; It != Count; ++It)
+    for (auto &HeaderPhi : HeaderPhis) {
+      auto *PN = cast<PHINode>(GetValue(It, HeaderPhi.first));
+      PN->replaceAllUsesWith(GetValue(It - 1, HeaderPhi.second));
+      PN->eraseFromParent();
+    }
+  for (auto &HeaderPhi : HeaderPhis) {
+    PHINode *PN = HeaderPhi.first;
+    unsigned Idx = PN->getBasicBlockIndex(Latch);
+    PN->setIncomingValue(Idx, GetValue(Last, HeaderPhi.second));
+    PN->setIncomingBlock(Idx, GetBlock(Last, Latch));
+  }
+
+  // Chain the copies of each group: all Fore blocks run first, then the
+  // jammed inner loop and then all Aft blocks.
+  SmallVector<WeakTrackingVH, 8> DeadInsts;
+  BasicBlock *LastSubPreheader = GetBlock(Last, SubPreheader);
+  BasicBlock *LastSubLatch = GetBlock(Last, SubLatch);
+  BasicBlock *LastLatch = GetBlock(Last, Latch);
+  Instruction *SubHeaderInsertPt = SubHeader->getFirstNonPHI();
+  Instruction *SubExitInsertPt = SubExit->getFirstNonPHI();
+  for (unsigned It = 0; It != Count; ++It) {
+    BasicBlock *NewSubPreheader = GetBlock(It, SubPreheader);
+    BasicBlock *NewSubHeader = GetBlock(It, SubHeader);
+    BasicBlock *NewSubLatch = GetBlock(It, SubLatch);
+    BasicBlock *NewSubExit = GetBlock(It, SubExit);
+    BasicBlock *NewLatch = GetBlock(It, Latch);
+    if (It != Last) {
+      NewSubPreheader->getTerminator()->replaceUsesOfWith(
+          NewSubHeader, GetBlock(It + 1, Header));
+      replaceWithBranch(NewSubLatch, GetBlock(It + 1, SubHeader), DeadInsts);
+      replaceWithBranch(NewLatch, GetBlock(It + 1, SubExit), DeadInsts);
+    } else {
+      NewSubPreheader->getTerminator()->replaceUsesOfWith(NewSubHeader,
+                                                          SubHeader);
+      NewSubLatch->getTerminator()->replaceUsesOfWith(NewSubHeader, SubHeader);
+      NewSubLatch->getTerminator()->replaceUsesOfWith(NewSubExit, SubExit);
+      NewLatch->getTerminator()->replaceUsesOfWith(GetBlock(It, Header),
+                                                   Header);
+    }
+
+    // The inner recurrences of all copies live in the header of the jammed
+    // inner loop, and the inner loop values used after it in its exit block.
+    SmallVector<PHINode *, 4> Phis;
+    for (PHINode &PN : NewSubHeader->phis())
+      Phis.push_back(&PN);
+    for (PHINode *PN : Phis) {
+      PN->setIncomingBlock(PN->getBasicBlockIndex(NewSubPreheader),
+                           LastSubPreheader);
+      PN->setIncomingBlock(PN->getBasicBlockIndex(NewSubLatch), LastSubLatch);
+      if (It != 0)
+        PN->moveBefore(SubHeaderInsertPt);
+    }
+    Phis.clear();
+    for (PHINode &PN : NewSubExit->phis())
+      Phis.push_back(&PN);
+    for (PHINode *PN : Phis) {
+      PN->setIncomingBlock(PN->getBasicBlockIndex(NewSubLatch), LastSubLatch);
+      if (It != 0)
+        PN->moveBefore(SubExitInsertPt);
+    }
+  }
+
+  // The loop is left from the last copy of the latch.
+  for (PHINode &PN : Exit->phis()) {
+    unsigned Idx = PN.getBasicBlockIndex(Latch);
+    PN.setIncomingValue(Idx, GetValue(Last, PN.getIncomingValue(Idx)));
+    PN.setIncomingBlock(Idx, LastLatch);
+  }
+
+  for (WeakTrackingVH &V : DeadInsts)
+    RecursivelyDeleteTriviallyDeadInstructions(V);
+  DT->recalculate(*F);
+  setLoopAlreadyUnrollAndJammed(L);
+  ++NumUnrolledAndJammed;
+  return LoopUnrollResult::PartiallyUnrolled;
+}
@@ -67,6 +67,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/ADT/iterator_range.h"
+#include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/BasicAliasAnalysis.h"
 #include "llvm/Analysis/BlockFrequencyInfo.h"
@@ -83,6 +84,7 @@
 #include "llvm/Analysis/ScalarEvolutionExpressions.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Analysis/VectorUtils.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/BasicBlock.h"
@@ -144,6 +146,7 @@ using namespace llvm;
 
 STATISTIC(LoopsVectorized, "Number of loops vectorized");
 STATISTIC(LoopsAnalyzed, "Number of loops analyzed for vectorization");
+STATISTIC(LoopsEpilogueVectorized, "Number of epilogue loops vectorized");
 
 static cl::opt<bool>
     EnableIfConversion("enable-if-conversion", cl::init(true), cl::Hidden,
@@ -157,6 +160,24 @@ static cl::opt<unsigned> TinyTripCountVectorThreshold(
              "value are vectorized only if no scalar iteration overheads "
              "are incurred."));
 
+static cl::opt<bool> EnableEpilogueVectorization(
+    "enable-epilogue-vectorization", cl::init(false), cl::Hidden,
+    cl::desc("Vectorize the scalar remainder of a vectorized loop with a "
+             "narrower vectorization factor when the cost model finds it "
+             "profitable."));
+
+static cl::opt<bool> EnableMaskedTailFolding(
+    "enable-masked-tail-folding", cl::init(false), cl::Hidden,
+    cl::desc("Fold the remainder iterations of a vectorized loop into the "
+             "vector loop by masking all memory accesses, instead of running "
+             "them in a scalar epilogue, when the target supports masked "
+             "loads and stores and the cost model prefers it."));
+
+static cl::opt<bool> EnableVPlanNativePath(
+    "enable-vplan-native-path", cl::init(false), cl::Hidden,
+    cl::desc("Enable the VPlan-native vectorization path, which vectorizes "
+             "outer loops annotated with an explicit vectorization hint."));
+
 static cl::opt<bool> MaximizeBandwidth(
     "vectorizer-maximize-bandwidth", cl::init(false), cl::Hidden,
     cl::desc("Maximize bandwidth when selecting vectorization factor which "
@@ -440,6 +461,18 @@ public:
   // Return true if any runtime check is added.
   bool areSafetyChecksAdded() { return AddedSafetyChecks; }
 
+  /// Create an i1 phi in the scalar preheader that is true if the scalar loop
+  /// is entered from the vector loop, i.e. if all runtime checks passed, and
+  /// false if it is entered from one of the bypass blocks.
+  PHINode *createVectorLoopTakenPhi();
+
+  /// Instead of emitting SCEV and memory runtime checks, bypass the vector
+  /// loop if \p ChecksPassed is false. Used for an epilogue vector loop whose
+  /// runtime checks are implied by the checks of the main vector loop.
+  void reuseRuntimeChecks(Value *ChecksPassed) {
+    RuntimeChecksPassed = ChecksPassed;
+  }
+
   /// A type for vectorized values in the new loop. Each value from the
   /// original loop, when vectorized, is represented by UF vector values in the
   /// new unrolled loop, where UF is the unroll factor.
@@ -506,6 +539,21 @@ public:
   /// the instruction.
   void setDebugLocFromInst(IRBuilder<> &B, const Value *Ptr);
 
+  /// Create the empty vector phis of a phi node \p Phi of an inner loop header
+  /// or of a join block, when vectorizing an outer loop. Their incoming values
+  /// are added by fixNestedPHIs.
+  void widenNestedPHI(PHINode *Phi);
+
+  /// Add the incoming values to the vector phis created by widenNestedPHI.
+  /// \p GetVectorBB maps a block of the original loop nest to the block of the
+  /// vector loop nest ending with the corresponding branch.
+  void fixNestedPHIs(function_ref<BasicBlock *(BasicBlock *)> GetVectorBB);
+
+  /// Keep the values live out of the masked inner loop \p L, for unroll part
+  /// \p Part, of the lanes active in the current iteration: \p Active is the
+  /// header phi of the mask of the active lanes.
+  void vectorizeInnerLoopLiveOuts(Loop *L, unsigned Part, PHINode *Active);
+
 protected:
   friend class LoopVectorizationPlanner;
 
@@ -632,6 +680,10 @@ protected:
   /// Emit bypass checks to check any memory assumptions we may have made.
   void emitMemRuntimeChecks(Loop *L, BasicBlock *Bypass);
 
+  /// Emit a bypass check on the runtime check result set by
+  /// reuseRuntimeChecks.
+  void emitReusedRuntimeChecks(Loop *L, BasicBlock *Bypass);
+
   /// Add additional metadata to \p To that was not present on \p Orig.
   ///
   /// Currently this is used to add the noalias annotations based on the
@@ -750,9 +802,21 @@ protected:
   // Record whether runtime checks are added.
   bool AddedSafetyChecks = false;
 
+  /// If set, the runtime checks of another vector loop that are reused by
+  /// this one instead of emitting its own.
+  Value *RuntimeChecksPassed = nullptr;
+
   // Holds the end values for each induction variable. We save the end values
   // so we can later fix-up the external users of the induction variables.
   DenseMap<PHINode *, Value *> IVEndValues;
+
+  /// The phis widened by widenNestedPHI, whose incoming values are added by
+  /// fixNestedPHIs.
+  PhiVector NestedPHIsToFix;
+
+  /// The values live out of masked inner loops, of the lanes that exited the
+  /// inner loop, for each LCSSA phi using them.
+  DenseMap<PHINode *, VectorParts> InnerLoopLiveOuts;
 };
 
 class InnerLoopUnroller : public InnerLoopVectorizer {
@@ -1543,9 +1607,9 @@ public:
       std::function<const LoopAccessInfo &(Loop &)> *GetLAA, LoopInfo *LI,
       OptimizationRemarkEmitter *ORE, LoopVectorizationRequirements *R,
       LoopVectorizeHints *H, DemandedBits *DB, AssumptionCache *AC)
-      : TheLoop(L), PSE(PSE), TLI(TLI), TTI(TTI), DT(DT), GetLAA(GetLAA),
-        ORE(ORE), InterleaveInfo(PSE, L, DT, LI), Requirements(R), Hints(H),
-        DB(DB), AC(AC) {}
+      : TheLoop(L), PSE(PSE), TLI(TLI), TTI(TTI), DT(DT), LI(LI),
+        GetLAA(GetLAA), ORE(ORE), InterleaveInfo(PSE, L, DT, LI),
+        Requirements(R), Hints(H), DB(DB), AC(AC) {}
 
   /// ReductionList contains the reduction descriptors for all
   /// of the reductions that were found in the loop.
@@ -1649,7 +1713,7 @@ public:
 	  return LAI->getDepChecker().getMaxSafeRegisterWidth();
   }
 
-  bool hasStride(Value *V) { return LAI->hasStride(V); }
+  bool hasStride(Value *V) { return LAI && LAI->hasStride(V); }
 
   /// Returns true if the target machine supports masked store operation
   /// for the given \p DataType and kind of access to \p Ptr.
@@ -1689,7 +1753,27 @@ public:
 
   /// Returns true if vector representation of the instruction \p I
   /// requires mask.
-  bool isMaskRequired(const Instruction *I) { return (MaskedOp.count(I) != 0); }
+  bool isMaskRequired(const Instruction *I) {
+    if (FoldTailByMasking && (isa<LoadInst>(I) || isa<StoreInst>(I)))
+      return true;
+    return (MaskedOp.count(I) != 0);
+  }
+
+  /// Returns true if the whole loop body can be predicated with a mask of the
+  /// lanes whose iterations are below the trip count, so that the remainder
+  /// iterations run in the vector loop instead of a scalar epilogue.
+  bool canFoldTailByMasking();
+
+  /// Returns true if the tail of the loop is folded into the vector loop by
+  /// masking, in which case all memory accesses are masked.
+  bool foldTailByMasking() const { return FoldTailByMasking; }
+
+  /// Decide whether to fold the tail of the loop by masking.
+  void setFoldTailByMasking(bool Fold) {
+    assert((!Fold || canFoldTailByMasking()) &&
+           "Tail cannot be folded by masking");
+    FoldTailByMasking = Fold;
+  }
 
   unsigned getNumStores() const { return LAI->getNumStores(); }
   unsigned getNumLoads() const { return LAI->getNumLoads(); }
@@ -1707,7 +1791,25 @@ public:
   // Returns true if the NoNaN attribute is set on the function.
   bool hasFunNoNaNAttr() const { return HasFunNoNaNAttr; }
 
+  /// Returns true if the inner loop \p L of the outer loop being vectorized
+  /// may iterate a different number of times in different lanes, in which
+  /// case its iterations are predicated by a mask of the active lanes.
+  bool isMaskedInnerLoop(const Loop *L) const {
+    return MaskedInnerLoops.count(L);
+  }
+
 private:
+  /// Check if an outer loop can be vectorized in the VPlan-native path.
+  /// Its inner loops must be innermost loops, the control flow of the loop
+  /// nest must be uniform across the lanes except for the exit conditions of
+  /// inner loops, the header phis must be inductions, and its iterations must
+  /// not depend on each other through memory.
+  bool canVectorizeOuterLoop();
+
+  /// Returns true if \p V has the same value in all the iterations of the
+  /// outer loop being vectorized, i.e. in all the lanes of the vector loop.
+  bool isUniformInOuterLoop(Value *V);
+
   /// Check if a single basic block loop is vectorizable.
   /// At this point we know that this is a loop with a constant trip count
   /// and we only need to check individual instructions.
@@ -1777,6 +1879,9 @@ private:
   /// Dominator Tree.
   DominatorTree *DT;
 
+  /// Loop Info.
+  LoopInfo *LI;
+
   // LoopAccess analysis.
   std::function<const LoopAccessInfo &(Loop &)> *GetLAA;
 
@@ -1845,6 +1950,12 @@ private:
   /// While vectorizing these instructions we have to generate a
   /// call to the appropriate masked intrinsic
   SmallPtrSet<const Instruction *, 8> MaskedOp;
+
+  /// Whether the tail of the loop is folded into the vector loop by masking.
+  bool FoldTailByMasking = false;
+
+  /// The inner loops of an outer loop whose iterations are masked.
+  SmallPtrSet<const Loop *, 2> MaskedInnerLoops;
 };
 
 /// LoopVectorizationCostModel - estimates the expected speedups due to
@@ -1885,12 +1996,24 @@ public:
   /// possible.
   VectorizationFactor selectVectorizationFactor(unsigned MaxVF);
 
+  /// \return The most profitable vectorization factor for an outer loop in
+  /// the VPlan-native path and the cost of that VF, or \p UserVF if it is not
+  /// zero. Outer loops are only vectorized on explicit request, so a VF is
+  /// selected even if the scalar loop looks cheaper.
+  VectorizationFactor selectOuterLoopVectorizationFactor(unsigned UserVF);
+
   /// Setup cost-based decisions for user vectorization factor.
   void selectUserVectorizationFactor(unsigned UserVF) {
     collectUniformsAndScalars(UserVF);
     collectInstsToScalarize(UserVF);
   }
 
+  /// Decide whether to fold the tail of the loop into the vector loop with
+  /// vectorization factor \p VF by masking, rather than to leave it to a
+  /// scalar epilogue. The cost-based decisions for \p VF are recomputed if
+  /// the loop is folded. \return true if the tail is folded.
+  bool selectTailFolding(unsigned VF);
+
   /// \return The size (in bits) of the smallest and widest types in the code
   /// that needs to be vectorized. We ignore values that remain scalar such as
   /// 64 bit loop indices.
@@ -2072,6 +2195,17 @@ public:
     collectLoopScalars(VF);
   }
 
+  /// Forget all cost-based decisions, e.g. after the masking of the memory
+  /// accesses changed.
+  void invalidateCostModelingDecisions() {
+    WideningDecisions.clear();
+    Uniforms.clear();
+    Scalars.clear();
+    ForcedScalars.clear();
+    InstsToScalarize.clear();
+    PredicatedBBsAfterVectorization.clear();
+  }
+
 private:
   /// \return An upper bound for the vectorization factor, larger than zero.
   /// One is returned if vectorization should best be avoided due to cost.
@@ -2120,6 +2254,11 @@ private:
   /// scalar load + broadcast.
   unsigned getUniformMemOpCost(Instruction *I, unsigned VF);
 
+  /// Returns the expected execution cost of an iteration of the outer loop
+  /// being vectorized with \p VF, including its inner loops, and takes the
+  /// widening decisions of its memory instructions.
+  unsigned expectedOuterLoopCost(unsigned VF);
+
   /// Returns whether the instruction is a load or store and will be a emitted
   /// as a vector operation.
   bool isConsecutiveLoadOrStore(Instruction *I);
@@ -2300,6 +2439,10 @@ class LoopVectorizationPlanner {
   unsigned BestVF = 0;
   unsigned BestUF = 0;
 
+  /// The VPBasicBlock built for each block of the loop nest, when planning an
+  /// outer loop in the VPlan-native path.
+  DenseMap<BasicBlock *, VPBasicBlock *> OuterLoopBlocks;
+
 public:
   LoopVectorizationPlanner(Loop *L, LoopInfo *LI, const TargetLibraryInfo *TLI,
                            const TargetTransformInfo *TTI,
@@ -2311,6 +2454,17 @@ public:
   LoopVectorizationCostModel::VectorizationFactor plan(bool OptForSize,
                                                        unsigned UserVF);
 
+  /// Plan how to best vectorize an outer loop in the VPlan-native path, return
+  /// the best VF and its cost.
+  LoopVectorizationCostModel::VectorizationFactor
+  planInVPlanNativePath(unsigned UserVF);
+
+  /// Plan how to best vectorize the scalar remainder of a vectorized loop,
+  /// considering vectorization factors up to \p MaxEpilogueVF only. Return
+  /// the best VF and its cost.
+  LoopVectorizationCostModel::VectorizationFactor
+  planEpilogue(unsigned MaxEpilogueVF);
+
   /// Finalize the best decision and dispose of all other VPlans.
   void setBestPlan(unsigned VF, unsigned UF);
 
@@ -2419,6 +2573,12 @@ private:
   /// exclusive, possibly decreasing \p Range.End.
   VPlanPtr buildVPlan(VFRange &Range,
                                     const SmallPtrSetImpl<Value *> &NeedDef);
+
+  /// Build a VPlan for the outer loop being vectorized with \p VF. The plan
+  /// keeps the control flow of the loop nest: it has a VPBasicBlock for every
+  /// basic block, and the latch of each inner loop branches back to its
+  /// header.
+  VPlanPtr buildOuterLoopVPlan(unsigned VF);
 };
 
 } // end namespace llvm
@@ -2495,14 +2655,30 @@ private:
 
 } // end anonymous namespace
 
-static void addAcyclicInnerLoop(Loop &L, SmallVectorImpl<Loop *> &V) {
+/// Returns true if \p L is an outer loop explicitly annotated for
+/// vectorization, which the VPlan-native path vectorizes as a whole.
+static bool isExplicitVecOuterLoop(Loop *L, OptimizationRemarkEmitter *ORE) {
+  assert(!L->empty() && "This is not an outer loop");
+  LoopVectorizeHints Hints(L, /*DisableInterleaving=*/true, *ORE);
+  return Hints.getForce() == LoopVectorizeHints::FK_Enabled;
+}
+
+/// Collect the loops of the nest \p L to vectorize: the innermost loops
+/// without cycles in their body and, in the VPlan-native path, the outer loops
+/// with an explicit vectorization hint, whose inner loops are then left alone.
+static void collectSupportedLoops(Loop &L, OptimizationRemarkEmitter *ORE,
+                                  SmallVectorImpl<Loop *> &V) {
   if (L.empty()) {
     if (!hasCyclesInLoopBody(L))
       V.push_back(&L);
     return;
   }
+  if (EnableVPlanNativePath && isExplicitVecOuterLoop(&L, ORE)) {
+    V.push_back(&L);
+    return;
+  }
   for (Loop *InnerL : L)
-    addAcyclicInnerLoop(*InnerL, V);
+    collectSupportedLoops(*InnerL, ORE, V);
 }
 
 namespace {
@@ -2888,6 +3064,38 @@ void InnerLoopVectorizer::buildScalarSteps(Value *ScalarIV, Value *Step,
 }
 
 int LoopVectorizationLegality::isConsecutivePtr(Value *Ptr) {
+  // In an outer loop, an access in an inner loop is consecutive if its address
+  // advances by one element per iteration of the outer loop, whatever it does
+  // across the iterations of the inner loops.
+  if (!TheLoop->empty()) {
+    auto *SE = PSE.getSE();
+    if (!SE->isSCEVable(Ptr->getType()))
+      return 0;
+    const SCEV *PtrScev = SE->getSCEV(Ptr);
+    auto *AR = dyn_cast<SCEVAddRecExpr>(PtrScev);
+    while (AR && AR->getLoop() != TheLoop &&
+           TheLoop->contains(AR->getLoop())) {
+      if (!AR->isAffine() ||
+          !SE->isLoopInvariant(AR->getStepRecurrence(*SE), TheLoop))
+        return 0;
+      AR = dyn_cast<SCEVAddRecExpr>(AR->getStart());
+    }
+    if (!AR || AR->getLoop() != TheLoop || !AR->isAffine())
+      return 0;
+    auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(*SE));
+    if (!Step)
+      return 0;
+    const DataLayout &DL = TheLoop->getHeader()->getModule()->getDataLayout();
+    Type *ElemTy = cast<PointerType>(Ptr->getType())->getElementType();
+    int64_t Size = DL.getTypeAllocSize(ElemTy);
+    int64_t StepVal = Step->getAPInt().getSExtValue();
+    if (StepVal == Size)
+      return 1;
+    if (StepVal == -Size)
+      return -1;
+    return 0;
+  }
+
   const ValueToValueMap &Strides = getSymbolicStrides() ? *getSymbolicStrides() :
     ValueToValueMap();
 
@@ -2898,9 +3106,36 @@ int LoopVectorizationLegality::isConsecutivePtr(Value *Ptr) {
 }
 
 bool LoopVectorizationLegality::isUniform(Value *V) {
+  if (!TheLoop->empty())
+    return isUniformInOuterLoop(V);
   return LAI->isUniform(V);
 }
 
+bool LoopVectorizationLegality::isUniformInOuterLoop(Value *V) {
+  // A comparison of uniform values is uniform. This covers the exit
+  // conditions of inner loops, which SCEV cannot represent.
+  auto *Cmp = dyn_cast<CmpInst>(V);
+  if (Cmp && TheLoop->contains(Cmp))
+    return isUniformInOuterLoop(Cmp->getOperand(0)) &&
+           isUniformInOuterLoop(Cmp->getOperand(1));
+
+  auto *SE = PSE.getSE();
+  if (!SE->isSCEVable(V->getType()))
+    return TheLoop->isLoopInvariant(V);
+
+  // The value is uniform if it only varies with the inner loops: it must not
+  // recur over the outer loop nor depend on values SCEV cannot analyze which
+  // are defined in the loop nest.
+  const SCEV *S = SE->getSCEV(V);
+  return !SCEVExprContains(S, [&](const SCEV *E) {
+    if (auto *AR = dyn_cast<SCEVAddRecExpr>(E))
+      return AR->getLoop() == TheLoop;
+    if (auto *U = dyn_cast<SCEVUnknown>(E))
+      return !TheLoop->isLoopInvariant(U->getValue());
+    return isa<SCEVCouldNotCompute>(E);
+  });
+}
+
 Value *InnerLoopVectorizer::getOrCreateVectorValue(Value *V, unsigned Part) {
   assert(V != Induction && "The new induction variable should not be used.");
   assert(!V->getType()->isVectorTy() && "Can't widen a vector");
@@ -3219,6 +3454,22 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
     Alignment = DL.getABITypeAlignment(ScalarDataTy);
   unsigned AddressSpace = getMemInstAddressSpace(Instr);
 
+  // A load from an address that is the same in all the lanes of an outer loop
+  // is a scalar load broadcast to all the lanes.
+  if (Decision == LoopVectorizationCostModel::CM_Scalarize) {
+    assert(LI && !OrigLoop->empty() && "Expected a uniform outer loop load");
+    setDebugLocFromInst(Builder, LI);
+    for (unsigned Part = 0; Part < UF; ++Part) {
+      Value *ScalarPtr = getOrCreateScalarValue(Ptr, {Part, 0});
+      LoadInst *NewLI = Builder.CreateAlignedLoad(ScalarPtr, Alignment,
+                                                  "uniform.load");
+      addMetadata(NewLI, LI);
+      VectorLoopValueMap.setVectorValue(
+          Instr, Part, Builder.CreateVectorSplat(VF, NewLI, "broadcast"));
+    }
+    return;
+  }
+
   // Determine if the pointer operand of the access is either consecutive or
   // reverse consecutive.
   bool Reverse = (Decision == LoopVectorizationCostModel::CM_Widen_Reverse);
@@ -3456,6 +3707,16 @@ Value *InnerLoopVectorizer::getOrCreateVectorTripCount(Loop *L) {
   Value *TC = getOrCreateTripCount(L);
   IRBuilder<> Builder(L->getLoopPreheader()->getTerminator());
 
+  // If the tail is folded by masking, round the trip count up so that the
+  // vector loop also runs the remainder iterations, with their lanes masked
+  // off.
+  if (Legal->foldTailByMasking()) {
+    assert(!Legal->requiresScalarEpilogue() &&
+           "Cannot fold the tail of a loop that needs a scalar epilogue");
+    TC = Builder.CreateAdd(TC, ConstantInt::get(TC->getType(), VF * UF - 1),
+                           "n.rnd.up");
+  }
+
   // Now we need to generate the expression for the part of the loop that the
   // vectorized body will execute. This is equal to N - (N % Step) if scalar
   // iterations are not required for correctness, or N - Step, otherwise. Step
@@ -3522,10 +3783,24 @@ void InnerLoopVectorizer::emitMinimumIterationCountCheck(Loop *L,
   // vector trip count is zero. This check also covers the case where adding one
   // to the backedge-taken count overflowed leading to an incorrect trip count
   // of zero. In this case we will also jump to the scalar loop.
-  auto P = Legal->requiresScalarEpilogue() ? ICmpInst::ICMP_ULE
-                                           : ICmpInst::ICMP_ULT;
-  Value *CheckMinIters = Builder.CreateICmp(
-      P, Count, ConstantInt::get(Count->getType(), VF * UF), "min.iters.check");
+  Value *CheckMinIters;
+  if (Legal->foldTailByMasking()) {
+    // If the tail is folded, the vector loop runs all iterations. It is only
+    // bypassed if rounding the trip count up to a multiple of VF * UF
+    // overflows, or if the trip count itself overflowed to zero.
+    auto *Ty = cast<IntegerType>(Count->getType());
+    Value *BTC = Builder.CreateSub(Count, ConstantInt::get(Ty, 1));
+    CheckMinIters = Builder.CreateICmpUGT(
+        BTC, ConstantInt::get(Ty, APInt::getMaxValue(Ty->getBitWidth()) -
+                                      VF * UF),
+        "min.iters.check");
+  } else {
+    auto P = Legal->requiresScalarEpilogue() ? ICmpInst::ICMP_ULE
+                                             : ICmpInst::ICMP_ULT;
+    CheckMinIters =
+        Builder.CreateICmp(P, Count, ConstantInt::get(Count->getType(), VF * UF),
+                           "min.iters.check");
+  }
 
   BasicBlock *NewBB = BB->splitBasicBlock(BB->getTerminator(), "vector.ph");
   // Update dominator tree immediately if the generated block is a
@@ -3577,6 +3852,9 @@ void InnerLoopVectorizer::emitMemRuntimeChecks(Loop *L, BasicBlock *Bypass) {
   // faster.
   Instruction *FirstCheckInst;
   Instruction *MemRuntimeCheck;
+  // Outer loops are not analyzed by LoopAccessAnalysis and need no checks.
+  if (!Legal->getLAI())
+    return;
   std::tie(FirstCheckInst, MemRuntimeCheck) =
       Legal->getLAI()->addRuntimeChecks(BB->getTerminator());
   if (!MemRuntimeCheck)
@@ -3603,6 +3881,31 @@ void InnerLoopVectorizer::emitMemRuntimeChecks(Loop *L, BasicBlock *Bypass) {
   LVer->prepareNoAliasMetadata();
 }
 
+void InnerLoopVectorizer::emitReusedRuntimeChecks(Loop *L,
+                                                  BasicBlock *Bypass) {
+  BasicBlock *BB = L->getLoopPreheader();
+
+  BB->setName("vector.checkspassed");
+  auto *NewBB = BB->splitBasicBlock(BB->getTerminator(), "vector.ph");
+  DT->addNewBlock(NewBB, BB);
+  if (L->getParentLoop())
+    L->getParentLoop()->addBasicBlockToLoop(NewBB, *LI);
+  ReplaceInstWithInst(BB->getTerminator(),
+                      BranchInst::Create(NewBB, Bypass, RuntimeChecksPassed));
+  LoopBypassBlocks.push_back(BB);
+  AddedSafetyChecks = true;
+}
+
+PHINode *InnerLoopVectorizer::createVectorLoopTakenPhi() {
+  PHINode *Phi =
+      PHINode::Create(Builder.getInt1Ty(), LoopBypassBlocks.size() + 1,
+                      "vec.loop.taken", &LoopScalarPreHeader->front());
+  Phi->addIncoming(Builder.getTrue(), LoopMiddleBlock);
+  for (BasicBlock *BB : LoopBypassBlocks)
+    Phi->addIncoming(Builder.getFalse(), BB);
+  return Phi;
+}
+
 BasicBlock *InnerLoopVectorizer::createVectorizedLoopSkeleton() {
   /*
    In this function we generate a new loop. The new loop will contain
@@ -3691,14 +3994,19 @@ BasicBlock *InnerLoopVectorizer::createVectorizedLoopSkeleton() {
   // to the scalar loop.
   emitMinimumIterationCountCheck(Lp, ScalarPH);
 
-  // Generate the code to check any assumptions that we've made for SCEV
-  // expressions.
-  emitSCEVChecks(Lp, ScalarPH);
+  if (RuntimeChecksPassed) {
+    // The runtime checks of the main vector loop also cover this loop.
+    emitReusedRuntimeChecks(Lp, ScalarPH);
+  } else {
+    // Generate the code to check any assumptions that we've made for SCEV
+    // expressions.
+    emitSCEVChecks(Lp, ScalarPH);
 
-  // Generate the code that checks in runtime if arrays overlap. We put the
-  // checks into a separate block to make the more common case of few elements
-  // faster.
-  emitMemRuntimeChecks(Lp, ScalarPH);
+    // Generate the code that checks in runtime if arrays overlap. We put the
+    // checks into a separate block to make the more common case of few
+    // elements faster.
+    emitMemRuntimeChecks(Lp, ScalarPH);
+  }
 
   // Generate the induction variable.
   // The loop step is equal to the vectorization factor (num of SIMD elements)
@@ -3759,10 +4067,13 @@ BasicBlock *InnerLoopVectorizer::createVectorizedLoopSkeleton() {
 
   // Add a check in the middle block to see if we have completed
   // all of the iterations in the first vector loop.
-  // If (N - N%VF) == N, then we *don't* need to run the remainder.
-  Value *CmpN =
-      CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_EQ, Count,
-                      CountRoundDown, "cmp.n", MiddleBlock->getTerminator());
+  // If (N - N%VF) == N, then we *don't* need to run the remainder. If the tail
+  // is folded, the vector loop has run all of them.
+  Value *CmpN = ConstantInt::getTrue(OldBasicBlock->getContext());
+  if (!Legal->foldTailByMasking())
+    CmpN = CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_EQ, Count,
+                           CountRoundDown, "cmp.n",
+                           MiddleBlock->getTerminator());
   ReplaceInstWithInst(MiddleBlock->getTerminator(),
                       BranchInst::Create(ExitBlock, ScalarPH, CmpN));
 
@@ -4603,6 +4914,55 @@ void InnerLoopVectorizer::sinkScalarOperands(Instruction *PredInst) {
   } while (Changed);
 }
 
+void InnerLoopVectorizer::widenNestedPHI(PHINode *Phi) {
+  Type *VecTy = VF == 1 ? Phi->getType() : VectorType::get(Phi->getType(), VF);
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    PHINode *VecPhi = Builder.CreatePHI(VecTy, Phi->getNumIncomingValues(),
+                                        "vec.phi");
+    VectorLoopValueMap.setVectorValue(Phi, Part, VecPhi);
+  }
+  NestedPHIsToFix.push_back(Phi);
+}
+
+void InnerLoopVectorizer::fixNestedPHIs(
+    function_ref<BasicBlock *(BasicBlock *)> GetVectorBB) {
+  for (PHINode *Phi : NestedPHIsToFix) {
+    // The LCSSA phi of a masked inner loop takes the values kept for the lanes
+    // as they exited the loop.
+    auto LiveOut = InnerLoopLiveOuts.find(Phi);
+    for (unsigned Part = 0; Part < UF; ++Part) {
+      auto *VecPhi = cast<PHINode>(VectorLoopValueMap.getVectorValue(Phi, Part));
+      if (LiveOut != InnerLoopLiveOuts.end()) {
+        VecPhi->addIncoming(LiveOut->second[Part],
+                            GetVectorBB(Phi->getIncomingBlock(0)));
+        continue;
+      }
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I)
+        VecPhi->addIncoming(getOrCreateVectorValue(Phi->getIncomingValue(I),
+                                                   Part),
+                            GetVectorBB(Phi->getIncomingBlock(I)));
+    }
+  }
+}
+
+void InnerLoopVectorizer::vectorizeInnerLoopLiveOuts(Loop *L, unsigned Part,
+                                                     PHINode *Active) {
+  BasicBlock *VectorHeader = Active->getParent();
+  for (PHINode &LCSSAPhi : L->getExitBlock()->phis()) {
+    Value *V = getOrCreateVectorValue(LCSSAPhi.getIncomingValue(0), Part);
+    // The value of a lane is updated as long as the lane is active, so it is
+    // the one of the iteration in which the lane exits the loop.
+    PHINode *Acc = PHINode::Create(V->getType(), 2, "live.out",
+                                   &*VectorHeader->getFirstInsertionPt());
+    Acc->addIncoming(UndefValue::get(V->getType()), Active->getIncomingBlock(0));
+    Value *Next = Builder.CreateSelect(Active, V, Acc);
+    Acc->addIncoming(Next, Builder.GetInsertBlock());
+    auto &Parts = InnerLoopLiveOuts[&LCSSAPhi];
+    Parts.resize(UF);
+    Parts[Part] = Next;
+  }
+}
+
 void InnerLoopVectorizer::widenPHIInstruction(Instruction *PN, unsigned UF,
                                               unsigned VF) {
   assert(PN->getParent() == OrigLoop->getHeader() &&
@@ -4963,6 +5323,13 @@ void InnerLoopVectorizer::updateAnalysis() {
   // Forget the original basic block.
   PSE.getSE()->forgetLoop(OrigLoop);
 
+  // The vector body of an outer loop contains the inner loops, for which the
+  // dominator tree is not updated incrementally.
+  if (!OrigLoop->empty()) {
+    DT->recalculate(*OrigLoop->getHeader()->getParent());
+    return;
+  }
+
   // Update the dominator tree information.
   assert(DT->properlyDominates(LoopBypassBlocks.front(), LoopExitBlock) &&
          "Entry does not dominate exit.");
@@ -5057,11 +5424,10 @@ bool LoopVectorizationLegality::canVectorize() {
       return false;
   }
 
-  // FIXME: The code is currently dead, since the loop gets sent to
-  // LoopVectorizationLegality is already an innermost loop.
-  //
-  // We can only vectorize innermost loops.
-  if (!TheLoop->empty()) {
+  // We can only vectorize innermost loops, unless the VPlan-native path is
+  // enabled, in which case outer loops are only sent here when they are
+  // annotated with an explicit vectorization hint.
+  if (!TheLoop->empty() && !EnableVPlanNativePath) {
     ORE->emit(createMissedAnalysis("NotInnermostLoop")
               << "loop is not the innermost loop");
     if (DoExtraAnalysis)
@@ -5106,6 +5472,16 @@ bool LoopVectorizationLegality::canVectorize() {
   DEBUG(dbgs() << "LV: Found a loop: " << TheLoop->getHeader()->getName()
                << '\n');
 
+  // Outer loops are vectorized in the VPlan-native path, which has its own
+  // legality checks.
+  if (!TheLoop->empty()) {
+    if (!canVectorizeOuterLoop()) {
+      DEBUG(dbgs() << "LV: Can't vectorize the outer loop.\n");
+      return false;
+    }
+    return Result;
+  }
+
   // Check if we can if-convert non-single-bb loops.
   unsigned NumBlocks = TheLoop->getNumBlocks();
   if (NumBlocks != 1 && !canVectorizeWithIfConvert()) {
@@ -5433,6 +5809,276 @@ bool LoopVectorizationLegality::canVectorizeInstrs() {
   return true;
 }
 
+/// Return true if \p SI writes a different, non-overlapping location in every
+/// iteration of the loop nest \p L and of the inner loop containing it. The
+/// address must be {{Base,+,OuterStep}<L>,+,InnerStep}<Inner> with constant
+/// steps, and OuterStep must be larger than the span the inner loop covers, so
+/// that the last value written to a location is the same whether the outer
+/// iterations run one after the other or interleaved.
+static bool isDistinctOuterLoopStore(StoreInst *SI, Loop *L,
+                                     ScalarEvolution &SE) {
+  const DataLayout &DL = SI->getModule()->getDataLayout();
+  uint64_t Size = DL.getTypeStoreSize(SI->getValueOperand()->getType());
+  const SCEV *Ptr = SE.getSCEV(SI->getPointerOperand());
+
+  uint64_t InnerSpan = 0;
+  const Loop *Inner = nullptr;
+  auto *AR = dyn_cast<SCEVAddRecExpr>(Ptr);
+  if (AR && AR->getLoop() != L) {
+    Inner = AR->getLoop();
+    if (Inner->getParentLoop() != L || !AR->isAffine())
+      return false;
+    auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+    unsigned TripCount = SE.getSmallConstantMaxTripCount(Inner);
+    if (!Step || !TripCount)
+      return false;
+    uint64_t InnerStep = Step->getAPInt().abs().getLimitedValue();
+    // Locations written by one outer iteration must not overlap either. A
+    // zero step rewrites one location, which keeps the order of the writes.
+    if (InnerStep != 0 && InnerStep < Size)
+      return false;
+    InnerSpan = InnerStep * (TripCount - 1);
+    AR = dyn_cast<SCEVAddRecExpr>(AR->getStart());
+  }
+
+  if (!AR || AR->getLoop() != L || !AR->isAffine() ||
+      !SE.isLoopInvariant(AR->getStart(), L))
+    return false;
+  auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+  if (!Step)
+    return false;
+  uint64_t OuterStep = Step->getAPInt().abs().getLimitedValue();
+  return OuterStep >= InnerSpan + Size;
+}
+
+/// Return a memory access of the loop nest \p L that may depend on an access
+/// made in another iteration of \p L, or null if there is none. LoopAccess
+/// analysis only handles innermost loops, so this is conservative: every
+/// object written in the loop nest must be an identified object that is
+/// written by a single store and not read, every store must write a distinct
+/// location in every iteration of the loop nest, and every access of the loop
+/// nest must be to an identified object.
+static Instruction *findOuterLoopDependence(Loop *L, ScalarEvolution &SE) {
+  const DataLayout &DL = L->getHeader()->getModule()->getDataLayout();
+  SmallVector<std::pair<Instruction *, Value *>, 8> Accesses;
+  SmallPtrSet<Value *, 8> WrittenObjects;
+  for (BasicBlock *BB : L->blocks())
+    for (Instruction &I : *BB) {
+      Value *Ptr = getPointerOperand(&I);
+      if (!Ptr)
+        continue;
+      Value *Obj = GetUnderlyingObject(Ptr, DL);
+      if (auto *SI = dyn_cast<StoreInst>(&I))
+        if (!WrittenObjects.insert(Obj).second ||
+            !isDistinctOuterLoopStore(SI, L, SE))
+          return &I;
+      Accesses.push_back({&I, Obj});
+    }
+  if (WrittenObjects.empty())
+    return nullptr;
+  for (auto &Access : Accesses)
+    if (!isIdentifiedObject(Access.second) ||
+        (isa<LoadInst>(Access.first) && WrittenObjects.count(Access.second)))
+      return Access.first;
+  return nullptr;
+}
+
+bool LoopVectorizationLegality::canVectorizeOuterLoop() {
+  BasicBlock *Header = TheLoop->getHeader();
+  BasicBlock *Latch = TheLoop->getLoopLatch();
+
+  // The vector loop iterates over the outer loop, whose trip count must be
+  // computable.
+  if (isa<SCEVCouldNotCompute>(PSE.getBackedgeTakenCount())) {
+    ORE->emit(createMissedAnalysis("CantComputeNumberOfIterations")
+              << "could not determine number of loop iterations");
+    DEBUG(dbgs() << "LV: Can't compute the outer loop trip count.\n");
+    return false;
+  }
+
+  // Inner loops must be innermost loops in canonical form, exiting from their
+  // latch. An inner loop whose exit condition may differ across the lanes is
+  // iterated under the mask of the lanes that have not exited it yet.
+  for (Loop *Inner : *TheLoop) {
+    if (!Inner->empty() || !Inner->getLoopPreheader() ||
+        !Inner->getLoopLatch() ||
+        Inner->getExitingBlock() != Inner->getLoopLatch() ||
+        !Inner->getExitBlock()) {
+      ORE->emit(createMissedAnalysis("CFGNotUnderstood")
+                << "inner loop control flow is not understood by vectorizer");
+      DEBUG(dbgs() << "LV: Unsupported inner loop.\n");
+      return false;
+    }
+    auto *Br = dyn_cast<BranchInst>(Inner->getLoopLatch()->getTerminator());
+    if (Br && Br->isConditional() && !isUniform(Br->getCondition()))
+      MaskedInnerLoops.insert(Inner);
+  }
+
+  // The control flow of the loop nest must be reducible and, apart from the
+  // latches of the masked inner loops, uniform across the lanes.
+  LoopBlocksDFS DFS(TheLoop);
+  DFS.perform(LI);
+  SmallPtrSet<BasicBlock *, 16> Visited;
+  for (BasicBlock *BB : make_range(DFS.beginRPO(), DFS.endRPO())) {
+    Loop *L = LI->getLoopFor(BB);
+    for (BasicBlock *Pred : predecessors(BB))
+      if (TheLoop->contains(Pred) && !Visited.count(Pred) &&
+          !(L->getHeader() == BB && L->getLoopLatch() == Pred)) {
+        ORE->emit(createMissedAnalysis("CFGNotUnderstood")
+                  << "loop control flow is not understood by vectorizer");
+        DEBUG(dbgs() << "LV: Irreducible control flow in the loop nest.\n");
+        return false;
+      }
+    Visited.insert(BB);
+
+    auto *Br = dyn_cast<BranchInst>(BB->getTerminator());
+    if (!Br || (Br->isConditional() &&
+                Br->getSuccessor(0) == Br->getSuccessor(1))) {
+      ORE->emit(createMissedAnalysis("CFGNotUnderstood", BB->getTerminator())
+                << "loop control flow is not understood by vectorizer");
+      return false;
+    }
+    bool IsMaskedLatch = MaskedInnerLoops.count(L) && L->getLoopLatch() == BB;
+    if (BB != Latch && Br->isConditional() && !IsMaskedLatch &&
+        !isUniform(Br->getCondition())) {
+      ORE->emit(createMissedAnalysis("DivergentBranch", Br)
+                << "branch condition varies across the outer loop iterations");
+      DEBUG(dbgs() << "LV: Found a divergent branch: " << *Br << "\n");
+      return false;
+    }
+  }
+
+  // Look for the attribute signaling the absence of NaNs.
+  Function &F = *Header->getParent();
+  HasFunNoNaNAttr =
+      F.getFnAttribute("no-nans-fp-math").getValueAsString() == "true";
+
+  for (BasicBlock *BB : TheLoop->blocks()) {
+    bool InMaskedLoop = MaskedInnerLoops.count(LI->getLoopFor(BB));
+    for (Instruction &I : *BB) {
+      if (auto *Phi = dyn_cast<PHINode>(&I)) {
+        Type *PhiTy = Phi->getType();
+        if (!PhiTy->isIntegerTy() && !PhiTy->isFloatingPointTy() &&
+            !PhiTy->isPointerTy()) {
+          ORE->emit(createMissedAnalysis("CFGNotUnderstood", Phi)
+                    << "loop control flow is not understood by vectorizer");
+          DEBUG(dbgs() << "LV: Found an non-int non-pointer PHI.\n");
+          return false;
+        }
+
+        // The phis of the outer loop header must be inductions; reductions
+        // and recurrences across the outer loop are not supported.
+        if (BB == Header) {
+          InductionDescriptor ID;
+          if (!InductionDescriptor::isInductionPHI(Phi, TheLoop, PSE, ID) ||
+              ID.getKind() == InductionDescriptor::IK_PtrInduction) {
+            ORE->emit(createMissedAnalysis("NonInductionPhi", Phi)
+                      << "outer loop phi is not an integer or "
+                         "floating-point induction");
+            DEBUG(dbgs() << "LV: Found an unsupported outer loop PHI: "
+                         << *Phi << "\n");
+            return false;
+          }
+          addInductionPhi(Phi, ID, AllowedExit);
+          if (ID.hasUnsafeAlgebra() && !HasFunNoNaNAttr)
+            Requirements->addUnsafeAlgebraInst(ID.getUnsafeAlgebraInst());
+          continue;
+        }
+      } else if (!I.isBinaryOp() && !isa<CmpInst>(I) &&
+                 !isa<SelectInst>(I) && !isa<GetElementPtrInst>(I) &&
+                 !isa<LoadInst>(I) && !isa<StoreInst>(I) &&
+                 !isa<BranchInst>(I) && !isa<DbgInfoIntrinsic>(I) &&
+                 !(isa<CastInst>(I) && !isa<AddrSpaceCastInst>(I))) {
+        ORE->emit(createMissedAnalysis("CantVectorizeInstruction", &I)
+                  << "instruction cannot be vectorized in an outer loop");
+        DEBUG(dbgs() << "LV: Found an unsupported instruction: " << I
+                     << "\n");
+        return false;
+      }
+
+      if (!VectorType::isValidElementType(I.getType()) &&
+          !I.getType()->isVoidTy()) {
+        ORE->emit(createMissedAnalysis("CantVectorizeInstructionReturnType", &I)
+                  << "instruction return type cannot be vectorized");
+        DEBUG(dbgs() << "LV: Found unvectorizable type.\n");
+        return false;
+      }
+
+      if (auto *Load = dyn_cast<LoadInst>(&I)) {
+        if (!Load->isSimple()) {
+          ORE->emit(createMissedAnalysis("NonSimpleLoad", Load)
+                    << "read with atomic ordering or volatile read");
+          return false;
+        }
+        if (InMaskedLoop)
+          MaskedOp.insert(Load);
+      } else if (auto *Store = dyn_cast<StoreInst>(&I)) {
+        Type *T = Store->getValueOperand()->getType();
+        if (!Store->isSimple() || !VectorType::isValidElementType(T)) {
+          ORE->emit(createMissedAnalysis("CantVectorizeStore", Store)
+                    << "store instruction cannot be vectorized");
+          return false;
+        }
+        // All the lanes would store to the same address.
+        if (isUniform(Store->getPointerOperand())) {
+          ORE->emit(createMissedAnalysis("UniformStore", Store)
+                    << "write to an address that does not vary with the "
+                       "outer loop could not be vectorized");
+          return false;
+        }
+        if (InMaskedLoop)
+          MaskedOp.insert(Store);
+      } else if (InMaskedLoop && (I.getOpcode() == Instruction::UDiv ||
+                                  I.getOpcode() == Instruction::SDiv ||
+                                  I.getOpcode() == Instruction::URem ||
+                                  I.getOpcode() == Instruction::SRem)) {
+        // The inactive lanes of a masked inner loop may divide by zero.
+        ORE->emit(createMissedAnalysis("CantVectorizeDivision", &I)
+                  << "division in a divergent inner loop cannot be vectorized");
+        return false;
+      } else if (I.getType()->isFloatingPointTy() && I.isBinaryOp() &&
+                 !I.isFast()) {
+        DEBUG(dbgs() << "LV: Found FP op with unsafe algebra.\n");
+        Hints->setPotentiallyUnsafe();
+      }
+
+      if (hasOutsideLoopUser(TheLoop, &I, AllowedExit)) {
+        ORE->emit(createMissedAnalysis("ValueUsedOutsideLoop", &I)
+                  << "value cannot be used outside the loop");
+        return false;
+      }
+    }
+  }
+
+  if (Inductions.empty()) {
+    ORE->emit(createMissedAnalysis("NoInductionVariable")
+              << "loop induction variable could not be identified");
+    return false;
+  }
+
+  // The vector loop runs several outer iterations at once, interleaving their
+  // inner loops, so their memory accesses must be independent. That is taken
+  // from the parallel loop access annotations, if any, and otherwise checked
+  // conservatively.
+  if (!TheLoop->isAnnotatedParallel()) {
+    if (Instruction *I = findOuterLoopDependence(TheLoop, *PSE.getSE())) {
+      ORE->emit(createMissedAnalysis("UnsafeDep", I)
+                << "memory accesses of different outer loop iterations may "
+                   "depend on each other");
+      DEBUG(dbgs() << "LV: Found a possible outer loop dependence: " << *I
+                   << "\n");
+      return false;
+    }
+  }
+
+  // Let InnerLoopVectorizer create the primary induction if none of the
+  // inductions found has the widest type.
+  if (PrimaryInduction && WidestIndTy != PrimaryInduction->getType())
+    PrimaryInduction = nullptr;
+
+  return true;
+}
+
 void LoopVectorizationCostModel::collectLoopScalars(unsigned VF) {
   // We should not collect Scalars more than once per VF. Right now, this
   // function is called from collectUniformsAndScalars(), which already does
@@ -5939,6 +6585,74 @@ bool LoopVectorizationLegality::blockCanBePredicated(
   return true;
 }
 
+bool LoopVectorizationLegality::canFoldTailByMasking() {
+  // The mask of active lanes compares the primary induction variable with the
+  // backedge-taken count.
+  if (!PrimaryInduction) {
+    DEBUG(dbgs() << "LV: Cannot fold tail: no primary induction.\n");
+    return false;
+  }
+
+  // Reductions, recurrences and other live-out values would have to be taken
+  // from the last active lane rather than from the last lane.
+  if (!Reductions.empty() || !FirstOrderRecurrences.empty()) {
+    DEBUG(dbgs() << "LV: Cannot fold tail: loop has reductions or "
+                    "recurrences.\n");
+    return false;
+  }
+  for (PHINode &Phi : TheLoop->getExitBlock()->phis())
+    for (Value *V : Phi.incoming_values())
+      if (!TheLoop->isLoopInvariant(V)) {
+        DEBUG(dbgs() << "LV: Cannot fold tail: loop has live-outs.\n");
+        return false;
+      }
+
+  if (requiresScalarEpilogue())
+    return false;
+
+  // The masked-off lanes run with arbitrary values, so every instruction that
+  // may trap or access memory has to be masked.
+  for (BasicBlock *BB : TheLoop->blocks()) {
+    for (Instruction &I : *BB) {
+      for (Value *Operand : I.operands())
+        if (auto *C = dyn_cast<Constant>(Operand))
+          if (C->canTrap())
+            return false;
+
+      if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        if (!isLegalMaskedLoad(LI->getType(), LI->getPointerOperand())) {
+          DEBUG(dbgs() << "LV: Cannot fold tail: cannot mask " << I << "\n");
+          return false;
+        }
+        continue;
+      }
+      if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        if (!isLegalMaskedStore(SI->getValueOperand()->getType(),
+                                SI->getPointerOperand())) {
+          DEBUG(dbgs() << "LV: Cannot fold tail: cannot mask " << I << "\n");
+          return false;
+        }
+        continue;
+      }
+
+      switch (I.getOpcode()) {
+      case Instruction::UDiv:
+      case Instruction::SDiv:
+      case Instruction::URem:
+      case Instruction::SRem:
+        DEBUG(dbgs() << "LV: Cannot fold tail: " << I << " may trap.\n");
+        return false;
+      }
+      if (I.mayReadOrWriteMemory() || I.mayThrow()) {
+        DEBUG(dbgs() << "LV: Cannot fold tail: cannot mask " << I << "\n");
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 void InterleavedAccessInfo::collectConstStrideAccesses(
     MapVector<Instruction *, StrideDescriptor> &AccessStrideInfo,
     const ValueToValueMap &Strides) {
@@ -6288,6 +7002,13 @@ Optional<unsigned> LoopVectorizationCostModel::computeMaxVF(bool OptForSize) {
   unsigned MaxVF = computeFeasibleMaxVF(OptForSize, TC);
 
   if (TC % MaxVF != 0) {
+    // The tail can be folded into the vector loop instead.
+    if (EnableMaskedTailFolding && Legal->canFoldTailByMasking()) {
+      DEBUG(dbgs() << "LV: Folding the tail by masking with -Os/-Oz.\n");
+      Legal->setFoldTailByMasking(true);
+      return MaxVF;
+    }
+
     // If the trip count that we found modulo the vectorization factor is not
     // zero then we require a tail.
     // FIXME: look for a smaller MaxVF that does divide TC rather than give up.
@@ -6414,6 +7135,153 @@ LoopVectorizationCostModel::selectVectorizationFactor(unsigned MaxVF) {
   return Factor;
 }
 
+LoopVectorizationCostModel::VectorizationFactor
+LoopVectorizationCostModel::selectOuterLoopVectorizationFactor(
+    unsigned UserVF) {
+  if (UserVF) {
+    DEBUG(dbgs() << "LV: Using user VF " << UserVF << " for the outer loop.\n");
+    return {UserVF, expectedOuterLoopCost(UserVF)};
+  }
+
+  unsigned WidestType = getSmallestAndWidestTypes().second;
+  unsigned WidestRegister = TTI.getRegisterBitWidth(true);
+  unsigned MaxVF = PowerOf2Floor(WidestRegister / WidestType);
+  DEBUG(dbgs() << "LV: Scalar outer loop costs: " << expectedOuterLoopCost(1)
+               << ".\n");
+
+  VectorizationFactor Factor = {1, 0};
+  float Cost = 0;
+  for (unsigned VF = 2; VF <= MaxVF; VF *= 2) {
+    unsigned C = expectedOuterLoopCost(VF);
+    float VectorCost = C / (float)VF;
+    DEBUG(dbgs() << "LV: Vector outer loop of width " << VF
+                 << " costs: " << (int)VectorCost << ".\n");
+    if (Factor.Width == 1 || VectorCost < Cost) {
+      Cost = VectorCost;
+      Factor = {VF, C};
+    }
+  }
+  DEBUG(dbgs() << "LV: Selecting VF: " << Factor.Width << ".\n");
+  return Factor;
+}
+
+unsigned LoopVectorizationCostModel::expectedOuterLoopCost(unsigned VF) {
+  if (VF > 1) {
+    // Nothing is scalarized or kept uniform in the VPlan-native path, except
+    // the loads the decisions below make uniform.
+    Uniforms[VF].clear();
+    Scalars[VF].clear();
+    InstsToScalarize[VF].clear();
+  }
+
+  unsigned Cost = 0;
+  for (BasicBlock *BB : TheLoop->blocks()) {
+    // The blocks of an inner loop run once per iteration of the inner loop.
+    // Without a known bound, assume it runs once.
+    Loop *L = LI->getLoopFor(BB);
+    unsigned Weight = 1;
+    if (L != TheLoop)
+      if (unsigned TC = PSE.getSE()->getSmallConstantMaxTripCount(L))
+        Weight = TC;
+
+    unsigned BlockCost = 0;
+    for (Instruction &I : *BB) {
+      if (ValuesToIgnore.count(&I) || isa<DbgInfoIntrinsic>(I) ||
+          isa<PHINode>(I))
+        continue;
+
+      if (auto *Br = dyn_cast<BranchInst>(&I)) {
+        BlockCost += TTI.getCFInstrCost(Instruction::Br);
+        if (VF == 1 || Br->isUnconditional() || BB == TheLoop->getLoopLatch())
+          continue;
+        // The latch of a masked inner loop updates the mask and tests if any
+        // lane is still active; other branches are on lane 0 of a uniform
+        // condition.
+        if (L != TheLoop && L->getLoopLatch() == BB &&
+            Legal->isMaskedInnerLoop(L)) {
+          Type *MaskTy = VectorType::get(IntegerType::getInt1Ty(I.getContext()),
+                                         VF);
+          Type *IntTy = IntegerType::get(I.getContext(), VF);
+          BlockCost += TTI.getArithmeticInstrCost(Instruction::And, MaskTy) +
+                       TTI.getCastInstrCost(Instruction::BitCast, IntTy,
+                                            MaskTy) +
+                       TTI.getCmpSelInstrCost(Instruction::ICmp, IntTy);
+        } else {
+          BlockCost += TTI.getVectorInstrCost(
+              Instruction::ExtractElement,
+              VectorType::get(IntegerType::getInt1Ty(I.getContext()), VF), 0);
+        }
+        continue;
+      }
+
+      if (VF > 1 && (isa<LoadInst>(I) || isa<StoreInst>(I))) {
+        if (isa<LoadInst>(I) && Legal->isUniform(getPointerOperand(&I)))
+          setWideningDecision(&I, VF, CM_Scalarize,
+                              getUniformMemOpCost(&I, VF));
+        else if (int Stride = Legal->isConsecutivePtr(getPointerOperand(&I)))
+          setWideningDecision(&I, VF, Stride == 1 ? CM_Widen : CM_Widen_Reverse,
+                              getConsecutiveMemOpCost(&I, VF));
+        else
+          setWideningDecision(&I, VF, CM_GatherScatter,
+                              getGatherScatterCost(&I, VF));
+      }
+      BlockCost += getInstructionCost(&I, VF).first;
+    }
+    Cost += BlockCost * Weight;
+  }
+  return Cost;
+}
+
+bool LoopVectorizationCostModel::selectTailFolding(unsigned VF) {
+  assert(VF > 1 && "Only vector loops have a tail to fold");
+  if (Legal->foldTailByMasking())
+    return true;
+  if (!EnableMaskedTailFolding || !Legal->canFoldTailByMasking())
+    return false;
+
+  unsigned TC = PSE.getSE()->getSmallConstantTripCount(TheLoop);
+  if (TC && TC % VF == 0)
+    return false;
+  Optional<unsigned> ExpectedTC;
+  if (TC)
+    ExpectedTC = TC;
+  else
+    ExpectedTC = getLoopEstimatedTripCount(TheLoop);
+
+  unsigned ScalarCost = expectedCost(1).first;
+  unsigned VectorCost = expectedCost(VF).first;
+
+  // Cost the loop again with all memory accesses masked, plus the compare
+  // that computes the mask of active lanes.
+  Legal->setFoldTailByMasking(true);
+  invalidateCostModelingDecisions();
+  selectUserVectorizationFactor(VF);
+  Type *IdxTy = Legal->getWidestInductionType();
+  unsigned MaskedCost =
+      expectedCost(VF).first +
+      TTI.getCmpSelInstrCost(Instruction::ICmp, VectorType::get(IdxTy, VF));
+
+  // Without a trip count estimate, only fold if masking comes for free.
+  bool Fold = MaskedCost <= VectorCost;
+  if (ExpectedTC) {
+    uint64_t N = *ExpectedTC;
+    uint64_t EpilogueCost = N / VF * VectorCost + N % VF * ScalarCost;
+    uint64_t FoldedCost = (N + VF - 1) / VF * MaskedCost;
+    Fold = FoldedCost < EpilogueCost;
+  }
+  DEBUG(dbgs() << "LV: Masked loop of width " << VF << " costs: " << MaskedCost
+               << ", unmasked: " << VectorCost << ", scalar: " << ScalarCost
+               << ". " << (Fold ? "Folding" : "Not folding")
+               << " the tail by masking.\n");
+  if (Fold)
+    return true;
+
+  Legal->setFoldTailByMasking(false);
+  invalidateCostModelingDecisions();
+  selectUserVectorizationFactor(VF);
+  return false;
+}
+
 std::pair<unsigned, unsigned>
 LoopVectorizationCostModel::getSmallestAndWidestTypes() {
   unsigned MinWidth = -1U;
@@ -6487,8 +7355,9 @@ unsigned LoopVectorizationCostModel::selectInterleaveCount(bool OptForSize,
   // 3. We don't interleave if we think that we will spill registers to memory
   // due to the increased register pressure.
 
-  // When we optimize for size, we don't interleave.
-  if (OptForSize)
+  // When we optimize for size, we don't interleave. A loop with a masked tail
+  // is meant for short trip counts, so it is not interleaved either.
+  if (OptForSize || Legal->foldTailByMasking())
     return 1;
 
   // We used the distance for the interleave count.
@@ -7606,6 +8475,8 @@ LoopVectorizationPlanner::plan(bool OptForSize, unsigned UserVF) {
     // Collect the instructions (and their associated costs) that will be more
     // profitable to scalarize.
     CM.selectUserVectorizationFactor(UserVF);
+    if (UserVF > 1)
+      CM.selectTailFolding(UserVF);
     buildVPlans(UserVF, UserVF);
     DEBUG(printPlans(dbgs()));
     return {UserVF, 0};
@@ -7630,6 +8501,52 @@ LoopVectorizationPlanner::plan(bool OptForSize, unsigned UserVF) {
     return NoVectorization;
 
   // Select the optimal vectorization factor.
+  LoopVectorizationCostModel::VectorizationFactor VF =
+      CM.selectVectorizationFactor(MaxVF);
+
+  // Folding the tail changes the recipes of the memory accesses, so the plan
+  // for the selected VF has to be built again.
+  if (VF.Width > 1 && !Legal->foldTailByMasking() &&
+      CM.selectTailFolding(VF.Width)) {
+    VPlans.clear();
+    buildVPlans(VF.Width, VF.Width);
+    DEBUG(printPlans(dbgs()));
+  }
+  return VF;
+}
+
+LoopVectorizationCostModel::VectorizationFactor
+LoopVectorizationPlanner::planInVPlanNativePath(unsigned UserVF) {
+  assert(!OrigLoop->empty() && "Expected an outer loop");
+  LoopVectorizationCostModel::VectorizationFactor VF =
+      CM.selectOuterLoopVectorizationFactor(UserVF);
+  if (VF.Width > 1) {
+    VPlans.push_back(buildOuterLoopVPlan(VF.Width));
+    DEBUG(printPlans(dbgs()));
+  }
+  return VF;
+}
+
+LoopVectorizationCostModel::VectorizationFactor
+LoopVectorizationPlanner::planEpilogue(unsigned MaxEpilogueVF) {
+  const LoopVectorizationCostModel::VectorizationFactor NoVectorization = {1U,
+                                                                           0U};
+  Optional<unsigned> MaybeMaxVF = CM.computeMaxVF(/*OptForSize=*/false);
+  if (!MaybeMaxVF.hasValue())
+    return NoVectorization;
+
+  unsigned MaxVF = std::min(MaybeMaxVF.getValue(), MaxEpilogueVF);
+  if (MaxVF < 2)
+    return NoVectorization;
+
+  for (unsigned VF = 1; VF <= MaxVF; VF *= 2) {
+    CM.collectUniformsAndScalars(VF);
+    if (VF > 1)
+      CM.collectInstsToScalarize(VF);
+  }
+
+  buildVPlans(1, MaxVF);
+  DEBUG(printPlans(dbgs()));
   return CM.selectVectorizationFactor(MaxVF);
 }
 
@@ -7655,6 +8572,7 @@ void LoopVectorizationPlanner::executePlan(InnerLoopVectorizer &ILV,
                          DT,     ILV.Builder, ILV.VectorLoopValueMap,
                          &ILV,   CallbackILV};
   State.CFG.PrevBB = ILV.createVectorizedLoopSkeleton();
+  State.TripCount = ILV.getOrCreateTripCount(nullptr);
 
   //===------------------------------------------------===//
   //
@@ -7668,6 +8586,29 @@ void LoopVectorizationPlanner::executePlan(InnerLoopVectorizer &ILV,
   assert(VPlans.size() == 1 && "Not a single VPlan to execute.");
   VPlans.front()->execute(&State);
 
+  // The vector loop of an outer loop contains a copy of each inner loop: add
+  // the incoming values of their phis, and register them in LoopInfo.
+  if (!OrigLoop->empty()) {
+    auto GetVectorBB = [&](BasicBlock *BB) {
+      return State.CFG.VPBB2IRBB[OuterLoopBlocks[BB]];
+    };
+    ILV.fixNestedPHIs(GetVectorBB);
+
+    Loop *VectorLoop = LI->getLoopFor(GetVectorBB(OrigLoop->getHeader()));
+    for (Loop *Inner : *OrigLoop) {
+      Loop *VectorInner = LI->AllocateLoop();
+      VectorLoop->addChildLoop(VectorInner);
+      SmallPtrSet<BasicBlock *, 8> Added;
+      for (BasicBlock *BB : Inner->blocks()) {
+        BasicBlock *VectorBB = GetVectorBB(BB);
+        if (!Added.insert(VectorBB).second)
+          continue;
+        VectorInner->addBlockEntry(VectorBB);
+        LI->changeLoopFor(VectorBB, VectorInner);
+      }
+    }
+  }
+
   // 3. Fix the vectorized code: take care of header phi's, live-outs,
   //    predication, updating analyses.
   ILV.fixVectorizedLoop();
@@ -7798,6 +8739,11 @@ void LoopVectorizationPlanner::buildVPlans(unsigned MinVF, unsigned MaxVF) {
       NeedDef.insert(Branch->getCondition());
   }
 
+  // If the tail is folded by masking, the primary induction is needed to
+  // compute the mask of active lanes.
+  if (Legal->foldTailByMasking())
+    NeedDef.insert(Legal->getPrimaryInduction());
+
   for (unsigned VF = MinVF; VF < MaxVF + 1;) {
     VFRange SubRange = {VF, MaxVF + 1};
     VPlans.push_back(buildVPlan(SubRange, NeedDef));
@@ -7850,9 +8796,17 @@ VPValue *LoopVectorizationPlanner::createBlockInMask(BasicBlock *BB,
   // load/store/gather/scatter. Initialize BlockMask to no-mask.
   VPValue *BlockMask = nullptr;
 
-  // Loop incoming mask is all-one.
-  if (OrigLoop->getHeader() == BB)
+  if (OrigLoop->getHeader() == BB) {
+    // Loop incoming mask is all-one, unless the tail is folded. Then the
+    // active lanes are those whose induction variable value does not exceed
+    // the backedge-taken count; unlike the trip count, it cannot wrap.
+    if (Legal->foldTailByMasking()) {
+      VPValue *IV = Plan->getVPValue(Legal->getPrimaryInduction());
+      VPValue *BTC = Plan->getOrCreateBackedgeTakenCount();
+      BlockMask = Builder.createICmpULE(IV, BTC);
+    }
     return BlockMaskCache[BB] = BlockMask;
+  }
 
   // This is the block mask. We OR all incoming edges.
   for (auto *Predecessor : predecessors(BB)) {
@@ -8316,6 +9270,101 @@ LoopVectorizationPlanner::buildVPlan(VFRange &Range,
   return Plan;
 }
 
+LoopVectorizationPlanner::VPlanPtr
+LoopVectorizationPlanner::buildOuterLoopVPlan(unsigned VF) {
+  SmallPtrSet<Instruction *, 4> DeadInstructions;
+  collectTriviallyDeadInstructions(DeadInstructions);
+
+  auto Plan = llvm::make_unique<VPlan>();
+  OuterLoopBlocks.clear();
+  DenseMap<const Loop *, VPInnerLoopMaskRecipe *> InnerLoopMasks;
+
+  // Create a VPBasicBlock for each basic block, visiting the definitions before
+  // their uses except for the phis of inner loop headers.
+  LoopBlocksDFS DFS(OrigLoop);
+  DFS.perform(LI);
+  for (BasicBlock *BB : make_range(DFS.beginRPO(), DFS.endRPO())) {
+    auto *VPBB = new VPBasicBlock(BB->getName());
+    OuterLoopBlocks[BB] = VPBB;
+
+    Loop *L = LI->getLoopFor(BB);
+    VPValue *Mask = nullptr;
+    if (L != OrigLoop) {
+      if (L->getHeader() == BB && Legal->isMaskedInnerLoop(L)) {
+        auto *MaskRecipe = new VPInnerLoopMaskRecipe(L);
+        VPBB->appendRecipe(MaskRecipe);
+        InnerLoopMasks[L] = MaskRecipe;
+      }
+      if (VPInnerLoopMaskRecipe *MaskRecipe = InnerLoopMasks.lookup(L))
+        Mask = MaskRecipe->getMask();
+    }
+
+    for (Instruction &I : *BB) {
+      if (isa<BranchInst>(I) || isa<DbgInfoIntrinsic>(I) ||
+          DeadInstructions.count(&I))
+        continue;
+      if (auto *Phi = dyn_cast<PHINode>(&I)) {
+        if (BB == OrigLoop->getHeader())
+          VPBB->appendRecipe(new VPWidenIntOrFpInductionRecipe(Phi));
+        else
+          VPBB->appendRecipe(new VPWidenNestedPHIRecipe(Phi));
+        continue;
+      }
+      if (isa<LoadInst>(I) || isa<StoreInst>(I)) {
+        VPBB->appendRecipe(new VPWidenMemoryInstructionRecipe(I, Mask));
+        continue;
+      }
+      if (!VPBB->empty()) {
+        auto *LastWidenRecipe = dyn_cast<VPWidenRecipe>(&VPBB->back());
+        if (LastWidenRecipe && LastWidenRecipe->appendInstruction(&I))
+          continue;
+      }
+      VPBB->appendRecipe(new VPWidenRecipe(&I));
+    }
+  }
+
+  // Connect the VPBasicBlocks as their basic blocks, except for the backedge
+  // of the outer loop which the vector loop provides. The latch of a masked
+  // inner loop branches on whether any lane is still active, other blocks on
+  // their uniform branch condition.
+  BasicBlock *Latch = OrigLoop->getLoopLatch();
+  SmallPtrSet<Value *, 8> CondBits;
+  for (BasicBlock *BB : make_range(DFS.beginRPO(), DFS.endRPO())) {
+    if (BB == Latch)
+      continue;
+    VPBasicBlock *VPBB = OuterLoopBlocks[BB];
+    auto *Br = cast<BranchInst>(BB->getTerminator());
+    if (Br->isUnconditional()) {
+      VPBB->setOneSuccessor(OuterLoopBlocks[Br->getSuccessor(0)]);
+      continue;
+    }
+    VPBB->setTwoSuccessors(OuterLoopBlocks[Br->getSuccessor(0)],
+                           OuterLoopBlocks[Br->getSuccessor(1)]);
+
+    Loop *L = LI->getLoopFor(BB);
+    if (L != OrigLoop && L->getLoopLatch() == BB &&
+        Legal->isMaskedInnerLoop(L)) {
+      auto *LatchRecipe = new VPInnerLoopLatchRecipe(L, InnerLoopMasks[L]);
+      VPBB->appendRecipe(LatchRecipe);
+      VPBB->setCondBit(LatchRecipe->getCondBit());
+      continue;
+    }
+    Value *Cond = Br->getCondition();
+    if (CondBits.insert(Cond).second)
+      Plan->addVPValue(Cond);
+    VPBB->setCondBit(Plan->getVPValue(Cond));
+  }
+
+  auto *Region = new VPRegionBlock(OuterLoopBlocks[OrigLoop->getHeader()],
+                                   OuterLoopBlocks[Latch], "outer.loop");
+  for (auto &Entry : OuterLoopBlocks)
+    Entry.second->setParent(Region);
+  Plan->setEntry(Region);
+  Plan->addVF(VF);
+  Plan->setName("Outer loop VPlan for VF={" + Twine(VF) + "},UF=1");
+  return Plan;
+}
+
 void VPInterleaveRecipe::print(raw_ostream &O, const Twine &Indent) const {
   O << " +\n"
     << Indent << "\"INTERLEAVE-GROUP with factor " << IG->getFactor() << " at ";
@@ -8341,6 +9390,49 @@ void VPWidenPHIRecipe::execute(VPTransformState &State) {
   State.ILV->widenPHIInstruction(Phi, State.UF, State.VF);
 }
 
+void VPWidenNestedPHIRecipe::execute(VPTransformState &State) {
+  State.ILV->widenNestedPHI(Phi);
+}
+
+void VPInnerLoopMaskRecipe::execute(VPTransformState &State) {
+  // All the lanes enter the inner loop from its preheader, the only
+  // predecessor of the header generated so far.
+  BasicBlock *Preheader = State.CFG.PrevBB->getSinglePredecessor();
+  assert(Preheader && "Inner loop header has no single generated predecessor");
+  Type *MaskTy = VectorType::get(State.Builder.getInt1Ty(), State.VF);
+  for (unsigned Part = 0; Part < State.UF; ++Part) {
+    PHINode *Active = State.Builder.CreatePHI(MaskTy, 2, "inner.active");
+    Active->addIncoming(ConstantInt::getTrue(MaskTy), Preheader);
+    State.set(&Mask, Active, Part);
+  }
+}
+
+void VPInnerLoopLatchRecipe::execute(VPTransformState &State) {
+  IRBuilder<> &Builder = State.Builder;
+  auto *Br = cast<BranchInst>(InnerLoop->getLoopLatch()->getTerminator());
+  bool ExitOnTrue = !InnerLoop->contains(Br->getSuccessor(0));
+  Type *IntTy = Builder.getIntNTy(State.VF);
+
+  Value *AnyActive = nullptr;
+  for (unsigned Part = 0; Part < State.UF; ++Part) {
+    auto *Active = cast<PHINode>(State.get(Header->getMask(), Part));
+    Value *Cond = State.ILV->getOrCreateVectorValue(Br->getCondition(), Part);
+    Value *Continue = ExitOnTrue ? Builder.CreateNot(Cond) : Cond;
+    Value *Next = Builder.CreateAnd(Active, Continue, "inner.active.next");
+    Active->addIncoming(Next, State.CFG.PrevBB);
+    State.ILV->vectorizeInnerLoopLiveOuts(InnerLoop, Part, Active);
+
+    Value *Any = Builder.CreateICmpNE(Builder.CreateBitCast(Next, IntTy),
+                                      ConstantInt::get(IntTy, 0));
+    AnyActive = AnyActive ? Builder.CreateOr(AnyActive, Any) : Any;
+  }
+
+  // The first successor is the exit if the original branch exits on true.
+  Value *Bit = ExitOnTrue ? Builder.CreateNot(AnyActive) : AnyActive;
+  for (unsigned Part = 0; Part < State.UF; ++Part)
+    State.set(&CondBit, Bit, Part);
+}
+
 void VPBlendRecipe::execute(VPTransformState &State) {
   State.ILV->setDebugLocFromInst(State.Builder, Phi);
   // We know that all PHIs in non-header blocks are converted into
@@ -8480,8 +9572,161 @@ void VPWidenMemoryInstructionRecipe::execute(VPTransformState &State) {
   State.ILV->vectorizeMemoryInstruction(&Instr, &MaskValues);
 }
 
+/// Vectorize the scalar remainder loop \p L left behind by vectorizing it
+/// with \p MainVF and \p MainIC, using a narrower vectorization factor and no
+/// interleaving. The remainder runs fewer than MainVF * MainIC iterations, so
+/// only factors up to half of that are considered, and only if the cost model
+/// prefers them over the scalar loop. The epilogue vector loop does not emit
+/// runtime checks of its own: it runs only if those of the main vector loop,
+/// which cover all iterations, passed.
+static bool vectorizeEpilogue(Loop *L, InnerLoopVectorizer &MainLB,
+                              LoopVectorizationLegality &MainLVL,
+                              PredicatedScalarEvolution &MainPSE,
+                              unsigned MainVF, unsigned MainIC,
+                              LoopVectorizeHints &Hints, ScalarEvolution *SE,
+                              LoopInfo *LI, DominatorTree *DT,
+                              const TargetTransformInfo *TTI,
+                              TargetLibraryInfo *TLI, AliasAnalysis *AA,
+                              DemandedBits *DB, AssumptionCache *AC,
+                              OptimizationRemarkEmitter *ORE) {
+  unsigned MaxEpilogueVF = std::min(MainVF, MainVF * MainIC / 2);
+  if (MaxEpilogueVF < 2)
+    return false;
+
+  // The exit block is shared with the middle block of the main vector loop;
+  // give the remainder loop its own so the new middle block can be wired up
+  // like for any other loop.
+  formDedicatedExitBlocks(L, DT, LI, /*PreserveLCSSA=*/true);
+
+  // The analyses of the main loop describe the original loop, which has since
+  // been rewritten. Analyze the remainder loop from scratch.
+  Function *F = L->getHeader()->getParent();
+  PredicatedScalarEvolution PSE(*SE, *L);
+  std::unique_ptr<LoopAccessInfo> LAI;
+  std::function<const LoopAccessInfo &(Loop &)> GetLAI =
+      [&](Loop &EpilogueLoop) -> const LoopAccessInfo & {
+    LAI = llvm::make_unique<LoopAccessInfo>(&EpilogueLoop, SE, TLI, AA, DT, LI);
+    return *LAI;
+  };
+  LoopVectorizationRequirements Requirements(*ORE);
+  LoopVectorizationLegality LVL(L, PSE, DT, TLI, AA, F, TTI, &GetLAI, LI, ORE,
+                                &Requirements, &Hints, DB, AC);
+  if (!LVL.canVectorize()) {
+    DEBUG(dbgs() << "LV: Epilogue loop cannot be vectorized.\n");
+    return false;
+  }
+
+  // Reusing the runtime checks of the main loop is only correct if they
+  // imply everything the epilogue loop would check for.
+  bool NeedsMemChecks = LVL.getRuntimePointerChecking()->Need;
+  bool NeedsSCEVChecks = !PSE.getUnionPredicate().isAlwaysTrue();
+  if (NeedsMemChecks && !MainLVL.getRuntimePointerChecking()->Need) {
+    DEBUG(dbgs() << "LV: Epilogue loop needs memory checks that the main "
+                    "loop did not emit.\n");
+    return false;
+  }
+
+  LoopVectorizationCostModel CM(L, PSE, LI, &LVL, *TTI, TLI, DB, AC, ORE, F,
+                                &Hints);
+  CM.collectValuesToIgnore();
+  LoopVectorizationPlanner LVP(L, LI, TLI, TTI, &LVL, CM);
+  LoopVectorizationCostModel::VectorizationFactor VF =
+      LVP.planEpilogue(MaxEpilogueVF);
+  if (VF.Width == 1) {
+    DEBUG(dbgs() << "LV: Epilogue vectorization is not beneficial.\n");
+    return false;
+  }
+
+  // Planning may have added SCEV predicates as well.
+  NeedsSCEVChecks = !PSE.getUnionPredicate().isAlwaysTrue();
+  if (NeedsSCEVChecks &&
+      !MainPSE.getUnionPredicate().implies(&PSE.getUnionPredicate())) {
+    DEBUG(dbgs() << "LV: Epilogue loop needs SCEV checks that the main loop "
+                    "did not emit.\n");
+    return false;
+  }
+
+  DEBUG(dbgs() << "LV: Vectorizing epilogue loop with VF " << VF.Width
+               << ".\n");
+  LVP.setBestPlan(VF.Width, 1);
+  InnerLoopVectorizer LB(L, PSE, LI, DT, TLI, TTI, AC, ORE, VF.Width, 1, &LVL,
+                         &CM);
+  if (NeedsMemChecks || NeedsSCEVChecks)
+    LB.reuseRuntimeChecks(MainLB.createVectorLoopTakenPhi());
+  LVP.executePlan(LB, DT);
+  ++LoopsEpilogueVectorized;
+
+  ORE->emit([&]() {
+    return OptimizationRemark(LV_NAME, "EpilogueVectorized", L->getStartLoc(),
+                              L->getHeader())
+           << "vectorized epilogue loop (vectorization width: "
+           << ore::NV("VectorizationFactor", VF.Width) << ")";
+  });
+  return true;
+}
+
+/// Vectorize the outer loop \p L, found legal by \p LVL, in the VPlan-native
+/// path: the vector loop iterates over VF iterations of \p L at once and
+/// contains a copy of each inner loop, operating on vectors. Outer loops are
+/// not interleaved.
+static bool processLoopInVPlanNativePath(
+    Loop *L, PredicatedScalarEvolution &PSE, LoopInfo *LI, DominatorTree *DT,
+    LoopVectorizationLegality &LVL, const TargetTransformInfo *TTI,
+    TargetLibraryInfo *TLI, DemandedBits *DB, AssumptionCache *AC,
+    OptimizationRemarkEmitter *ORE, LoopVectorizeHints &Hints,
+    LoopVectorizationRequirements &Requirements) {
+  Function *F = L->getHeader()->getParent();
+  LoopVectorizationCostModel CM(L, PSE, LI, &LVL, *TTI, TLI, DB, AC, ORE, F,
+                                &Hints);
+  CM.collectValuesToIgnore();
+  LoopVectorizationPlanner LVP(L, LI, TLI, TTI, &LVL, CM);
+
+  LoopVectorizationCostModel::VectorizationFactor VF =
+      LVP.planInVPlanNativePath(Hints.getWidth());
+
+  if (Requirements.doesNotMeet(F, L, Hints)) {
+    DEBUG(dbgs() << "LV: Not vectorizing: loop did not meet vectorization "
+                    "requirements.\n");
+    emitMissedWarning(F, L, Hints, ORE);
+    return false;
+  }
+
+  if (VF.Width == 1) {
+    DEBUG(dbgs() << "LV: No vector width for the outer loop.\n");
+    ORE->emit([&]() {
+      return OptimizationRemarkMissed(Hints.vectorizeAnalysisPassName(),
+                                      "VectorizationNotBeneficial",
+                                      L->getStartLoc(), L->getHeader())
+             << "the cost-model indicates that vectorization is not "
+                "beneficial";
+    });
+    return false;
+  }
+
+  LVP.setBestPlan(VF.Width, 1);
+  InnerLoopVectorizer LB(L, PSE, LI, DT, TLI, TTI, AC, ORE, VF.Width, 1, &LVL,
+                         &CM);
+  LVP.executePlan(LB, DT);
+  ++LoopsVectorized;
+
+  using namespace ore;
+  ORE->emit([&]() {
+    return OptimizationRemark(LV_NAME, "Vectorized", L->getStartLoc(),
+                              L->getHeader())
+           << "vectorized outer loop (vectorization width: "
+           << NV("VectorizationFactor", VF.Width) << ")";
+  });
+
+  // Mark the loop as already vectorized to avoid vectorizing again.
+  Hints.setAlreadyVectorized();
+
+  DEBUG(verifyFunction(*F));
+  return true;
+}
+
 bool LoopVectorizePass::processLoop(Loop *L) {
-  assert(L->empty() && "Only process inner loops.");
+  assert((EnableVPlanNativePath || L->empty()) &&
+         "Only process inner loops, or outer loops in the VPlan-native path.");
 
 #ifndef NDEBUG
   const std::string DebugLocStr = getDebugLocString(L);
@@ -8592,6 +9837,10 @@ bool LoopVectorizePass::processLoop(Loop *L) {
     return false;
   }
 
+  if (!L->empty())
+    return processLoopInVPlanNativePath(L, PSE, LI, DT, LVL, TTI, TLI, DB, AC,
+                                        ORE, Hints, Requirements);
+
   // Use the cost model.
   LoopVectorizationCostModel CM(L, PSE, LI, &LVL, *TTI, TLI, DB, AC, ORE, F,
                                 &Hints);
@@ -8732,6 +9981,12 @@ bool LoopVectorizePass::processLoop(Loop *L) {
              << NV("VectorizationFactor", VF.Width)
              << ", interleaved count: " << NV("InterleaveCount", IC) << ")";
     });
+
+    // Vectorize what is left for the scalar loop with a narrower VF.
+    if (EnableEpilogueVectorization && !OptForSize &&
+        !LVL.foldTailByMasking())
+      vectorizeEpilogue(L, LB, LVL, PSE, VF.Width, IC, Hints, SE, LI, DT, TTI,
+                        TLI, AA, DB, AC, ORE);
   }
 
   // Mark the loop as already vectorized to avoid vectorizing again.
@@ -8785,7 +10040,7 @@ bool LoopVectorizePass::runImpl(
   SmallVector<Loop *, 8> Worklist;
 
   for (Loop *L : *LI)
-    addAcyclicInnerLoop(*L, Worklist);
+    collectSupportedLoops(*L, ORE, Worklist);
 
   LoopsAnalyzed += Worklist.size();
 
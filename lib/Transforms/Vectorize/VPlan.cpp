@@ -123,7 +123,13 @@ VPBasicBlock::createEmptyBasicBlock(VPTransformState::CFGState &CFG) {
     VPBasicBlock *PredVPBB = PredVPBlock->getExitBasicBlock();
     auto &PredVPSuccessors = PredVPBB->getSuccessors();
     BasicBlock *PredBB = CFG.VPBB2IRBB[PredVPBB];
-    assert(PredBB && "Predecessor basic-block not found building successor.");
+    // In outer loop vectorization the predecessor may be the latch of an inner
+    // loop, reached through a backedge, which is not generated yet. Its branch
+    // is completed once all the blocks are generated.
+    if (!PredBB) {
+      CFG.VPBBsToFix.push_back(PredVPBB);
+      continue;
+    }
     auto *PredBBTerminator = PredBB->getTerminator();
     DEBUG(dbgs() << "LV: draw edge from" << PredBB->getName() << '\n');
     if (isa<UnreachableInst>(PredBBTerminator)) {
@@ -184,6 +190,23 @@ void VPBasicBlock::execute(VPTransformState *State) {
   for (VPRecipeBase &Recipe : Recipes)
     Recipe.execute(*State);
 
+  // A block with two successors in the VPlan-native path is terminated by a
+  // conditional branch on its uniform condition bit, whose two destinations
+  // will be set later when they are created.
+  if (VPValue *CBV = getCondBit()) {
+    Value *IRCBV = State->get(CBV, 0);
+    if (IRCBV->getType()->isVectorTy())
+      IRCBV = State->Builder.CreateExtractElement(IRCBV,
+                                                  State->Builder.getInt32(0));
+    auto *CurrentTerminator = NewBB->getTerminator();
+    assert(isa<UnreachableInst>(CurrentTerminator) &&
+           "Expected to replace unreachable terminator with conditional "
+           "branch.");
+    auto *CondBr = BranchInst::Create(NewBB, nullptr, IRCBV);
+    CondBr->setSuccessor(0, nullptr);
+    ReplaceInstWithInst(CurrentTerminator, CondBr);
+  }
+
   DEBUG(dbgs() << "LV: filled BB:" << *NewBB);
 }
 
@@ -239,6 +262,13 @@ void VPInstruction::generateInstruction(VPTransformState &State,
     State.set(this, V, Part);
     break;
   }
+  case VPInstruction::ICmpULE: {
+    Value *IV = State.get(getOperand(0), Part);
+    Value *TC = State.get(getOperand(1), Part);
+    Value *V = Builder.CreateICmpULE(IV, TC);
+    State.set(this, V, Part);
+    break;
+  }
   default:
     llvm_unreachable("Unsupported opcode for instruction");
   }
@@ -264,6 +294,9 @@ void VPInstruction::print(raw_ostream &O) const {
   case VPInstruction::Not:
     O << "not";
     break;
+  case VPInstruction::ICmpULE:
+    O << "icmp ule";
+    break;
   default:
     O << Instruction::getOpcodeName(getOpcode());
   }
@@ -278,6 +311,15 @@ void VPInstruction::print(raw_ostream &O) const {
 /// LoopVectorBody basic-block was created for this. Introduce additional
 /// basic-blocks as needed, and fill them all.
 void VPlan::execute(VPTransformState *State) {
+  // -1. Materialize the backedge taken count in the preheader if it is used.
+  if (BackedgeTakenCount) {
+    Value *TC = State->TripCount;
+    IRBuilder<> Builder(State->CFG.PrevBB->getTerminator());
+    auto *TCMO = Builder.CreateSub(TC, ConstantInt::get(TC->getType(), 1),
+                                   "trip.count.minus.1");
+    Value2VPValue[TCMO] = BackedgeTakenCount;
+  }
+
   // 0. Set the reverse mapping from VPValues to Values for code generation.
   for (auto &Entry : Value2VPValue)
     State->VPValue2Value[Entry.second] = Entry.first;
@@ -309,6 +351,27 @@ void VPlan::execute(VPTransformState *State) {
   for (VPBlockBase *Block : depth_first(Entry))
     Block->execute(State);
 
+  // Complete the branches of the latches of inner loops, now that their
+  // headers and exits are generated.
+  for (VPBasicBlock *VPBB : State->CFG.VPBBsToFix) {
+    BasicBlock *BB = State->CFG.VPBB2IRBB[VPBB];
+    auto *Terminator = BB->getTerminator();
+    if (isa<UnreachableInst>(Terminator)) {
+      assert(VPBB->getSuccessors().size() == 1 &&
+             "Latch ending w/o branch must have single successor.");
+      BasicBlock *SuccBB =
+          State->CFG.VPBB2IRBB[VPBB->getSuccessors()[0]->getEntryBasicBlock()];
+      Terminator->eraseFromParent();
+      BranchInst::Create(SuccBB, BB);
+      continue;
+    }
+    for (unsigned Idx = 0, E = VPBB->getSuccessors().size(); Idx != E; ++Idx)
+      if (!Terminator->getSuccessor(Idx))
+        Terminator->setSuccessor(
+            Idx, State->CFG.VPBB2IRBB[VPBB->getSuccessors()[Idx]
+                                          ->getEntryBasicBlock()]);
+  }
+
   // 3. Merge the temporary latch created with the last basic-block filled.
   BasicBlock *LastBB = State->CFG.PrevBB;
   // Connect LastBB to VectorLatchBB to facilitate their merge.
@@ -323,7 +386,10 @@ void VPlan::execute(VPTransformState *State) {
   assert(Merged && "Could not merge last basic block with latch.");
   VectorLatchBB = LastBB;
 
-  updateDominatorTree(State->DT, VectorPreHeaderBB, VectorLatchBB);
+  // The vector body of an outer loop contains loops, which the incremental
+  // update below does not handle; the caller recomputes the dominator tree.
+  if (State->CFG.VPBBsToFix.empty())
+    updateDominatorTree(State->DT, VectorPreHeaderBB, VectorLatchBB);
 }
 
 void VPlan::updateDominatorTree(DominatorTree *DT, BasicBlock *LoopPreHeaderBB,
@@ -555,3 +621,20 @@ void VPWidenMemoryInstructionRecipe::print(raw_ostream &O,
   }
   O << "\\l\"";
 }
+
+void VPWidenNestedPHIRecipe::print(raw_ostream &O, const Twine &Indent) const {
+  O << " +\n" << Indent << "\"WIDEN-NESTED-PHI " << VPlanIngredient(Phi);
+  O << "\\l\"";
+}
+
+void VPInnerLoopMaskRecipe::print(raw_ostream &O, const Twine &Indent) const {
+  O << " +\n" << Indent << "\"INNER-LOOP-MASK ";
+  Mask.printAsOperand(O);
+  O << " for " << InnerLoop->getHeader()->getName() << "\\l\"";
+}
+
+void VPInnerLoopLatchRecipe::print(raw_ostream &O, const Twine &Indent) const {
+  O << " +\n" << Indent << "\"INNER-LOOP-LATCH ";
+  CondBit.printAsOperand(O);
+  O << " for " << InnerLoop->getHeader()->getName() << "\\l\"";
+}
@@ -55,7 +55,9 @@ class BasicBlock;
 class DominatorTree;
 class InnerLoopVectorizer;
 class InterleaveGroup;
+class Loop;
 class LoopInfo;
+class PHINode;
 class raw_ostream;
 class Value;
 class VPBasicBlock;
@@ -282,6 +284,11 @@ struct VPTransformState {
     /// of replication, maps the BasicBlock of the last replica created.
     SmallDenseMap<VPBasicBlock *, BasicBlock *> VPBB2IRBB;
 
+    /// The VPBasicBlocks whose successors were not generated yet when their
+    /// IR BasicBlocks were terminated, i.e. the latches of inner loops. Their
+    /// branches are completed once all the BasicBlocks are generated.
+    SmallVector<VPBasicBlock *, 4> VPBBsToFix;
+
     CFGState() = default;
   } CFG;
 
@@ -298,6 +305,9 @@ struct VPTransformState {
   /// Values of the output IR.
   VectorizerValueMap &ValueMap;
 
+  /// Hold the trip count of the scalar loop.
+  Value *TripCount = nullptr;
+
   /// Hold a reference to a mapping between VPValues in VPlan and original
   /// Values they correspond to.
   VPValue2ValueTy VPValue2Value;
@@ -327,6 +337,9 @@ private:
   /// List of successor blocks.
   SmallVector<VPBlockBase *, 1> Successors;
 
+  /// Successor selector, null for zero or single successor blocks.
+  VPValue *CondBit = nullptr;
+
   /// Add \p Successor as the last successor to this block.
   void appendSuccessor(VPBlockBase *Successor) {
     assert(Successor && "Cannot add nullptr successor!");
@@ -478,6 +491,13 @@ public:
     IfFalse->Parent = Parent;
   }
 
+  /// \return the condition selecting between the two successors of this
+  /// block: the first successor is taken if it is true.
+  VPValue *getCondBit() { return CondBit; }
+  const VPValue *getCondBit() const { return CondBit; }
+
+  void setCondBit(VPValue *CV) { CondBit = CV; }
+
   void disconnectSuccessor(VPBlockBase *Successor) {
     assert(Successor && "Successor to disconnect is null.");
     removeSuccessor(Successor);
@@ -511,12 +531,15 @@ public:
   using VPRecipeTy = enum {
     VPBlendSC,
     VPBranchOnMaskSC,
+    VPInnerLoopLatchSC,
+    VPInnerLoopMaskSC,
     VPInstructionSC,
     VPInterleaveSC,
     VPPredInstPHISC,
     VPReplicateSC,
     VPWidenIntOrFpInductionSC,
     VPWidenMemoryInstructionSC,
+    VPWidenNestedPHISC,
     VPWidenPHISC,
     VPWidenSC,
   };
@@ -548,7 +571,7 @@ public:
 class VPInstruction : public VPUser, public VPRecipeBase {
 public:
   /// VPlan opcodes, extending LLVM IR with idiomatics instructions.
-  enum { Not = Instruction::OtherOpsEnd + 1 };
+  enum { Not = Instruction::OtherOpsEnd + 1, ICmpULE };
 
 private:
   typedef unsigned char OpcodeTy;
@@ -861,6 +884,95 @@ public:
   void print(raw_ostream &O, const Twine &Indent) const override;
 };
 
+/// A recipe for widening a phi node of an inner loop header or of a join block
+/// of an outer loop, in the VPlan-native path. The vector phi is created empty
+/// and its incoming values are added once all the blocks of the vector loop
+/// nest are generated.
+class VPWidenNestedPHIRecipe : public VPRecipeBase {
+private:
+  PHINode *Phi;
+
+public:
+  VPWidenNestedPHIRecipe(PHINode *Phi)
+      : VPRecipeBase(VPWidenNestedPHISC), Phi(Phi) {}
+  ~VPWidenNestedPHIRecipe() override = default;
+
+  /// Method to support type inquiry through isa, cast, and dyn_cast.
+  static inline bool classof(const VPRecipeBase *V) {
+    return V->getVPRecipeID() == VPRecipeBase::VPWidenNestedPHISC;
+  }
+
+  /// Generate the empty vector phi.
+  void execute(VPTransformState &State) override;
+
+  /// Print the recipe.
+  void print(raw_ostream &O, const Twine &Indent) const override;
+};
+
+/// A recipe for the header of an inner loop whose trip count may differ across
+/// the lanes of the vectorized outer loop. It generates the mask of the lanes
+/// still iterating the inner loop, which guards the memory accesses of the
+/// inner loop.
+class VPInnerLoopMaskRecipe : public VPRecipeBase {
+private:
+  Loop *InnerLoop;
+
+  /// The mask of the active lanes.
+  VPValue Mask;
+
+public:
+  VPInnerLoopMaskRecipe(Loop *InnerLoop)
+      : VPRecipeBase(VPInnerLoopMaskSC), InnerLoop(InnerLoop) {}
+  ~VPInnerLoopMaskRecipe() override = default;
+
+  /// Method to support type inquiry through isa, cast, and dyn_cast.
+  static inline bool classof(const VPRecipeBase *V) {
+    return V->getVPRecipeID() == VPRecipeBase::VPInnerLoopMaskSC;
+  }
+
+  VPValue *getMask() { return &Mask; }
+
+  /// Generate the phi of the mask of active lanes.
+  void execute(VPTransformState &State) override;
+
+  /// Print the recipe.
+  void print(raw_ostream &O, const Twine &Indent) const override;
+};
+
+/// A recipe for the latch of an inner loop with a mask of active lanes. It
+/// drops the lanes that exit the inner loop from the mask, keeps the values
+/// live out of the inner loop of these lanes, and branches back to the header
+/// as long as any lane is active.
+class VPInnerLoopLatchRecipe : public VPRecipeBase {
+private:
+  Loop *InnerLoop;
+
+  /// The recipe of the inner loop header.
+  VPInnerLoopMaskRecipe *Header;
+
+  /// The condition of the branch terminating the latch.
+  VPValue CondBit;
+
+public:
+  VPInnerLoopLatchRecipe(Loop *InnerLoop, VPInnerLoopMaskRecipe *Header)
+      : VPRecipeBase(VPInnerLoopLatchSC), InnerLoop(InnerLoop),
+        Header(Header) {}
+  ~VPInnerLoopLatchRecipe() override = default;
+
+  /// Method to support type inquiry through isa, cast, and dyn_cast.
+  static inline bool classof(const VPRecipeBase *V) {
+    return V->getVPRecipeID() == VPRecipeBase::VPInnerLoopLatchSC;
+  }
+
+  VPValue *getCondBit() { return &CondBit; }
+
+  /// Generate the update of the mask, the live-outs and the branch condition.
+  void execute(VPTransformState &State) override;
+
+  /// Print the recipe.
+  void print(raw_ostream &O, const Twine &Indent) const override;
+};
+
 /// VPBasicBlock serves as the leaf of the Hierarchical Control-Flow Graph. It
 /// holds a sequence of zero or more VPRecipe's each representing a sequence of
 /// output IR instructions.
@@ -1016,6 +1128,10 @@ private:
   /// VPlan.
   Value2VPValueTy Value2VPValue;
 
+  /// Represents the backedge taken count of the original loop, for folding
+  /// the tail.
+  VPValue *BackedgeTakenCount = nullptr;
+
 public:
   VPlan(VPBlockBase *Entry = nullptr) : Entry(Entry) {}
 
@@ -1023,7 +1139,9 @@ public:
     if (Entry)
       VPBlockBase::deleteCFG(Entry);
     for (auto &MapEntry : Value2VPValue)
-      delete MapEntry.second;
+      if (MapEntry.second != BackedgeTakenCount)
+        delete MapEntry.second;
+    delete BackedgeTakenCount;
   }
 
   /// Generate the IR code for this VPlan.
@@ -1034,6 +1152,13 @@ public:
 
   VPBlockBase *setEntry(VPBlockBase *Block) { return Entry = Block; }
 
+  /// The backedge taken count of the original loop.
+  VPValue *getOrCreateBackedgeTakenCount() {
+    if (!BackedgeTakenCount)
+      BackedgeTakenCount = new VPValue();
+    return BackedgeTakenCount;
+  }
+
   void addVF(unsigned VF) { VFs.insert(VF); }
 
   bool hasVF(unsigned VF) { return VFs.count(VF); }
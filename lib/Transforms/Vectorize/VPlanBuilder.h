@@ -54,6 +54,10 @@ public:
   VPValue *createOr(VPValue *LHS, VPValue *RHS) {
     return createInstruction(Instruction::BinaryOps::Or, {LHS, RHS});
   }
+
+  VPValue *createICmpULE(VPValue *LHS, VPValue *RHS) {
+    return createInstruction(VPInstruction::ICmpULE, {LHS, RHS});
+  }
 };
 
 } // namespace llvm
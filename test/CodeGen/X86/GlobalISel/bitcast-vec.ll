@@ -0,0 +1,63 @@
+; NOTE: Assertions have been autogenerated by utils/update_llc_test_checks.py
+; RUN: llc -mtriple=x86_64-linux-gnu                  -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=SSE
+; RUN: llc -mtriple=x86_64-linux-gnu -mattr=+avx      -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=AVX
+; RUN: llc -mtriple=x86_64-linux-gnu -mattr=+avx512f  -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=AVX512
+
+define <2 x i64> @test_bitcast_v4i32_v2i64(<4 x i32>* %p) {
+; SSE-LABEL: test_bitcast_v4i32_v2i64:
+; SSE:       # %bb.0:
+; SSE-NEXT:    movaps (%rdi), %xmm0
+; SSE-NEXT:    retq
+;
+; AVX-LABEL: test_bitcast_v4i32_v2i64:
+; AVX:       # %bb.0:
+; AVX-NEXT:    vmovaps (%rdi), %xmm0
+; AVX-NEXT:    retq
+;
+; AVX512-LABEL: test_bitcast_v4i32_v2i64:
+; AVX512:       # %bb.0:
+; AVX512-NEXT:    vmovaps (%rdi), %xmm0
+; AVX512-NEXT:    retq
+  %v = load <4 x i32>, <4 x i32>* %p, align 16
+  %r = bitcast <4 x i32> %v to <2 x i64>
+  ret <2 x i64> %r
+}
+
+define <8 x i16> @test_bitcast_v16i8_v8i16(<16 x i8>* %p) {
+; SSE-LABEL: test_bitcast_v16i8_v8i16:
+; SSE:       # %bb.0:
+; SSE-NEXT:    movaps (%rdi), %xmm0
+; SSE-NEXT:    retq
+;
+; AVX-LABEL: test_bitcast_v16i8_v8i16:
+; AVX:       # %bb.0:
+; AVX-NEXT:    vmovaps (%rdi), %xmm0
+; AVX-NEXT:    retq
+;
+; AVX512-LABEL: test_bitcast_v16i8_v8i16:
+; AVX512:       # %bb.0:
+; AVX512-NEXT:    vmovaps (%rdi), %xmm0
+; AVX512-NEXT:    retq
+  %v = load <16 x i8>, <16 x i8>* %p, align 16
+  %r = bitcast <16 x i8> %v to <8 x i16>
+  ret <8 x i16> %r
+}
+
+define void @test_store_v8i16(<8 x i16> %v, <8 x i16>* %p) {
+; SSE-LABEL: test_store_v8i16:
+; SSE:       # %bb.0:
+; SSE-NEXT:    movaps %xmm0, (%rdi)
+; SSE-NEXT:    retq
+;
+; AVX-LABEL: test_store_v8i16:
+; AVX:       # %bb.0:
+; AVX-NEXT:    vmovaps %xmm0, (%rdi)
+; AVX-NEXT:    retq
+;
+; AVX512-LABEL: test_store_v8i16:
+; AVX512:       # %bb.0:
+; AVX512-NEXT:    vmovaps %xmm0, (%rdi)
+; AVX512-NEXT:    retq
+  store <8 x i16> %v, <8 x i16>* %p, align 16
+  ret void
+}
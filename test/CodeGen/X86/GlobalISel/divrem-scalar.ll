@@ -0,0 +1,76 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X64
+
+; ALL-LABEL: test_sdiv_i8:
+; X64:       movsbw
+; X64:       idivb
+define i8 @test_sdiv_i8(i8 %arg1, i8 %arg2) {
+  %res = sdiv i8 %arg1, %arg2
+  ret i8 %res
+}
+
+; ALL-LABEL: test_urem_i8:
+; X64:       movzbw
+; X64:       divb
+; X64:       shrw $8
+define i8 @test_urem_i8(i8 %arg1, i8 %arg2) {
+  %res = urem i8 %arg1, %arg2
+  ret i8 %res
+}
+
+; ALL-LABEL: test_sdiv_i16:
+; X64:       cwtd
+; X64:       idivw
+define i16 @test_sdiv_i16(i16 %arg1, i16 %arg2) {
+  %res = sdiv i16 %arg1, %arg2
+  ret i16 %res
+}
+
+; ALL-LABEL: test_udiv_i16:
+; X64:       xorl %e
+; X64:       divw
+define i16 @test_udiv_i16(i16 %arg1, i16 %arg2) {
+  %res = udiv i16 %arg1, %arg2
+  ret i16 %res
+}
+
+; ALL-LABEL: test_sdiv_i32:
+; X64:       cltd
+; X64:       idivl
+define i32 @test_sdiv_i32(i32 %arg1, i32 %arg2) {
+  %res = sdiv i32 %arg1, %arg2
+  ret i32 %res
+}
+
+; ALL-LABEL: test_srem_i32:
+; X64:       cltd
+; X64:       idivl
+; X64:       movl %edx, %eax
+define i32 @test_srem_i32(i32 %arg1, i32 %arg2) {
+  %res = srem i32 %arg1, %arg2
+  ret i32 %res
+}
+
+; ALL-LABEL: test_udiv_i32:
+; X64:       xorl %edx, %edx
+; X64:       divl
+define i32 @test_udiv_i32(i32 %arg1, i32 %arg2) {
+  %res = udiv i32 %arg1, %arg2
+  ret i32 %res
+}
+
+; ALL-LABEL: test_sdiv_i64:
+; X64:       cqto
+; X64:       idivq
+define i64 @test_sdiv_i64(i64 %arg1, i64 %arg2) {
+  %res = sdiv i64 %arg1, %arg2
+  ret i64 %res
+}
+
+; ALL-LABEL: test_urem_i64:
+; X64:       xorl %edx, %edx
+; X64:       divq
+; X64:       movq %rdx, %rax
+define i64 @test_urem_i64(i64 %arg1, i64 %arg2) {
+  %res = urem i64 %arg1, %arg2
+  ret i64 %res
+}
@@ -0,0 +1,33 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X64
+
+; ALL-LABEL: test_inttoptr:
+; X64:       movq %rdi, %rax
+; X64-NEXT:  retq
+define i8* @test_inttoptr(i64 %x) {
+  %p = inttoptr i64 %x to i8*
+  ret i8* %p
+}
+
+; ALL-LABEL: test_ptrtoint_i64:
+; X64:       movq %rdi, %rax
+; X64-NEXT:  retq
+define i64 @test_ptrtoint_i64(i8* %p) {
+  %x = ptrtoint i8* %p to i64
+  ret i64 %x
+}
+
+; ALL-LABEL: test_ptrtoint_i32:
+; X64:       movl %edi, %eax
+; X64-NEXT:  retq
+define i32 @test_ptrtoint_i32(i8* %p) {
+  %x = ptrtoint i8* %p to i32
+  ret i32 %x
+}
+
+; ALL-LABEL: test_ptrtoint_i16:
+; X64:       movl %edi, %eax
+; X64-NEXT:  retq
+define i16 @test_ptrtoint_i16(i8* %p) {
+  %x = ptrtoint i8* %p to i16
+  ret i16 %x
+}
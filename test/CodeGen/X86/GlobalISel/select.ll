@@ -0,0 +1,43 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X64
+
+; ALL-LABEL: test_select_i8:
+; X64:       testb $1
+; X64:       cmovnew
+define i8 @test_select_i8(i1 %cond, i8 %a, i8 %b) {
+  %res = select i1 %cond, i8 %a, i8 %b
+  ret i8 %res
+}
+
+; ALL-LABEL: test_select_i16:
+; X64:       testb $1
+; X64:       cmovnew
+define i16 @test_select_i16(i1 %cond, i16 %a, i16 %b) {
+  %res = select i1 %cond, i16 %a, i16 %b
+  ret i16 %res
+}
+
+; ALL-LABEL: test_select_i32:
+; X64:       setl
+; X64:       testb $1
+; X64:       cmovnel
+define i32 @test_select_i32(i32 %x, i32 %a, i32 %b) {
+  %cond = icmp slt i32 %x, %a
+  %res = select i1 %cond, i32 %a, i32 %b
+  ret i32 %res
+}
+
+; ALL-LABEL: test_select_i64:
+; X64:       testb $1
+; X64:       cmovneq
+define i64 @test_select_i64(i1 %cond, i64 %a, i64 %b) {
+  %res = select i1 %cond, i64 %a, i64 %b
+  ret i64 %res
+}
+
+; ALL-LABEL: test_select_ptr:
+; X64:       testb $1
+; X64:       cmovneq
+define i32* @test_select_ptr(i1 %cond, i32* %a, i32* %b) {
+  %res = select i1 %cond, i32* %a, i32* %b
+  ret i32* %res
+}
@@ -0,0 +1,78 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X64
+
+; ALL-LABEL: test_shl_i8:
+; X64:       shlb %cl
+define i8 @test_shl_i8(i8 %arg1, i8 %arg2) {
+  %res = shl i8 %arg1, %arg2
+  ret i8 %res
+}
+
+; ALL-LABEL: test_shl_i16:
+; X64:       shlw %cl
+define i16 @test_shl_i16(i16 %arg1, i16 %arg2) {
+  %res = shl i16 %arg1, %arg2
+  ret i16 %res
+}
+
+; ALL-LABEL: test_shl_i32:
+; X64:       shll %cl
+define i32 @test_shl_i32(i32 %arg1, i32 %arg2) {
+  %res = shl i32 %arg1, %arg2
+  ret i32 %res
+}
+
+; ALL-LABEL: test_shl_i64:
+; X64:       shlq %cl
+define i64 @test_shl_i64(i64 %arg1, i64 %arg2) {
+  %res = shl i64 %arg1, %arg2
+  ret i64 %res
+}
+
+; ALL-LABEL: test_lshr_i32:
+; X64:       shrl %cl
+define i32 @test_lshr_i32(i32 %arg1, i32 %arg2) {
+  %res = lshr i32 %arg1, %arg2
+  ret i32 %res
+}
+
+; ALL-LABEL: test_lshr_i64:
+; X64:       shrq %cl
+define i64 @test_lshr_i64(i64 %arg1, i64 %arg2) {
+  %res = lshr i64 %arg1, %arg2
+  ret i64 %res
+}
+
+; ALL-LABEL: test_ashr_i16:
+; X64:       sarw %cl
+define i16 @test_ashr_i16(i16 %arg1, i16 %arg2) {
+  %res = ashr i16 %arg1, %arg2
+  ret i16 %res
+}
+
+; ALL-LABEL: test_ashr_i32:
+; X64:       sarl %cl
+define i32 @test_ashr_i32(i32 %arg1, i32 %arg2) {
+  %res = ashr i32 %arg1, %arg2
+  ret i32 %res
+}
+
+; ALL-LABEL: test_lshr_i1:
+; X64:       shrb %cl
+define i1 @test_lshr_i1(i1 %arg1, i1 %arg2) {
+  %res = lshr i1 %arg1, %arg2
+  ret i1 %res
+}
+
+; ALL-LABEL: test_lshr_i32_imm:
+; X64:       shrl $5, %edi
+define i32 @test_lshr_i32_imm(i32 %arg1) {
+  %res = lshr i32 %arg1, 5
+  ret i32 %res
+}
+
+; ALL-LABEL: test_ashr_i64_imm:
+; X64:       sarq $63, %rdi
+define i64 @test_ashr_i64_imm(i64 %arg1) {
+  %res = ashr i64 %arg1, 63
+  ret i64 %res
+}
@@ -0,0 +1,120 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -enable-ext-tsp-block-placement \
+; RUN:     -ext-tsp-block-placement-stats < %s 2>%t.stats | FileCheck %s
+; RUN: FileCheck %s --check-prefix=STATS < %t.stats
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu < %s | FileCheck %s \
+; RUN:     --check-prefix=DEFAULT
+
+; The hot path through the loop must be laid out as fall-throughs, with the
+; rarely executed error handling moved after it.
+
+; CHECK-LABEL: sum_checked:
+; CHECK: # %entry
+; CHECK: # %loop
+; CHECK: # %latch
+; CHECK: # %exit
+; CHECK: # %error
+
+; STATS: ext-tsp: sum_checked: score {{[0-9.]+}} -> {{[0-9.]+}}, taken branches per entry {{[0-9.]+}} -> {{[0-9.]+}}
+; STATS: ext-tsp: diamonds: score 869.00 -> 1631.00, taken branches per entry 225.000 -> 129.750 (-42.3%)
+
+declare void @report(i32)
+
+define i32 @sum_checked(i32* %p, i32 %n) !prof !0 {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+  %addr = getelementptr inbounds i32, i32* %p, i32 %i
+  %v = load i32, i32* %addr
+  br label %check
+
+check:
+  %bad = icmp slt i32 %v, 0
+  br i1 %bad, label %error, label %latch, !prof !1
+
+error:
+  call void @report(i32 %v)
+  br label %latch
+
+latch:
+  %s.next = add i32 %s, %v
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !2
+
+exit:
+  ret i32 %s.next
+}
+
+; The chain-based layout places %c, which runs in 30% of the iterations,
+; between %b and the loop header, so the common path through %b jumps over it
+; to %latch. Ext-TSP lets %b fall through into %latch and %latch into the
+; header instead, and moves %c after %a.
+
+; DEFAULT-LABEL: diamonds:
+; DEFAULT: # %entry
+; DEFAULT: # %b
+; DEFAULT: # %c
+; DEFAULT: # %loop
+; DEFAULT: # %a
+; DEFAULT: # %latch
+; DEFAULT: # %exit
+
+; CHECK-LABEL: diamonds:
+; CHECK: # %entry
+; CHECK: # %b
+; CHECK: # %latch
+; CHECK: # %loop
+; CHECK: # %a
+; CHECK: # %c
+; CHECK: # %exit
+
+declare void @f(i32)
+declare void @g(i32)
+
+define void @diamonds(i32 %n, i32* %p) !prof !0 {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %addr = getelementptr inbounds i32, i32* %p, i32 %i
+  %v = load i32, i32* %addr
+  %neg = icmp slt i32 %v, 0
+  br i1 %neg, label %a, label %b, !prof !3
+
+a:
+  call void @f(i32 %v)
+  br label %join
+
+b:
+  call void @g(i32 %v)
+  br label %join
+
+join:
+  %big = icmp sgt i32 %v, 100
+  br i1 %big, label %c, label %latch, !prof !4
+
+c:
+  call void @f(i32 1)
+  call void @f(i32 2)
+  call void @f(i32 3)
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !5
+
+exit:
+  ret void
+}
+
+!0 = !{!"function_entry_count", i64 1000}
+!1 = !{!"branch_weights", i32 1, i32 10000}
+!2 = !{!"branch_weights", i32 1000, i32 100000}
+!3 = !{!"branch_weights", i32 55, i32 45}
+!4 = !{!"branch_weights", i32 30, i32 70}
+!5 = !{!"branch_weights", i32 1, i32 100}
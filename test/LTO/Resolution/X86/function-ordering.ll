@@ -0,0 +1,96 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-lto2 run %t.bc -o %t.o -save-temps \
+; RUN:   -r %t.bc,main,px -r %t.bc,mid,px -r %t.bc,leaf,px -r %t.bc,rare,px \
+; RUN:   -r %t.bc,check, -lto-function-ordering-file=%t.order
+; RUN: FileCheck %s --check-prefix=ORDER < %t.order
+; RUN: llvm-dis %t.o.0.4.opt.bc -o - | FileCheck %s
+
+; RUN: llvm-lto2 run %t.bc -o %t.sections.o \
+; RUN:   -r %t.bc,main,px -r %t.bc,mid,px -r %t.bc,leaf,px -r %t.bc,rare,px \
+; RUN:   -r %t.bc,check, -lto-function-ordering-file=%t.sections.order \
+; RUN:   -lto-function-ordering-file-sections
+; RUN: FileCheck %s --check-prefix=SECTIONS < %t.sections.order
+
+; ThinLTO backends only order the functions of their own module. They must not
+; write the file named by -function-ordering-file either.
+; RUN: opt -module-summary %s -o %t.thin.bc
+; RUN: rm -f %t.thin.order
+; RUN: llvm-lto2 run %t.thin.bc -o %t.thin.o -save-temps \
+; RUN:   -r %t.thin.bc,main,px -r %t.thin.bc,mid,px -r %t.thin.bc,leaf,px \
+; RUN:   -r %t.thin.bc,rare,px -r %t.thin.bc,check, -lto-function-ordering \
+; RUN:   -function-ordering-file=%t.thin.order
+; RUN: not ls %t.thin.order
+; RUN: llvm-dis %t.thin.o.1.4.opt.bc -o - | FileCheck %s
+
+; Regular LTO moves the hot call chain to the front of the module and writes
+; it to the ordering file.
+
+; ORDER: main
+; ORDER-NEXT: mid
+; ORDER-NEXT: leaf
+; ORDER-NOT: {{.}}
+
+; SECTIONS: .text.hot.main
+; SECTIONS-NEXT: .text.hot.mid
+; SECTIONS-NEXT: .text.hot.leaf
+; SECTIONS-NOT: {{.}}
+
+; CHECK: define void @main()
+; CHECK: define void @mid()
+; CHECK: define void @leaf()
+; CHECK: define void @rare()
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @rare() noinline !prof !16 {
+  call i1 @check()
+  ret void
+}
+
+define void @leaf() noinline !prof !17 {
+  call i1 @check()
+  ret void
+}
+
+define void @main() noinline !prof !15 {
+entry:
+  call void @mid()
+  %c = call i1 @check()
+  br i1 %c, label %if.rare, label %exit, !prof !18
+
+if.rare:
+  call void @rare()
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @mid() noinline !prof !19 {
+  call void @leaf()
+  ret void
+}
+
+declare i1 @check()
+
+!llvm.module.flags = !{!1}
+!1 = !{i32 1, !"ProfileSummary", !2}
+!2 = !{!3, !4, !5, !6, !7, !8, !9, !10}
+!3 = !{!"ProfileFormat", !"InstrProf"}
+!4 = !{!"TotalCount", i64 10000}
+!5 = !{!"MaxCount", i64 1000}
+!6 = !{!"MaxInternalCount", i64 1}
+!7 = !{!"MaxFunctionCount", i64 1000}
+!8 = !{!"NumCounts", i64 3}
+!9 = !{!"NumFunctions", i64 3}
+!10 = !{!"DetailedSummary", !11}
+!11 = !{!12, !13, !14}
+!12 = !{i32 10000, i64 100, i32 1}
+!13 = !{i32 999000, i64 100, i32 1}
+!14 = !{i32 999999, i64 1, i32 2}
+!15 = !{!"function_entry_count", i64 1000}
+!16 = !{!"function_entry_count", i64 1}
+!17 = !{!"function_entry_count", i64 950}
+!18 = !{!"branch_weights", i32 1, i32 999}
+!19 = !{!"function_entry_count", i64 900}
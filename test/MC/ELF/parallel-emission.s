@@ -0,0 +1,46 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.seq \
+// RUN:   -elf-parallel-emission=false
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.par \
+// RUN:   -elf-parallel-emission -elf-parallel-emission-threshold=0
+// RUN: cmp %t.seq %t.par
+// RUN: llvm-readobj -r -t %t.par | FileCheck %s
+
+// Sorting the symbol table and encoding the relocation sections and the string
+// table in parallel must produce the same object file as the sequential path.
+
+// CHECK:      Relocations [
+// CHECK-NEXT:   Section {{.*}} .rela.text {
+// CHECK-NEXT:     0x1 R_X86_64_PC32 zed 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:     0x6 R_X86_64_PC32 bar 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:     0xB R_X86_64_PC32 foo 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section {{.*}} .rela.data {
+// CHECK-NEXT:     0x0 R_X86_64_64 .text 0x0
+// CHECK-NEXT:     0x8 R_X86_64_64 zed 0x0
+// CHECK-NEXT:     0x10 R_X86_64_64 bar 0x0
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section {{.*}} .rela.foo {
+// CHECK-NEXT:     0x0 R_X86_64_32 foo 0x0
+// CHECK-NEXT:     0x4 R_X86_64_32 .text 0x0
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
+
+// CHECK: Name: local
+// CHECK: Name: bar
+// CHECK: Name: foo
+// CHECK: Name: zed
+
+        .text
+local:
+        call zed
+        call bar
+        call foo
+
+        .data
+        .quad local
+        .quad zed
+        .quad bar
+
+        .section .foo,"a",@progbits
+        .long foo
+        .long local
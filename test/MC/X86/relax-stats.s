@@ -0,0 +1,17 @@
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu -stats %s -o /dev/null 2>&1 | FileCheck %s
+# REQUIRES: asserts
+
+# Only the first jump is out of range of a rel8 displacement. It is relaxed in
+# the first layout step, and the second step confirms that nothing changed.
+
+# CHECK-DAG: 1 assembler{{.*}}Maximum number of fragments relaxed in a layout step
+# CHECK-DAG: 1 assembler{{.*}}Number of relaxed fragments
+# CHECK-DAG: 2 assembler{{.*}}Number of assembler layout and relaxation steps
+
+        .text
+        jmp     far
+        jmp     near
+near:
+        .fill   200, 1, 0x90
+far:
+        ret
@@ -0,0 +1,16 @@
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+@gRO = external global i32
+
+define i32 @main() {
+entry:
+  %v = load i32, i32* @gRO
+  %f = call i32 @foo()
+  call void @bar()
+  %r = add i32 %v, %f
+  ret i32 %r
+}
+
+declare i32 @foo()
+declare void @bar()
@@ -0,0 +1,115 @@
+; Check that variables only read or only written by the ThinLTO modules are
+; imported and internalized in every module that references them.
+; RUN: opt -module-summary %s -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/globals-readonly-writeonly.ll -o %t2.bc
+
+; The references from loads and stores are flagged in the per-module summary.
+; RUN: llvm-bcanalyzer -dump %t1.bc | FileCheck %s --check-prefix=BCAN
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -save-temps \
+; RUN:     -r=%t1.bc,_gRO,pl \
+; RUN:     -r=%t1.bc,_gWO,pl \
+; RUN:     -r=%t1.bc,_gRW,pl \
+; RUN:     -r=%t1.bc,_foo,pl \
+; RUN:     -r=%t1.bc,_bar,pl \
+; RUN:     -r=%t1.bc,_gLO,pl \
+; RUN:     -r=%t1.bc,_readLO,pl \
+; RUN:     -r=%t2.bc,_main,plx \
+; RUN:     -r=%t2.bc,_gRO, \
+; RUN:     -r=%t2.bc,_foo, \
+; RUN:     -r=%t2.bc,_bar,
+; RUN: llvm-dis %t.o.1.3.import.bc -o - | FileCheck %s --check-prefix=DEF
+; RUN: llvm-dis %t.o.2.3.import.bc -o - | FileCheck %s --check-prefix=IMPORT
+; RUN: llvm-dis %t.o.1.4.opt.bc -o - | FileCheck %s --check-prefix=OPT
+
+; A variable visible to a regular object may be written there.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t2.o -save-temps \
+; RUN:     -r=%t1.bc,_gRO,plx \
+; RUN:     -r=%t1.bc,_gWO,pl \
+; RUN:     -r=%t1.bc,_gRW,pl \
+; RUN:     -r=%t1.bc,_foo,pl \
+; RUN:     -r=%t1.bc,_bar,pl \
+; RUN:     -r=%t1.bc,_gLO,pl \
+; RUN:     -r=%t1.bc,_readLO,pl \
+; RUN:     -r=%t2.bc,_main,plx \
+; RUN:     -r=%t2.bc,_gRO, \
+; RUN:     -r=%t2.bc,_foo, \
+; RUN:     -r=%t2.bc,_bar,
+; RUN: llvm-dis %t2.o.2.3.import.bc -o - | FileCheck %s --check-prefix=PRESERVED
+
+; A linkonce_odr variable whose prevailing definition is in a native object may
+; be written there, even though no IR module writes it.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t3.o -save-temps \
+; RUN:     -r=%t1.bc,_gRO,pl \
+; RUN:     -r=%t1.bc,_gWO,pl \
+; RUN:     -r=%t1.bc,_gRW,pl \
+; RUN:     -r=%t1.bc,_foo,pl \
+; RUN:     -r=%t1.bc,_bar,pl \
+; RUN:     -r=%t1.bc,_gLO,x \
+; RUN:     -r=%t1.bc,_readLO,plx \
+; RUN:     -r=%t2.bc,_main,plx \
+; RUN:     -r=%t2.bc,_gRO, \
+; RUN:     -r=%t2.bc,_foo, \
+; RUN:     -r=%t2.bc,_bar,
+; RUN: llvm-dis %t3.o.1.3.import.bc -o - | FileCheck %s --check-prefix=NATIVE
+; RUN: llvm-dis %t3.o.1.4.opt.bc -o - | FileCheck %s --check-prefix=NATIVE-OPT
+
+; @foo has one read-only and one write-only reference, @bar a regular one.
+; BCAN: <PERMODULE {{.*}} op4=2 op5=1 op6=1 op7=0 op8=1/>
+; BCAN-NEXT: <PERMODULE {{.*}} op4=1 op5=0 op6=0 op7=2/>
+
+; DEF: @gRO = internal dso_local global i32 42{{$}}
+; DEF: @gWO = internal dso_local global i32 0{{$}}
+; DEF: @gRW = dso_local global i32 0
+; DEF-NOT: thinlto-internalize
+
+; IMPORT: @gRO = internal dso_local global i32 42{{$}}
+; IMPORT: @gWO = internal dso_local global i32 0{{$}}
+; IMPORT: @gRW = external dso_local global i32
+
+; The load of @gRO is folded and the store to @gWO is dropped.
+; OPT-NOT: @gRO
+; OPT-NOT: @gWO
+; OPT: define dso_local i32 @foo()
+; OPT-NEXT: entry:
+; OPT-NEXT: ret i32 42
+
+; PRESERVED: @gRO = external dso_local global i32
+; PRESERVED: @gWO = internal dso_local global i32 0{{$}}
+
+; The non-prevailing copy of @gLO is neither internalized nor assumed read-only,
+; and its load is kept.
+; NATIVE: @gLO = available_externally global i32 0
+; NATIVE-OPT: @gLO = external
+; NATIVE-OPT: define dso_local i32 @readLO()
+; NATIVE-OPT-NEXT: entry:
+; NATIVE-OPT-NEXT: %v = load i32, i32* @gLO
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+@gRO = global i32 42
+@gWO = global i32 0
+@gRW = global i32 0
+@gLO = linkonce_odr global i32 0
+
+define i32 @foo() {
+entry:
+  %v = load i32, i32* @gRO
+  store i32 %v, i32* @gWO
+  ret i32 %v
+}
+
+define void @bar() {
+entry:
+  %v = load i32, i32* @gRW
+  %inc = add i32 %v, 1
+  store i32 %inc, i32* @gRW
+  ret void
+}
+
+define i32 @readLO() {
+entry:
+  %v = load i32, i32* @gLO
+  ret i32 %v
+}
@@ -0,0 +1,85 @@
+; RUN: opt < %s -function-ordering -function-ordering-file=%t.order -S \
+; RUN:   | FileCheck %s
+; RUN: FileCheck %s --check-prefix=ORDER < %t.order
+; RUN: opt < %s -passes=function-ordering -S | FileCheck %s
+
+target triple = "x86_64-unknown-linux-gnu"
+
+; main calls mid, which calls leaf. They form one cluster in call order.
+; other only calls leaf rarely, so it gets its own cluster after it. Cold and
+; unprofiled functions keep their relative order at the end.
+
+; CHECK: define void @main() {{.*}}!section_prefix [[HOT:![0-9]+]]
+; CHECK: define void @mid() {{.*}}!section_prefix [[HOT]]
+; CHECK: define void @leaf() {{.*}}!section_prefix [[HOT]]
+; CHECK: define void @other() {{.*}}!section_prefix [[HOT]]
+; CHECK: define void @rare() !prof
+; CHECK-NOT: section_prefix
+; CHECK: define void @unprofiled() {
+; CHECK: [[HOT]] = !{!"function_section_prefix", !".hot"}
+
+; ORDER: main
+; ORDER-NEXT: mid
+; ORDER-NEXT: leaf
+; ORDER-NEXT: other
+; ORDER-NOT: {{.}}
+
+define void @rare() !prof !16 {
+  ret void
+}
+
+define void @leaf() !prof !17 {
+  ret void
+}
+
+define void @unprofiled() {
+  ret void
+}
+
+define void @other() !prof !18 {
+  call void @leaf()
+  ret void
+}
+
+define void @main() !prof !15 {
+entry:
+  call void @mid()
+  %c = call i1 @check()
+  br i1 %c, label %if.rare, label %exit, !prof !19
+
+if.rare:
+  call void @rare()
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @mid() !prof !20 {
+  call void @leaf()
+  ret void
+}
+
+declare i1 @check()
+
+!llvm.module.flags = !{!1}
+!1 = !{i32 1, !"ProfileSummary", !2}
+!2 = !{!3, !4, !5, !6, !7, !8, !9, !10}
+!3 = !{!"ProfileFormat", !"InstrProf"}
+!4 = !{!"TotalCount", i64 10000}
+!5 = !{!"MaxCount", i64 1000}
+!6 = !{!"MaxInternalCount", i64 1}
+!7 = !{!"MaxFunctionCount", i64 1000}
+!8 = !{!"NumCounts", i64 3}
+!9 = !{!"NumFunctions", i64 3}
+!10 = !{!"DetailedSummary", !11}
+!11 = !{!12, !13, !14}
+!12 = !{i32 10000, i64 100, i32 1}
+!13 = !{i32 999000, i64 100, i32 1}
+!14 = !{i32 999999, i64 1, i32 2}
+!15 = !{!"function_entry_count", i64 1000}
+!16 = !{!"function_entry_count", i64 1}
+!17 = !{!"function_entry_count", i64 950}
+!18 = !{!"function_entry_count", i64 50}
+!19 = !{!"branch_weights", i32 1, i32 999}
+!20 = !{!"function_entry_count", i64 900}
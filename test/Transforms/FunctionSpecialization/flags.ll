@@ -0,0 +1,49 @@
+; RUN: opt -function-specialization -func-specialization-max-growth=200 -S < %s | FileCheck %s
+
+; Both values of %mode are passed by some call site, so interprocedural SCCP
+; cannot fold it. Each specialization keeps one side of the branch in the
+; loop.
+
+; CHECK-LABEL: define void @caller(
+; CHECK-DAG: call void [[ZERO:@fill.specialized.[0-9]+]](i32* %p, i32 0, i32 %n)
+; CHECK-DAG: call void [[ONE:@fill.specialized.[0-9]+]](i32* %p, i32 1, i32 %n)
+
+define void @caller(i32* %p, i32 %n) {
+  call void @fill(i32* %p, i32 0, i32 %n)
+  call void @fill(i32* %p, i32 1, i32 %n)
+  ret void
+}
+
+; CHECK-DAG: define internal void [[ZERO]](
+; CHECK-DAG: define internal void [[ONE]](
+
+define internal void @fill(i32* %p, i32 %mode, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %gep = getelementptr inbounds i32, i32* %p, i32 %i
+  %zero = icmp eq i32 %mode, 0
+  br i1 %zero, label %then, label %else
+
+then:
+  %a = mul i32 %i, 3
+  %b = add i32 %a, 7
+  store i32 %b, i32* %gep, align 4
+  br label %latch
+
+else:
+  %c = shl i32 %i, 2
+  %d = xor i32 %c, 5
+  store i32 %d, i32* %gep, align 4
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
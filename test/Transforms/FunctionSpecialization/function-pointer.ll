@@ -0,0 +1,51 @@
+; RUN: opt -function-specialization -func-specialization-max-growth=200 -S < %s | FileCheck %s
+; RUN: opt -passes=function-specialization -func-specialization-max-growth=200 -S < %s | FileCheck %s
+
+; The call sites that pass @inc get a copy of @apply in which the indirect
+; call in the loop is a direct call to @inc.
+
+; CHECK-LABEL: define internal i32 @apply(
+; CHECK: call i32 %f(i32 %v)
+
+define internal i32 @apply(i32 (i32)* %f, i32* %a, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %gep = getelementptr inbounds i32, i32* %a, i32 %i
+  %v = load i32, i32* %gep, align 4
+  %r = call i32 %f(i32 %v)
+  %s.next = add i32 %s, %r
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %s.next
+}
+
+define internal i32 @inc(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
+
+; CHECK-LABEL: define i32 @caller(
+; CHECK: call i32 @apply.specialized.1(i32 (i32)* @inc, i32* %a, i32 %n)
+; CHECK: call i32 @apply.specialized.1(i32 (i32)* @inc, i32* %b, i32 %n)
+; CHECK: call i32 @apply(i32 (i32)* %f, i32* %a, i32 %n)
+
+define i32 @caller(i32* %a, i32* %b, i32 %n, i32 (i32)* %f) {
+  %r1 = call i32 @apply(i32 (i32)* @inc, i32* %a, i32 %n)
+  %r2 = call i32 @apply(i32 (i32)* @inc, i32* %b, i32 %n)
+  %r3 = call i32 @apply(i32 (i32)* %f, i32* %a, i32 %n)
+  %s1 = add i32 %r1, %r2
+  %s2 = add i32 %s1, %r3
+  ret i32 %s2
+}
+
+; CHECK-LABEL: define internal i32 @apply.specialized.1(
+; CHECK: loop:
+; CHECK: call i32 @inc(i32 %v)
+; CHECK: ret i32
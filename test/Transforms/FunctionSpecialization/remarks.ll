@@ -0,0 +1,52 @@
+; RUN: opt -function-specialization -pass-remarks=function-specialization -pass-remarks-missed=function-specialization -disable-output < %s 2>&1 | FileCheck %s
+; RUN: opt -function-specialization -func-specialization-max-growth=200 -pass-remarks=function-specialization -pass-remarks-missed=function-specialization -disable-output < %s 2>&1 | FileCheck %s --check-prefix=GROWTH
+
+; CHECK: remark: <unknown>:0:0: not specializing once: estimated benefit {{[0-9]+}} does not exceed the cost {{[0-9]+}} of the copy
+; CHECK: remark: <unknown>:0:0: not specializing apply: the code growth budget is exhausted
+
+; GROWTH: remark: <unknown>:0:0: not specializing once: estimated benefit {{[0-9]+}} does not exceed the cost {{[0-9]+}} of the copy
+; GROWTH: remark: <unknown>:0:0: specialized apply as apply.specialized.1 for 1 call sites: estimated benefit {{[0-9]+}}, cost {{[0-9]+}}
+
+define internal i32 @apply(i32 (i32)* %f, i32* %a, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %gep = getelementptr inbounds i32, i32* %a, i32 %i
+  %v = load i32, i32* %gep, align 4
+  %r = call i32 %f(i32 %v)
+  %s.next = add i32 %s, %r
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %s.next
+}
+
+define internal i32 @inc(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
+
+; The constant is used once outside of any loop.
+
+define internal i32 @once(i32 %x, i32 %y) {
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %a
+  %c = sub i32 %b, %y
+  %d = mul i32 %c, %b
+  %e = xor i32 %d, %y
+  ret i32 %e
+}
+
+define i32 @caller(i32* %a, i32 %n, i32 %y) {
+  %r1 = call i32 @apply(i32 (i32)* @inc, i32* %a, i32 %n)
+  %r2 = call i32 @once(i32 3, i32 %y)
+  %r3 = call i32 @once(i32 %n, i32 %y)
+  %s = add i32 %r1, %r2
+  %t = add i32 %s, %r3
+  ret i32 %t
+}
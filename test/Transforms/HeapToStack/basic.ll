@@ -0,0 +1,197 @@
+; RUN: opt < %s -heap-to-stack -S | FileCheck %s
+; RUN: opt < %s -passes=heap-to-stack -S | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+@g = global i8* null
+
+declare noalias i8* @malloc(i64)
+declare void @free(i8*)
+declare noalias i8* @_Znwm(i64)
+declare void @_ZdlPv(i8*)
+declare void @use(i8* nocapture)
+declare i32 @read(i8* nocapture) readonly nounwind
+declare i32 @__gxx_personality_v0(...)
+
+; CHECK-LABEL: @simple(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %p.h2s = alloca [16 x i8], align 16
+; CHECK-NOT: @malloc
+; CHECK: call void @llvm.lifetime.start.p0i8(i64 16, i8* {{.*}})
+; CHECK: store i32 %v
+; CHECK: call void @llvm.lifetime.end.p0i8(i64 16, i8* {{.*}})
+; CHECK-NOT: @free
+; CHECK: ret i32
+
+define i32 @simple(i32 %v) {
+entry:
+  %p = call i8* @malloc(i64 16)
+  %q = bitcast i8* %p to i32*
+  store i32 %v, i32* %q, align 4
+  %r = load i32, i32* %q, align 4
+  call void @free(i8* %p)
+  ret i32 %r
+}
+
+; The allocation is passed to a call that only reads it.
+
+; CHECK-LABEL: @readonly_call(
+; CHECK: alloca [32 x i8], align 16
+; CHECK-NOT: @malloc
+; CHECK: call i32 @read(
+; CHECK-NOT: @free
+
+define i32 @readonly_call() {
+entry:
+  %p = call i8* @malloc(i64 32)
+  call void @llvm.memset.p0i8.i64(i8* %p, i8 0, i64 32, i32 1, i1 false)
+  %r = call i32 @read(i8* %p)
+  call void @free(i8* %p)
+  ret i32 %r
+}
+
+; An invoke of operator new becomes a branch to its normal destination.
+
+; CHECK-LABEL: @new_invoke(
+; CHECK: alloca [8 x i8], align 16
+; CHECK-NOT: @_Znwm
+; CHECK: br label %cont
+; CHECK-NOT: @_ZdlPv
+; CHECK: ret i32
+
+define i32 @new_invoke() personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*) {
+entry:
+  %p = invoke i8* @_Znwm(i64 8)
+          to label %cont unwind label %lpad
+
+cont:
+  %q = bitcast i8* %p to i32*
+  store i32 1, i32* %q, align 4
+  %v = load i32, i32* %q, align 4
+  call void @_ZdlPv(i8* %p)
+  ret i32 %v
+
+lpad:
+  %lp = landingpad { i8*, i32 }
+          cleanup
+  resume { i8*, i32 } %lp
+}
+
+; Each iteration frees its allocation before the next one is made, so a
+; single stack slot in the entry block is enough.
+
+; CHECK-LABEL: @loop(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %p.h2s = alloca [4 x i8], align 16
+; CHECK: loop:
+; CHECK-NOT: @malloc
+; CHECK-NOT: @free
+; CHECK: ret void
+
+define void @loop(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %p = call i8* @malloc(i64 4)
+  %q = bitcast i8* %p to i32*
+  store i32 %i, i32* %q, align 4
+  call void @free(i8* %p)
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; The allocation of one iteration is freed in the next one.
+
+; CHECK-LABEL: @loop_carried(
+; CHECK: call i8* @malloc(i64 4)
+; CHECK: call void @free(
+
+define void @loop_carried(i32 %n) {
+entry:
+  %first = call i8* @malloc(i64 4)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %prev = phi i8* [ %first, %entry ], [ %p, %loop ]
+  %p = call i8* @malloc(i64 4)
+  call void @free(i8* %prev)
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  call void @free(i8* %p)
+  ret void
+}
+
+; CHECK-LABEL: @escapes(
+; CHECK: call i8* @malloc(i64 16)
+
+define void @escapes() {
+entry:
+  %p = call i8* @malloc(i64 16)
+  store i8* %p, i8** @g, align 8
+  call void @free(i8* %p)
+  ret void
+}
+
+; The callee may free the allocation.
+
+; CHECK-LABEL: @unknown_call(
+; CHECK: call i8* @malloc(i64 16)
+
+define void @unknown_call() {
+entry:
+  %p = call i8* @malloc(i64 16)
+  call void @use(i8* %p)
+  call void @free(i8* %p)
+  ret void
+}
+
+; CHECK-LABEL: @not_freed(
+; CHECK: call i8* @malloc(i64 16)
+
+define void @not_freed(i1 %c) {
+entry:
+  %p = call i8* @malloc(i64 16)
+  store i8 0, i8* %p, align 1
+  br i1 %c, label %free, label %exit
+
+free:
+  call void @free(i8* %p)
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK-LABEL: @too_large(
+; CHECK: call i8* @malloc(i64 256)
+
+define void @too_large() {
+entry:
+  %p = call i8* @malloc(i64 256)
+  store i8 0, i8* %p, align 1
+  call void @free(i8* %p)
+  ret void
+}
+
+; CHECK-LABEL: @unknown_size(
+; CHECK: call i8* @malloc(i64 %n)
+
+define void @unknown_size(i64 %n) {
+entry:
+  %p = call i8* @malloc(i64 %n)
+  store i8 0, i8* %p, align 1
+  call void @free(i8* %p)
+  ret void
+}
+
+declare void @llvm.memset.p0i8.i64(i8* nocapture, i8, i64, i32, i1)
@@ -0,0 +1,51 @@
+; RUN: opt < %s -heap-to-stack -heap-to-stack-max-frame-size=64 -S | FileCheck %s
+; RUN: opt < %s -heap-to-stack -heap-to-stack-max-frame-size=64 -pass-remarks-missed=heap-to-stack -disable-output 2>&1 | FileCheck %s --check-prefix=REMARK
+
+; Each promoted allocation takes a separate static stack slot, rounded up to
+; the malloc alignment. Once the slots of a function reach the limit, further
+; allocations stay on the heap.
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+declare noalias i8* @malloc(i64)
+declare void @free(i8*)
+
+; CHECK-LABEL: @three(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %c.h2s = alloca [20 x i8], align 16
+; CHECK-NEXT: %a.h2s = alloca [24 x i8], align 16
+; CHECK-NOT: alloca
+; CHECK: %b = call i8* @malloc(i64 40)
+; CHECK: call void @free(i8* %b)
+; CHECK: ret void
+
+; REMARK: remark: <unknown>:0:0: allocation of 40 bytes not moved to the stack: the function would use more than 64 bytes of stack for moved allocations
+; REMARK-NOT: remark
+
+define void @three() {
+entry:
+  %a = call i8* @malloc(i64 24)
+  store i8 0, i8* %a, align 1
+  call void @free(i8* %a)
+  %b = call i8* @malloc(i64 40)
+  store i8 0, i8* %b, align 1
+  call void @free(i8* %b)
+  %c = call i8* @malloc(i64 20)
+  store i8 0, i8* %c, align 1
+  call void @free(i8* %c)
+  ret void
+}
+
+; The limit applies to each function separately.
+; CHECK-LABEL: @other(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %p.h2s = alloca [32 x i8], align 16
+; CHECK-NOT: @malloc
+
+define void @other() {
+entry:
+  %p = call i8* @malloc(i64 32)
+  store i8 0, i8* %p, align 1
+  call void @free(i8* %p)
+  ret void
+}
@@ -0,0 +1,48 @@
+; RUN: opt < %s -heap-to-stack -heap-to-stack-max-size=64 -pass-remarks=heap-to-stack -pass-remarks-missed=heap-to-stack -disable-output 2>&1 | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+@g = global i8* null
+
+declare noalias i8* @malloc(i64)
+declare void @free(i8*)
+
+; CHECK: remark: <unknown>:0:0: moved allocation of 16 bytes to the stack
+; CHECK: remark: <unknown>:0:0: allocation of 128 bytes not moved to the stack: larger than 64 bytes
+; CHECK: remark: <unknown>:0:0: allocation not moved to the stack: its size is not a known constant
+; CHECK: remark: <unknown>:0:0: allocation not moved to the stack: the pointer may escape or be freed by a call
+; CHECK: remark: <unknown>:0:0: allocation not moved to the stack: it is not freed on all paths
+
+define void @promoted() {
+  %p = call i8* @malloc(i64 16)
+  store i8 0, i8* %p, align 1
+  call void @free(i8* %p)
+  ret void
+}
+
+define void @too_large() {
+  %p = call i8* @malloc(i64 128)
+  store i8 0, i8* %p, align 1
+  call void @free(i8* %p)
+  ret void
+}
+
+define void @unknown_size(i64 %n) {
+  %p = call i8* @malloc(i64 %n)
+  store i8 0, i8* %p, align 1
+  call void @free(i8* %p)
+  ret void
+}
+
+define void @escapes() {
+  %p = call i8* @malloc(i64 16)
+  store i8* %p, i8** @g, align 8
+  call void @free(i8* %p)
+  ret void
+}
+
+define void @not_freed() {
+  %p = call i8* @malloc(i64 16)
+  store i8 0, i8* %p, align 1
+  ret void
+}
@@ -0,0 +1,47 @@
+; RUN: opt -hotcoldsplit -S < %s | FileCheck %s
+
+; The landing pad and the resume have to stay in the function, but the cold
+; cleanup between them is outlined.
+
+; CHECK-LABEL: define void @cleanup(
+; CHECK: invoke void @may_throw()
+; CHECK-NEXT: to label %done unwind label %lpad
+; CHECK: lpad:
+; CHECK-NEXT: landingpad { i8*, i32 }
+; CHECK: call void @cleanup_handle(
+; CHECK: resume { i8*, i32 }
+
+; CHECK: define internal void @cleanup_handle(
+; CHECK-NOT: landingpad
+; CHECK-NOT: resume
+; CHECK: call void @log_failure(
+; CHECK-NOT: landingpad
+; CHECK-NOT: resume
+; CHECK: attributes
+
+declare void @may_throw()
+declare void @log_failure(i32) cold
+declare i32 @__gxx_personality_v0(...)
+
+define void @cleanup(i32 %x) personality i32 (...)* @__gxx_personality_v0 {
+entry:
+  invoke void @may_throw()
+          to label %done unwind label %lpad
+
+done:
+  ret void
+
+lpad:
+  %lp = landingpad { i8*, i32 }
+          cleanup
+  br label %handle
+
+handle:
+  %code = mul i32 %x, 3
+  %code.1 = add i32 %code, 7
+  call void @log_failure(i32 %code.1)
+  br label %rethrow
+
+rethrow:
+  resume { i8*, i32 } %lp
+}
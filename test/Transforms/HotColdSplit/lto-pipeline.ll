@@ -0,0 +1,31 @@
+; Hot/cold splitting runs once inlining decisions are final: in the per-module
+; pipeline, and after link-time inlining when the module goes through (Thin)LTO.
+; The pre-link pipelines leave it to the link-time ones.
+
+; RUN: opt -disable-output -debug-pass-manager -enable-npm-hot-cold-split \
+; RUN:     -passes='default<O2>' %s 2>&1 | FileCheck %s --check-prefix=SPLIT
+; RUN: opt -disable-output -debug-pass-manager -enable-npm-hot-cold-split \
+; RUN:     -passes='lto-pre-link<O2>' %s 2>&1 | FileCheck %s --check-prefix=NOSPLIT
+; RUN: opt -disable-output -debug-pass-manager -enable-npm-hot-cold-split \
+; RUN:     -passes='thinlto-pre-link<O2>' %s 2>&1 | FileCheck %s --check-prefix=NOSPLIT
+; RUN: opt -disable-output -debug-pass-manager -enable-npm-hot-cold-split \
+; RUN:     -passes='lto<O2>' %s 2>&1 | FileCheck %s --check-prefix=LTO
+; RUN: opt -disable-output -debug-pass-manager -enable-npm-hot-cold-split \
+; RUN:     -passes='thinlto<O2>' %s 2>&1 | FileCheck %s --check-prefix=SPLIT
+; RUN: opt -disable-output -debug-pass=Structure -hot-cold-split \
+; RUN:     -std-link-opts %s 2>&1 | FileCheck %s --check-prefix=LEGACY-LTO
+
+; SPLIT: Running pass: HotColdSplittingPass
+; NOSPLIT-NOT: Running pass: HotColdSplittingPass
+
+; LTO: Running pass: ModuleToPostOrderCGSCCPassAdaptor<{{.*}}InlinerPass>
+; LTO: Running pass: GlobalDCEPass
+; LTO-NEXT: Running pass: HotColdSplittingPass
+
+; LEGACY-LTO: Function Integration/Inlining
+; LEGACY-LTO: Dead Global Elimination
+; LEGACY-LTO-NEXT: Hot Cold Splitting
+
+define void @f() {
+  ret void
+}
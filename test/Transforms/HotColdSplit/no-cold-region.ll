@@ -0,0 +1,59 @@
+; RUN: opt -hotcoldsplit -S < %s | FileCheck %s
+
+; Nothing is outlined from functions without a cold region: a cold call in
+; the entry block, a cold function, and a function without any cold code.
+
+declare void @log_failure(i32) cold
+declare i32 @compute(i32)
+
+define i32 @cold_call_in_entry(i32 %x) {
+; CHECK-LABEL: define i32 @cold_call_in_entry(
+; CHECK: call void @log_failure(
+entry:
+  %code = mul i32 %x, 3
+  %code.1 = add i32 %code, 7
+  call void @log_failure(i32 %code.1)
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %then, label %else
+
+then:
+  ret i32 %code.1
+
+else:
+  ret i32 %x
+}
+
+define i32 @cold_function(i32 %x) cold {
+; CHECK-LABEL: define i32 @cold_function(
+; CHECK: call void @log_failure(
+entry:
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %good, label %bad
+
+good:
+  ret i32 %x
+
+bad:
+  %code = mul i32 %x, 3
+  %code.1 = add i32 %code, 7
+  call void @log_failure(i32 %code.1)
+  unreachable
+}
+
+define i32 @all_hot(i32 %x) {
+; CHECK-LABEL: define i32 @all_hot(
+; CHECK: call i32 @compute(
+; CHECK-NOT: define internal
+entry:
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %good, label %other
+
+good:
+  ret i32 %x
+
+other:
+  %a = call i32 @compute(i32 %x)
+  %b = mul i32 %a, 3
+  %c = add i32 %b, 7
+  ret i32 %c
+}
@@ -0,0 +1,79 @@
+; RUN: opt -hotcoldsplit -S < %s | FileCheck %s
+; RUN: opt -passes=hotcoldsplit -S < %s | FileCheck %s
+
+; With a profile summary and an entry count, a block that the profile says
+; is never executed is outlined even though it has no cold call and does not
+; end in unreachable.
+
+; CHECK-LABEL: define i32 @profiled(
+; CHECK: entry:
+; CHECK: codeRepl:
+; CHECK-NEXT: call void @profiled_rare(
+; CHECK: join:
+; CHECK: ret i32
+
+; Without an entry count the profile is not used, so the same code stays.
+; CHECK-LABEL: define i32 @unprofiled(
+; CHECK-NOT: call void @unprofiled_rare(
+; CHECK: rare:
+; CHECK-NEXT: call i32 @compute(
+; CHECK: ret i32
+
+; CHECK: define internal void @profiled_rare({{.*}}) [[ATTRS:#[0-9]+]] !section_prefix
+; CHECK: call i32 @compute(
+; CHECK-NOT: define internal void @unprofiled_rare(
+; CHECK: attributes [[ATTRS]] = { {{.*}}cold{{.*}} }
+
+declare i32 @compute(i32)
+
+define i32 @profiled(i32 %x) !prof !15 {
+entry:
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %join, label %rare, !prof !16
+
+rare:
+  %a = call i32 @compute(i32 %x)
+  %b = mul i32 %a, 3
+  %c = add i32 %b, 7
+  store volatile i32 %c, i32* @sink
+  br label %join
+
+join:
+  ret i32 %x
+}
+
+define i32 @unprofiled(i32 %x) {
+entry:
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %join, label %rare, !prof !16
+
+rare:
+  %a = call i32 @compute(i32 %x)
+  %b = mul i32 %a, 3
+  %c = add i32 %b, 7
+  store volatile i32 %c, i32* @sink
+  br label %join
+
+join:
+  ret i32 %x
+}
+
+@sink = global i32 0
+
+!llvm.module.flags = !{!1}
+!1 = !{i32 1, !"ProfileSummary", !2}
+!2 = !{!3, !4, !5, !6, !7, !8, !9, !10}
+!3 = !{!"ProfileFormat", !"InstrProf"}
+!4 = !{!"TotalCount", i64 10000}
+!5 = !{!"MaxCount", i64 1000}
+!6 = !{!"MaxInternalCount", i64 1}
+!7 = !{!"MaxFunctionCount", i64 1000}
+!8 = !{!"NumCounts", i64 3}
+!9 = !{!"NumFunctions", i64 3}
+!10 = !{!"DetailedSummary", !11}
+!11 = !{!12, !13, !14}
+!12 = !{i32 10000, i64 100, i32 1}
+!13 = !{i32 999000, i64 100, i32 1}
+!14 = !{i32 999999, i64 1, i32 2}
+!15 = !{!"function_entry_count", i64 1000}
+!16 = !{!"branch_weights", i32 1000, i32 0}
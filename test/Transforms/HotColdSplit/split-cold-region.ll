@@ -0,0 +1,64 @@
+; RUN: opt -hotcoldsplit -S < %s | FileCheck %s
+; RUN: opt -passes=hotcoldsplit -S < %s | FileCheck %s
+; RUN: opt -hotcoldsplit -pass-remarks=hotcoldsplit \
+; RUN:     -pass-remarks-missed=hotcoldsplit -disable-output < %s 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=REMARKS
+
+; The error path ends in a call to a cold function and an unreachable, and the
+; block computing its message only leads there, so both are outlined.
+
+; CHECK-LABEL: define i32 @parse(
+; CHECK: entry:
+; CHECK: call void @parse_bad.value(
+; CHECK-NOT: @report_error
+; CHECK: ret i32
+
+; The hot function is left alone when the region is too small.
+; CHECK-LABEL: define i32 @tiny(
+; CHECK: call void @abort()
+; CHECK: unreachable
+
+; CHECK: define internal void @parse_bad.value({{.*}}) [[ATTRS:#[0-9]+]] !section_prefix [[PREFIX:![0-9]+]]
+; CHECK: call void @report_error(
+; CHECK: attributes [[ATTRS]] = { {{.*}}cold{{.*}}minsize{{.*}}noinline{{.*}} }
+; CHECK: [[PREFIX]] = !{!"function_section_prefix", !".unlikely"}
+
+; REMARKS: remark: <unknown>:0:0: Outlined cold region into parse_bad.value
+
+declare void @report_error(i8*, i32) cold
+declare void @abort() noreturn
+declare i32 @compute(i32)
+
+@.msg = private constant [10 x i8] c"bad value\00"
+
+define i32 @parse(i32 %x) {
+entry:
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %good, label %bad.value
+
+good:
+  %r = call i32 @compute(i32 %x)
+  ret i32 %r
+
+bad.value:
+  %code = mul i32 %x, 3
+  %code.1 = add i32 %code, 7
+  br label %fail
+
+fail:
+  call void @report_error(i8* getelementptr ([10 x i8], [10 x i8]* @.msg, i32 0, i32 0), i32 %code.1)
+  unreachable
+}
+
+define i32 @tiny(i32 %x) {
+entry:
+  %ok = icmp slt i32 %x, 100
+  br i1 %ok, label %good, label %fail
+
+good:
+  ret i32 %x
+
+fail:
+  call void @abort()
+  unreachable
+}
@@ -0,0 +1,75 @@
+; RUN: opt < %s -S -passes=module-inline -module-inline-growth-percent=0 \
+; RUN:    -pass-remarks=module-inline 2>&1 | FileCheck %s --check-prefix=ALWAYS
+; RUN: opt < %s -S -passes=module-inline -module-inline-growth-percent=1000 \
+; RUN:    -pass-remarks=module-inline 2>&1 | FileCheck %s
+
+; Always-inline call sites are inlined even though the growth budget is zero,
+; and the local callee is deleted once it has no callers left.
+; ALWAYS: remark: <unknown>:0:0: always inlined into use_always with cost=always
+; ALWAYS-NOT: remark
+; ALWAYS-NOT: define internal i32 @always(
+; ALWAYS-LABEL: define i32 @use_always(
+; ALWAYS-NOT: call
+; ALWAYS: ret i32
+
+; Inlining @even into @main exposes a call to @odd, and inlining that exposes
+; a call to @even again. The inline history stops the cycle there, however
+; large the budget is.
+; CHECK: remark: <unknown>:0:0: even inlined into main
+; CHECK: remark: <unknown>:0:0: odd inlined into main
+; CHECK-NOT: remark: <unknown>:0:0: even inlined into main
+
+; CHECK-LABEL: define i32 @main(
+; CHECK: call i32 @even(
+; CHECK-NOT: call
+; CHECK: ret i32
+
+define internal i32 @always(i32 %x) alwaysinline {
+entry:
+  %a = mul i32 %x, %x
+  %b = add i32 %a, 7
+  %c = xor i32 %b, %x
+  %d = mul i32 %c, 3
+  %e = sub i32 %d, %a
+  ret i32 %e
+}
+
+define i32 @use_always(i32 %x) {
+entry:
+  %r = call i32 @always(i32 %x)
+  ret i32 %r
+}
+
+define i32 @main(i32 %n) {
+entry:
+  %r = call i32 @even(i32 %n)
+  ret i32 %r
+}
+
+define i32 @even(i32 %n) {
+entry:
+  %z = icmp eq i32 %n, 0
+  br i1 %z, label %done, label %rec
+
+rec:
+  %m = sub i32 %n, 1
+  %r = call i32 @odd(i32 %m)
+  ret i32 %r
+
+done:
+  ret i32 1
+}
+
+define i32 @odd(i32 %n) {
+entry:
+  %z = icmp eq i32 %n, 0
+  br i1 %z, label %done, label %rec
+
+rec:
+  %m = sub i32 %n, 1
+  %r = call i32 @even(i32 %m)
+  ret i32 %r
+
+done:
+  ret i32 0
+}
@@ -0,0 +1,83 @@
+; RUN: opt < %s -S -passes=module-inline -module-inline-growth-percent=40 \
+; RUN:    -pass-remarks=module-inline -pass-remarks-missed=module-inline \
+; RUN:    2>&1 | FileCheck %s
+; RUN: opt < %s -S -passes=module-inline -module-inline-growth-percent=100 \
+; RUN:    | FileCheck %s --check-prefix=ALL
+; RUN: opt < %s -S -passes='default<O2>' -enable-npm-module-inliner \
+; RUN:    -debug-pass-manager 2>&1 | FileCheck %s --check-prefix=PIPELINE
+
+; The call in the loop of @hot_caller is more profitable than the one in
+; @cold_caller although it comes later in the module, so it is the one that
+; fits in the growth budget.
+
+; CHECK: remark: <unknown>:0:0: hot inlined into hot_caller with cost={{[0-9\-]+}} (threshold={{[0-9]+}})
+; CHECK: remark: <unknown>:0:0: cold not inlined into cold_caller because the module growth budget is exhausted
+
+; CHECK-LABEL: define i32 @cold_caller(
+; CHECK: call i32 @cold(
+; CHECK-LABEL: define i32 @hot_caller(
+; CHECK-NOT: call i32 @hot(
+; CHECK: ret i32
+
+; With a larger budget, both call sites are inlined.
+
+; ALL-LABEL: define i32 @cold_caller(
+; ALL-NOT: call
+; ALL-LABEL: define i32 @hot_caller(
+; ALL-NOT: call
+
+; The module inliner runs before GlobalsAA is computed for the CGSCC walk, so
+; that it does not invalidate it.
+; PIPELINE: Running pass: ModuleInlinerPass
+; PIPELINE-NOT: Invalidating analysis: GlobalsAA
+; PIPELINE: Running analysis: GlobalsAA
+; PIPELINE-NOT: Invalidating analysis: GlobalsAA
+; PIPELINE-NOT: Running pass: InlinerPass
+; PIPELINE: Running pass: PostOrderFunctionAttrsPass
+
+define i32 @cold(i32 %x) {
+entry:
+  %a = mul i32 %x, %x
+  %b = add i32 %a, 7
+  %c = xor i32 %b, %x
+  %d = mul i32 %c, 3
+  %e = sub i32 %d, %a
+  %f = or i32 %e, 1
+  %g = add i32 %f, %b
+  ret i32 %g
+}
+
+define i32 @hot(i32 %x) {
+entry:
+  %a = mul i32 %x, %x
+  %b = add i32 %a, 7
+  %c = xor i32 %b, %x
+  %d = mul i32 %c, 3
+  %e = sub i32 %d, %a
+  %f = or i32 %e, 1
+  %g = add i32 %f, %b
+  ret i32 %g
+}
+
+define i32 @cold_caller(i32 %x) {
+entry:
+  %r = call i32 @cold(i32 %x)
+  ret i32 %r
+}
+
+define i32 @hot_caller(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+  %v = call i32 @hot(i32 %i)
+  %sum.next = add i32 %sum, %v
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %sum.next
+}
@@ -0,0 +1,218 @@
+; RUN: opt < %s -loop-fusion -pass-remarks=loop-fusion -pass-remarks-missed=loop-fusion -disable-output 2>&1 | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; CHECK: remark: <unknown>:0:0: fused with the following loop
+; CHECK: remark: <unknown>:0:0: loop not fused with the preceding loop: trip counts of the loops are not known to be equal
+; CHECK: remark: <unknown>:0:0: loop not fused with the preceding loop: loops are not control-flow equivalent
+; CHECK: remark: <unknown>:0:0: loop not fused with the preceding loop: code between the loops cannot be moved before the first loop
+; CHECK: remark: <unknown>:0:0: loop not fused with the preceding loop: values computed in the first loop are used after it
+; CHECK: remark: <unknown>:0:0: loop not fused with the preceding loop: loop contains calls or other instructions with side effects
+; CHECK: remark: <unknown>:0:0: loop not fused with the preceding loop: dependence prevents fusion
+
+declare void @f()
+
+define void @fused(i32* noalias %a, i32* noalias %b) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  store i32 1, i32* %b.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
+
+define void @trip_count(i32* noalias %a, i32* noalias %b) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  store i32 1, i32* %b.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 200
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
+
+; The second loop only runs if %c is true.
+
+define void @guarded(i32* noalias %a, i32* noalias %b, i1 %c) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %guard
+
+guard:
+  br i1 %c, label %l1.ph, label %exit
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  store i32 1, i32* %b.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %l1.exit
+
+l1.exit:
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @store_between(i32* noalias %a, i32* noalias %b, i32* %p) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  store i32 0, i32* %p, align 4
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  store i32 1, i32* %b.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
+
+define i32 @live_out(i32* noalias %a, i32* noalias %b) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  %a.val = load i32, i32* %a.gep, align 4
+  %s.next = add i32 %s, %a.val
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  %s.lcssa = phi i32 [ %s.next, %l0 ]
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  store i32 %s.lcssa, i32* %b.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret i32 %s.lcssa
+}
+
+define void @call(i32* noalias %a) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  call void @f()
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
+
+; The second loop reads the array backwards.
+
+define void @reverse(i32* noalias %a, i32* noalias %b) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %rev = sub nsw i64 99, %j
+  %a.gep1 = getelementptr inbounds i32, i32* %a, i64 %rev
+  %a.val = load i32, i32* %a.gep1, align 4
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  store i32 %a.val, i32* %b.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
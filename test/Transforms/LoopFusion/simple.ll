@@ -0,0 +1,147 @@
+; RUN: opt < %s -loop-fusion -S | FileCheck %s
+; RUN: opt < %s -passes=loop-fusion -aa-pipeline=basic-aa -S | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; The second loop reads a[i] after the first loop wrote it in the same
+; iteration, so the loops can share one header.
+
+; CHECK-LABEL: @fuse(
+; CHECK: entry:
+; CHECK-NEXT: br label %l0
+; CHECK: l0:
+; CHECK-NEXT: %i = phi i64 [ 0, %entry ], [ %i.next, %l1 ]
+; CHECK-NEXT: %j = phi i64 [ 0, %entry ], [ %j.next, %l1 ]
+; CHECK: store i32
+; CHECK: %i.next = add nuw nsw i64 %i, 1
+; CHECK-NEXT: br label %l1
+; CHECK: l1:
+; CHECK: load i32
+; CHECK: store i32
+; CHECK: %cond1 = icmp ne i64 %j.next, 100
+; CHECK-NEXT: br i1 %cond1, label %l0, label %exit
+; CHECK-NOT: l1.ph:
+
+define void @fuse(i32* noalias %a, i32* noalias %b, i32* noalias %c) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %i
+  %b.val = load i32, i32* %b.gep, align 4
+  %add = add nsw i32 %b.val, 1
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 %add, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %a.gep1 = getelementptr inbounds i32, i32* %a, i64 %j
+  %a.val = load i32, i32* %a.gep1, align 4
+  %mul = mul nsw i32 %a.val, 2
+  %c.gep = getelementptr inbounds i32, i32* %c, i64 %j
+  store i32 %mul, i32* %c.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
+
+; Three loops with the same trip count in a row are fused into one. The
+; code before the third loop is hoisted above the first loop.
+
+; CHECK-LABEL: @fuse_three(
+; CHECK: entry:
+; CHECK-NEXT: %n.trunc = trunc i64 %n to i32
+; CHECK-NEXT: br label %l0
+; CHECK: l0:
+; CHECK-NEXT: %i = phi i64 [ 0, %entry ], [ %i.next, %l2 ]
+; CHECK-NEXT: %j = phi i64 [ 0, %entry ], [ %j.next, %l2 ]
+; CHECK-NEXT: %k = phi i64 [ 0, %entry ], [ %k.next, %l2 ]
+; CHECK: br label %l1
+; CHECK: l1:
+; CHECK: br label %l2
+; CHECK: l2:
+; CHECK: br i1 %cond2, label %l0, label %exit
+
+define void @fuse_three(i32* noalias %a, i32* noalias %b, i64 %n) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %i
+  store i32 0, i32* %b.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, %n
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %j
+  store i32 1, i32* %a.gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %cond1 = icmp ne i64 %j.next, %n
+  br i1 %cond1, label %l1, label %l2.ph
+
+l2.ph:
+  %n.trunc = trunc i64 %n to i32
+  br label %l2
+
+l2:
+  %k = phi i64 [ 0, %l2.ph ], [ %k.next, %l2 ]
+  %a.gep2 = getelementptr inbounds i32, i32* %a, i64 %k
+  store i32 %n.trunc, i32* %a.gep2, align 4
+  %k.next = add nuw nsw i64 %k, 1
+  %cond2 = icmp ne i64 %k.next, %n
+  br i1 %cond2, label %l2, label %exit
+
+exit:
+  ret void
+}
+
+; The second loop reads a[i + 1] before the fused loop would have written it.
+
+; CHECK-LABEL: @backward_dependence(
+; CHECK: br i1 %cond0, label %l0, label %l1.ph
+; CHECK: br i1 %cond1, label %l1, label %exit
+
+define void @backward_dependence(i32* noalias %a, i32* noalias %c) {
+entry:
+  br label %l0
+
+l0:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %l0 ]
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 0, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %cond0 = icmp ne i64 %i.next, 100
+  br i1 %cond0, label %l0, label %l1.ph
+
+l1.ph:
+  br label %l1
+
+l1:
+  %j = phi i64 [ 0, %l1.ph ], [ %j.next, %l1 ]
+  %j.next = add nuw nsw i64 %j, 1
+  %a.gep1 = getelementptr inbounds i32, i32* %a, i64 %j.next
+  %a.val = load i32, i32* %a.gep1, align 4
+  %c.gep = getelementptr inbounds i32, i32* %c, i64 %j
+  store i32 %a.val, i32* %c.gep, align 4
+  %cond1 = icmp ne i64 %j.next, 100
+  br i1 %cond1, label %l1, label %exit
+
+exit:
+  ret void
+}
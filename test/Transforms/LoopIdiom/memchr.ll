@@ -0,0 +1,121 @@
+; RUN: opt -loop-idiom -S < %s | FileCheck %s
+; RUN: opt -loop-idiom -disable-simplify-libcalls -S < %s | FileCheck %s --check-prefix=NOLIB
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; NOLIB-NOT: call i8* @memchr
+
+; CHECK-LABEL: @find_ptr(
+; CHECK: loop.ph:
+; CHECK-NEXT: [[CH:%.*]] = zext i8 %ch to i32
+; CHECK-NEXT: [[FOUND:%.*]] = call i8* @memchr(i8* %s, i32 [[CH]], i64 %n)
+; CHECK-NEXT: [[NOTFOUND:%.*]] = icmp eq i8* [[FOUND]], null
+; CHECK: [[SEL:%.*]] = select i1 [[NOTFOUND]], i8* null, i8* {{%.*}}
+; CHECK-NEXT: br label %loop.exit
+; CHECK: loop.exit:
+; CHECK-NEXT: phi i8* [ [[SEL]], %loop.ph ]
+
+define i8* @find_ptr(i8* %s, i8 %ch, i64 %n) {
+entry:
+  %empty = icmp eq i64 %n, 0
+  br i1 %empty, label %exit, label %loop.ph
+
+loop.ph:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %loop.ph ], [ %i.next, %latch ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  %found = icmp eq i8 %c, %ch
+  br i1 %found, label %loop.exit, label %latch
+
+latch:
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %loop.exit, label %loop
+
+loop.exit:
+  %r.lcssa = phi i8* [ %gep, %loop ], [ null, %latch ]
+  br label %exit
+
+exit:
+  %r = phi i8* [ null, %entry ], [ %r.lcssa, %loop.exit ]
+  ret i8* %r
+}
+
+; The index of the byte is returned, or the length if it was not found.
+
+; CHECK-LABEL: @find_index(
+; CHECK: loop.ph:
+; CHECK-NEXT: [[FOUND:%.*]] = call i8* @memchr(i8* %s, i32 10, i64 %n)
+; CHECK-NEXT: [[NOTFOUND:%.*]] = icmp eq i8* [[FOUND]], null
+; CHECK-NEXT: [[END:%.*]] = ptrtoint i8* [[FOUND]] to i64
+; CHECK-NEXT: [[START:%.*]] = ptrtoint i8* %s to i64
+; CHECK-NEXT: [[POS:%.*]] = sub i64 [[END]], [[START]]
+; CHECK: select i1 [[NOTFOUND]], i64 %n, i64 [[POS]]
+
+define i64 @find_index(i8* %s, i64 %n) {
+entry:
+  %empty = icmp eq i64 %n, 0
+  br i1 %empty, label %exit, label %loop.ph
+
+loop.ph:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %loop.ph ], [ %i.next, %latch ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  %found = icmp ne i8 %c, 10
+  br i1 %found, label %latch, label %loop.exit
+
+latch:
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %loop.exit, label %loop
+
+loop.exit:
+  %r.lcssa = phi i64 [ %i, %loop ], [ %i.next, %latch ]
+  br label %exit
+
+exit:
+  %r = phi i64 [ 0, %entry ], [ %r.lcssa, %loop.exit ]
+  ret i64 %r
+}
+
+; The loop stores to memory, so it cannot be removed.
+
+; CHECK-LABEL: @find_store(
+; CHECK-NOT: call i8* @memchr
+; CHECK: br i1 %found, label %loop.exit, label %latch
+
+define i8* @find_store(i8* %s, i8 %ch, i64 %n, i64* %p) {
+entry:
+  %empty = icmp eq i64 %n, 0
+  br i1 %empty, label %exit, label %loop.ph
+
+loop.ph:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %loop.ph ], [ %i.next, %latch ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  %found = icmp eq i8 %c, %ch
+  br i1 %found, label %loop.exit, label %latch
+
+latch:
+  store i64 %i, i64* %p, align 8
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %loop.exit, label %loop
+
+loop.exit:
+  %r.lcssa = phi i8* [ %gep, %loop ], [ null, %latch ]
+  br label %exit
+
+exit:
+  %r = phi i8* [ null, %entry ], [ %r.lcssa, %loop.exit ]
+  ret i8* %r
+}
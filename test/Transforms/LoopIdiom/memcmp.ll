@@ -0,0 +1,97 @@
+; RUN: opt -loop-idiom -S < %s | FileCheck %s
+; RUN: opt -loop-idiom -disable-simplify-libcalls -S < %s | FileCheck %s --check-prefix=NOLIB
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; NOLIB-NOT: call i32 @memcmp
+
+; CHECK-LABEL: @equal(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: [[CMP:%.*]] = call i32 @memcmp(i8* %a, i8* %b, i64 16)
+; CHECK-NEXT: [[EQ:%.*]] = icmp eq i32 [[CMP]], 0
+; CHECK-NEXT: [[SEL:%.*]] = select i1 [[EQ]], i1 true, i1 false
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: phi i1 [ [[SEL]], %entry ]
+
+define i1 @equal(i8* dereferenceable(16) %a, i8* dereferenceable(16) %b) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+  %a.gep = getelementptr inbounds i8, i8* %a, i64 %i
+  %a.val = load i8, i8* %a.gep, align 1
+  %b.gep = getelementptr inbounds i8, i8* %b, i64 %i
+  %b.val = load i8, i8* %b.gep, align 1
+  %ne = icmp ne i8 %a.val, %b.val
+  br i1 %ne, label %exit, label %latch
+
+latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, 16
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r = phi i1 [ false, %loop ], [ true, %latch ]
+  ret i1 %r
+}
+
+; memcmp may read past the first difference, which the loop does not.
+
+; CHECK-LABEL: @not_dereferenceable(
+; CHECK-NOT: call i32 @memcmp
+; CHECK: br i1 %ne, label %exit, label %latch
+
+define i1 @not_dereferenceable(i8* %a, i8* dereferenceable(16) %b) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+  %a.gep = getelementptr inbounds i8, i8* %a, i64 %i
+  %a.val = load i8, i8* %a.gep, align 1
+  %b.gep = getelementptr inbounds i8, i8* %b, i64 %i
+  %b.val = load i8, i8* %b.gep, align 1
+  %ne = icmp ne i8 %a.val, %b.val
+  br i1 %ne, label %exit, label %latch
+
+latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, 16
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r = phi i1 [ false, %loop ], [ true, %latch ]
+  ret i1 %r
+}
+
+; The position of the first difference is not known after memcmp.
+
+; CHECK-LABEL: @mismatch_index(
+; CHECK-NOT: call i32 @memcmp
+; CHECK: br i1 %ne, label %exit, label %latch
+
+define i64 @mismatch_index(i8* dereferenceable(16) %a,
+                           i8* dereferenceable(16) %b) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+  %a.gep = getelementptr inbounds i8, i8* %a, i64 %i
+  %a.val = load i8, i8* %a.gep, align 1
+  %b.gep = getelementptr inbounds i8, i8* %b, i64 %i
+  %b.val = load i8, i8* %b.gep, align 1
+  %ne = icmp ne i8 %a.val, %b.val
+  br i1 %ne, label %exit, label %latch
+
+latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, 16
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r = phi i64 [ %i, %loop ], [ 16, %latch ]
+  ret i64 %r
+}
@@ -0,0 +1,130 @@
+; RUN: opt -loop-idiom -S < %s | FileCheck %s
+; RUN: opt -aa-pipeline=basic-aa -passes='require<aa>,require<targetir>,require<scalar-evolution>,loop(loop-idiom)' -S < %s | FileCheck %s
+; RUN: opt -loop-idiom -disable-simplify-libcalls -S < %s | FileCheck %s --check-prefix=NOLIB
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; NOLIB-NOT: call i64 @strlen
+
+; CHECK-LABEL: @strlen_index(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: [[LEN:%.*]] = call i64 @strlen(i8* %s)
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: [[RES:%.*]] = phi i64 [ [[LEN]], %entry ]
+; CHECK-NEXT: ret i64 [[RES]]
+
+define i64 @strlen_index(i8* %s) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i8 %c, 0
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %i.lcssa = phi i64 [ %i, %loop ]
+  ret i64 %i.lcssa
+}
+
+; The loop walks a pointer to the null byte and continues while the byte is
+; not null.
+
+; CHECK-LABEL: @strlen_end(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: [[LEN:%.*]] = call i64 @strlen(i8* %s)
+; CHECK-NEXT: [[END:%.*]] = getelementptr i8, i8* %s, i64 [[LEN]]
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: [[RES:%.*]] = phi i8* [ [[END]], %entry ]
+; CHECK-NEXT: ret i8* [[RES]]
+
+define i8* @strlen_end(i8* %s) {
+entry:
+  br label %loop
+
+loop:
+  %p = phi i8* [ %s, %entry ], [ %p.next, %loop ]
+  %c = load i8, i8* %p, align 1
+  %p.next = getelementptr inbounds i8, i8* %p, i64 1
+  %cont = icmp ne i8 %c, 0
+  br i1 %cont, label %loop, label %exit
+
+exit:
+  %p.lcssa = phi i8* [ %p, %loop ]
+  ret i8* %p.lcssa
+}
+
+; The loop stores to memory, so it cannot be removed.
+
+; CHECK-LABEL: @strlen_store(
+; CHECK-NOT: call i64 @strlen
+; CHECK: br i1 %done, label %exit, label %loop
+
+define i64 @strlen_store(i8* %s, i64* %cnt) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  store i64 %i, i64* %cnt, align 8
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i8 %c, 0
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %i.lcssa = phi i64 [ %i, %loop ]
+  ret i64 %i.lcssa
+}
+
+; The loop searches for a byte other than null.
+
+; CHECK-LABEL: @strlen_not_null(
+; CHECK-NOT: call i64 @strlen
+; CHECK: br i1 %done, label %exit, label %loop
+
+define i64 @strlen_not_null(i8* %s) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i8 %c, 10
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %i.lcssa = phi i64 [ %i, %loop ]
+  ret i64 %i.lcssa
+}
+
+; The loop reads every other byte.
+
+; CHECK-LABEL: @strlen_stride(
+; CHECK-NOT: call i64 @strlen
+; CHECK: br i1 %done, label %exit, label %loop
+
+define i64 @strlen_stride(i8* %s) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %gep = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %gep, align 1
+  %i.next = add nuw i64 %i, 2
+  %done = icmp eq i8 %c, 0
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %i.lcssa = phi i64 [ %i, %loop ]
+  ret i64 %i.lcssa
+}
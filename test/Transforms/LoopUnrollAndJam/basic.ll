@@ -0,0 +1,156 @@
+; RUN: opt < %s -loop-unroll-and-jam -unroll-and-jam-count=2 -S | FileCheck %s
+; RUN: opt < %s -passes=loop-unroll-and-jam -aa-pipeline=basic-aa -unroll-and-jam-count=2 -S | FileCheck %s
+; RUN: opt < %s -loop-unroll-and-jam -pass-remarks=loop-unroll-and-jam -S 2>&1 | FileCheck %s --check-prefix=DEFAULT
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; DEFAULT: remark: <unknown>:0:0: unroll and jammed loop by a factor of 4
+; DEFAULT: remark: <unknown>:0:0: unroll and jammed loop by a factor of 3
+
+; c[i] = sum(a[i][j] * b[j]). The copies of the inner loop share the load of
+; b[j]. The increment of i moves before the inner loop, all Fore blocks run
+; first, then the jammed inner loop and then all Aft blocks.
+
+; CHECK-LABEL: @matvec(
+; CHECK: outer:
+; CHECK-NEXT: %i = phi i64 [ 0, %entry ], [ %i.next.1, %outer.latch.1 ]
+; CHECK-NEXT: %i.next = add nuw nsw i64 %i, 1
+; CHECK-NEXT: br label %outer.1
+; CHECK: outer.1:
+; CHECK-NEXT: %i.next.1 = add nuw nsw i64 %i.next, 1
+; CHECK-NEXT: br label %inner
+; CHECK: inner:
+; CHECK-NEXT: %j = phi i64 [ 0, %outer.1 ], [ %j.next, %inner.1 ]
+; CHECK-NEXT: %s = phi i32 [ 0, %outer.1 ], [ %s.next, %inner.1 ]
+; CHECK-NEXT: %j.1 = phi i64 [ 0, %outer.1 ], [ %j.next.1, %inner.1 ]
+; CHECK-NEXT: %s.1 = phi i32 [ 0, %outer.1 ], [ %s.next.1, %inner.1 ]
+; CHECK: %j.next = add nuw nsw i64 %j, 1
+; CHECK-NEXT: br label %inner.1
+; CHECK: inner.1:
+; CHECK: %inner.cond.1 = icmp ne i64 %j.next.1, %m
+; CHECK-NEXT: br i1 %inner.cond.1, label %inner, label %outer.latch
+; CHECK: outer.latch:
+; CHECK-NEXT: %s.lcssa = phi i32 [ %s.next, %inner.1 ]
+; CHECK-NEXT: %s.lcssa.1 = phi i32 [ %s.next.1, %inner.1 ]
+; CHECK: store i32 %s.lcssa, i32* %c.gep
+; CHECK-NEXT: br label %outer.latch.1
+; CHECK: outer.latch.1:
+; CHECK: store i32 %s.lcssa.1, i32* %c.gep.1
+; CHECK: %outer.cond.1 = icmp ne i64 %i.next.1, 8
+; CHECK-NEXT: br i1 %outer.cond.1, label %outer, label %exit, !llvm.loop [[LOOP:![0-9]+]]
+
+; DEFAULT-LABEL: @matvec(
+; DEFAULT: inner.3:
+; DEFAULT-NOT: inner.4:
+; DEFAULT: ret void
+
+define void @matvec([64 x i32]* noalias %a, i32* noalias %b, i32* noalias %c,
+                    i64 %m) {
+entry:
+  br label %outer
+
+outer:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer ], [ %j.next, %inner ]
+  %s = phi i32 [ 0, %outer ], [ %s.next, %inner ]
+  %a.gep = getelementptr inbounds [64 x i32], [64 x i32]* %a, i64 %i, i64 %j
+  %a.val = load i32, i32* %a.gep, align 4
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  %b.val = load i32, i32* %b.gep, align 4
+  %mul = mul nsw i32 %a.val, %b.val
+  %s.next = add nsw i32 %s, %mul
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp ne i64 %j.next, %m
+  br i1 %inner.cond, label %inner, label %outer.latch
+
+outer.latch:
+  %s.lcssa = phi i32 [ %s.next, %inner ]
+  %c.gep = getelementptr inbounds i32, i32* %c, i64 %i
+  store i32 %s.lcssa, i32* %c.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp ne i64 %i.next, 8
+  br i1 %outer.cond, label %outer, label %exit
+
+exit:
+  ret void
+}
+
+; a[j] = a[j + 1] + i: iteration (i + 1, j) reads the value iteration (i, j + 1)
+; stores, which runs after it once the loops are jammed.
+
+; CHECK-LABEL: @dependence(
+; CHECK-NOT: inner.1:
+; CHECK: ret void
+
+define void @dependence(i32* noalias %a, i64 %m) {
+entry:
+  br label %outer
+
+outer:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %i.trunc = trunc i64 %i to i32
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer ], [ %j.next, %inner ]
+  %j.next = add nuw nsw i64 %j, 1
+  %src = getelementptr inbounds i32, i32* %a, i64 %j.next
+  %val = load i32, i32* %src, align 4
+  %add = add nsw i32 %val, %i.trunc
+  %dst = getelementptr inbounds i32, i32* %a, i64 %j
+  store i32 %add, i32* %dst, align 4
+  %inner.cond = icmp ne i64 %j.next, %m
+  br i1 %inner.cond, label %inner, label %outer.latch
+
+outer.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp ne i64 %i.next, 8
+  br i1 %outer.cond, label %outer, label %exit
+
+exit:
+  ret void
+}
+
+; Nothing is shared between the copies of the inner loop, so the loop nest is
+; only unroll and jammed as requested by its pragma.
+
+; DEFAULT-LABEL: @pragma(
+; DEFAULT: inner.2:
+; DEFAULT-NOT: inner.3:
+; DEFAULT: br i1 %outer.cond.2, label %outer, label %exit, !llvm.loop [[PRAGMA:![0-9]+]]
+
+define void @pragma([64 x i32]* noalias %a, i64 %m) {
+entry:
+  br label %outer
+
+outer:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer ], [ %j.next, %inner ]
+  %gep = getelementptr inbounds [64 x i32], [64 x i32]* %a, i64 %i, i64 %j
+  store i32 0, i32* %gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp ne i64 %j.next, %m
+  br i1 %inner.cond, label %inner, label %outer.latch
+
+outer.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp ne i64 %i.next, 6
+  br i1 %outer.cond, label %outer, label %exit, !llvm.loop !0
+
+exit:
+  ret void
+}
+
+; CHECK: [[LOOP]] = distinct !{[[LOOP]], [[DISABLE:![0-9]+]]}
+; CHECK: [[DISABLE]] = !{!"llvm.loop.unroll_and_jam.disable"}
+
+; DEFAULT: [[PRAGMA]] = distinct !{[[PRAGMA]], !{{[0-9]+}}}
+
+!0 = distinct !{!0, !1}
+!1 = !{!"llvm.loop.unroll_and_jam.count", i32 3}
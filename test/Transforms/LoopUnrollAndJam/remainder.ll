@@ -0,0 +1,81 @@
+; RUN: opt < %s -loop-unroll-and-jam -unroll-and-jam-count=2 -S | FileCheck %s
+; RUN: opt < %s -passes=loop-unroll-and-jam -aa-pipeline=basic-aa -unroll-and-jam-count=2 -S | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; c[i] = sum(a[i][j] * b[j]) for an unknown number of rows %n. The last
+; iteration for an odd %n runs in an epilogue copy of the loop nest, which is
+; neither unroll and jammed nor unrolled.
+
+; CHECK-LABEL: @matvec_n(
+; CHECK: entry:
+; CHECK: %xtraiter = and i64 %n, 1
+; CHECK: br i1 %{{.*}}, label %exit.unr-lcssa, label %entry.new
+; CHECK: entry.new:
+; CHECK-NEXT: %unroll_iter = sub i64 %n, %xtraiter
+; CHECK: outer:
+; CHECK-NEXT: %i = phi i64 [ 0, %entry.new ], [ %i.next.1, %outer.latch.1 ]
+; CHECK-NEXT: %niter = phi i64 [ %unroll_iter, %entry.new ], [ %niter.nsub.1, %outer.latch.1 ]
+; CHECK: inner:
+; CHECK-NEXT: %j = phi i64 [ 0, %outer.1 ], [ %j.next, %inner.1 ]
+; CHECK-NEXT: %s = phi i32 [ 0, %outer.1 ], [ %s.next, %inner.1 ]
+; CHECK-NEXT: %j.1 = phi i64 [ 0, %outer.1 ], [ %j.next.1, %inner.1 ]
+; CHECK-NEXT: %s.1 = phi i32 [ 0, %outer.1 ], [ %s.next.1, %inner.1 ]
+; CHECK: inner.1:
+; CHECK: br i1 %inner.cond.1, label %inner, label %outer.latch
+; CHECK: outer.latch.1:
+; CHECK: store i32 %s.lcssa.1, i32* %c.gep.1
+; CHECK: %niter.ncmp.1 = icmp ne i64 %niter.nsub.1, 0
+; CHECK-NEXT: br i1 %niter.ncmp.1, label %outer, label %exit.unr-lcssa.loopexit, !llvm.loop [[LOOP:![0-9]+]]
+; CHECK: exit.unr-lcssa:
+; CHECK-NEXT: %i.unr = phi i64 [ 0, %entry ], [ %i.unr.ph, %exit.unr-lcssa.loopexit ]
+; CHECK-NEXT: %lcmp.mod = icmp ne i64 %xtraiter, 0
+; CHECK-NEXT: br i1 %lcmp.mod, label %outer.epil.preheader, label %exit
+; CHECK: outer.epil:
+; CHECK-NEXT: %i.epil = phi i64 [ %i.unr, %outer.epil.preheader ]
+; CHECK-NEXT: br label %inner.epil
+; CHECK: inner.epil:
+; CHECK-NOT: .1 =
+; CHECK: br i1 %inner.cond.epil, label %inner.epil, label %outer.latch.epil
+; CHECK-NOT: !llvm.loop
+; CHECK: outer.latch.epil:
+; CHECK: store i32 %s.lcssa.epil, i32* %c.gep.epil
+; CHECK-NEXT: %i.next.epil = add nuw nsw i64 %i.epil, 1
+; CHECK: br label %exit.epilog-lcssa
+
+; CHECK: [[LOOP]] = distinct !{[[LOOP]], [[DISABLE:![0-9]+]]}
+; CHECK: [[DISABLE]] = !{!"llvm.loop.unroll_and_jam.disable"}
+
+define void @matvec_n([64 x i32]* noalias %a, i32* noalias %b, i32* noalias %c,
+                      i64 %n, i64 %m) {
+entry:
+  br label %outer
+
+outer:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer ], [ %j.next, %inner ]
+  %s = phi i32 [ 0, %outer ], [ %s.next, %inner ]
+  %a.gep = getelementptr inbounds [64 x i32], [64 x i32]* %a, i64 %i, i64 %j
+  %a.val = load i32, i32* %a.gep, align 4
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  %b.val = load i32, i32* %b.gep, align 4
+  %mul = mul nsw i32 %a.val, %b.val
+  %s.next = add nsw i32 %s, %mul
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp ne i64 %j.next, %m
+  br i1 %inner.cond, label %inner, label %outer.latch
+
+outer.latch:
+  %s.lcssa = phi i32 [ %s.next, %inner ]
+  %c.gep = getelementptr inbounds i32, i32* %c, i64 %i
+  store i32 %s.lcssa, i32* %c.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp ne i64 %i.next, %n
+  br i1 %outer.cond, label %outer, label %exit
+
+exit:
+  ret void
+}
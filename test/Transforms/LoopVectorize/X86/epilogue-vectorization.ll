@@ -0,0 +1,119 @@
+; RUN: opt < %s -loop-vectorize -enable-epilogue-vectorization -force-vector-width=8 -force-vector-interleave=1 -pass-remarks=loop-vectorize -S 2>%t | FileCheck %s
+; RUN: FileCheck %s --check-prefix=REMARK < %t
+; RUN: opt < %s -loop-vectorize -force-vector-width=8 -force-vector-interleave=1 -S | FileCheck %s --check-prefix=DISABLED
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; The remainder of the VF 8 loop is vectorized with VF 4. The epilogue vector
+; loop reuses the memory checks of the main vector loop and is skipped when
+; they failed.
+
+; REMARK: remark: <unknown>:0:0: vectorized loop (vectorization width: 8, interleaved count: 1)
+; REMARK: remark: <unknown>:0:0: vectorized epilogue loop (vectorization width: 4)
+
+; CHECK-LABEL: @add(
+; CHECK: vector.memcheck:
+; CHECK: vector.body:
+; CHECK: load <8 x float>
+; CHECK: middle.block:
+; CHECK: scalar.ph:
+; CHECK-NEXT: %vec.loop.taken = phi i1 [ true, %middle.block ], [ false, %for.body.preheader ], [ false, %vector.memcheck ]
+; CHECK: br i1 %min.iters.check{{[0-9]*}}, label %scalar.ph{{[0-9]+}}, label %vector.checkspassed
+; CHECK: vector.checkspassed:
+; CHECK-NEXT: br i1 %vec.loop.taken, label %vector.ph{{[0-9]+}}, label %scalar.ph{{[0-9]+}}
+; CHECK: vector.body{{[0-9]+}}:
+; CHECK: load <4 x float>
+; CHECK: store <4 x float>
+; CHECK: middle.block{{[0-9]+}}:
+; CHECK: for.body:
+; CHECK-NOT: <{{[0-9]+}} x float>
+; CHECK: ret void
+
+; DISABLED-LABEL: @add(
+; DISABLED-NOT: vec.loop.taken
+; DISABLED-NOT: <4 x float>
+; DISABLED: ret void
+
+define void @add(float* %a, float* %b, float* %c, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %b.gep = getelementptr inbounds float, float* %b, i64 %i
+  %b.val = load float, float* %b.gep, align 4
+  %c.gep = getelementptr inbounds float, float* %c, i64 %i
+  %c.val = load float, float* %c.gep, align 4
+  %sum = fadd float %b.val, %c.val
+  %a.gep = getelementptr inbounds float, float* %a, i64 %i
+  store float %sum, float* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Without runtime checks the epilogue vector loop also runs when the trip
+; count is too small for the main vector loop.
+
+; CHECK-LABEL: @add_noalias(
+; CHECK-NOT: vec.loop.taken
+; CHECK: load <8 x float>
+; CHECK: load <4 x float>
+; CHECK: ret void
+
+define void @add_noalias(float* noalias %a, float* noalias %b, float* noalias %c, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %b.gep = getelementptr inbounds float, float* %b, i64 %i
+  %b.val = load float, float* %b.gep, align 4
+  %c.gep = getelementptr inbounds float, float* %c, i64 %i
+  %c.val = load float, float* %c.gep, align 4
+  %sum = fadd float %b.val, %c.val
+  %a.gep = getelementptr inbounds float, float* %a, i64 %i
+  store float %sum, float* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; The sum reduction of the main loop is continued by the epilogue vector loop.
+
+; CHECK-LABEL: @sum(
+; CHECK: vector.body:
+; CHECK: load <8 x i32>
+; CHECK: add <8 x i32>
+; CHECK: vector.body{{[0-9]+}}:
+; CHECK: load <4 x i32>
+; CHECK: add <4 x i32>
+; CHECK: for.end:
+; CHECK: ret i32
+
+define i32 @sum(i32* noalias %a, i64 %n) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %s = phi i32 [ %s.next, %for.body ], [ 0, %entry ]
+  %gep = getelementptr inbounds i32, i32* %a, i64 %i
+  %val = load i32, i32* %gep, align 4
+  %s.next = add i32 %s, %val
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret i32 %s.next
+}
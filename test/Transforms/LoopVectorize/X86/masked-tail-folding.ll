@@ -0,0 +1,102 @@
+; RUN: opt < %s -loop-vectorize -enable-masked-tail-folding -mattr=+avx512f -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -mattr=+avx512f -S | FileCheck %s --check-prefix=NOFOLD
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; With a trip count of 20, one masked iteration of the VF 16 loop is cheaper
+; than the 4 scalar remainder iterations, so the tail is folded: the mask
+; compares the induction variable with the backedge-taken count, all memory
+; accesses are masked and the scalar loop is only reached through the bypass.
+
+; CHECK-LABEL: @add20(
+; CHECK: vector.body:
+; CHECK: [[MASK:%.*]] = icmp ule <16 x i64> {{%.*}}, <i64 19, i64 19
+; CHECK: call <16 x i32> @llvm.masked.load.v16i32.p0v16i32({{.*}}, <16 x i1> [[MASK]]
+; CHECK: call <16 x i32> @llvm.masked.load.v16i32.p0v16i32({{.*}}, <16 x i1> [[MASK]]
+; CHECK: call void @llvm.masked.store.v16i32.p0v16i32({{.*}}, <16 x i1> [[MASK]])
+; CHECK: %index.next = add i64 %index, 16
+; CHECK: icmp eq i64 %index.next, 32
+; CHECK: middle.block:
+; CHECK-NEXT: br i1 true, label %for.end, label %scalar.ph
+
+; NOFOLD-LABEL: @add20(
+; NOFOLD-NOT: llvm.masked.load
+; NOFOLD: middle.block:
+; NOFOLD: br i1 %cmp.n, label %for.end, label %scalar.ph
+
+define void @add20(i32* noalias %a, i32* noalias %b, i32* noalias %c) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %i
+  %b.val = load i32, i32* %b.gep, align 4
+  %c.gep = getelementptr inbounds i32, i32* %c, i64 %i
+  %c.val = load i32, i32* %c.gep, align 4
+  %sum = add nsw i32 %b.val, %c.val
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 %sum, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 20
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; A loop that is optimized for size is vectorized if its tail can be folded.
+
+; CHECK-LABEL: @add20_optsize(
+; CHECK: call <16 x i32> @llvm.masked.load.v16i32.p0v16i32
+; CHECK: call void @llvm.masked.store.v16i32.p0v16i32
+
+; NOFOLD-LABEL: @add20_optsize(
+; NOFOLD-NOT: <16 x i32>
+; NOFOLD: ret void
+
+define void @add20_optsize(i32* noalias %a, i32* noalias %b, i32* noalias %c) optsize {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %i
+  %b.val = load i32, i32* %b.gep, align 4
+  %c.gep = getelementptr inbounds i32, i32* %c, i64 %i
+  %c.val = load i32, i32* %c.gep, align 4
+  %sum = add nsw i32 %b.val, %c.val
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %i
+  store i32 %sum, i32* %a.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 20
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; The tail of a reduction is not folded.
+
+; CHECK-LABEL: @sum20(
+; CHECK-NOT: llvm.masked.load
+; CHECK: ret i32
+
+define i32 @sum20(i32* noalias %a) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %for.body ]
+  %gep = getelementptr inbounds i32, i32* %a, i64 %i
+  %val = load i32, i32* %gep, align 4
+  %s.next = add i32 %s, %val
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 20
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret i32 %s.next
+}
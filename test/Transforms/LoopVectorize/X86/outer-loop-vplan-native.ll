@@ -0,0 +1,321 @@
+; RUN: opt < %s -loop-vectorize -enable-vplan-native-path -mattr=+avx512f -pass-remarks=loop-vectorize -pass-remarks-analysis=loop-vectorize -S 2>%t | FileCheck %s
+; RUN: FileCheck %s --check-prefix=REMARK < %t
+; RUN: opt < %s -loop-vectorize -mattr=+avx512f -S | FileCheck %s --check-prefix=DISABLED
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; REMARK: remark: <unknown>:0:0: vectorized outer loop (vectorization width: 4)
+; REMARK: remark: <unknown>:0:0: vectorized outer loop (vectorization width: 4)
+; REMARK: remark: <unknown>:0:0: loop not vectorized: memory accesses of different outer loop iterations may depend on each other
+; REMARK: remark: <unknown>:0:0: loop not vectorized: memory accesses of different outer loop iterations may depend on each other
+; REMARK: remark: <unknown>:0:0: vectorized outer loop (vectorization width: 4)
+; REMARK: remark: <unknown>:0:0: vectorized outer loop (vectorization width: 4)
+
+; The inner loop runs 128 times in every lane: it is copied into the vector
+; loop and branches on lane 0 of its exit condition. The load of a[j][i] is
+; consecutive across the lanes and the load of b[j] is the same in all lanes.
+
+; CHECK-LABEL: @uniform_inner(
+; CHECK: vector.body:
+; CHECK: %vec.ind = phi <4 x i64>
+; CHECK: br label %[[INNER:inner[0-9]+]]
+; CHECK: [[INNER]]:
+; CHECK: %vec.phi = phi <4 x i64> [ zeroinitializer, %vector.body ], [ %{{.*}}, %[[INNER]] ]
+; CHECK: load <4 x i32>, <4 x i32>*
+; CHECK: %uniform.load = load i32, i32*
+; CHECK: shufflevector <4 x i32> %broadcast.splatinsert{{[0-9]*}}
+; CHECK: [[COND:%.*]] = icmp eq <4 x i64> %{{.*}}, <i64 128, i64 128, i64 128, i64 128>
+; CHECK: [[LANE0:%.*]] = extractelement <4 x i1> [[COND]], i32 0
+; CHECK: br i1 [[LANE0]], label %[[LATCH:outer.latch[0-9]+]], label %[[INNER]]
+; CHECK: [[LATCH]]:
+; CHECK: store <4 x i32>
+; CHECK: %index.next = add i64 %index, 4
+
+; DISABLED-LABEL: @uniform_inner(
+; DISABLED-NOT: uniform.load
+; DISABLED: ret void
+
+define void @uniform_inner(i32* noalias %a, i32* noalias %b, i32* noalias %out) {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer.header ], [ %j.next, %inner ]
+  %s = phi i32 [ 0, %outer.header ], [ %s.next, %inner ]
+  %row = mul nsw i64 %j, 1024
+  %idx = add nsw i64 %row, %i
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %idx
+  %a.val = load i32, i32* %a.gep, align 4
+  %b.gep = getelementptr inbounds i32, i32* %b, i64 %j
+  %b.val = load i32, i32* %b.gep, align 4
+  %mul = mul nsw i32 %a.val, %b.val
+  %s.next = add nsw i32 %s, %mul
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp eq i64 %j.next, 128
+  br i1 %inner.cond, label %outer.latch, label %inner
+
+outer.latch:
+  %s.lcssa = phi i32 [ %s.next, %inner ]
+  %out.gep = getelementptr inbounds i32, i32* %out, i64 %i
+  store i32 %s.lcssa, i32* %out.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp eq i64 %i.next, 1024
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !0
+
+exit:
+  ret void
+}
+
+; The trip count of the inner loop is loaded for every i, so it differs across
+; the lanes. The inner loop iterates while any lane is active, its memory
+; accesses are masked, and the sum of each lane is kept from the iteration in
+; which the lane exits.
+
+; CHECK-LABEL: @divergent_inner(
+; CHECK: vector.body:
+; CHECK: load <4 x i32>, <4 x i32>*
+; CHECK: br label %[[INNER:inner[0-9]+]]
+; CHECK: [[INNER]]:
+; CHECK-NEXT: %inner.active = phi <4 x i1> [ <i1 true, i1 true, i1 true, i1 true>, %vector.body ], [ %inner.active.next, %[[INNER]] ]
+; CHECK: %live.out = phi <4 x i32> [ undef, %vector.body ], [ [[KEEP:%.*]], %[[INNER]] ]
+; CHECK: call <4 x i32> @llvm.masked.gather.v4i32.v4p0i32(<4 x i32*> %{{.*}}, i32 4, <4 x i1> %inner.active, <4 x i32> undef)
+; CHECK: [[CONT:%.*]] = icmp slt <4 x i32>
+; CHECK: %inner.active.next = and <4 x i1> %inner.active, [[CONT]]
+; CHECK: [[KEEP]] = select <4 x i1> %inner.active, <4 x i32> %{{.*}}, <4 x i32> %live.out
+; CHECK: [[BITS:%.*]] = bitcast <4 x i1> %inner.active.next to i4
+; CHECK: [[ANY:%.*]] = icmp ne i4 [[BITS]], 0
+; CHECK: br i1 [[ANY]], label %[[INNER]], label %[[LATCH:outer.latch[0-9]+]]
+; CHECK: [[LATCH]]:
+; CHECK: %vec.phi{{[0-9]*}} = phi <4 x i32> [ [[KEEP]], %[[INNER]] ]
+; CHECK: store <4 x i32>
+
+; DISABLED-LABEL: @divergent_inner(
+; DISABLED-NOT: inner.active
+; DISABLED: ret void
+
+define void @divergent_inner(i32* noalias %a, i32* noalias %n, i32* noalias %out) {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %n.gep = getelementptr inbounds i32, i32* %n, i64 %i
+  %n.val = load i32, i32* %n.gep, align 4
+  %row = mul nsw i64 %i, 64
+  br label %inner
+
+inner:
+  %j = phi i32 [ 0, %outer.header ], [ %j.next, %inner ]
+  %s = phi i32 [ 0, %outer.header ], [ %s.next, %inner ]
+  %j.ext = zext i32 %j to i64
+  %idx = add nsw i64 %row, %j.ext
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %idx
+  %a.val = load i32, i32* %a.gep, align 4
+  %s.next = add nsw i32 %s, %a.val
+  %j.next = add nuw nsw i32 %j, 1
+  %inner.cond = icmp slt i32 %j.next, %n.val
+  br i1 %inner.cond, label %inner, label %outer.latch
+
+outer.latch:
+  %s.lcssa = phi i32 [ %s.next, %inner ]
+  %out.gep = getelementptr inbounds i32, i32* %out, i64 %i
+  store i32 %s.lcssa, i32* %out.gep, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp eq i64 %i.next, 1024
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !0
+
+exit:
+  ret void
+}
+
+; A sum across the iterations of the outer loop is not supported.
+
+; CHECK-LABEL: @outer_reduction(
+; CHECK-NOT: <4 x
+; CHECK: ret i32
+
+define i32 @outer_reduction(i32* noalias %a) {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %t = phi i32 [ 0, %entry ], [ %t.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer.header ], [ %j.next, %inner ]
+  %s = phi i32 [ %t, %outer.header ], [ %s.next, %inner ]
+  %row = mul nsw i64 %j, 1024
+  %idx = add nsw i64 %row, %i
+  %a.gep = getelementptr inbounds i32, i32* %a, i64 %idx
+  %a.val = load i32, i32* %a.gep, align 4
+  %s.next = add nsw i32 %s, %a.val
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp eq i64 %j.next, 128
+  br i1 %inner.cond, label %outer.latch, label %inner
+
+outer.latch:
+  %t.next = phi i32 [ %s.next, %inner ]
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp eq i64 %i.next, 1024
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !0
+
+exit:
+  %t.lcssa = phi i32 [ %t.next, %outer.latch ]
+  ret i32 %t.lcssa
+}
+
+; a[i + 1][j] = a[i][j]: iteration i + 1 reads what iteration i stores, so the
+; outer loop must not be vectorized.
+
+; CHECK-LABEL: @outer_dependence(
+; CHECK-NOT: <4 x
+; CHECK: ret void
+
+define void @outer_dependence([64 x i32]* noalias %a) {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %i.next = add nuw nsw i64 %i, 1
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer.header ], [ %j.next, %inner ]
+  %src = getelementptr inbounds [64 x i32], [64 x i32]* %a, i64 %i, i64 %j
+  %val = load i32, i32* %src, align 4
+  %dst = getelementptr inbounds [64 x i32], [64 x i32]* %a, i64 %i.next, i64 %j
+  store i32 %val, i32* %dst, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp eq i64 %j.next, 64
+  br i1 %inner.cond, label %outer.latch, label %inner
+
+outer.latch:
+  %outer.cond = icmp eq i64 %i.next, 1023
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !0
+
+exit:
+  ret void
+}
+
+; A[i + j] = i: iterations i and i + 1 both write A[i + 1], and the last write
+; must be the one of iteration i + 1. Running the outer iterations in lanes
+; reorders the writes, so the outer loop must not be vectorized.
+
+; CHECK-LABEL: @overlapping_stores(
+; CHECK-NOT: <4 x
+; CHECK: ret void
+
+@A = global [1024 x i32] zeroinitializer
+
+define void @overlapping_stores() {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %i.trunc = trunc i64 %i to i32
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer.header ], [ %j.next, %inner ]
+  %idx = add nuw nsw i64 %i, %j
+  %gep = getelementptr inbounds [1024 x i32], [1024 x i32]* @A, i64 0, i64 %idx
+  store i32 %i.trunc, i32* %gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp eq i64 %j.next, 8
+  br i1 %inner.cond, label %outer.latch, label %inner
+
+outer.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp eq i64 %i.next, 512
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !0
+
+exit:
+  ret void
+}
+
+; a[i][j] = j: every iteration of the loop nest writes its own element, so the
+; stores of the different lanes never overlap. The lanes write different rows,
+; so the store becomes a scatter.
+
+; CHECK-LABEL: @distinct_stores(
+; CHECK: vector.body:
+; CHECK: call void @llvm.masked.scatter.v4i32.v4p0i32(<4 x i32>
+; CHECK: %index.next = add i64 %index, 4
+
+define void @distinct_stores([64 x i32]* noalias %a) {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer.header ], [ %j.next, %inner ]
+  %j.trunc = trunc i64 %j to i32
+  %gep = getelementptr inbounds [64 x i32], [64 x i32]* %a, i64 %i, i64 %j
+  store i32 %j.trunc, i32* %gep, align 4
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp eq i64 %j.next, 64
+  br i1 %inner.cond, label %outer.latch, label %inner
+
+outer.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp eq i64 %i.next, 1024
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !0
+
+exit:
+  ret void
+}
+
+; a[i][j] += 1 reads and writes the same object, which is only allowed because
+; the accesses are annotated as parallel across the outer loop.
+
+; CHECK-LABEL: @annotated_parallel(
+; CHECK: vector.body:
+; CHECK: load <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: %index.next = add i64 %index, 4
+
+define void @annotated_parallel(i32* noalias %a) {
+entry:
+  br label %outer.header
+
+outer.header:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i64 [ 0, %outer.header ], [ %j.next, %inner ]
+  %row = mul nsw i64 %j, 1024
+  %idx = add nsw i64 %row, %i
+  %gep = getelementptr inbounds i32, i32* %a, i64 %idx
+  %val = load i32, i32* %gep, align 4, !llvm.mem.parallel_loop_access !3
+  %inc = add nsw i32 %val, 1
+  store i32 %inc, i32* %gep, align 4, !llvm.mem.parallel_loop_access !3
+  %j.next = add nuw nsw i64 %j, 1
+  %inner.cond = icmp eq i64 %j.next, 128
+  br i1 %inner.cond, label %outer.latch, label %inner
+
+outer.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %outer.cond = icmp eq i64 %i.next, 1024
+  br i1 %outer.cond, label %exit, label %outer.header, !llvm.loop !3
+
+exit:
+  ret void
+}
+
+!0 = distinct !{!0, !1, !2}
+!1 = !{!"llvm.loop.vectorize.enable", i1 true}
+!2 = !{!"llvm.loop.vectorize.width", i32 4}
+!3 = distinct !{!3, !1, !2}
@@ -0,0 +1,104 @@
+; RUN: opt -S -mergefunc -mergefunc-parallel=false < %s | FileCheck %s
+; RUN: opt -S -mergefunc -mergefunc-parallel < %s | FileCheck %s
+
+; The functions are compared within their hash buckets, on several threads if
+; possible, but the result must not depend on it. @c1 and @c2 only become equal
+; once @f2 has been merged into @f1, so @c2 is merged in the second round.
+
+; CHECK-NOT: @f2
+; CHECK-NOT: @c2
+; CHECK-NOT: @g2
+; CHECK-NOT: @h2
+
+%pair = type { i32, i64 }
+%nested = type { i8, %pair }
+
+; CHECK-LABEL: define internal i32 @f1(
+define internal i32 @f1(i32 %x) {
+  %a = mul i32 %x, 3
+  %b = add i32 %a, 7
+  %c = xor i32 %b, %x
+  ret i32 %c
+}
+
+define internal i32 @f2(i32 %x) {
+  %a = mul i32 %x, 3
+  %b = add i32 %a, 7
+  %c = xor i32 %b, %x
+  ret i32 %c
+}
+
+; CHECK-LABEL: define internal i32 @c1(
+; CHECK: call i32 @f1(i32 %x)
+define internal i32 @c1(i32 %x) {
+  %a = call i32 @f1(i32 %x)
+  %b = add i32 %a, 1
+  %c = mul i32 %b, %a
+  ret i32 %c
+}
+
+define internal i32 @c2(i32 %x) {
+  %a = call i32 @f2(i32 %x)
+  %b = add i32 %a, 1
+  %c = mul i32 %b, %a
+  ret i32 %c
+}
+
+; CHECK-LABEL: define internal i64 @g1(
+define internal i64 @g1(i64 %x) {
+  %a = shl i64 %x, 2
+  %b = or i64 %a, 1
+  %c = udiv i64 %b, 3
+  ret i64 %c
+}
+
+define internal i64 @g2(i64 %x) {
+  %a = shl i64 %x, 2
+  %b = or i64 %a, 1
+  %c = udiv i64 %b, 3
+  ret i64 %c
+}
+
+; The GEP offsets are scaled by the sizes of struct types, which are computed
+; before the functions are compared on several threads.
+; CHECK-LABEL: define internal i64* @h1(
+define internal i64* @h1(%nested* %p) {
+  %a = getelementptr %nested, %nested* %p, i64 2, i32 1, i32 1
+  %b = getelementptr [4 x %pair], [4 x %pair]* null, i64 0, i64 3, i32 1
+  %c = ptrtoint i64* %b to i64
+  %d = getelementptr i64, i64* %a, i64 %c
+  ret i64* %d
+}
+
+define internal i64* @h2(%nested* %p) {
+  %a = getelementptr %nested, %nested* %p, i64 2, i32 1, i32 1
+  %b = getelementptr [4 x %pair], [4 x %pair]* null, i64 0, i64 3, i32 1
+  %c = ptrtoint i64* %b to i64
+  %d = getelementptr i64, i64* %a, i64 %c
+  ret i64* %d
+}
+
+; CHECK-LABEL: define i64 @main(
+; CHECK: call i32 @c1(i32 %x)
+; CHECK: call i32 @c1(i32 %x)
+; CHECK: call i64 @g1(i64 %y)
+; CHECK: call i64 @g1(i64 %y)
+; CHECK: call i64* @h1(%nested* %p)
+; CHECK: call i64* @h1(%nested* %p)
+define i64 @main(i32 %x, i64 %y, %nested* %p) {
+  %r1 = call i32 @c1(i32 %x)
+  %r2 = call i32 @c2(i32 %x)
+  %r3 = call i64 @g1(i64 %y)
+  %r4 = call i64 @g2(i64 %y)
+  %s = add i32 %r1, %r2
+  %z = zext i32 %s to i64
+  %t = add i64 %z, %r3
+  %u = add i64 %t, %r4
+  %h1 = call i64* @h1(%nested* %p)
+  %h2 = call i64* @h2(%nested* %p)
+  %v1 = load i64, i64* %h1
+  %v2 = load i64, i64* %h2
+  %w = add i64 %u, %v1
+  %res = add i64 %w, %v2
+  ret i64 %res
+}
@@ -0,0 +1,125 @@
+; RUN: opt -S -wholeprogramdevirt -wholeprogramdevirt-speculative -pass-remarks=wholeprogramdevirt %s 2>&1 | FileCheck %s
+; RUN: opt -S -wholeprogramdevirt %s | FileCheck %s --check-prefix=NOSPEC
+
+target datalayout = "e-p:64:64"
+target triple = "x86_64-unknown-linux-gnu"
+
+; CHECK: remark: <unknown>:0:0: speculative: devirtualized a call to vf2a
+; CHECK: remark: <unknown>:0:0: speculative: devirtualized a call to vf1
+; CHECK-NOT: remark: <unknown>:0:0: speculative
+; CHECK: remark: <unknown>:0:0: devirtualized vf1
+; CHECK: remark: <unknown>:0:0: devirtualized vf2a
+; CHECK-NOT: devirtualized
+
+@vt1a = constant [1 x i8*] [i8* bitcast (void (i8*)* @vf1 to i8*)], !type !0
+@vt1b = constant [1 x i8*] [i8* bitcast (void (i8*)* @vf1 to i8*)], !type !0
+@vt2a = constant [1 x i8*] [i8* bitcast (void (i8*)* @vf2a to i8*)], !type !1
+@vt2b = constant [1 x i8*] [i8* bitcast (void (i8*)* @vf2b to i8*)], !type !1
+
+define void @vf1(i8* %this) {
+  ret void
+}
+
+define void @vf2a(i8* %this) {
+  ret void
+}
+
+define void @vf2b(i8* %this) {
+  ret void
+}
+
+; The type metadata names a single implementation. Without whole program
+; visibility the call may still reach a target defined elsewhere.
+
+; CHECK-LABEL: define void @single_impl(
+; CHECK: [[CMP:%.*]] = icmp eq void (i8*)* %fptr_casted, @vf1
+; CHECK-NEXT: br i1 [[CMP]], label %if.true.direct_targ, label %if.false.orig_indirect
+; CHECK: if.true.direct_targ:
+; CHECK-NEXT: call void @vf1(i8* %obj)
+; CHECK: if.false.orig_indirect:
+; CHECK-NEXT: call void %fptr_casted(i8* %obj)
+
+; NOSPEC-LABEL: define void @single_impl(
+; NOSPEC-NOT: icmp
+; NOSPEC: call void @vf1(i8* %obj)
+define void @single_impl(i8* %obj) {
+  %vtableptr = bitcast i8* %obj to [1 x i8*]**
+  %vtable = load [1 x i8*]*, [1 x i8*]** %vtableptr
+  %vtablei8 = bitcast [1 x i8*]* %vtable to i8*
+  %p = call i1 @llvm.type.test(i8* %vtablei8, metadata !"typeid1")
+  call void @llvm.assume(i1 %p)
+  %fptrptr = getelementptr [1 x i8*], [1 x i8*]* %vtable, i32 0, i32 0
+  %fptr = load i8*, i8** %fptrptr
+  %fptr_casted = bitcast i8* %fptr to void (i8*)*
+  call void %fptr_casted(i8* %obj)
+  ret void
+}
+
+; The value profile says that @vf2a is the most likely target.
+
+; CHECK-LABEL: define void @profiled(
+; CHECK: [[CMP:%.*]] = icmp eq void (i8*)* %fptr_casted, @vf2a
+; CHECK-NEXT: br i1 [[CMP]], label %if.true.direct_targ, label %if.false.orig_indirect, !prof [[WEIGHTS:![0-9]+]]
+; CHECK: if.true.direct_targ:
+; CHECK-NEXT: call void @vf2a(i8* %obj){{$}}
+; CHECK: if.false.orig_indirect:
+; CHECK-NEXT: call void %fptr_casted(i8* %obj), !prof [[VP:![0-9]+]]
+define void @profiled(i8* %obj) {
+  %vtableptr = bitcast i8* %obj to [1 x i8*]**
+  %vtable = load [1 x i8*]*, [1 x i8*]** %vtableptr
+  %vtablei8 = bitcast [1 x i8*]* %vtable to i8*
+  %p = call i1 @llvm.type.test(i8* %vtablei8, metadata !"typeid2")
+  call void @llvm.assume(i1 %p)
+  %fptrptr = getelementptr [1 x i8*], [1 x i8*]* %vtable, i32 0, i32 0
+  %fptr = load i8*, i8** %fptrptr
+  %fptr_casted = bitcast i8* %fptr to void (i8*)*
+  call void %fptr_casted(i8* %obj), !prof !2
+  ret void
+}
+
+; No target accounts for enough of the profiled calls.
+
+; CHECK-LABEL: define void @cold(
+; CHECK-NOT: icmp
+; CHECK: call void %fptr_casted(i8* %obj), !prof !{{[0-9]+}}
+define void @cold(i8* %obj) {
+  %vtableptr = bitcast i8* %obj to [1 x i8*]**
+  %vtable = load [1 x i8*]*, [1 x i8*]** %vtableptr
+  %vtablei8 = bitcast [1 x i8*]* %vtable to i8*
+  %p = call i1 @llvm.type.test(i8* %vtablei8, metadata !"typeid2")
+  call void @llvm.assume(i1 %p)
+  %fptrptr = getelementptr [1 x i8*], [1 x i8*]* %vtable, i32 0, i32 0
+  %fptr = load i8*, i8** %fptrptr
+  %fptr_casted = bitcast i8* %fptr to void (i8*)*
+  call void %fptr_casted(i8* %obj), !prof !3
+  ret void
+}
+
+; Without a profile there is no way to choose between @vf2a and @vf2b.
+
+; CHECK-LABEL: define void @unprofiled(
+; CHECK-NOT: icmp
+; CHECK: call void %fptr_casted(i8* %obj)
+define void @unprofiled(i8* %obj) {
+  %vtableptr = bitcast i8* %obj to [1 x i8*]**
+  %vtable = load [1 x i8*]*, [1 x i8*]** %vtableptr
+  %vtablei8 = bitcast [1 x i8*]* %vtable to i8*
+  %p = call i1 @llvm.type.test(i8* %vtablei8, metadata !"typeid2")
+  call void @llvm.assume(i1 %p)
+  %fptrptr = getelementptr [1 x i8*], [1 x i8*]* %vtable, i32 0, i32 0
+  %fptr = load i8*, i8** %fptrptr
+  %fptr_casted = bitcast i8* %fptr to void (i8*)*
+  call void %fptr_casted(i8* %obj)
+  ret void
+}
+
+declare i1 @llvm.type.test(i8*, metadata)
+declare void @llvm.assume(i1)
+
+; CHECK: [[WEIGHTS]] = !{!"branch_weights", i32 90, i32 10}
+; CHECK: [[VP]] = !{!"VP", i32 0, i64 10, i64 1239882198163242525, i64 10}
+
+!0 = !{i32 0, !"typeid1"}
+!1 = !{i32 0, !"typeid2"}
+!2 = !{!"VP", i32 0, i64 100, i64 6715865490944628386, i64 90, i64 1239882198163242525, i64 10}
+!3 = !{!"VP", i32 0, i64 100, i64 6715865490944628386, i64 40, i64 1239882198163242525, i64 30, i64 -2545542355363006406, i64 30}
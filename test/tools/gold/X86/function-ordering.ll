@@ -0,0 +1,76 @@
+; RUN: llvm-as %s -o %t.o
+; RUN: %gold -m elf_x86_64 -plugin %llvmshlibdir/LLVMgold%shlibext \
+; RUN:    --plugin-opt=function-ordering-file=%t.order \
+; RUN:    -shared %t.o -o %t.so
+; RUN: FileCheck %s --check-prefix=ORDER < %t.order
+
+; gold orders input sections, so the plugin writes the sections of the hot
+; functions, which can be passed back to gold as --section-ordering-file.
+; RUN: %gold -m elf_x86_64 -plugin %llvmshlibdir/LLVMgold%shlibext \
+; RUN:    --plugin-opt=function-ordering \
+; RUN:    --section-ordering-file=%t.order -shared %t.o -o %t2.so
+; RUN: llvm-nm -n %t2.so | FileCheck %s
+
+; ORDER: .text.hot.main
+; ORDER-NEXT: .text.hot.mid
+; ORDER-NEXT: .text.hot.leaf
+; ORDER-NOT: {{.}}
+
+; CHECK: T main
+; CHECK-NEXT: T mid
+; CHECK-NEXT: T leaf
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @rare() noinline !prof !16 {
+  call i1 @check()
+  ret void
+}
+
+define void @leaf() noinline !prof !17 {
+  call i1 @check()
+  ret void
+}
+
+define void @main() noinline !prof !15 {
+entry:
+  call void @mid()
+  %c = call i1 @check()
+  br i1 %c, label %if.rare, label %exit, !prof !18
+
+if.rare:
+  call void @rare()
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @mid() noinline !prof !19 {
+  call void @leaf()
+  ret void
+}
+
+declare i1 @check()
+
+!llvm.module.flags = !{!1}
+!1 = !{i32 1, !"ProfileSummary", !2}
+!2 = !{!3, !4, !5, !6, !7, !8, !9, !10}
+!3 = !{!"ProfileFormat", !"InstrProf"}
+!4 = !{!"TotalCount", i64 10000}
+!5 = !{!"MaxCount", i64 1000}
+!6 = !{!"MaxInternalCount", i64 1}
+!7 = !{!"MaxFunctionCount", i64 1000}
+!8 = !{!"NumCounts", i64 3}
+!9 = !{!"NumFunctions", i64 3}
+!10 = !{!"DetailedSummary", !11}
+!11 = !{!12, !13, !14}
+!12 = !{i32 10000, i64 100, i32 1}
+!13 = !{i32 999000, i64 100, i32 1}
+!14 = !{i32 999999, i64 1, i32 2}
+!15 = !{!"function_entry_count", i64 1000}
+!16 = !{!"function_entry_count", i64 1}
+!17 = !{!"function_entry_count", i64 950}
+!18 = !{!"branch_weights", i32 1, i32 999}
+!19 = !{!"function_entry_count", i64 900}
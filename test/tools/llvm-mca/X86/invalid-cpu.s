@@ -0,0 +1,10 @@
+# RUN: not llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=generic < %s 2>&1 | FileCheck %s
+# RUN: not llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=foo < %s 2>&1 | FileCheck %s --check-prefix=UNKNOWN
+
+# The generic x86 model has no per-instruction scheduling information.
+
+addl %eax, %eax
+
+# CHECK: error: unable to find instruction-level scheduling information for target triple 'x86_64-unknown-unknown' and cpu 'generic'.
+
+# UNKNOWN: error: invalid CPU 'foo' for target triple 'x86_64-unknown-unknown'.
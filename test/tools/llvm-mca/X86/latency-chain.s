@@ -0,0 +1,18 @@
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=100 < %s | FileCheck %s
+
+# A chain of dependent multiplies is bound by the multiply latency, not by
+# the number of ports that can execute it.
+
+imull %eax, %eax
+
+# CHECK:      Iterations:        100
+# CHECK-NEXT: Instructions:      100
+# CHECK-NEXT: Total Cycles:      30{{[0-9]}}
+# CHECK:      Dispatch Width:    2
+# CHECK-NEXT: Reorder Buffer:    64
+# CHECK:      Block RThroughput: 1.0
+
+# CHECK:      [1]    [2]    [3]    [4]    [5]    [6]    [7]    Instructions:
+# CHECK-NEXT:  1      3      1.00 {{.*}} imull %eax, %eax
+
+# CHECK:      Bottleneck: register dependencies
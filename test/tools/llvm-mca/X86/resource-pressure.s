@@ -0,0 +1,19 @@
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=100 < %s | FileCheck %s
+
+# Independent multiplies all compete for the single integer multiply pipe.
+
+# Processor resource names are only available in builds with assertions or
+# LLVM_ENABLE_DUMP.
+# REQUIRES: asserts
+
+imull %eax, %eax
+imull %ebx, %ebx
+imull %ecx, %ecx
+imull %edx, %edx
+
+# CHECK:      Iterations:        100
+# CHECK-NEXT: Instructions:      400
+# CHECK:      Block RThroughput: 4.0
+# CHECK:      Resource pressure per iteration:
+# CHECK:        JALU1 4.00
+# CHECK:      Bottleneck: resource pressure on JALU1
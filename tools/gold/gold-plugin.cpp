@@ -185,6 +185,11 @@ namespace options {
   static std::string sample_profile;
   // New pass manager
   static bool new_pass_manager = false;
+  // Order hot functions by the profiled call graph, and where to write the
+  // resulting order. gold orders input sections, so the file lists the
+  // sections of the functions, for --section-ordering-file.
+  static bool function_ordering = false;
+  static std::string function_ordering_file;
 
   static void process_plugin_option(const char *opt_)
   {
@@ -246,6 +251,10 @@ namespace options {
       sample_profile= opt.substr(strlen("sample-profile="));
     } else if (opt == "new-pass-manager") {
       new_pass_manager = true;
+    } else if (opt == "function-ordering") {
+      function_ordering = true;
+    } else if (opt.startswith("function-ordering-file=")) {
+      function_ordering_file = opt.substr(strlen("function-ordering-file="));
     } else {
       // Save this option to pass to the code generator.
       // ParseCommandLineOptions() expects argv[0] to be program name. Lazily
@@ -816,6 +825,10 @@ static std::unique_ptr<LTO> createLTO() {
   // Use new pass manager if set in driver
   Conf.UseNewPM = options::new_pass_manager;
 
+  Conf.FunctionOrdering = options::function_ordering;
+  Conf.FunctionOrderingFile = options::function_ordering_file;
+  Conf.FunctionOrderingFileSections = true;
+
   return llvm::make_unique<LTO>(std::move(Conf), Backend,
                                 options::ParallelCodeGenParallelismLevel);
 }
@@ -0,0 +1,299 @@
+//===- BenchmarkRunner.cpp - Run snippets on the host ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BenchmarkRunner.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/MC/MCCodeEmitter.h"
+#include "llvm/MC/MCFixup.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Support/Memory.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__linux__) && defined(__x86_64__)
+#define LLVM_EXEGESIS_CAN_EXECUTE 1
+#include <linux/perf_event.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#else
+#define LLVM_EXEGESIS_CAN_EXECUTE 0
+#endif
+
+using namespace llvm;
+using namespace exegesis;
+
+static Error makeError(const Twine &Msg) {
+  return make_error<StringError>(Msg, inconvertibleErrorCode());
+}
+
+// The prologue and epilogue are built from opcodes and registers looked up by
+// name. Report a missing one as an error rather than asserting.
+static Expected<unsigned> findOpcode(const MCInstrInfo &MCII, StringRef Name) {
+  for (unsigned I = 0, E = MCII.getNumOpcodes(); I != E; ++I)
+    if (MCII.getName(I) == Name)
+      return I;
+  return makeError("target has no opcode named '" + Name + "'");
+}
+
+static Expected<unsigned> findRegister(const MCRegisterInfo &MRI,
+                                       StringRef Name) {
+  for (unsigned I = 1, E = MRI.getNumRegs(); I != E; ++I)
+    if (Name == MRI.getName(I))
+      return I;
+  return makeError("target has no register named '" + Name + "'");
+}
+
+// Callee-saved registers of the SysV x86-64 ABI that snippets may clobber.
+static const char *const SavedRegisters[] = {"RBX", "RBP", "R12",
+                                             "R13", "R14", "R15"};
+
+bool exegesis::canExecuteOnHost() { return LLVM_EXEGESIS_CAN_EXECUTE; }
+
+BenchmarkRunner::BenchmarkRunner(const MCInstrInfo &MCII,
+                                 const MCRegisterInfo &MRI,
+                                 const MCSubtargetInfo &STI,
+                                 MCCodeEmitter &Emitter,
+                                 unsigned MinInstructions, unsigned NumCalls)
+    : MCII(MCII), MRI(MRI), STI(STI), Emitter(Emitter),
+      MinInstructions(std::max(1u, MinInstructions)),
+      NumCalls(std::max(1u, NumCalls)) {}
+
+Error BenchmarkRunner::encode(const MCInst &Inst,
+                              SmallVectorImpl<char> &Code) const {
+  SmallVector<MCFixup, 4> Fixups;
+  raw_svector_ostream OS(Code);
+  Emitter.encodeInstruction(Inst, OS, Fixups, STI);
+  if (!Fixups.empty())
+    return makeError("instruction needs a relocation");
+  return Error::success();
+}
+
+Expected<SmallString<0>>
+BenchmarkRunner::assemble(ArrayRef<MCInst> Body,
+                          unsigned &NumInstructions) const {
+  SmallString<0> Code;
+  Expected<unsigned> Push = findOpcode(MCII, "PUSH64r");
+  if (!Push)
+    return Push.takeError();
+  Expected<unsigned> Pop = findOpcode(MCII, "POP64r");
+  if (!Pop)
+    return Pop.takeError();
+  Expected<unsigned> Ret = findOpcode(MCII, "RETQ");
+  if (!Ret)
+    return Ret.takeError();
+
+  SmallVector<unsigned, array_lengthof(SavedRegisters)> Saved;
+  for (const char *Name : SavedRegisters) {
+    Expected<unsigned> Reg = findRegister(MRI, Name);
+    if (!Reg)
+      return Reg.takeError();
+    Saved.push_back(*Reg);
+  }
+
+  for (unsigned Reg : Saved) {
+    MCInst Inst;
+    Inst.setOpcode(*Push);
+    Inst.addOperand(MCOperand::createReg(Reg));
+    if (Error E = encode(Inst, Code))
+      return std::move(E);
+  }
+
+  NumInstructions = 0;
+  while (!Body.empty() && NumInstructions < MinInstructions) {
+    for (const MCInst &Inst : Body)
+      if (Error E = encode(Inst, Code))
+        return std::move(E);
+    NumInstructions += Body.size();
+  }
+
+  for (unsigned Reg : llvm::reverse(Saved)) {
+    MCInst Inst;
+    Inst.setOpcode(*Pop);
+    Inst.addOperand(MCOperand::createReg(Reg));
+    if (Error E = encode(Inst, Code))
+      return std::move(E);
+  }
+
+  MCInst RetInst;
+  RetInst.setOpcode(*Ret);
+  if (Error E = encode(RetInst, Code))
+    return std::move(E);
+  return std::move(Code);
+}
+
+#if LLVM_EXEGESIS_CAN_EXECUTE
+static int openCycleCounter() {
+  perf_event_attr Attr;
+  memset(&Attr, 0, sizeof(Attr));
+  Attr.type = PERF_TYPE_HARDWARE;
+  Attr.size = sizeof(Attr);
+  Attr.config = PERF_COUNT_HW_CPU_CYCLES;
+  Attr.disabled = 1;
+  Attr.exclude_kernel = 1;
+  Attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &Attr, 0, -1, -1, 0);
+}
+
+// Runs in the child: returns the smallest counter value over a few runs.
+static double measureInProcess(StringRef Code, unsigned NumCalls,
+                               bool UsePerfCounters) {
+  std::error_code EC;
+  sys::MemoryBlock MB = sys::Memory::allocateMappedMemory(
+      Code.size(), nullptr, sys::Memory::MF_READ | sys::Memory::MF_WRITE, EC);
+  if (EC)
+    return -1.0;
+  memcpy(MB.base(), Code.data(), Code.size());
+  if (sys::Memory::protectMappedMemory(
+          MB, sys::Memory::MF_READ | sys::Memory::MF_EXEC))
+    return -1.0;
+  sys::Memory::InvalidateInstructionCache(MB.base(), Code.size());
+  auto Fn = reinterpret_cast<void (*)()>(MB.base());
+
+  int Fd = UsePerfCounters ? openCycleCounter() : -1;
+  if (UsePerfCounters && Fd < 0)
+    return -1.0;
+
+  // Warm up the caches and the branch predictors.
+  Fn();
+
+  double Best = -1.0;
+  for (unsigned Run = 0; Run != 5; ++Run) {
+    double Value;
+    if (Fd >= 0) {
+      ioctl(Fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(Fd, PERF_EVENT_IOC_ENABLE, 0);
+      for (unsigned I = 0; I != NumCalls; ++I)
+        Fn();
+      ioctl(Fd, PERF_EVENT_IOC_DISABLE, 0);
+      uint64_t Count = 0;
+      if (read(Fd, &Count, sizeof(Count)) != sizeof(Count))
+        return -1.0;
+      Value = Count;
+    } else {
+      auto Start = std::chrono::steady_clock::now();
+      for (unsigned I = 0; I != NumCalls; ++I)
+        Fn();
+      auto End = std::chrono::steady_clock::now();
+      Value = std::chrono::duration<double, std::nano>(End - Start).count();
+    }
+    if (Best < 0 || Value < Best)
+      Best = Value;
+  }
+  if (Fd >= 0)
+    close(Fd);
+  return Best;
+}
+#endif
+
+Expected<double> BenchmarkRunner::runInChild(StringRef Code) const {
+#if LLVM_EXEGESIS_CAN_EXECUTE
+  int Pipe[2];
+  if (pipe(Pipe))
+    return makeError("cannot create a pipe");
+
+  pid_t Child = fork();
+  if (Child < 0) {
+    close(Pipe[0]);
+    close(Pipe[1]);
+    return makeError("cannot fork");
+  }
+  if (Child == 0) {
+    close(Pipe[0]);
+    double Value = measureInProcess(Code, NumCalls, UsePerfCounters);
+    ssize_t Written = write(Pipe[1], &Value, sizeof(Value));
+    _exit(Written == sizeof(Value) ? 0 : 1);
+  }
+
+  close(Pipe[1]);
+  double Value = -1.0;
+  ssize_t Read = read(Pipe[0], &Value, sizeof(Value));
+  close(Pipe[0]);
+  int Status = 0;
+  waitpid(Child, &Status, 0);
+  if (WIFSIGNALED(Status))
+    return makeError("crashed with signal " + Twine(WTERMSIG(Status)) +
+                     (WTERMSIG(Status) == SIGILL
+                          ? " (not supported by the host)"
+                          : ""));
+  if (Read != sizeof(Value) || Value < 0)
+    return makeError("measurement failed");
+  return Value;
+#else
+  return makeError("running snippets is only supported on x86-64 Linux");
+#endif
+}
+
+Error BenchmarkRunner::initialize() {
+  if (!canExecuteOnHost())
+    return makeError("running snippets is only supported on x86-64 Linux");
+
+#if LLVM_EXEGESIS_CAN_EXECUTE
+  int Fd = openCycleCounter();
+  UsePerfCounters = Fd >= 0;
+  if (Fd >= 0)
+    close(Fd);
+#endif
+
+  unsigned NumInstructions;
+  Expected<SmallString<0>> Empty = assemble(None, NumInstructions);
+  if (!Empty)
+    return Empty.takeError();
+  Expected<double> Baseline = runInChild(*Empty);
+  if (!Baseline)
+    return Baseline.takeError();
+  BaselineCycles = *Baseline;
+  if (UsePerfCounters)
+    return Error::success();
+
+  // Without a cycle counter, calibrate the clock with a chain of adds. Their
+  // latency is one cycle on every x86-64 implementation.
+  Expected<unsigned> AddOpcode = findOpcode(MCII, "ADD64ri8");
+  if (!AddOpcode)
+    return AddOpcode.takeError();
+  Expected<unsigned> RAX = findRegister(MRI, "RAX");
+  if (!RAX)
+    return RAX.takeError();
+  MCInst Add;
+  Add.setOpcode(*AddOpcode);
+  Add.addOperand(MCOperand::createReg(*RAX));
+  Add.addOperand(MCOperand::createReg(*RAX));
+  Add.addOperand(MCOperand::createImm(1));
+  Expected<SmallString<0>> Chain = assemble(Add, NumInstructions);
+  if (!Chain)
+    return Chain.takeError();
+  Expected<double> Nanoseconds = runInChild(*Chain);
+  if (!Nanoseconds)
+    return Nanoseconds.takeError();
+  NanosecondsPerCycle =
+      (*Nanoseconds - BaselineCycles) / ((double)NumCalls * NumInstructions);
+  if (NanosecondsPerCycle <= 0)
+    return makeError("clock calibration failed");
+  BaselineCycles /= NanosecondsPerCycle;
+  return Error::success();
+}
+
+Expected<double> BenchmarkRunner::measure(const Snippet &S) const {
+  unsigned NumInstructions;
+  Expected<SmallString<0>> Code = assemble(S.Instructions, NumInstructions);
+  if (!Code)
+    return Code.takeError();
+  Expected<double> Value = runInChild(*Code);
+  if (!Value)
+    return Value.takeError();
+  double Cycles = UsePerfCounters ? *Value : *Value / NanosecondsPerCycle;
+  Cycles = std::max(0.0, Cycles - BaselineCycles);
+  return Cycles / ((double)NumCalls * NumInstructions);
+}
@@ -0,0 +1,83 @@
+//===- BenchmarkRunner.h - Run snippets on the host -------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Assembles snippets into executable functions and measures how many cycles
+// they take on the host. Cycles are read from the hardware cycle counter
+// through perf_event_open when it is available. Otherwise wall-clock time is
+// converted to cycles with a calibration loop made of one-cycle-latency adds.
+//
+// Every measurement runs in a forked child, so that an opcode the host does
+// not implement only costs that one measurement.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_EXEGESIS_BENCHMARKRUNNER_H
+#define LLVM_TOOLS_LLVM_EXEGESIS_BENCHMARKRUNNER_H
+
+#include "SnippetGenerator.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Error.h"
+
+namespace llvm {
+
+class MCCodeEmitter;
+class MCInstrInfo;
+class MCRegisterInfo;
+class MCSubtargetInfo;
+
+namespace exegesis {
+
+/// Returns true if snippets can be executed on this host.
+bool canExecuteOnHost();
+
+class BenchmarkRunner {
+  const MCInstrInfo &MCII;
+  const MCRegisterInfo &MRI;
+  const MCSubtargetInfo &STI;
+  MCCodeEmitter &Emitter;
+
+  /// Number of instructions in the measured function, and number of calls
+  /// to it per measurement.
+  unsigned MinInstructions;
+  unsigned NumCalls;
+
+  /// Cycles taken by a function with no instructions besides the prologue
+  /// and epilogue, and the cost of a cycle when it has to be derived from
+  /// wall-clock time.
+  double BaselineCycles = 0.0;
+  double NanosecondsPerCycle = 0.0;
+  bool UsePerfCounters = false;
+
+  Error encode(const MCInst &Inst, SmallVectorImpl<char> &Code) const;
+  Expected<SmallString<0>> assemble(ArrayRef<MCInst> Body,
+                                    unsigned &NumInstructions) const;
+  /// Runs \p Code NumCalls times in a child process and returns the raw
+  /// counter value (cycles or nanoseconds) of the fastest of a few runs.
+  Expected<double> runInChild(StringRef Code) const;
+
+public:
+  BenchmarkRunner(const MCInstrInfo &MCII, const MCRegisterInfo &MRI,
+                  const MCSubtargetInfo &STI, MCCodeEmitter &Emitter,
+                  unsigned MinInstructions, unsigned NumCalls);
+
+  /// Measures the baseline and, if needed, the clock calibration. Must be
+  /// called before measure().
+  Error initialize();
+
+  /// Returns the number of cycles per instruction of the snippet.
+  Expected<double> measure(const Snippet &S) const;
+
+  bool usesPerfCounters() const { return UsePerfCounters; }
+};
+
+} // end namespace exegesis
+} // end namespace llvm
+
+#endif // LLVM_TOOLS_LLVM_EXEGESIS_BENCHMARKRUNNER_H
@@ -0,0 +1,161 @@
+//===- SnippetGenerator.cpp - Microbenchmark snippet generation -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SnippetGenerator.h"
+#include "llvm/MC/MCInstrDesc.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+
+using namespace llvm;
+using namespace exegesis;
+
+static void addAliases(const MCRegisterInfo &MRI, unsigned Reg,
+                       BitVector &Regs) {
+  for (MCRegAliasIterator AI(Reg, &MRI, true); AI.isValid(); ++AI)
+    Regs.set(*AI);
+}
+
+static bool overlaps(const MCRegisterInfo &MRI, unsigned RegA, unsigned RegB) {
+  for (MCRegAliasIterator AI(RegA, &MRI, true); AI.isValid(); ++AI)
+    if (*AI == RegB)
+      return true;
+  return false;
+}
+
+static Error makeError(const Twine &Msg) {
+  return make_error<StringError>(Msg, inconvertibleErrorCode());
+}
+
+SnippetGenerator::SnippetGenerator(const MCInstrInfo &MCII,
+                                   const MCRegisterInfo &MRI,
+                                   ArrayRef<unsigned> ReservedRegs,
+                                   ArrayRef<unsigned> ImplicitRegs,
+                                   unsigned MaxCopies)
+    : MCII(MCII), MRI(MRI), Reserved(MRI.getNumRegs()),
+      AllowedImplicit(MRI.getNumRegs()), MaxCopies(MaxCopies) {
+  for (unsigned Reg : ReservedRegs)
+    addAliases(MRI, Reg, Reserved);
+  for (unsigned Reg : ImplicitRegs)
+    addAliases(MRI, Reg, AllowedImplicit);
+}
+
+unsigned SnippetGenerator::pickRegister(int RegClassID, unsigned Preferred,
+                                        const BitVector &Forbidden) const {
+  const MCRegisterClass &RC = MRI.getRegClass(RegClassID);
+  unsigned Fallback = 0;
+  for (unsigned Reg : RC) {
+    if (Reserved.test(Reg) || Forbidden.test(Reg))
+      continue;
+    if (!Preferred || overlaps(MRI, Reg, Preferred))
+      return Reg;
+    if (!Fallback)
+      Fallback = Reg;
+  }
+  return Fallback;
+}
+
+bool SnippetGenerator::buildInstance(unsigned Opcode,
+                                     const BitVector &Forbidden,
+                                     MCInst &Inst) const {
+  const MCInstrDesc &Desc = MCII.get(Opcode);
+  Inst.clear();
+  Inst.setOpcode(Opcode);
+
+  unsigned FirstDef = 0;
+  for (unsigned I = 0, E = Desc.getNumOperands(); I != E; ++I) {
+    const MCOperandInfo &OpInfo = Desc.OpInfo[I];
+    int TiedTo = Desc.getOperandConstraint(I, MCOI::TIED_TO);
+    if (TiedTo >= 0) {
+      Inst.addOperand(Inst.getOperand(TiedTo));
+      continue;
+    }
+    if (OpInfo.RegClass < 0) {
+      Inst.addOperand(MCOperand::createImm(1));
+      continue;
+    }
+    unsigned Reg = pickRegister(OpInfo.RegClass, FirstDef, Forbidden);
+    if (!Reg)
+      return false;
+    if (I < Desc.getNumDefs() && !FirstDef)
+      FirstDef = Reg;
+    Inst.addOperand(MCOperand::createReg(Reg));
+  }
+  return true;
+}
+
+Expected<Snippet> SnippetGenerator::generate(unsigned Opcode,
+                                             BenchmarkMode Mode) const {
+  const MCInstrDesc &Desc = MCII.get(Opcode);
+  if (Desc.isPseudo())
+    return makeError("pseudo instruction");
+  if (Desc.mayLoad() || Desc.mayStore())
+    return makeError("memory access");
+  if (Desc.isBranch() || Desc.isCall() || Desc.isReturn() ||
+      Desc.isBarrier() || Desc.isTerminator())
+    return makeError("control flow");
+  if (Desc.hasUnmodeledSideEffects() || Desc.isVariadic())
+    return makeError("unmodeled side effects");
+
+  auto onlyAllowedImplicit = [&](const MCPhysReg *Regs, unsigned Num) {
+    for (unsigned I = 0; I != Num; ++I)
+      if (!AllowedImplicit.test(Regs[I]))
+        return false;
+    return true;
+  };
+  if (!onlyAllowedImplicit(Desc.getImplicitUses(), Desc.getNumImplicitUses()) ||
+      !onlyAllowedImplicit(Desc.getImplicitDefs(), Desc.getNumImplicitDefs()))
+    return makeError("implicit register operands");
+
+  for (unsigned I = 0, E = Desc.getNumOperands(); I != E; ++I) {
+    const MCOperandInfo &OpInfo = Desc.OpInfo[I];
+    if (OpInfo.OperandType == MCOI::OPERAND_MEMORY ||
+        OpInfo.OperandType == MCOI::OPERAND_PCREL)
+      return makeError("memory or pc-relative operand");
+    if (OpInfo.OperandType == MCOI::OPERAND_REGISTER && OpInfo.RegClass < 0)
+      return makeError("register operand without a register class");
+  }
+
+  Snippet S;
+  S.Opcode = Opcode;
+  S.Mode = Mode;
+
+  if (Mode == BenchmarkMode::Latency) {
+    if (!Desc.getNumDefs())
+      return makeError("no explicit result to chain on");
+    MCInst Inst;
+    if (!buildInstance(Opcode, BitVector(MRI.getNumRegs()), Inst))
+      return makeError("no usable registers");
+    unsigned Def = Inst.getOperand(0).getReg();
+    bool Chained = false;
+    for (unsigned I = Desc.getNumDefs(), E = Inst.getNumOperands(); I != E;
+         ++I)
+      if (Inst.getOperand(I).isReg() &&
+          overlaps(MRI, Inst.getOperand(I).getReg(), Def))
+        Chained = true;
+    if (!Chained)
+      return makeError("the result cannot feed any of the inputs");
+    S.Instructions.push_back(Inst);
+    return std::move(S);
+  }
+
+  // Throughput: independent copies, each using registers no other copy uses.
+  BitVector Used(MRI.getNumRegs());
+  for (unsigned Copy = 0; Copy != MaxCopies; ++Copy) {
+    MCInst Inst;
+    if (!buildInstance(Opcode, Used, Inst))
+      break;
+    for (const MCOperand &Op : Inst)
+      if (Op.isReg())
+        addAliases(MRI, Op.getReg(), Used);
+    S.Instructions.push_back(Inst);
+  }
+  if (S.Instructions.empty())
+    return makeError("no usable registers");
+  return std::move(S);
+}
@@ -0,0 +1,79 @@
+//===- SnippetGenerator.h - Microbenchmark snippet generation ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Generates the instruction sequences used to measure the latency and the
+// reciprocal throughput of a single opcode.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_EXEGESIS_SNIPPETGENERATOR_H
+#define LLVM_TOOLS_LLVM_EXEGESIS_SNIPPETGENERATOR_H
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/Support/Error.h"
+#include <vector>
+
+namespace llvm {
+
+class MCInstrInfo;
+class MCRegisterInfo;
+
+namespace exegesis {
+
+enum class BenchmarkMode { Latency, Throughput };
+
+/// A group of instructions that is repeated to form the measured code.
+///
+/// In latency mode this is a single instruction whose result feeds one of its
+/// own inputs, so repeating it creates a dependency chain. In throughput mode
+/// it is several copies of the instruction that use disjoint registers, so the
+/// copies can execute in parallel.
+struct Snippet {
+  unsigned Opcode;
+  BenchmarkMode Mode;
+  std::vector<MCInst> Instructions;
+};
+
+class SnippetGenerator {
+  const MCInstrInfo &MCII;
+  const MCRegisterInfo &MRI;
+  /// Registers (and their aliases) that snippets must not touch.
+  BitVector Reserved;
+  /// Registers that may be used implicitly by a benchmarked instruction.
+  BitVector AllowedImplicit;
+  unsigned MaxCopies;
+
+  /// Pick a register of class \p RegClassID that is not in \p Forbidden,
+  /// preferring one that overlaps \p Preferred. Returns 0 if there is none.
+  unsigned pickRegister(int RegClassID, unsigned Preferred,
+                        const BitVector &Forbidden) const;
+
+  /// Build one instance of \p Opcode avoiding the registers in \p Forbidden.
+  /// Uses overlap the first def whenever the register classes allow it.
+  /// Returns false if no registers are left.
+  bool buildInstance(unsigned Opcode, const BitVector &Forbidden,
+                     MCInst &Inst) const;
+
+public:
+  /// \p ReservedRegs are never used by snippets, e.g. the stack pointer.
+  /// \p ImplicitRegs may appear as implicit operands, e.g. the flags.
+  SnippetGenerator(const MCInstrInfo &MCII, const MCRegisterInfo &MRI,
+                   ArrayRef<unsigned> ReservedRegs,
+                   ArrayRef<unsigned> ImplicitRegs, unsigned MaxCopies = 8);
+
+  /// Returns an error describing why \p Opcode cannot be benchmarked in
+  /// \p Mode, if it cannot.
+  Expected<Snippet> generate(unsigned Opcode, BenchmarkMode Mode) const;
+};
+
+} // end namespace exegesis
+} // end namespace llvm
+
+#endif // LLVM_TOOLS_LLVM_EXEGESIS_SNIPPETGENERATOR_H
@@ -0,0 +1,338 @@
+//===- llvm-exegesis.cpp - Validate scheduling models on the host ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This utility generates latency and throughput microbenchmarks for
+// individual opcodes with the MC layer, runs them on the host and compares
+// the measurements with the scheduling model of the selected CPU.
+//
+// Example:
+//
+//   llvm-exegesis -mcpu=skylake -opcode-name=IMUL32rr,ADD32rr
+//
+//===----------------------------------------------------------------------===//
+
+#include "BenchmarkRunner.h"
+#include "SnippetGenerator.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCCodeEmitter.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInstPrinter.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSchedule.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace llvm;
+using namespace exegesis;
+
+static cl::opt<std::string> OutputFilename("o", cl::desc("Output filename"),
+                                           cl::init("-"),
+                                           cl::value_desc("filename"));
+
+static cl::opt<std::string>
+    TripleName("mtriple",
+               cl::desc("Target triple; defaults to the host triple"));
+
+static cl::opt<std::string>
+    MCPU("mcpu",
+         cl::desc("CPU whose scheduling model is validated "
+                  "(-mcpu=help for details)"),
+         cl::value_desc("cpu-name"), cl::init("native"));
+
+static cl::list<std::string>
+    OpcodeNames("opcode-name",
+                cl::desc("Opcodes to benchmark; all opcodes that can be "
+                         "benchmarked if empty"),
+                cl::CommaSeparated, cl::value_desc("name"));
+
+enum class ModeKind { Latency, Throughput, Both };
+static cl::opt<ModeKind> Mode(
+    "mode", cl::desc("What to measure"),
+    cl::values(clEnumValN(ModeKind::Latency, "latency", "Latency"),
+               clEnumValN(ModeKind::Throughput, "throughput",
+                          "Reciprocal throughput"),
+               clEnumValN(ModeKind::Both, "both", "Latency and throughput")),
+    cl::init(ModeKind::Both));
+
+static cl::opt<bool>
+    PrintSnippets("print-snippets",
+                  cl::desc("Print the generated snippets and the model "
+                           "values instead of running the benchmarks"));
+
+static cl::opt<bool>
+    MismatchesOnly("mismatches-only",
+                   cl::desc("Only report opcodes where the measurement "
+                            "disagrees with the model"));
+
+static cl::opt<double> Tolerance(
+    "tolerance",
+    cl::desc("Relative difference from the model that is reported as a "
+             "mismatch; differences below half a cycle are always accepted"),
+    cl::init(0.2));
+
+static cl::opt<unsigned>
+    MinInstructions("min-instructions",
+                    cl::desc("Minimum number of instructions in the "
+                             "measured function"),
+                    cl::init(1024));
+
+static cl::opt<unsigned>
+    NumCalls("num-calls",
+             cl::desc("Number of calls to the measured function per run"),
+             cl::init(1000));
+
+/// Latency and reciprocal throughput according to the scheduling model.
+static bool getModelValues(const MCSubtargetInfo &STI, const MCInstrDesc &Desc,
+                           double &Latency, double &RThroughput) {
+  const MCSchedModel &SM = STI.getSchedModel();
+  const MCSchedClassDesc *SCDesc = SM.getSchedClassDesc(Desc.getSchedClass());
+  if (!SCDesc->isValid() || SCDesc->isVariant())
+    return false;
+
+  Latency = 0;
+  for (unsigned I = 0, E = SCDesc->NumWriteLatencyEntries; I != E; ++I)
+    Latency = std::max(Latency,
+                       (double)STI.getWriteLatencyEntry(SCDesc, I)->Cycles);
+
+  RThroughput = (double)SCDesc->NumMicroOps / SM.IssueWidth;
+  for (const MCWriteProcResEntry &PRE :
+       make_range(STI.getWriteProcResBegin(SCDesc),
+                  STI.getWriteProcResEnd(SCDesc)))
+    if (PRE.Cycles)
+      RThroughput = std::max(RThroughput,
+                             (double)PRE.Cycles /
+                                 SM.getProcResource(PRE.ProcResourceIdx)
+                                     ->NumUnits);
+  return true;
+}
+
+static bool isMismatch(double Model, double Measured) {
+  double Diff = std::abs(Model - Measured);
+  return Diff > 0.5 && Diff > Tolerance * Model;
+}
+
+static unsigned findRegister(const MCRegisterInfo &MRI, StringRef Name) {
+  for (unsigned I = 1, E = MRI.getNumRegs(); I != E; ++I)
+    if (Name == MRI.getName(I))
+      return I;
+  return 0;
+}
+
+static void printSnippet(raw_ostream &OS, const Snippet &S, MCInstPrinter &IP,
+                         const MCSubtargetInfo &STI) {
+  for (const MCInst &Inst : S.Instructions) {
+    std::string Str;
+    raw_string_ostream SOS(Str);
+    IP.printInst(&Inst, SOS, "", STI);
+    SOS.flush();
+    std::replace(Str.begin(), Str.end(), '\t', ' ');
+    OS << "  " << StringRef(Str).trim() << '\n';
+  }
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y; // Call llvm_shutdown() on exit.
+
+  InitializeAllTargetInfos();
+  InitializeAllTargetMCs();
+
+  cl::AddExtraVersionPrinter(TargetRegistry::printRegisteredTargetsForVersion);
+  cl::ParseCommandLineOptions(argc, argv,
+                              "llvm scheduling model validation tool\n");
+
+  const char *ProgName = argv[0];
+  if (TripleName.empty())
+    TripleName = sys::getProcessTriple();
+  Triple TheTriple(Triple::normalize(TripleName));
+  TripleName = TheTriple.getTriple();
+
+  std::string Error;
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleName, Error);
+  if (!TheTarget) {
+    errs() << ProgName << ": " << Error;
+    return 1;
+  }
+  if (TheTriple.getArch() != Triple::x86_64) {
+    errs() << ProgName << ": error: only x86-64 targets are supported.\n";
+    return 1;
+  }
+
+  if (MCPU == "native")
+    MCPU = sys::getHostCPUName();
+
+  std::unique_ptr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
+  std::unique_ptr<MCAsmInfo> MAI(TheTarget->createMCAsmInfo(*MRI, TripleName));
+  std::unique_ptr<MCInstrInfo> MCII(TheTarget->createMCInstrInfo());
+  std::unique_ptr<MCSubtargetInfo> STI(
+      TheTarget->createMCSubtargetInfo(TripleName, MCPU, /*Features=*/""));
+  if (!STI->isCPUStringValid(MCPU)) {
+    errs() << ProgName << ": error: invalid CPU '" << MCPU
+           << "' for target triple '" << TripleName << "'.\n";
+    return 1;
+  }
+  if (!STI->getSchedModel().hasInstrSchedModel()) {
+    errs() << ProgName
+           << ": error: unable to find instruction-level scheduling "
+              "information for cpu '"
+           << MCPU << "'.\n";
+    return 1;
+  }
+
+  MCObjectFileInfo MOFI;
+  MCContext Ctx(MAI.get(), MRI.get(), &MOFI);
+  MOFI.InitMCObjectFileInfo(TheTriple, /*PIC=*/false, Ctx);
+  std::unique_ptr<MCCodeEmitter> Emitter(
+      TheTarget->createMCCodeEmitter(*MCII, *MRI, Ctx));
+  std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
+      TheTriple, MAI->getAssemblerDialect(), *MAI, *MCII, *MRI));
+  if (!Emitter || !IP) {
+    errs() << ProgName << ": error: the target cannot encode or print "
+                          "instructions.\n";
+    return 1;
+  }
+
+  // Select the opcodes to benchmark.
+  std::vector<unsigned> Opcodes;
+  if (OpcodeNames.empty()) {
+    for (unsigned I = 0, E = MCII->getNumOpcodes(); I != E; ++I)
+      Opcodes.push_back(I);
+  } else {
+    for (const std::string &Name : OpcodeNames) {
+      unsigned I = 0, E = MCII->getNumOpcodes();
+      while (I != E && MCII->getName(I) != Name)
+        ++I;
+      if (I == E) {
+        errs() << ProgName << ": error: unknown opcode '" << Name << "'.\n";
+        return 1;
+      }
+      Opcodes.push_back(I);
+    }
+  }
+
+  // The stack and instruction pointers must be left alone; the flags may be
+  // read and written freely.
+  SmallVector<unsigned, 4> Reserved;
+  for (StringRef Name : {"RSP", "RIP"})
+    if (unsigned Reg = findRegister(*MRI, Name))
+      Reserved.push_back(Reg);
+  SmallVector<unsigned, 1> Implicit;
+  if (unsigned Reg = findRegister(*MRI, "EFLAGS"))
+    Implicit.push_back(Reg);
+  SnippetGenerator Generator(*MCII, *MRI, Reserved, Implicit);
+
+  BenchmarkRunner Runner(*MCII, *MRI, *STI, *Emitter, MinInstructions,
+                         NumCalls);
+  if (!PrintSnippets) {
+    if (auto E = Runner.initialize()) {
+      errs() << ProgName << ": error: " << toString(std::move(E)) << '\n';
+      return 1;
+    }
+  }
+
+  std::error_code EC;
+  ToolOutputFile Out(OutputFilename, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << EC.message() << '\n';
+    return 1;
+  }
+  raw_ostream &OS = Out.os();
+
+  SmallVector<BenchmarkMode, 2> Modes;
+  if (Mode != ModeKind::Throughput)
+    Modes.push_back(BenchmarkMode::Latency);
+  if (Mode != ModeKind::Latency)
+    Modes.push_back(BenchmarkMode::Throughput);
+
+  if (!PrintSnippets) {
+    OS << "CPU: " << MCPU << " (cycles from "
+       << (Runner.usesPerfCounters() ? "perf counters" : "calibrated clock")
+       << ")\n\n";
+    OS << "Opcode                   Mode           Model  Measured  Status\n";
+  }
+
+  const char *Dash = "-";
+  unsigned NumMeasured = 0, NumMismatches = 0;
+  for (unsigned Opcode : Opcodes) {
+    double ModelLatency, ModelRThroughput;
+    if (!getModelValues(*STI, MCII->get(Opcode), ModelLatency,
+                        ModelRThroughput)) {
+      if (!OpcodeNames.empty())
+        errs() << ProgName << ": warning: " << MCII->getName(Opcode)
+               << " has no scheduling information in the model.\n";
+      continue;
+    }
+
+    for (BenchmarkMode M : Modes) {
+      bool IsLatency = M == BenchmarkMode::Latency;
+      StringRef ModeName = IsLatency ? "latency" : "throughput";
+      double Model = IsLatency ? ModelLatency : ModelRThroughput;
+
+      Expected<Snippet> S = Generator.generate(Opcode, M);
+      if (!S) {
+        std::string Reason = toString(S.takeError());
+        // Only explain why an opcode is skipped if it was asked for.
+        if (!OpcodeNames.empty())
+          OS << format("%-24s %-11s %8.2f %9s  skipped: %s\n",
+                       MCII->getName(Opcode).str().c_str(),
+                       ModeName.str().c_str(), Model, Dash, Reason.c_str());
+        continue;
+      }
+
+      if (PrintSnippets) {
+        OS << MCII->getName(Opcode) << ' ' << ModeName << " (model "
+           << format("%.2f", Model) << "):\n";
+        printSnippet(OS, *S, *IP, *STI);
+        continue;
+      }
+
+      Expected<double> Measured = Runner.measure(*S);
+      if (!Measured) {
+        std::string Reason = toString(Measured.takeError());
+        if (!MismatchesOnly)
+          OS << format("%-24s %-11s %8.2f %9s  failed: %s\n",
+                       MCII->getName(Opcode).str().c_str(),
+                       ModeName.str().c_str(), Model, Dash, Reason.c_str());
+        continue;
+      }
+
+      ++NumMeasured;
+      bool Mismatch = isMismatch(Model, *Measured);
+      NumMismatches += Mismatch;
+      if (Mismatch || !MismatchesOnly)
+        OS << format("%-24s %-11s %8.2f %9.2f  ",
+                     MCII->getName(Opcode).str().c_str(),
+                     ModeName.str().c_str(), Model, *Measured)
+           << (Mismatch ? "MISMATCH" : "ok") << '\n';
+    }
+  }
+
+  if (!PrintSnippets)
+    OS << '\n'
+       << NumMeasured << " measurements, " << NumMismatches
+       << " differ from the model.\n";
+
+  Out.keep();
+  return 0;
+}
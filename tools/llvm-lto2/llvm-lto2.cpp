@@ -104,6 +104,19 @@ static cl::opt<std::string>
     SamplePGOFile("lto-sample-profile-file",
                   cl::desc("Specify a SamplePGO profile file"));
 
+static cl::opt<bool>
+    FunctionOrdering("lto-function-ordering",
+                     cl::desc("Order hot functions by the profiled call graph"));
+
+static cl::opt<std::string> FunctionOrderingFile(
+    "lto-function-ordering-file",
+    cl::desc("Write the order of the hot functions to this file"));
+
+static cl::opt<bool> FunctionOrderingFileSections(
+    "lto-function-ordering-file-sections",
+    cl::desc("Write section names instead of symbol names to the function "
+             "ordering file"));
+
 static cl::opt<bool>
     UseNewPM("use-new-pm",
              cl::desc("Run LTO passes using the new pass manager"),
@@ -211,6 +224,10 @@ static int run(int argc, char **argv) {
 
   Conf.SampleProfile = SamplePGOFile;
 
+  Conf.FunctionOrdering = FunctionOrdering;
+  Conf.FunctionOrderingFile = FunctionOrderingFile;
+  Conf.FunctionOrderingFileSections = FunctionOrderingFileSections;
+
   // Run a custom pipeline, if asked for.
   Conf.OptPipeline = OptPipeline;
   Conf.AAPipeline = AAPipeline;
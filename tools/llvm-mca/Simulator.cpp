@@ -0,0 +1,404 @@
+//===- Simulator.cpp - Scheduling model driven pipeline simulator ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The simulated machine has three stages:
+//
+//  * Dispatch: up to DispatchWidth micro-ops per cycle enter the reorder
+//    buffer in program order, as long as the reorder buffer has room for
+//    them. Register dependencies are resolved here; register renaming is
+//    assumed to remove all false dependencies.
+//
+//  * Issue: every cycle, the oldest dispatched instructions whose operands
+//    are ready are issued, provided that a unit of each processor resource
+//    they consume is free. A unit stays busy for the number of cycles given
+//    by the scheduling model.
+//
+//  * Retire: up to DispatchWidth instructions per cycle leave the reorder
+//    buffer in program order, once they have finished executing.
+//
+// Memory dependencies, store forwarding and the front-end are not modeled.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Simulator.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/MC/MCInstPrinter.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSchedule.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <deque>
+
+using namespace llvm;
+using namespace mca;
+
+Simulator::Simulator(const MCSubtargetInfo &STI, const MCInstrInfo &MCII,
+                     const MCRegisterInfo &MRI, const SimulatorOptions &Opts)
+    : STI(STI), MCII(MCII), MRI(MRI), SM(STI.getSchedModel()), Opts(Opts) {}
+
+static std::string printInstruction(const MCInst &Inst, MCInstPrinter &IP,
+                                    const MCSubtargetInfo &STI) {
+  std::string Str;
+  raw_string_ostream OS(Str);
+  IP.printInst(&Inst, OS, "", STI);
+  OS.flush();
+  // Instruction printers indent with tabs; make the output table friendly.
+  std::replace(Str.begin(), Str.end(), '\t', ' ');
+  return StringRef(Str).trim().str();
+}
+
+std::string Simulator::getResourceName(unsigned Idx) const {
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_DUMP)
+  return SM.getProcResource(Idx)->Name;
+#else
+  return "Resource" + utostr(Idx);
+#endif
+}
+
+bool Simulator::buildDescriptors(raw_ostream &Err, MCInstPrinter &IP) {
+  Descs.clear();
+  Descs.reserve(Source.size());
+
+  for (const MCInst &Inst : Source) {
+    const MCInstrDesc &MCDesc = MCII.get(Inst.getOpcode());
+    const MCSchedClassDesc *SCDesc =
+        SM.getSchedClassDesc(MCDesc.getSchedClass());
+    if (!SCDesc->isValid() || SCDesc->isVariant()) {
+      Err << "error: the scheduling model has no "
+          << (SCDesc->isVariant() ? "non-variant " : "")
+          << "scheduling information for '"
+          << printInstruction(Inst, IP, STI) << "'\n";
+      return false;
+    }
+
+    InstrDesc D;
+    D.NumMicroOps = SCDesc->NumMicroOps;
+    D.MayLoad = MCDesc.mayLoad();
+    D.MayStore = MCDesc.mayStore();
+    D.HasSideEffects = MCDesc.hasUnmodeledSideEffects();
+
+    for (const MCWriteProcResEntry &PRE :
+         make_range(STI.getWriteProcResBegin(SCDesc),
+                    STI.getWriteProcResEnd(SCDesc))) {
+      if (!PRE.Cycles)
+        continue;
+      auto It = find_if(D.Resources, [&](const std::pair<unsigned, unsigned> &R) {
+        return R.first == PRE.ProcResourceIdx;
+      });
+      if (It != D.Resources.end())
+        It->second += PRE.Cycles;
+      else
+        D.Resources.push_back({PRE.ProcResourceIdx, PRE.Cycles});
+    }
+
+    for (unsigned I = 0, E = SCDesc->NumWriteLatencyEntries; I != E; ++I) {
+      int Cycles = STI.getWriteLatencyEntry(SCDesc, I)->Cycles;
+      D.MaxLatency = std::max(D.MaxLatency, (unsigned)std::max(Cycles, 0));
+    }
+
+    // Explicit defs come first, followed by the implicit ones. This is also
+    // the order of the write latency entries.
+    auto getDefLatency = [&](unsigned DefIdx) -> unsigned {
+      if (DefIdx >= SCDesc->NumWriteLatencyEntries)
+        return D.MaxLatency;
+      return std::max(STI.getWriteLatencyEntry(SCDesc, DefIdx)->Cycles, 0);
+    };
+    unsigned NumDefs = MCDesc.getNumDefs();
+    for (unsigned I = 0; I != NumDefs; ++I) {
+      const MCOperand &Op = Inst.getOperand(I);
+      if (Op.isReg() && Op.getReg())
+        D.Defs.push_back({Op.getReg(), getDefLatency(I)});
+    }
+    for (unsigned I = 0, E = MCDesc.getNumImplicitDefs(); I != E; ++I)
+      D.Defs.push_back(
+          {MCDesc.getImplicitDefs()[I], getDefLatency(NumDefs + I)});
+
+    for (unsigned I = NumDefs, E = Inst.getNumOperands(); I != E; ++I) {
+      const MCOperand &Op = Inst.getOperand(I);
+      if (Op.isReg() && Op.getReg())
+        D.Uses.push_back(Op.getReg());
+    }
+    for (unsigned I = 0, E = MCDesc.getNumImplicitUses(); I != E; ++I)
+      D.Uses.push_back(MCDesc.getImplicitUses()[I]);
+
+    D.RThroughput = (double)D.NumMicroOps / SM.IssueWidth;
+    for (const auto &R : D.Resources) {
+      unsigned NumUnits = SM.getProcResource(R.first)->NumUnits;
+      D.RThroughput = std::max(D.RThroughput, (double)R.second / NumUnits);
+    }
+
+    Descs.push_back(std::move(D));
+  }
+  return true;
+}
+
+namespace {
+
+/// Dynamic state of one instruction instance.
+struct InstState {
+  unsigned DescIdx;
+  unsigned DispatchCycle = 0;
+  unsigned IssueCycle = 0;
+  unsigned ExecutedCycle = 0;
+  bool Issued = false;
+  /// Producers of the registers read, as (instance index, latency).
+  SmallVector<std::pair<unsigned, unsigned>, 4> Deps;
+
+  explicit InstState(unsigned DescIdx) : DescIdx(DescIdx) {}
+};
+
+} // end anonymous namespace
+
+bool Simulator::run(ArrayRef<MCInst> Insts, MCInstPrinter &IP,
+                    raw_ostream &Err) {
+  Source = Insts;
+  if (!buildDescriptors(Err, IP))
+    return false;
+
+  DispatchWidth = Opts.DispatchWidth ? Opts.DispatchWidth : SM.IssueWidth;
+  ReorderBufferSize = Opts.ReorderBufferSize ? Opts.ReorderBufferSize
+                                             : SM.MicroOpBufferSize;
+  // In-order models have no reorder buffer to speak of; only let a single
+  // dispatch group be in flight.
+  if (!ReorderBufferSize)
+    ReorderBufferSize = DispatchWidth;
+
+  unsigned NumResources = SM.getNumProcResourceKinds();
+  std::vector<std::vector<unsigned>> UnitBusyUntil(NumResources);
+  for (unsigned I = 1; I != NumResources; ++I)
+    UnitBusyUntil[I].assign(SM.getProcResource(I)->NumUnits, 0);
+
+  ResourceCycles.assign(NumResources, 0);
+  ResourceStallCycles.assign(NumResources, 0);
+  WaitCycles.assign(Source.size(), 0);
+  TotalCycles = TotalMicroOps = 0;
+  ROBFullCycles = DataDependencyCycles = 0;
+
+  const unsigned NumInstances = Source.size() * Opts.Iterations;
+  std::vector<InstState> Instances;
+  Instances.reserve(NumInstances);
+
+  // Last writer of every register (and its aliases), as
+  // (instance index, latency).
+  DenseMap<unsigned, std::pair<unsigned, unsigned>> LastWriter;
+
+  std::deque<unsigned> ROB;
+  std::vector<unsigned> Window;
+  unsigned ROBMicroOps = 0;
+  unsigned NumRetired = 0;
+  SmallVector<unsigned, 8> StalledOn;
+
+  for (unsigned Cycle = 0; NumRetired != NumInstances; ++Cycle) {
+    // Retire.
+    for (unsigned N = 0; N != DispatchWidth && !ROB.empty(); ++N) {
+      InstState &IS = Instances[ROB.front()];
+      if (!IS.Issued || IS.ExecutedCycle > Cycle)
+        break;
+      ROBMicroOps -= std::min(Descs[IS.DescIdx].NumMicroOps, ReorderBufferSize);
+      ROB.pop_front();
+      ++NumRetired;
+    }
+
+    // Issue, oldest first.
+    bool IssuedAny = false, BlockedOnData = false;
+    StalledOn.clear();
+    for (auto It = Window.begin(); It != Window.end();) {
+      InstState &IS = Instances[*It];
+      const InstrDesc &D = Descs[IS.DescIdx];
+
+      bool Ready = all_of(IS.Deps, [&](const std::pair<unsigned, unsigned> &P) {
+        const InstState &Producer = Instances[P.first];
+        return Producer.Issued && Producer.IssueCycle + P.second <= Cycle;
+      });
+      if (!Ready) {
+        BlockedOnData = true;
+        ++It;
+        continue;
+      }
+
+      // Find a free unit for every resource before reserving any of them.
+      SmallVector<unsigned, 4> Units;
+      bool Available = true;
+      for (const auto &R : D.Resources) {
+        std::vector<unsigned> &Busy = UnitBusyUntil[R.first];
+        auto Unit = std::min_element(Busy.begin(), Busy.end());
+        if (Unit == Busy.end() || *Unit > Cycle) {
+          StalledOn.push_back(R.first);
+          Available = false;
+          break;
+        }
+        Units.push_back(Unit - Busy.begin());
+      }
+      if (!Available) {
+        ++It;
+        continue;
+      }
+
+      for (unsigned I = 0, E = D.Resources.size(); I != E; ++I) {
+        unsigned Res = D.Resources[I].first, Cycles = D.Resources[I].second;
+        UnitBusyUntil[Res][Units[I]] = Cycle + Cycles;
+        ResourceCycles[Res] += Cycles;
+      }
+      IS.Issued = true;
+      IS.IssueCycle = Cycle;
+      IS.ExecutedCycle = Cycle + D.MaxLatency;
+      IS.Deps.clear();
+      WaitCycles[IS.DescIdx] += Cycle - IS.DispatchCycle;
+      IssuedAny = true;
+      It = Window.erase(It);
+    }
+    for (unsigned Res : StalledOn)
+      ++ResourceStallCycles[Res];
+    if (!IssuedAny && BlockedOnData && StalledOn.empty())
+      ++DataDependencyCycles;
+
+    // Dispatch, in program order.
+    unsigned Slots = DispatchWidth;
+    while (Instances.size() != NumInstances) {
+      unsigned DescIdx = Instances.size() % Source.size();
+      const InstrDesc &D = Descs[DescIdx];
+      unsigned MicroOps = std::min(D.NumMicroOps, ReorderBufferSize);
+      // An instruction wider than the dispatch width starts its own group.
+      if (MicroOps > Slots && Slots != DispatchWidth)
+        break;
+      if (ROBMicroOps + MicroOps > ReorderBufferSize) {
+        ++ROBFullCycles;
+        break;
+      }
+
+      unsigned Idx = Instances.size();
+      Instances.emplace_back(DescIdx);
+      InstState &IS = Instances.back();
+      IS.DispatchCycle = Cycle;
+      for (unsigned Reg : D.Uses) {
+        // Keep the dependency even if the producer has issued already, so
+        // that its latency is still honored.
+        auto W = LastWriter.find(Reg);
+        if (W != LastWriter.end())
+          IS.Deps.push_back(W->second);
+      }
+      for (const auto &Def : D.Defs)
+        for (MCRegAliasIterator AI(Def.first, &MRI, true); AI.isValid(); ++AI)
+          LastWriter[*AI] = {Idx, Def.second};
+
+      ROB.push_back(Idx);
+      Window.push_back(Idx);
+      ROBMicroOps += MicroOps;
+      TotalMicroOps += D.NumMicroOps;
+      Slots -= std::min(MicroOps, Slots);
+      if (!Slots)
+        break;
+    }
+
+    TotalCycles = Cycle + 1;
+  }
+  return true;
+}
+
+double Simulator::getBlockRThroughput() const {
+  uint64_t MicroOps = 0;
+  std::vector<uint64_t> Pressure(SM.getNumProcResourceKinds(), 0);
+  for (const InstrDesc &D : Descs) {
+    MicroOps += D.NumMicroOps;
+    for (const auto &R : D.Resources)
+      Pressure[R.first] += R.second;
+  }
+
+  double Throughput = (double)MicroOps / DispatchWidth;
+  for (unsigned I = 1, E = Pressure.size(); I != E; ++I)
+    Throughput = std::max(Throughput, (double)Pressure[I] /
+                                          SM.getProcResource(I)->NumUnits);
+  return Throughput;
+}
+
+void Simulator::printReport(raw_ostream &OS, MCInstPrinter &IP) const {
+  unsigned NumInstructions = Source.size() * Opts.Iterations;
+  double Iterations = Opts.Iterations;
+  double BlockRThroughput = getBlockRThroughput();
+
+  OS << "Iterations:        " << Opts.Iterations << '\n'
+     << "Instructions:      " << NumInstructions << '\n'
+     << "Total Cycles:      " << TotalCycles << '\n'
+     << "Total uOps:        " << TotalMicroOps << "\n\n"
+     << "Dispatch Width:    " << DispatchWidth << '\n'
+     << "Reorder Buffer:    " << ReorderBufferSize << '\n'
+     << "uOps Per Cycle:    "
+     << format("%.2f", (double)TotalMicroOps / TotalCycles) << '\n'
+     << "IPC:               "
+     << format("%.2f", (double)NumInstructions / TotalCycles) << '\n'
+     << "Cycles/Iteration:  " << format("%.2f", TotalCycles / Iterations)
+     << '\n'
+     << "Block RThroughput: " << format("%.1f", BlockRThroughput) << "\n\n";
+
+  OS << "Instruction Info:\n"
+     << "[1]: #uOps\n"
+     << "[2]: Latency\n"
+     << "[3]: RThroughput\n"
+     << "[4]: Average cycles waiting to issue\n"
+     << "[5]: MayLoad\n"
+     << "[6]: MayStore\n"
+     << "[7]: HasSideEffects\n\n"
+     << "[1]    [2]    [3]    [4]    [5]    [6]    [7]    Instructions:\n";
+  for (unsigned I = 0, E = Source.size(); I != E; ++I) {
+    const InstrDesc &D = Descs[I];
+    OS << format(" %-6u %-6u %-6.2f %-6.1f ", D.NumMicroOps, D.MaxLatency,
+                 D.RThroughput, WaitCycles[I] / Iterations)
+       << (D.MayLoad ? " *     " : "       ")
+       << (D.MayStore ? " *     " : "       ")
+       << (D.HasSideEffects ? " U     " : "       ")
+       << printInstruction(Source[I], IP, STI) << '\n';
+  }
+
+  OS << "\nResource pressure per iteration:\n";
+  unsigned Bottleneck = 0;
+  double BottleneckPressure = 0.0;
+  for (unsigned I = 1, E = ResourceCycles.size(); I != E; ++I) {
+    if (!ResourceCycles[I])
+      continue;
+    unsigned NumUnits = SM.getProcResource(I)->NumUnits;
+    double Pressure = ResourceCycles[I] / Iterations;
+    OS << format("  %-20s %8.2f", getResourceName(I).c_str(), Pressure);
+    if (NumUnits > 1)
+      OS << format("  (%u units)", NumUnits);
+    OS << '\n';
+    if (Pressure / NumUnits > BottleneckPressure) {
+      BottleneckPressure = Pressure / NumUnits;
+      Bottleneck = I;
+    }
+  }
+
+  OS << "\nDynamic dispatch stalls:\n"
+     << "  Reorder buffer full:   " << ROBFullCycles << " cycles\n"
+     << "  Register dependencies: " << DataDependencyCycles << " cycles\n";
+  for (unsigned I = 1, E = ResourceStallCycles.size(); I != E; ++I)
+    if (ResourceStallCycles[I])
+      OS << "  Resource " << getResourceName(I) << ": "
+         << ResourceStallCycles[I] << " cycles\n";
+
+  // Classify the main limiter: if the simulated throughput is close to the
+  // static bound, whatever determines the bound is the bottleneck; otherwise
+  // the block is latency bound.
+  double CyclesPerIteration = TotalCycles / Iterations;
+  double DispatchBound =
+      (double)TotalMicroOps / Opts.Iterations / DispatchWidth;
+  OS << "\nBottleneck: ";
+  if (CyclesPerIteration > BlockRThroughput * 1.1)
+    OS << "register dependencies (latency bound, "
+       << format("%.2f", CyclesPerIteration - BlockRThroughput)
+       << " cycles/iteration above the throughput bound)\n";
+  else if (Bottleneck && BottleneckPressure >= DispatchBound)
+    OS << "resource pressure on " << getResourceName(Bottleneck) << '\n';
+  else
+    OS << "dispatch width\n";
+}
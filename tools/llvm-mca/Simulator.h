@@ -0,0 +1,113 @@
+//===- Simulator.h - Scheduling model driven pipeline simulator -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a simple out-of-order pipeline simulator that is driven
+// entirely by the MCSchedModel of a subtarget. A sequence of MCInsts is
+// repeatedly dispatched, issued to processor resources and retired, and the
+// simulator reports the resulting throughput together with the resources and
+// dependencies that limited it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCA_SIMULATOR_H
+#define LLVM_TOOLS_LLVM_MCA_SIMULATOR_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/MC/MCInst.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+class MCInstPrinter;
+class MCInstrInfo;
+class MCRegisterInfo;
+class MCSchedModel;
+class MCSubtargetInfo;
+class raw_ostream;
+
+namespace mca {
+
+/// Static properties of one instruction of the analyzed block, as described
+/// by the scheduling model.
+struct InstrDesc {
+  unsigned NumMicroOps = 0;
+  unsigned MaxLatency = 0;
+  /// Reciprocal throughput of the instruction in isolation.
+  double RThroughput = 0.0;
+  bool MayLoad = false;
+  bool MayStore = false;
+  bool HasSideEffects = false;
+  /// Processor resources consumed at issue, as (resource index, cycles).
+  SmallVector<std::pair<unsigned, unsigned>, 4> Resources;
+  /// Registers written, as (register, latency).
+  SmallVector<std::pair<unsigned, unsigned>, 2> Defs;
+  /// Registers read.
+  SmallVector<unsigned, 4> Uses;
+};
+
+/// Knobs for the simulated pipeline. A value of zero means "take it from the
+/// scheduling model".
+struct SimulatorOptions {
+  unsigned Iterations = 100;
+  unsigned DispatchWidth = 0;
+  unsigned ReorderBufferSize = 0;
+};
+
+class Simulator {
+  const MCSubtargetInfo &STI;
+  const MCInstrInfo &MCII;
+  const MCRegisterInfo &MRI;
+  const MCSchedModel &SM;
+  SimulatorOptions Opts;
+
+  ArrayRef<MCInst> Source;
+  std::vector<InstrDesc> Descs;
+
+  // Results of the last run.
+  unsigned TotalCycles = 0;
+  unsigned TotalMicroOps = 0;
+  unsigned DispatchWidth = 0;
+  unsigned ReorderBufferSize = 0;
+  unsigned ROBFullCycles = 0;
+  unsigned DataDependencyCycles = 0;
+  /// Cycles spent by each processor resource, over all iterations.
+  std::vector<uint64_t> ResourceCycles;
+  /// Number of cycles in which a ready instruction could not be issued
+  /// because a unit of the resource was busy.
+  std::vector<unsigned> ResourceStallCycles;
+  /// Sum over all iterations of the cycles each instruction spent between
+  /// dispatch and issue.
+  std::vector<uint64_t> WaitCycles;
+
+  bool buildDescriptors(raw_ostream &Err, MCInstPrinter &IP);
+  double getBlockRThroughput() const;
+  std::string getResourceName(unsigned Idx) const;
+
+public:
+  Simulator(const MCSubtargetInfo &STI, const MCInstrInfo &MCII,
+            const MCRegisterInfo &MRI, const SimulatorOptions &Opts);
+
+  /// Simulate \p Insts for the configured number of iterations. Returns false
+  /// and prints a diagnostic to \p Err if the block cannot be analyzed with
+  /// the scheduling model.
+  bool run(ArrayRef<MCInst> Insts, MCInstPrinter &IP, raw_ostream &Err);
+
+  /// Print the summary, per-instruction, resource pressure and bottleneck
+  /// reports for the last run.
+  void printReport(raw_ostream &OS, MCInstPrinter &IP) const;
+};
+
+} // end namespace mca
+} // end namespace llvm
+
+#endif // LLVM_TOOLS_LLVM_MCA_SIMULATOR_H
@@ -0,0 +1,252 @@
+//===- llvm-mca.cpp - Machine Code Analyzer ---------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This utility statically estimates the throughput of a sequence of machine
+// instructions, typically the body of a hot loop. The assembly is parsed with
+// the MC layer and simulated on a pipeline described by the scheduling model
+// of the selected CPU.
+//
+// Example:
+//
+//   llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=haswell loop.s
+//
+//===----------------------------------------------------------------------===//
+
+#include "Simulator.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInstPrinter.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCParser/MCAsmParser.h"
+#include "llvm/MC/MCParser/MCTargetAsmParser.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCTargetOptions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace llvm;
+
+static cl::opt<std::string>
+    InputFilename(cl::Positional, cl::desc("<input file>"), cl::init("-"));
+
+static cl::opt<std::string> OutputFilename("o", cl::desc("Output filename"),
+                                           cl::init("-"),
+                                           cl::value_desc("filename"));
+
+static cl::opt<std::string>
+    ArchName("march", cl::desc("Target arch to assemble for, "
+                               "see -version for available targets"));
+
+static cl::opt<std::string>
+    TripleName("mtriple", cl::desc("Target triple to assemble for, "
+                                   "see -version for available targets"));
+
+static cl::opt<std::string>
+    MCPU("mcpu",
+         cl::desc("Target a specific cpu type (-mcpu=help for details)"),
+         cl::value_desc("cpu-name"), cl::init("native"));
+
+static cl::opt<unsigned>
+    Iterations("iterations",
+               cl::desc("Number of iterations to run (default: 100)"),
+               cl::init(100));
+
+static cl::opt<unsigned>
+    DispatchWidth("dispatch",
+                  cl::desc("Dispatch width; defaults to the issue width of "
+                           "the scheduling model"),
+                  cl::init(0));
+
+static cl::opt<unsigned> ReorderBufferSize(
+    "rob-size",
+    cl::desc("Size of the reorder buffer in micro-ops; defaults to the "
+             "micro-op buffer size of the scheduling model"),
+    cl::init(0));
+
+static cl::opt<int> OutputAsmVariant(
+    "output-asm-variant",
+    cl::desc("Syntax variant to use for output printing"), cl::init(-1));
+
+namespace {
+
+/// Collects the instructions produced by the assembly parser and discards
+/// everything else.
+class MCInstCollector final : public MCStreamer {
+  std::vector<MCInst> &Insts;
+
+public:
+  MCInstCollector(MCContext &Context, std::vector<MCInst> &Insts)
+      : MCStreamer(Context), Insts(Insts) {}
+
+  void EmitInstruction(const MCInst &Inst, const MCSubtargetInfo &STI,
+                       bool /* PrintSchedInfo */) override {
+    Insts.push_back(Inst);
+  }
+
+  bool EmitSymbolAttribute(MCSymbol *Symbol,
+                           MCSymbolAttr Attribute) override {
+    return true;
+  }
+
+  void EmitCommonSymbol(MCSymbol *Symbol, uint64_t Size,
+                        unsigned ByteAlignment) override {}
+  void EmitZerofill(MCSection *Section, MCSymbol *Symbol = nullptr,
+                    uint64_t Size = 0, unsigned ByteAlignment = 0) override {}
+  void EmitGPRel32Value(const MCExpr *Value) override {}
+  void BeginCOFFSymbolDef(const MCSymbol *Symbol) override {}
+  void EmitCOFFSymbolStorageClass(int StorageClass) override {}
+  void EmitCOFFSymbolType(int Type) override {}
+  void EndCOFFSymbolDef() override {}
+};
+
+} // end anonymous namespace
+
+static const Target *getTarget(const char *ProgName) {
+  if (TripleName.empty())
+    TripleName = sys::getDefaultTargetTriple();
+  Triple TheTriple(Triple::normalize(TripleName));
+
+  std::string Error;
+  const Target *TheTarget =
+      TargetRegistry::lookupTarget(ArchName, TheTriple, Error);
+  if (!TheTarget) {
+    errs() << ProgName << ": " << Error;
+    return nullptr;
+  }
+
+  // Update the triple name and return the found target.
+  TripleName = TheTriple.getTriple();
+  return TheTarget;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y; // Call llvm_shutdown() on exit.
+
+  InitializeAllTargetInfos();
+  InitializeAllTargetMCs();
+  InitializeAllAsmParsers();
+
+  cl::AddExtraVersionPrinter(TargetRegistry::printRegisteredTargetsForVersion);
+  cl::ParseCommandLineOptions(argc, argv, "llvm machine code analyzer\n");
+
+  const char *ProgName = argv[0];
+  const Target *TheTarget = getTarget(ProgName);
+  if (!TheTarget)
+    return 1;
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferPtr =
+      MemoryBuffer::getFileOrSTDIN(InputFilename);
+  if (std::error_code EC = BufferPtr.getError()) {
+    errs() << InputFilename << ": " << EC.message() << '\n';
+    return 1;
+  }
+
+  SourceMgr SrcMgr;
+  SrcMgr.AddNewSourceBuffer(std::move(*BufferPtr), SMLoc());
+
+  std::unique_ptr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
+  assert(MRI && "Unable to create target register info!");
+
+  std::unique_ptr<MCAsmInfo> MAI(TheTarget->createMCAsmInfo(*MRI, TripleName));
+  assert(MAI && "Unable to create target asm info!");
+
+  MCObjectFileInfo MOFI;
+  MCContext Ctx(MAI.get(), MRI.get(), &MOFI, &SrcMgr);
+  MOFI.InitMCObjectFileInfo(Triple(TripleName), /*PIC=*/false, Ctx);
+
+  if (MCPU == "native")
+    MCPU = sys::getHostCPUName();
+
+  std::unique_ptr<MCSubtargetInfo> STI(
+      TheTarget->createMCSubtargetInfo(TripleName, MCPU, /*Features=*/""));
+  if (!STI->isCPUStringValid(MCPU)) {
+    errs() << ProgName << ": error: invalid CPU '" << MCPU
+           << "' for target triple '" << TripleName << "'.\n";
+    return 1;
+  }
+
+  if (!STI->getSchedModel().hasInstrSchedModel()) {
+    errs() << ProgName
+           << ": error: unable to find instruction-level scheduling "
+              "information for target triple '"
+           << TripleName << "' and cpu '" << MCPU << "'.\n";
+    return 1;
+  }
+
+  std::unique_ptr<MCInstrInfo> MCII(TheTarget->createMCInstrInfo());
+
+  std::vector<MCInst> Insts;
+  MCInstCollector Str(Ctx, Insts);
+  std::unique_ptr<MCAsmParser> Parser(createMCAsmParser(SrcMgr, Ctx, Str, *MAI));
+  MCTargetOptions MCOptions;
+  std::unique_ptr<MCTargetAsmParser> TAP(
+      TheTarget->createMCAsmParser(*STI, *Parser, *MCII, MCOptions));
+  if (!TAP) {
+    errs() << ProgName
+           << ": error: this target does not support assembly parsing.\n";
+    return 1;
+  }
+  Parser->setTargetParser(*TAP);
+  if (Parser->Run(/*NoInitialTextSection=*/false))
+    return 1;
+
+  if (Insts.empty()) {
+    errs() << ProgName << ": error: no assembly instructions found.\n";
+    return 1;
+  }
+
+  unsigned AssemblerDialect = OutputAsmVariant >= 0
+                                  ? (unsigned)OutputAsmVariant
+                                  : MAI->getAssemblerDialect();
+  std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
+      Triple(TripleName), AssemblerDialect, *MAI, *MCII, *MRI));
+  if (!IP) {
+    errs() << ProgName
+           << ": error: unable to create instruction printer for target "
+              "triple '"
+           << TripleName << "' with assembly variant " << AssemblerDialect
+           << ".\n";
+    return 1;
+  }
+
+  std::error_code EC;
+  auto Out = llvm::make_unique<ToolOutputFile>(OutputFilename, EC,
+                                               sys::fs::F_Text);
+  if (EC) {
+    errs() << EC.message() << '\n';
+    return 1;
+  }
+
+  mca::SimulatorOptions Opts;
+  Opts.Iterations = std::max(1u, (unsigned)Iterations);
+  Opts.DispatchWidth = DispatchWidth;
+  Opts.ReorderBufferSize = ReorderBufferSize;
+
+  mca::Simulator Sim(*STI, *MCII, *MRI, Opts);
+  if (!Sim.run(Insts, *IP, errs()))
+    return 1;
+  Sim.printReport(Out->os(), *IP);
+
+  Out->keep();
+  return 0;
+}
@@ -8,10 +8,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/MC/StringTableBuilder.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Endian.h"
 #include "gtest/gtest.h"
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -104,4 +107,75 @@ TEST(StringTableBuilderTest, ELFInOrder) {
   EXPECT_EQ(9U, B.getOffset("foobar"));
 }
 
+TEST(StringTableBuilderTest, LargeTailMergedELF) {
+  // Enough strings that the tail merging sort is split into parallel tasks.
+  std::vector<std::string> Strings;
+  for (unsigned I = 0; I != 5000; ++I) {
+    Strings.push_back("prefix_" + std::to_string(I) + "_suffix");
+    Strings.push_back(std::to_string(I) + "_suffix");
+  }
+
+  // The result must not depend on the insertion order.
+  StringTableBuilder Forward(StringTableBuilder::ELF);
+  StringTableBuilder Backward(StringTableBuilder::ELF);
+  for (const std::string &S : Strings)
+    Forward.add(S);
+  for (const std::string &S : llvm::reverse(Strings))
+    Backward.add(S);
+  Forward.finalize();
+  Backward.finalize();
+
+  SmallString<0> ForwardData, BackwardData;
+  raw_svector_ostream ForwardOS(ForwardData), BackwardOS(BackwardData);
+  Forward.write(ForwardOS);
+  Backward.write(BackwardOS);
+  EXPECT_EQ(ForwardData, BackwardData);
+
+  for (const std::string &S : Strings) {
+    size_t Offset = Forward.getOffset(S);
+    EXPECT_EQ(Offset, Backward.getOffset(S));
+    EXPECT_EQ(S, StringRef(ForwardData.data() + Offset));
+  }
+
+  // Every short string is a suffix of a long one, so only the long strings
+  // take up space in the table.
+  size_t ExpectedSize = 1;
+  for (unsigned I = 0; I != Strings.size(); I += 2)
+    ExpectedSize += Strings[I].size() + 1;
+  EXPECT_EQ(ExpectedSize, Forward.getSize());
+}
+
+TEST(StringTableBuilderTest, ParallelTailMergingMatchesSequential) {
+  StringMap<cl::Option *> &Opts = cl::getRegisteredOptions();
+  ASSERT_EQ(1U, Opts.count("strtab-parallel-tail-merging"));
+  auto *Parallel =
+      static_cast<cl::opt<bool> *>(Opts["strtab-parallel-tail-merging"]);
+
+  // Strings with many shared suffixes of different lengths, so that the sort
+  // recurses through several character positions.
+  std::vector<std::string> Strings;
+  for (unsigned I = 0; I != 20000; ++I) {
+    std::string S = std::to_string((I * 7919) % 20011);
+    Strings.push_back(S);
+    Strings.push_back("_" + S);
+    Strings.push_back(S + "_" + std::to_string(I % 13));
+  }
+
+  auto Build = [&](bool UseParallel, SmallString<0> &Data) {
+    *Parallel = UseParallel;
+    StringTableBuilder B(StringTableBuilder::ELF);
+    for (const std::string &S : Strings)
+      B.add(S);
+    B.finalize();
+    raw_svector_ostream OS(Data);
+    B.write(OS);
+  };
+
+  SmallString<0> SequentialData, ParallelData;
+  Build(false, SequentialData);
+  Build(true, ParallelData);
+  *Parallel = false;
+  EXPECT_EQ(SequentialData, ParallelData);
+}
+
 }
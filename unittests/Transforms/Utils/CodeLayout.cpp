@@ -0,0 +1,89 @@
+//===- CodeLayout.cpp - Unit tests for the code layout algorithms ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/CodeLayout.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace llvm;
+
+namespace {
+
+std::vector<unsigned> identity(unsigned N) {
+  std::vector<unsigned> Order(N);
+  std::iota(Order.begin(), Order.end(), 0);
+  return Order;
+}
+
+TEST(CodeLayoutTest, ExtTspMovesColdBlockOut) {
+  // 0 branches to a cold block 1 and a hot block 2, which join in 3. Block 4
+  // is a hot self loop exiting to 5.
+  std::vector<uint64_t> Sizes = {10, 40, 10, 10, 20, 5};
+  std::vector<uint64_t> Counts = {100, 1, 99, 100, 1000, 100};
+  std::vector<LayoutEdge> Edges = {{0, 1, 1},   {0, 2, 99},  {1, 3, 1},
+                                   {2, 3, 99},  {3, 4, 100}, {4, 4, 900},
+                                   {4, 5, 100}};
+
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges);
+  EXPECT_EQ(std::vector<unsigned>({0, 2, 3, 4, 5, 1}), Order);
+  EXPECT_GT(calcExtTspScore(Order, Sizes, Edges),
+            calcExtTspScore(identity(Sizes.size()), Sizes, Edges));
+}
+
+TEST(CodeLayoutTest, ExtTspKeepsEntryFirst) {
+  // The hottest edge is 2 -> 0, which would like 2 to precede the entry.
+  std::vector<uint64_t> Sizes = {4, 4, 4};
+  std::vector<uint64_t> Counts = {100, 1, 99};
+  std::vector<LayoutEdge> Edges = {{0, 1, 1}, {0, 2, 99}, {2, 0, 98}};
+
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges);
+  ASSERT_EQ(3u, Order.size());
+  EXPECT_EQ(0u, Order[0]);
+  EXPECT_EQ(2u, Order[1]);
+}
+
+TEST(CodeLayoutTest, ExtTspIsAPermutation) {
+  // A chain of blocks with no executed edges keeps every block.
+  std::vector<uint64_t> Sizes(20, 8);
+  std::vector<uint64_t> Counts(20, 0);
+  std::vector<LayoutEdge> Edges;
+  for (unsigned I = 0; I + 1 < Sizes.size(); ++I)
+    Edges.push_back({I, I + 1, 0});
+
+  std::vector<unsigned> Order = applyExtTspLayout(Sizes, Counts, Edges);
+  std::vector<unsigned> Sorted = Order;
+  std::sort(Sorted.begin(), Sorted.end());
+  EXPECT_EQ(identity(Sizes.size()), Sorted);
+  EXPECT_EQ(0u, Order[0]);
+}
+
+TEST(CodeLayoutTest, C3PlacesHotCalleesAfterCallers) {
+  // 0 calls 2 a lot and 1 rarely; 2 calls 3. Function 4 is never executed.
+  std::vector<uint64_t> Sizes = {100, 100, 50, 50, 100};
+  std::vector<uint64_t> Counts = {10, 1, 1000, 500, 0};
+  std::vector<LayoutEdge> Calls = {
+      {0, 1, 1}, {0, 2, 1000}, {2, 3, 500}, {1, 3, 1}};
+
+  std::vector<unsigned> Order = applyC3Ordering(Sizes, Counts, Calls);
+  EXPECT_EQ(std::vector<unsigned>({0, 2, 3, 1, 4}), Order);
+}
+
+TEST(CodeLayoutTest, C3RespectsClusterSizeLimit) {
+  // Two huge functions are not merged into one cluster; the denser one goes
+  // first.
+  std::vector<uint64_t> Sizes = {2 << 20, 2 << 20};
+  std::vector<uint64_t> Counts = {10, 1000};
+  std::vector<LayoutEdge> Calls = {{0, 1, 1000}};
+
+  std::vector<unsigned> Order = applyC3Ordering(Sizes, Counts, Calls);
+  EXPECT_EQ(std::vector<unsigned>({1, 0}), Order);
+}
+
+} // end anonymous namespace
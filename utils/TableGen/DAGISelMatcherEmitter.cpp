@@ -24,6 +24,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/TableGen/Error.h"
 #include "llvm/TableGen/Record.h"
+#include <algorithm>
 using namespace llvm;
 
 enum {
@@ -82,6 +83,8 @@ public:
   MatcherTableEmitter(const CodeGenDAGPatterns &cgp)
     : CGP(cgp) {}
 
+  void AssignPredicateIndices(const Matcher *TheMatcher);
+
   unsigned EmitMatcherList(const Matcher *N, unsigned Indent,
                            unsigned StartIdx, raw_ostream &OS);
 
@@ -165,6 +168,32 @@ static unsigned GetVBRSize(unsigned Val) {
   return NumBytes+1;
 }
 
+/// getCompressedTypeSuffix - Return the suffix of the space-optimized opcode
+/// form that implicitly encodes the specified type, or an empty string if
+/// the type has to be emitted explicitly.
+static StringRef getCompressedTypeSuffix(MVT::SimpleValueType VT) {
+  switch (VT) {
+  case MVT::i32: return "I32";
+  case MVT::i64: return "I64";
+  default:       return StringRef();
+  }
+}
+
+/// EmitIntegerVT - Emit the opcode for an EmitInteger with the specified
+/// type, using the space-optimized forms where possible.  Return the number
+/// of bytes emitted in addition to the opcode.
+static unsigned EmitIntegerVT(MVT::SimpleValueType VT, raw_ostream &OS) {
+  switch (VT) {
+  case MVT::i8:  OS << "OPC_EmitInteger8, ";  return 0;
+  case MVT::i16: OS << "OPC_EmitInteger16, "; return 0;
+  case MVT::i32: OS << "OPC_EmitInteger32, "; return 0;
+  case MVT::i64: OS << "OPC_EmitInteger64, "; return 0;
+  default:
+    OS << "OPC_EmitInteger, " << getEnumName(VT) << ", ";
+    return 1;
+  }
+}
+
 /// EmitVBRValue - Emit the specified value as a VBR, returning the number of
 /// bytes emitted.
 static uint64_t EmitVBRValue(uint64_t Val, raw_ostream &OS) {
@@ -265,6 +294,74 @@ void MatcherTableEmitter::EmitPatternMatchTable(raw_ostream &OS) {
   EndEmitFunction(OS);
 }
 
+/// Node predicates keyed by the code they run, with their use counts.
+using NodePredicateUseMap =
+    MapVector<std::string, std::pair<TreePredicateFn, unsigned>,
+              StringMap<unsigned>>;
+
+static void CountPredicateUses(const Matcher *M,
+                               StringMap<unsigned> &PatternPredicateUses,
+                               NodePredicateUseMap &NodePredicateUses) {
+  for (; M != nullptr; M = M->getNext()) {
+    if (const auto *CPPM = dyn_cast<CheckPatternPredicateMatcher>(M)) {
+      ++PatternPredicateUses[CPPM->getPredicate()];
+    } else if (const auto *CPM = dyn_cast<CheckPredicateMatcher>(M)) {
+      TreePredicateFn Pred = CPM->getPredicate();
+      auto &Entry = NodePredicateUses.insert(
+          std::make_pair(Pred.getCodeToRunOnSDNode(),
+                         std::make_pair(Pred, 0u))).first->second;
+      ++Entry.second;
+    } else if (const auto *SM = dyn_cast<ScopeMatcher>(M)) {
+      for (unsigned i = 0, e = SM->getNumChildren(); i != e; ++i)
+        CountPredicateUses(SM->getChild(i), PatternPredicateUses,
+                           NodePredicateUses);
+    } else if (const auto *SOM = dyn_cast<SwitchOpcodeMatcher>(M)) {
+      for (unsigned i = 0, e = SOM->getNumCases(); i != e; ++i)
+        CountPredicateUses(SOM->getCaseMatcher(i), PatternPredicateUses,
+                           NodePredicateUses);
+    } else if (const auto *STM = dyn_cast<SwitchTypeMatcher>(M)) {
+      for (unsigned i = 0, e = STM->getNumCases(); i != e; ++i)
+        CountPredicateUses(STM->getCaseMatcher(i), PatternPredicateUses,
+                           NodePredicateUses);
+    }
+  }
+}
+
+/// AssignPredicateIndices - Number the pattern and node predicates in order of
+/// decreasing use count, so that the most frequently checked predicates get
+/// the single-byte OPC_CheckPatternPredicateN / OPC_CheckPredicateN forms.
+void MatcherTableEmitter::AssignPredicateIndices(const Matcher *TheMatcher) {
+  StringMap<unsigned> PatternPredicateUses;
+  NodePredicateUseMap NodePredicateUses;
+  CountPredicateUses(TheMatcher, PatternPredicateUses, NodePredicateUses);
+
+  // Sort by use count, breaking ties by name so that the output is stable.
+  std::vector<std::pair<StringRef, unsigned>> PatternPreds;
+  for (const auto &P : PatternPredicateUses)
+    PatternPreds.push_back(std::make_pair(P.getKey(), P.getValue()));
+  std::sort(PatternPreds.begin(), PatternPreds.end(),
+            [](const std::pair<StringRef, unsigned> &LHS,
+               const std::pair<StringRef, unsigned> &RHS) {
+              if (LHS.second != RHS.second)
+                return LHS.second > RHS.second;
+              return LHS.first < RHS.first;
+            });
+  for (const auto &P : PatternPreds)
+    getPatternPredicate(P.first);
+
+  // Node predicates are keyed by the code they run; ties keep first-use order.
+  std::vector<std::pair<TreePredicateFn, unsigned>> NodePreds;
+  for (const auto &P : NodePredicateUses)
+    NodePreds.push_back(P.second);
+  std::stable_sort(NodePreds.begin(), NodePreds.end(),
+                   [](const std::pair<TreePredicateFn, unsigned> &LHS,
+                      const std::pair<TreePredicateFn, unsigned> &RHS) {
+                     return LHS.second > RHS.second;
+                   });
+  for (const auto &P : NodePreds)
+    getNodePredicate(P.first);
+}
+
 /// EmitMatcher - Emit bytes for the specified matcher and return
 /// the number of bytes emitted.
 unsigned MatcherTableEmitter::
@@ -388,19 +485,29 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
 
   case Matcher::CheckPatternPredicate: {
     StringRef Pred =cast<CheckPatternPredicateMatcher>(N)->getPredicate();
-    OS << "OPC_CheckPatternPredicate, " << getPatternPredicate(Pred) << ',';
+    unsigned PredNo = getPatternPredicate(Pred);
+    // Handle the specialized forms that encode the predicate number.
+    if (PredNo < 8)
+      OS << "OPC_CheckPatternPredicate" << PredNo << ',';
+    else
+      OS << "OPC_CheckPatternPredicate, " << PredNo << ',';
     if (!OmitComments)
       OS << " // " << Pred;
     OS << '\n';
-    return 2;
+    return PredNo < 8 ? 1 : 2;
   }
   case Matcher::CheckPredicate: {
     TreePredicateFn Pred = cast<CheckPredicateMatcher>(N)->getPredicate();
-    OS << "OPC_CheckPredicate, " << getNodePredicate(Pred) << ',';
+    unsigned PredNo = getNodePredicate(Pred);
+    // Handle the specialized forms that encode the predicate number.
+    if (PredNo < 8)
+      OS << "OPC_CheckPredicate" << PredNo << ',';
+    else
+      OS << "OPC_CheckPredicate, " << PredNo << ',';
     if (!OmitComments)
       OS << " // " << Pred.getFnName();
     OS << '\n';
-    return 2;
+    return PredNo < 8 ? 1 : 2;
   }
 
   case Matcher::CheckOpcode:
@@ -498,19 +605,32 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
 
  case Matcher::CheckType:
     if (cast<CheckTypeMatcher>(N)->getResNo() == 0) {
-      OS << "OPC_CheckType, "
-         << getEnumName(cast<CheckTypeMatcher>(N)->getType()) << ",\n";
+      MVT::SimpleValueType VT = cast<CheckTypeMatcher>(N)->getType();
+      // Handle the specialized forms that encode the type.
+      StringRef Suffix = getCompressedTypeSuffix(VT);
+      if (!Suffix.empty()) {
+        OS << "OPC_CheckType" << Suffix << ",\n";
+        return 1;
+      }
+      OS << "OPC_CheckType, " << getEnumName(VT) << ",\n";
       return 2;
     }
     OS << "OPC_CheckTypeRes, " << cast<CheckTypeMatcher>(N)->getResNo()
        << ", " << getEnumName(cast<CheckTypeMatcher>(N)->getType()) << ",\n";
     return 3;
 
-  case Matcher::CheckChildType:
-    OS << "OPC_CheckChild"
-       << cast<CheckChildTypeMatcher>(N)->getChildNo() << "Type, "
-       << getEnumName(cast<CheckChildTypeMatcher>(N)->getType()) << ",\n";
+  case Matcher::CheckChildType: {
+    const auto *CCTM = cast<CheckChildTypeMatcher>(N);
+    OS << "OPC_CheckChild" << CCTM->getChildNo() << "Type";
+    // Handle the specialized forms that encode the type.
+    StringRef Suffix = getCompressedTypeSuffix(CCTM->getType());
+    if (!Suffix.empty()) {
+      OS << Suffix << ",\n";
+      return 1;
+    }
+    OS << ", " << getEnumName(CCTM->getType()) << ",\n";
     return 2;
+  }
 
   case Matcher::CheckInteger: {
     OS << "OPC_CheckInteger, ";
@@ -575,19 +695,19 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
 
   case Matcher::EmitInteger: {
     int64_t Val = cast<EmitIntegerMatcher>(N)->getValue();
-    OS << "OPC_EmitInteger, "
-       << getEnumName(cast<EmitIntegerMatcher>(N)->getVT()) << ", ";
-    unsigned Bytes = 2+EmitVBRValue(Val, OS);
+    MVT::SimpleValueType VT = cast<EmitIntegerMatcher>(N)->getVT();
+    unsigned Bytes = 1 + EmitIntegerVT(VT, OS);
+    Bytes += EmitVBRValue(Val, OS);
     OS << '\n';
     return Bytes;
   }
   case Matcher::EmitStringInteger: {
     const std::string &Val = cast<EmitStringIntegerMatcher>(N)->getValue();
+    MVT::SimpleValueType VT = cast<EmitStringIntegerMatcher>(N)->getVT();
     // These should always fit into one byte.
-    OS << "OPC_EmitInteger, "
-      << getEnumName(cast<EmitStringIntegerMatcher>(N)->getVT()) << ", "
-      << Val << ",\n";
-    return 3;
+    unsigned Bytes = 2 + EmitIntegerVT(VT, OS);
+    OS << Val << ",\n";
+    return Bytes;
   }
 
   case Matcher::EmitRegister: {
@@ -600,7 +720,14 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
       OS << "TARGET_VAL(" << getQualifiedName(Reg->TheDef) << "),\n";
       return 4;
     } else {
-      OS << "OPC_EmitRegister, " << getEnumName(Matcher->getVT()) << ", ";
+      unsigned Bytes = 3;
+      // Handle the specialized forms that encode the type.
+      StringRef Suffix = getCompressedTypeSuffix(Matcher->getVT());
+      if (!Suffix.empty()) {
+        OS << "OPC_EmitRegister" << Suffix << ", ";
+        --Bytes;
+      } else
+        OS << "OPC_EmitRegister, " << getEnumName(Matcher->getVT()) << ", ";
       if (Reg) {
         OS << getQualifiedName(Reg->TheDef) << ",\n";
       } else {
@@ -609,7 +736,7 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
           OS << "/*zero_reg*/";
         OS << ",\n";
       }
-      return 3;
+      return Bytes;
     }
   }
 
@@ -1034,6 +1161,10 @@ void llvm::EmitMatcherTable(const Matcher *TheMatcher,
   BeginEmitFunction(OS, "void", "SelectCode(SDNode *N)", false/*AddOverride*/);
   MatcherTableEmitter MatcherEmitter(CGP);
 
+  // Number the predicates up front so that the hottest ones are encoded in the
+  // opcode byte.
+  MatcherEmitter.AssignPredicateIndices(TheMatcher);
+
   OS << "{\n";
   OS << "  // Some target values are emitted as 2 bytes, TARGET_VAL handles\n";
   OS << "  // this.\n";